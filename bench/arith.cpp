@@ -0,0 +1,171 @@
+#include "workloads.hpp"
+
+#include <rv/detail/arith.hpp>
+
+#include <fmt/format.h>
+
+#include <chrono>
+#include <limits>
+#include <optional>
+#include <random>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+using namespace bench;
+namespace arith = rv::arith;
+
+struct result {
+    std::string_view operation;
+    usize bits;
+    std::string_view version;
+    /// operations per second
+    summary rate;
+};
+
+struct options {
+    usize repetitions = 5;
+    std::chrono::nanoseconds min_time = std::chrono::milliseconds(100);
+};
+
+/// calls `fn` on every pair of operands for at least `min_time`, `repetitions` times over
+template<typename T, typename Fn>
+auto measure(std::span<const std::pair<T, T>> operands, options const& options, Fn&& fn) -> summary {
+    using clock = std::chrono::steady_clock;
+
+    auto rates = std::vector<double>{};
+
+    for (usize i = 0; i < options.repetitions; i++) {
+        u64 operations = 0;
+
+        const auto tp_0 = clock::now();
+        auto tp_1 = tp_0;
+        while (tp_1 - tp_0 < options.min_time) {
+            for (const auto [lhs, rhs] : operands) {
+                do_not_optimize(fn(lhs, rhs));
+            }
+
+            operations += operands.size();
+            tp_1 = clock::now();
+        }
+
+        rates.push_back(static_cast<double>(operations) * 1e9 / static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(tp_1 - tp_0).count()));
+    }
+
+    return summarize(std::move(rates));
+}
+
+/// the portable and the host version of what the M extension and the shifts and comparisons of RV32I/RV64I use, at the register width `T`
+template<std::unsigned_integral T>
+void run_width(options const& options, std::vector<result>& results) {
+    auto operands = std::vector<std::pair<T, T>>(1uz << 12);
+    auto engine = std::mt19937_64(0x5eed);
+    for (auto& [lhs, rhs] : operands) {
+        lhs = static_cast<T>(engine());
+        rhs = static_cast<T>(engine());
+    }
+
+    constexpr auto bits = static_cast<usize>(std::numeric_limits<T>::digits);
+    // shift amounts are taken from the right hand side the way the shift instructions mask them
+    constexpr auto shift_mask = static_cast<T>(bits - 1);
+
+    const auto add = [&](std::string_view operation, auto&& portable, auto&& host) {
+        results.push_back({operation, bits, "portable", measure<T>(operands, options, portable)});
+        results.push_back({operation, bits, "host", measure<T>(operands, options, host)});
+    };
+
+    // clang-format off
+    add("mulhu",
+        [](T lhs, T rhs) { return arith::portable_multiply<T, false, false>(lhs, rhs).first; },
+        [](T lhs, T rhs) { return arith::host_multiply<T, false, false>(lhs, rhs).first; });
+    add("mulhsu",
+        [](T lhs, T rhs) { return arith::portable_multiply<T, true, false>(lhs, rhs).first; },
+        [](T lhs, T rhs) { return arith::host_multiply<T, true, false>(lhs, rhs).first; });
+    add("mulh",
+        [](T lhs, T rhs) { return arith::portable_multiply<T, true, true>(lhs, rhs).first; },
+        [](T lhs, T rhs) { return arith::host_multiply<T, true, true>(lhs, rhs).first; });
+    add("sra",
+        [](T lhs, T rhs) { return arith::portable_arithmetic_shr<T>(lhs, rhs & shift_mask); },
+        [](T lhs, T rhs) { return arith::host_arithmetic_shr<T>(lhs, rhs & shift_mask); });
+    add("slt",
+        [](T lhs, T rhs) { return arith::portable_signed_compare<T>(lhs, rhs) < 0; },
+        [](T lhs, T rhs) { return arith::host_signed_compare<T>(lhs, rhs) < 0; });
+    // clang-format on
+}
+
+void print_text(std::vector<result> const& results) {
+    fmt::print("{:<10} {:>4} {:<10} {:>14} {:>8}\n", "operation", "bits", "version", "M/s", "stdev");
+
+    for (auto const& result : results) {
+        fmt::print(
+          "{:<10} {:>4} {:<10} {:>14.2f} {:>7.2f}%\n",  //
+          result.operation, result.bits, result.version, result.rate.median / 1e6, result.rate.stdev * 100. / result.rate.median
+        );
+    }
+}
+
+void print_json(std::vector<result> const& results) {
+    fmt::print("{{\n  \"native_arithmetic\": {},\n  \"results\": [\n", arith::native_arithmetic);
+
+    for (usize i = 0; i < results.size(); i++) {
+        auto const& result = results[i];
+        fmt::print(
+          R"(    {{"operation": "{}", "bits": {}, "version": "{}", "per_second": {{"median": {}, "min": {}, "max": {}, "stdev": {}}}}}{})",  //
+          result.operation, result.bits, result.version, result.rate.median, result.rate.min, result.rate.max, result.rate.stdev, i + 1 == results.size() ? "\n" : ",\n"
+        );
+    }
+
+    fmt::print("  ]\n}}\n");
+}
+
+auto usage(const char* program_name) -> int {
+    fmt::print(stderr, "usage: {} [--json] [--repetitions N] [--min-time-ms N]\n", program_name);
+    fmt::print(stderr, "the host versions are what the interpreter uses when built with native_arithmetic, which this build has {}\n", arith::native_arithmetic ? "on" : "off");
+    return 1;
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) -> int {
+    auto json = false;
+    auto options = ::options{};
+
+    for (int i = 1; i < argc; i++) {
+        const auto arg = std::string_view(argv[i]);
+        const auto next = [&]() -> std::optional<std::string_view> { return i + 1 < argc ? std::optional{std::string_view(argv[++i])} : std::nullopt; };
+
+        if (arg == "--json") {
+            json = true;
+        } else if (arg == "--repetitions") {
+            const auto value = next().and_then(parse_number);
+            if (!value || *value == 0) {
+                return usage(argv[0]);
+            }
+
+            options.repetitions = *value;
+        } else if (arg == "--min-time-ms") {
+            const auto value = next().and_then(parse_number);
+            if (!value) {
+                return usage(argv[0]);
+            }
+
+            options.min_time = std::chrono::milliseconds(*value);
+        } else {
+            return usage(argv[0]);
+        }
+    }
+
+    auto results = std::vector<result>{};
+    run_width<u32>(options, results);
+    run_width<u64>(options, results);
+
+    if (json) {
+        print_json(results);
+    } else {
+        print_text(results);
+    }
+
+    return 0;
+}
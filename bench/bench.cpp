@@ -0,0 +1,175 @@
+#include "workloads.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+using namespace bench;
+
+using risc_v_type = rv::risc_v<u64>;
+
+struct result {
+    std::string name;
+    u64 instructions;
+    usize repetitions;
+    summary mips;
+    summary ns_per_instruction;
+    /// the share of the time per instruction that the decoder takes on its own
+    double decode_fraction;
+};
+
+auto run_workload(workload const& workload, usize repetitions, u64 max_instructions) -> result {
+    using clock = std::chrono::steady_clock;
+
+    auto mips = std::vector<double>{};
+    auto ns_per_instruction = std::vector<double>{};
+    u64 instructions = 0;
+
+    // one more run than asked for, the first one warms up caches and page tables and doesn't count
+    for (usize i = 0; i <= repetitions; i++) {
+        auto risc_v = risc_v_type(rv::is_rv64<risc_v_type>, memory_size);
+        load_workload(risc_v, workload);
+
+        const auto tp_0 = clock::now();
+        instructions = run_to_completion(risc_v, max_instructions);
+        const auto tp_1 = clock::now();
+
+        if (i == 0) {
+            continue;
+        }
+
+        const auto nanoseconds = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(tp_1 - tp_0).count());
+        mips.push_back(static_cast<double>(instructions) * 1e3 / nanoseconds);
+        ns_per_instruction.push_back(nanoseconds / static_cast<double>(instructions));
+    }
+
+    const auto words = record_words(workload, max_instructions);
+    auto const& isa = static_cast<rv::generic_instruction_set<risc_v_type> const&>(rv::is_rv64<risc_v_type>);
+
+    const auto tp_0 = clock::now();
+    for (const auto word : words) {
+        const auto match = isa.match(word);
+        do_not_optimize(match);
+    }
+    const auto tp_1 = clock::now();
+
+    const auto decode_ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(tp_1 - tp_0).count()) / static_cast<double>(words.size());
+    const auto ns_per_instruction_summary = summarize(ns_per_instruction);
+
+    return {
+      .name = workload.name,
+      .instructions = instructions,
+      .repetitions = repetitions,
+      .mips = summarize(std::move(mips)),
+      .ns_per_instruction = ns_per_instruction_summary,
+      .decode_fraction = std::min(decode_ns / ns_per_instruction_summary.median, 1.),
+    };
+}
+
+void print_text(std::vector<result> const& results) {
+    fmt::print("{:<16} {:>12} {:>10} {:>10} {:>10} {:>8} {:>9} {:>9}\n", "workload", "instructions", "MIPS", "min", "max", "stdev", "ns/insn", "decode");
+
+    for (auto const& result : results) {
+        fmt::print(
+          "{:<16} {:>12} {:>10.2f} {:>10.2f} {:>10.2f} {:>7.2f}% {:>9.3f} {:>8.1f}%\n",  //
+          result.name, result.instructions, result.mips.median, result.mips.min, result.mips.max, result.mips.stdev * 100. / result.mips.median,
+          result.ns_per_instruction.median, result.decode_fraction * 100.
+        );
+    }
+}
+
+void print_json(std::vector<result> const& results) {
+    const auto summary_json = [](summary const& summary) {
+        return fmt::format(R"({{"median": {}, "min": {}, "max": {}, "stdev": {}}})", summary.median, summary.min, summary.max, summary.stdev);
+    };
+
+    fmt::print("{{\n  \"workloads\": [\n");
+
+    for (usize i = 0; i < results.size(); i++) {
+        auto const& result = results[i];
+        fmt::print(
+          R"(    {{"name": "{}", "instructions": {}, "repetitions": {}, "mips": {}, "ns_per_instruction": {}, "decode_fraction": {}}}{})",  //
+          result.name, result.instructions, result.repetitions, summary_json(result.mips), summary_json(result.ns_per_instruction), result.decode_fraction,
+          i + 1 == results.size() ? "\n" : ",\n"
+        );
+    }
+
+    fmt::print("  ]\n}}\n");
+}
+
+auto usage(const char* program_name) -> int {
+    fmt::print(stderr, "usage: {} [--json] [--repetitions N] [--max-instructions N] [--filter SUBSTRING] [--image NAME=FILE.hex]...\n", program_name);
+    fmt::print(stderr, "images are Intel HEX files that are run from address 0 until they halt (e.g. devenv builds of main_gol.cpp)\n");
+    return 1;
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) -> int {
+    auto json = false;
+    auto repetitions = 5uz;
+    auto max_instructions = u64(1'000'000'000);
+    auto filter = std::string_view{};
+    auto workloads = builtin_workloads();
+
+    for (int i = 1; i < argc; i++) {
+        const auto arg = std::string_view(argv[i]);
+        const auto next = [&]() -> std::optional<std::string_view> { return i + 1 < argc ? std::optional{std::string_view(argv[++i])} : std::nullopt; };
+
+        if (arg == "--json") {
+            json = true;
+        } else if (arg == "--repetitions" || arg == "--max-instructions") {
+            const auto value = next().and_then(parse_number);
+            if (!value || *value == 0) {
+                return usage(argv[0]);
+            }
+
+            (arg == "--repetitions" ? repetitions : max_instructions) = *value;
+        } else if (arg == "--filter") {
+            const auto value = next();
+            if (!value) {
+                return usage(argv[0]);
+            }
+
+            filter = *value;
+        } else if (arg == "--image") {
+            const auto value = next();
+            const auto separator = value ? value->find('=') : std::string_view::npos;
+            if (separator == std::string_view::npos) {
+                return usage(argv[0]);
+            }
+
+            workloads.push_back({std::string(value->substr(0, separator)), {}, std::string(value->substr(separator + 1))});
+        } else {
+            return usage(argv[0]);
+        }
+    }
+
+    auto results = std::vector<result>{};
+    for (auto const& workload : workloads) {
+        if (workload.name.find(filter) == std::string::npos) {
+            continue;
+        }
+
+        if (!json) {
+            fmt::print(stderr, "running {}...\n", workload.name);
+        }
+
+        results.push_back(run_workload(workload, repetitions, max_instructions));
+    }
+
+    if (json) {
+        print_json(results);
+    } else {
+        print_text(results);
+    }
+
+    return 0;
+}
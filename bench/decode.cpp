@@ -0,0 +1,244 @@
+#include "workloads.hpp"
+
+#include <fmt/format.h>
+
+#include <chrono>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+using namespace bench;
+
+/// `rv::is_rv32` and `rv::is_rv64` without the C extension, these have to list the same tables as those otherwise
+template<typename RiscV>
+inline constexpr auto is_rv32_without_c = rv::instruction_set(
+  std::type_identity<RiscV>{}, rv::detail::is_rv32i<RiscV>, rv::detail::is_rv32m<RiscV>, rv::detail::is_rv32zifencei<RiscV>, rv::detail::is_rv32zicsr<RiscV>,
+  rv::detail::is_rv32_privileged<RiscV>, rv::detail::is_rv32a<RiscV>, rv::detail::is_rv32f<RiscV>, rv::detail::is_rv32d<RiscV>, rv::detail::is_rv32zba<RiscV>,
+  rv::detail::is_rv32zbb<RiscV>, rv::detail::is_rv32zbs<RiscV>, rv::detail::is_rvv<RiscV>
+);
+
+template<typename RiscV>
+inline constexpr auto is_rv64_without_c = rv::instruction_set(
+  std::type_identity<RiscV>{}, rv::detail::is_rv64i<RiscV>, rv::detail::is_rv64m<RiscV>, rv::detail::is_rv32zifencei<RiscV>, rv::detail::is_rv32zicsr<RiscV>,
+  rv::detail::is_rv32_privileged<RiscV>, rv::detail::is_rv64a<RiscV>, rv::detail::is_rv64f<RiscV>, rv::detail::is_rv64d<RiscV>, rv::detail::is_rv64zba<RiscV>,
+  rv::detail::is_rv64zbb<RiscV>, rv::detail::is_rv32zbs<RiscV>, rv::detail::is_rvv<RiscV>
+);
+
+struct word_set {
+    std::string name;
+    std::vector<u32> words;
+};
+
+struct result {
+    std::string isa;
+    std::string word_set;
+    std::string_view operation;
+    usize words;
+    /// decodes (or formats, or translations) per second
+    summary rate;
+};
+
+struct options {
+    usize repetitions = 5;
+    std::chrono::nanoseconds min_time = std::chrono::milliseconds(100);
+};
+
+/// calls `fn` on every word in `words` for at least `min_time`, `repetitions` times over
+template<typename Fn>
+auto measure(std::span<const u32> words, options const& options, Fn&& fn) -> summary {
+    using clock = std::chrono::steady_clock;
+
+    auto rates = std::vector<double>{};
+
+    for (usize i = 0; i < options.repetitions; i++) {
+        u64 operations = 0;
+
+        const auto tp_0 = clock::now();
+        auto tp_1 = tp_0;
+        while (tp_1 - tp_0 < options.min_time) {
+            for (const auto word : words) {
+                fn(word);
+            }
+
+            operations += words.size();
+            tp_1 = clock::now();
+        }
+
+        rates.push_back(static_cast<double>(operations) * 1e9 / static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(tp_1 - tp_0).count()));
+    }
+
+    return summarize(std::move(rates));
+}
+
+/// goes through the isa's virtual interface like the processor does
+template<typename RiscV>
+void run_isa(std::string_view isa_name, rv::generic_instruction_set<RiscV> const& isa, std::span<const word_set> word_sets, options const& options, std::vector<result>& results) {
+    for (auto const& set : word_sets) {
+        const auto add_result = [&](std::string_view operation, usize words, summary rate) {
+            results.push_back({std::string(isa_name), set.name, operation, words, rate});
+        };
+
+        add_result("match", set.words.size(), measure(set.words, options, [&](u32 word) { do_not_optimize(isa.match(word)); }));
+        add_result("format", set.words.size(), measure(set.words, options, [&](u32 word) { do_not_optimize(isa.format(word, true)); }));
+
+        auto buffer = rv::format_buffer{};
+        add_result("format_to", set.words.size(), measure(set.words, options, [&](u32 word) {
+            buffer.clear();
+            isa.format_to(buffer, word, true);
+            do_not_optimize(buffer);
+        }));
+
+        auto cache = rv::disassembly_cache{};
+        add_result("cached", set.words.size(), measure(set.words, options, [&](u32 word) { do_not_optimize(cache.format(isa, word, true)); }));
+
+        // only the words that have a translator are translated, what the rate is for is the translators on their own
+        auto translated_words = std::vector<u32>{};
+        auto translators = std::vector<typename rv::instruction_properties<RiscV>::translator_type>{};
+        for (const auto word : set.words) {
+            if (const auto props = isa.match(word); props && props->translator != nullptr) {
+                translated_words.push_back(word);
+                translators.push_back(props->translator);
+            }
+        }
+
+        if (translated_words.empty()) {
+            continue;
+        }
+
+        usize index = 0;
+        add_result("translate", translated_words.size(), measure(translated_words, options, [&](u32 word) {
+                       do_not_optimize(translators[index](word));
+                       index = index + 1 == translators.size() ? 0 : index + 1;
+                   }));
+    }
+}
+
+auto make_word_sets(std::span<const workload> workloads) -> std::vector<word_set> {
+    // the loops in the workloads are short, this keeps the distribution from being a single workload's
+    constexpr auto max_words_per_workload = u64(1) << 18;
+
+    auto executed = word_set{"executed", {}};
+    for (auto const& workload : workloads) {
+        const auto words = record_words(workload, max_words_per_workload);
+        executed.words.insert(executed.words.end(), words.begin(), words.end());
+    }
+
+    auto compressed = word_set{"compressed", std::vector<u32>(1uz << 16)};
+    for (usize i = 0; i < compressed.words.size(); i++) {
+        compressed.words[i] = static_cast<u32>(i);
+    }
+
+    auto random = word_set{"random", std::vector<u32>(1uz << 18)};
+    auto engine = std::mt19937(0x5eed);
+    for (auto& word : random.words) {
+        word = static_cast<u32>(engine());
+    }
+
+    return {std::move(executed), std::move(compressed), std::move(random)};
+}
+
+void print_text(std::vector<result> const& results) {
+    fmt::print("{:<12} {:<12} {:<10} {:>8} {:>14} {:>8}\n", "isa", "words", "operation", "count", "M/s", "stdev");
+
+    for (auto const& result : results) {
+        fmt::print(
+          "{:<12} {:<12} {:<10} {:>8} {:>14.2f} {:>7.2f}%\n",  //
+          result.isa, result.word_set, result.operation, result.words, result.rate.median / 1e6, result.rate.stdev * 100. / result.rate.median
+        );
+    }
+}
+
+void print_json(std::vector<result> const& results) {
+    fmt::print("{{\n  \"results\": [\n");
+
+    for (usize i = 0; i < results.size(); i++) {
+        auto const& result = results[i];
+        fmt::print(
+          R"(    {{"isa": "{}", "words": "{}", "operation": "{}", "count": {}, "per_second": {{"median": {}, "min": {}, "max": {}, "stdev": {}}}}}{})",  //
+          result.isa, result.word_set, result.operation, result.words, result.rate.median, result.rate.min, result.rate.max, result.rate.stdev,
+          i + 1 == results.size() ? "\n" : ",\n"
+        );
+    }
+
+    fmt::print("  ]\n}}\n");
+}
+
+auto usage(const char* program_name) -> int {
+    fmt::print(stderr, "usage: {} [--json] [--repetitions N] [--min-time-ms N] [--filter SUBSTRING] [--image NAME=FILE.hex]...\n", program_name);
+    fmt::print(stderr, "the executed words come from the workloads of the bench and the given images, all of them run on RV64\n");
+    return 1;
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) -> int {
+    auto json = false;
+    auto options = ::options{};
+    auto filter = std::string_view{};
+    auto workloads = builtin_workloads();
+
+    for (int i = 1; i < argc; i++) {
+        const auto arg = std::string_view(argv[i]);
+        const auto next = [&]() -> std::optional<std::string_view> { return i + 1 < argc ? std::optional{std::string_view(argv[++i])} : std::nullopt; };
+
+        if (arg == "--json") {
+            json = true;
+        } else if (arg == "--repetitions") {
+            const auto value = next().and_then(parse_number);
+            if (!value || *value == 0) {
+                return usage(argv[0]);
+            }
+
+            options.repetitions = *value;
+        } else if (arg == "--min-time-ms") {
+            const auto value = next().and_then(parse_number);
+            if (!value) {
+                return usage(argv[0]);
+            }
+
+            options.min_time = std::chrono::milliseconds(*value);
+        } else if (arg == "--filter") {
+            const auto value = next();
+            if (!value) {
+                return usage(argv[0]);
+            }
+
+            filter = *value;
+        } else if (arg == "--image") {
+            const auto value = next();
+            const auto separator = value ? value->find('=') : std::string_view::npos;
+            if (separator == std::string_view::npos) {
+                return usage(argv[0]);
+            }
+
+            workloads.push_back({std::string(value->substr(0, separator)), {}, std::string(value->substr(separator + 1))});
+        } else {
+            return usage(argv[0]);
+        }
+    }
+
+    auto word_sets = make_word_sets(workloads);
+    std::erase_if(word_sets, [filter](auto const& set) { return set.name.find(filter) == std::string::npos; });
+
+    using rv32_type = rv::risc_v<u32>;
+    using rv64_type = rv::risc_v<u64>;
+
+    auto results = std::vector<result>{};
+    // G is IMAFD with Zicsr and Zifencei, B is Zba, Zbb and Zbs
+    run_isa("rv32gcbv", rv::is_rv32<rv32_type>, word_sets, options, results);
+    run_isa("rv32gbv", is_rv32_without_c<rv32_type>, word_sets, options, results);
+    run_isa("rv64gcbv", rv::is_rv64<rv64_type>, word_sets, options, results);
+    run_isa("rv64gbv", is_rv64_without_c<rv64_type>, word_sets, options, results);
+
+    if (json) {
+        print_json(results);
+    } else {
+        print_text(results);
+    }
+
+    return 0;
+}
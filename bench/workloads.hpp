@@ -0,0 +1,219 @@
+#pragma once
+
+#include <rv/rv.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <functional>
+#include <numeric>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace bench {
+
+using namespace rv::detail::assembler;
+using rv::alu_action;
+using rv::reg;
+
+constexpr usize memory_size = 0x10'0000;
+
+struct workload {
+    std::string name;
+    /// either a program that gets written to address 0 or an image file
+    std::vector<u32> program;
+    std::string image_path;
+};
+
+constexpr auto li(reg rd, i32 imm) -> u32 { return alu_i<alu_action::add, false>(rd, reg::zero, imm); }
+constexpr auto mv(reg rd, reg rs) -> u32 { return alu_i<alu_action::add, false>(rd, rs, 0); }
+constexpr auto addi(reg rd, reg rs, i32 imm) -> u32 { return alu_i<alu_action::add, false>(rd, rs, imm); }
+constexpr auto add(reg rd, reg rs_1, reg rs_2) -> u32 { return alu<alu_action::add>(rd, rs_1, rs_2); }
+constexpr auto bne(reg rs_1, reg rs_2, i32 offset) -> u32 { return branch<branch_type::not_equal>(rs_1, rs_2, offset); }
+constexpr auto halt() -> u32 { return jal(reg::zero, 0); }
+
+// clang-format off
+inline auto builtin_workloads() -> std::vector<workload> {
+    return {
+      {"fib_iterative", {
+        li(reg::a0, 0),                       // 0x00
+        li(reg::a1, 1),                       // 0x04
+        lui(reg::a2, 256),                    // 0x08: 1M iterations
+        add(reg::a3, reg::a0, reg::a1),       // 0x0C
+        mv(reg::a0, reg::a1),                 // 0x10
+        mv(reg::a1, reg::a3),                 // 0x14
+        addi(reg::a2, reg::a2, -1),           // 0x18
+        bne(reg::a2, reg::zero, -16),         // 0x1C: bnez a2, 0x0C
+        halt(),                               // 0x20
+      }, {}},
+
+      {"fib_recursive", {
+        lui(reg::sp, memory_size >> 12),                      // 0x00
+        li(reg::a0, 25),                                      // 0x04
+        jal(reg::ra, 8),                                      // 0x08: call fib
+        halt(),                                               // 0x0C
+        li(reg::t0, 2),                                       // 0x10: fib
+        branch<branch_type::less_than>(reg::a0, reg::t0, 56), // 0x14: blt a0, t0, 0x4C
+        addi(reg::sp, reg::sp, -24),                          // 0x18
+        store<ld_st_type::dword>(reg::ra, 0, reg::sp),        // 0x1C
+        store<ld_st_type::dword>(reg::a0, 8, reg::sp),        // 0x20
+        addi(reg::a0, reg::a0, -1),                           // 0x24
+        jal(reg::ra, -24),                                    // 0x28: call fib
+        store<ld_st_type::dword>(reg::a0, 16, reg::sp),       // 0x2C
+        load<ld_st_type::dword>(reg::a0, 8, reg::sp),         // 0x30
+        addi(reg::a0, reg::a0, -2),                           // 0x34
+        jal(reg::ra, -40),                                    // 0x38: call fib
+        load<ld_st_type::dword>(reg::t1, 16, reg::sp),        // 0x3C
+        add(reg::a0, reg::a0, reg::t1),                       // 0x40
+        load<ld_st_type::dword>(reg::ra, 0, reg::sp),         // 0x44
+        addi(reg::sp, reg::sp, 24),                           // 0x48
+        jalr(reg::zero, reg::ra, 0),                          // 0x4C: ret
+      }, {}},
+
+      {"factorial", {
+        lui(reg::s0, 25),                     // 0x00: ~100k repetitions
+        li(reg::a0, 1),                       // 0x04
+        li(reg::a1, 20),                      // 0x08
+        alu<alu_action::mul>(reg::a0, reg::a0, reg::a1),  // 0x0C
+        addi(reg::a1, reg::a1, -1),           // 0x10
+        bne(reg::a1, reg::zero, -8),          // 0x14: bnez a1, 0x0C
+        addi(reg::s0, reg::s0, -1),           // 0x18
+        bne(reg::s0, reg::zero, -24),         // 0x1C: bnez s0, 0x04
+        halt(),                               // 0x20
+      }, {}},
+
+      {"lr_sc", {
+        lui(reg::a1, 1),                                    // 0x00: counter at 0x1000
+        store<ld_st_type::dword>(reg::zero, 0, reg::a1),    // 0x04
+        lui(reg::a2, 256),                                  // 0x08: 1M increments
+        load_reserved<true>(reg::t0, reg::a1),              // 0x0C
+        addi(reg::t0, reg::t0, 1),                          // 0x10
+        store_conditional<true>(reg::t1, reg::t0, reg::a1), // 0x14
+        bne(reg::t1, reg::zero, -12),                       // 0x18: retry
+        addi(reg::a2, reg::a2, -1),                         // 0x1C
+        bne(reg::a2, reg::zero, -20),                       // 0x20: bnez a2, 0x0C
+        halt(),                                             // 0x24
+      }, {}},
+
+      {"memcpy", {
+        li(reg::s0, 256),                                   // 0x00: repetitions
+        lui(reg::a0, 16),                                   // 0x04: from 0x10000
+        lui(reg::a1, 32),                                   // 0x08: to 0x20000
+        lui(reg::a2, 16),                                   // 0x0C: 64 KiB
+        add(reg::a2, reg::a2, reg::a0),                     // 0x10
+        load<ld_st_type::dword>(reg::t0, 0, reg::a0),       // 0x14
+        load<ld_st_type::dword>(reg::t1, 8, reg::a0),       // 0x18
+        load<ld_st_type::dword>(reg::t2, 16, reg::a0),      // 0x1C
+        load<ld_st_type::dword>(reg::t3, 24, reg::a0),      // 0x20
+        store<ld_st_type::dword>(reg::t0, 0, reg::a1),      // 0x24
+        store<ld_st_type::dword>(reg::t1, 8, reg::a1),      // 0x28
+        store<ld_st_type::dword>(reg::t2, 16, reg::a1),     // 0x2C
+        store<ld_st_type::dword>(reg::t3, 24, reg::a1),     // 0x30
+        addi(reg::a0, reg::a0, 32),                         // 0x34
+        addi(reg::a1, reg::a1, 32),                         // 0x38
+        bne(reg::a0, reg::a2, -40),                         // 0x3C: bne a0, a2, 0x14
+        addi(reg::s0, reg::s0, -1),                         // 0x40
+        bne(reg::s0, reg::zero, -64),                       // 0x44: bnez s0, 0x04
+        halt(),                                             // 0x48
+      }, {}},
+    };
+}
+// clang-format on
+
+template<typename T>
+void do_not_optimize(T const& value) {
+    asm volatile("" : : "r"(&value) : "memory");
+}
+
+template<typename RiscV>
+void load_workload(RiscV& risc_v, workload const& workload) {
+    if (!workload.image_path.empty()) {
+        risc_v.load(workload.image_path, rv::infmt_ihex_tag{});
+        return;
+    }
+
+    for (usize i = 0; i < workload.program.size(); i++) {
+        risc_v.m_memory.template write<u32>(i * 4, workload.program[i]);
+    }
+}
+
+/// runs until the program halts or `max_instructions` get executed, returns the amount executed
+template<typename RiscV>
+auto run_to_completion(RiscV& risc_v, u64 max_instructions) -> u64 {
+    constexpr auto chunk = 1uz << 20;
+
+    u64 executed = 0;
+    while (executed < max_instructions) {
+        const auto to_execute = std::min<u64>(chunk, max_instructions - executed);
+        const auto chunk_executed = risc_v.run(to_execute);
+        executed += chunk_executed;
+
+        if (chunk_executed != to_execute) {
+            break;
+        }
+    }
+
+    return executed;
+}
+
+/// collects the words of the executed instructions, for timing the decoder on its own
+struct word_recorder : rv::null_observer {
+    static constexpr usize max_words = 1uz << 22;
+
+    template<typename RiscV>
+    void on_execute(RiscV const& self, usize) {
+        if (m_words.size() < max_words) {
+            m_words.push_back(self.m_memory.template read<u32>(self.m_program_counter));
+        }
+    }
+
+    std::vector<u32> m_words{};
+};
+
+/// the words of the first `max_instructions` instructions a workload executes on RV64
+inline auto record_words(workload const& workload, u64 max_instructions = word_recorder::max_words) -> std::vector<u32> {
+    using recording_risc_v_type = rv::risc_v<u64, std::allocator<u8>, word_recorder>;
+
+    auto risc_v = recording_risc_v_type(rv::is_rv64<recording_risc_v_type>, memory_size);
+    load_workload(risc_v, workload);
+    run_to_completion(risc_v, std::min<u64>(max_instructions, word_recorder::max_words));
+
+    return std::move(risc_v.m_observer.m_words);
+}
+
+struct summary {
+    double median;
+    double min;
+    double max;
+    double stdev;
+};
+
+inline auto summarize(std::vector<double> values) -> summary {
+    std::ranges::sort(values);
+
+    const auto n = static_cast<double>(values.size());
+    const auto mean = std::reduce(values.begin(), values.end(), 0.) / n;
+    const auto variance = std::transform_reduce(values.begin(), values.end(), 0., std::plus{}, [mean](double v) { return (v - mean) * (v - mean); }) / n;
+    const auto middle = values.size() / 2;
+
+    return {
+      .median = values.size() % 2 == 1 ? values[middle] : (values[middle - 1] + values[middle]) / 2.,
+      .min = values.front(),
+      .max = values.back(),
+      .stdev = std::sqrt(variance),
+    };
+}
+
+inline auto parse_number(std::string_view str) -> std::optional<u64> {
+    u64 ret = 0;
+    const auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), ret);
+    if (ec != std::errc{} || ptr != str.data() + str.size()) {
+        return std::nullopt;
+    }
+
+    return ret;
+}
+
+}  // namespace bench
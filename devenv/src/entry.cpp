@@ -27,8 +27,33 @@ void load_data() {
     _start();
 }
 
+// where the emulator maps the CLINT
+volatile unsigned int* const clint_msip = reinterpret_cast<volatile unsigned int*>(0x0200'0000);
+volatile unsigned long long* const clint_mtimecmp = reinterpret_cast<volatile unsigned long long*>(0x0200'4000);
+
 void trap_handler() {
-    //
+    unsigned long cause;
+    unsigned long epc;
+    asm volatile("csrr %0, mcause" : "=r"(cause));
+    asm volatile("csrr %0, mepc" : "=r"(epc));
+
+    const auto is_interrupt = static_cast<long>(cause) < 0;
+    const auto code = cause & 0xFF;
+
+    if (!is_interrupt) {
+        // ecall and ebreak, `mret` would otherwise come back to them
+        const auto is_compressed = (*reinterpret_cast<const unsigned short*>(epc) & 0b11) != 0b11;
+        epc += is_compressed ? 2 : 4;
+        asm volatile("csrw mepc, %0" ::"r"(epc));
+        return;
+    }
+
+    if (code == 3) {
+        *clint_msip = 0;
+    } else if (code == 7) {
+        // disarmed until whoever armed it arms it again
+        *clint_mtimecmp = ~0ull;
+    }
 }
 
 }  // namespace rv::detail
@@ -6,6 +6,27 @@ extern uint8_t game_of_life[16][8];
 extern auto neighbours_inner(ptrdiff_t y, ptrdiff_t x, ptrdiff_t o_y, ptrdiff_t o_x) -> bool;
 extern auto neighbours(ptrdiff_t y, ptrdiff_t x) -> size_t;
 extern void step_gol();
+extern void draw_gol();
+
+/// the control registers of the emulator's framebuffer, which shows `screen`
+struct framebuffer_registers {
+    uint64_t address;
+    uint32_t width;
+    uint32_t height;
+    uint32_t format;
+};
+
+inline auto& framebuffer = *reinterpret_cast<volatile framebuffer_registers*>(0x1000'1000);
+
+alignas(8) uint8_t screen[16][8]{};
+
+void draw_gol() {
+    for (ptrdiff_t y = 0; y < std::size(game_of_life); y++) {
+        for (ptrdiff_t x = 0; x < std::size(game_of_life[0]); x++) {
+            screen[y][x] = (game_of_life[y][x] & 1) == 1 ? 0xFF : 0x00;
+        }
+    }
+}
 
 void step_gol() {
     for (ptrdiff_t y = 0; y < std::size(game_of_life); y++) {
@@ -99,8 +120,15 @@ extern "C" int main() {
         }
     }*/
 
+    // gray8
+    framebuffer.address = reinterpret_cast<uintptr_t>(&screen[0][0]);
+    framebuffer.format = 0;
+    framebuffer.width = std::size(screen[0]);
+    framebuffer.height = std::size(screen);
+
     for (int i = 0; i < 16; i++) {
         step_gol();
+        draw_gol();
     }
 
     return 0;
@@ -66,8 +66,9 @@ void assert_eq(T val, T expected) {
 }
 
 int64_t read_cyc() {
-    /*for (;;) {
-        int64_t upper, lower, upper_again;
+#if __riscv_xlen == 32
+    for (;;) {
+        uint32_t upper, lower, upper_again;
 
         asm volatile(
           "rdcycleh %[upper]\n"
@@ -80,15 +81,16 @@ int64_t read_cyc() {
           :
         );
 
+        // read again if the lower half wrapped around in between
         if (upper == upper_again) {
-            return upper << 32l | upper_again;
+            return static_cast<int64_t>(static_cast<uint64_t>(upper) << 32 | lower);
         }
-    }*/
-
-    // int64_t cyc_cnt;
-    // asm volatile("rdcycle %[cyc_cnt]" : [cyc_cnt] "=r"(cyc_cnt));
-    // return cyc_cnt;
-    return 0x0E'0F'0A'0C'0D'0A'0B'0All;
+    }
+#else
+    int64_t cyc_cnt;
+    asm volatile("rdcycle %[cyc_cnt]" : [cyc_cnt] "=r"(cyc_cnt));
+    return cyc_cnt;
+#endif
 }
 
 extern "C" int main() {
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <stuff/core.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <ostream>
+#include <vector>
+
+namespace util {
+
+/// A histogram of unsigned values with logarithmically sized buckets, in the manner of HdrHistogram.
+/// Values below `2^SubBucketBits` get a bucket each, every power of two above that is split into `2^(SubBucketBits - 1)` equally sized
+/// buckets, so that the value a bucket stands for is within `2^-(SubBucketBits - 1)` of any value that got recorded into it.
+/// Recording is a constant time increment, percentiles are exact up to the bucket a percentile falls into.
+/// There can be one thread recording values while others read, like `rv::execution_statistics`. Histograms of the same precision can be
+/// merged, e.g. to combine the histograms of several processors.
+template<usize SubBucketBits = 7>
+    requires(SubBucketBits >= 1 && SubBucketBits < 32)
+struct log_histogram {
+    static constexpr usize sub_bucket_count = 1uz << SubBucketBits;
+    static constexpr usize half_sub_bucket_count = sub_bucket_count / 2;
+    static constexpr usize num_buckets = (64 - SubBucketBits + 2) * half_sub_bucket_count;
+
+    log_histogram()
+        : m_counts(num_buckets, 0) {}
+
+    static constexpr auto bucket_of(u64 value) -> usize {
+        if (value < sub_bucket_count) {
+            return static_cast<usize>(value);
+        }
+
+        const auto magnitude = static_cast<usize>(std::bit_width(value)) - SubBucketBits;
+        return magnitude * half_sub_bucket_count + static_cast<usize>(value >> magnitude);
+    }
+
+    /// The smallest value that goes into `bucket`.
+    static constexpr auto bucket_lower_bound(usize bucket) -> u64 {
+        if (bucket < sub_bucket_count) {
+            return bucket;
+        }
+
+        const auto magnitude = bucket / half_sub_bucket_count - 1;
+        const auto sub_bucket = bucket % half_sub_bucket_count + half_sub_bucket_count;
+        return static_cast<u64>(sub_bucket) << magnitude;
+    }
+
+    /// The largest value that goes into `bucket`.
+    static constexpr auto bucket_upper_bound(usize bucket) -> u64 {
+        return bucket + 1 == num_buckets ? std::numeric_limits<u64>::max() : bucket_lower_bound(bucket + 1) - 1;
+    }
+
+    void record(u64 value, u64 count = 1) {
+        add(m_counts[bucket_of(value)], count);
+        add(m_total_count, count);
+        add(m_sum, value * count);
+
+        if (value < load(m_min)) {
+            store(m_min, value);
+        }
+
+        if (value > load(m_max)) {
+            store(m_max, value);
+        }
+    }
+
+    /// Adds the values recorded into `other` to this one, both are to be left alone by their recording threads in the meantime.
+    void merge(log_histogram const& other) {
+        for (usize i = 0; i < num_buckets; i++) {
+            add(m_counts[i], other.bucket_count(i));
+        }
+
+        add(m_total_count, other.count());
+        add(m_sum, load(other.m_sum));
+        store(m_min, std::min(load(m_min), load(other.m_min)));
+        store(m_max, std::max(load(m_max), load(other.m_max)));
+    }
+
+    void reset() {
+        for (auto& count : m_counts) {
+            store(count, 0);
+        }
+
+        store(m_total_count, 0);
+        store(m_sum, 0);
+        store(m_min, std::numeric_limits<u64>::max());
+        store(m_max, 0);
+    }
+
+    auto bucket_count(usize bucket) const -> u64 { return load(m_counts[bucket]); }
+
+    auto count() const -> u64 { return load(m_total_count); }
+    auto min() const -> u64 { return count() == 0 ? 0 : load(m_min); }
+    auto max() const -> u64 { return load(m_max); }
+
+    /// Exact as long as the sum of the recorded values fits in 64 bits.
+    auto mean() const -> double {
+        const auto total = count();
+        return total == 0 ? 0. : static_cast<double>(load(m_sum)) / static_cast<double>(total);
+    }
+
+    /// The largest value that is equivalent (i.e. shares a bucket) with the value at or below which `percentile` percent of the recorded
+    /// values are, clamped to the largest recorded value.
+    auto percentile(double percentile) const -> u64 {
+        const auto total = count();
+        if (total == 0) {
+            return 0;
+        }
+
+        const auto fraction = std::clamp(percentile, 0., 100.) / 100.;
+        const auto target = std::max<u64>(static_cast<u64>(std::ceil(fraction * static_cast<double>(total))), 1);
+
+        u64 seen = 0;
+        for (usize i = 0; i < num_buckets; i++) {
+            seen += bucket_count(i);
+
+            if (seen >= target) {
+                return std::min(bucket_upper_bound(i), max());
+            }
+        }
+
+        return max();
+    }
+
+    /// Writes the summary and the non-empty buckets.
+    void dump_json(std::ostream& os) const {
+        os << fmt::format(
+          R"({{"count": {}, "min": {}, "max": {}, "mean": {}, "p50": {}, "p95": {}, "p99": {}, "p999": {}, "buckets": [)",  //
+          count(), min(), max(), mean(), percentile(50.), percentile(95.), percentile(99.), percentile(99.9)
+        );
+
+        auto first = true;
+        for (usize i = 0; i < num_buckets; i++) {
+            if (const auto bucket = bucket_count(i); bucket != 0) {
+                os << fmt::format(R"({}{{"from": {}, "to": {}, "count": {}}})", first ? "" : ", ", bucket_lower_bound(i), bucket_upper_bound(i), bucket);
+                first = false;
+            }
+        }
+
+        os << "]}";
+    }
+
+private:
+    std::vector<u64> m_counts;
+    u64 m_total_count = 0;
+    u64 m_sum = 0;
+    u64 m_min = std::numeric_limits<u64>::max();
+    u64 m_max = 0;
+
+    // a recording thread is the only one writing, this lets others read while it records without locked increments
+
+    static auto load(u64 const& value) -> u64 { return std::atomic_ref<u64>(const_cast<u64&>(value)).load(std::memory_order_relaxed); }
+    static void store(u64& value, u64 new_value) { std::atomic_ref<u64>(value).store(new_value, std::memory_order_relaxed); }
+    static void add(u64& value, u64 amount) { store(value, load(value) + amount); }
+};
+
+static_assert(log_histogram<7>::bucket_of(127) == 127);
+static_assert(log_histogram<7>::bucket_of(128) == 128);
+static_assert(log_histogram<7>::bucket_of(130) == 129);
+static_assert(log_histogram<7>::bucket_lower_bound(log_histogram<7>::bucket_of(1'000'000)) <= 1'000'000);
+static_assert(log_histogram<7>::bucket_upper_bound(log_histogram<7>::bucket_of(1'000'000)) >= 1'000'000);
+static_assert(log_histogram<7>::bucket_of(std::numeric_limits<u64>::max()) + 1 == log_histogram<7>::num_buckets);
+
+}  // namespace util
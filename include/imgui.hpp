@@ -7,6 +7,7 @@
 
 #include <optional>
 #include <span>
+#include <string_view>
 
 namespace imgui {
 
@@ -134,6 +135,10 @@ inline void text(const char* str) {
     ImGui::TextUnformatted(str);
 }
 
+inline void text(std::string_view str) {
+    ImGui::TextUnformatted(str.data(), str.data() + str.size());
+}
+
 template<typename... Ts>
 inline void text(fmt::format_string<Ts...> fmt, Ts&&... args) {
     ImGui::TextUnformatted(fmt::format(std::move(fmt), std::forward<Ts>(args)...).c_str());
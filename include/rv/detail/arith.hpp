@@ -2,7 +2,13 @@
 
 #include <stuff/core.hpp>
 
+#include <compare>
 #include <limits>
+#include <utility>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
 
 namespace rv::arith {
 
@@ -45,19 +51,22 @@ static_assert(sign_bit<u32>(-1) == 1);
 static_assert(sign_bit<u32>(-2) == 1);
 static_assert(sign_bit<u32>(0x8000'0000) == 1);
 
-template<std::unsigned_integral T, bool UseNative = false>
-constexpr auto signed_compare(T lhs, T rhs) -> std::strong_ordering {
-    if constexpr (UseNative) {
-        using U = std::make_signed_t<T>;
-        return (U)lhs <=> (U)rhs;
-    }
+/*
+ * Host arithmetic
+ * `signed_compare`, `arithmetic_shr` and `multiply` come in two versions. The portable ones only use unsigned arithmetic and work everywhere
+ * including constant evaluation, the host ones use signed types, `__int128` and `mulx` so that they compile to a single host instruction.
+ * `native_arithmetic` picks the host versions for x86-64 GCC and Clang unless `RV_PORTABLE_ARITHMETIC` is defined, the portable ones are
+ * still used when constant evaluating. The two get checked against each other at the bottom of this file.
+ */
 
-    /* sign: ff tf ft tt
-     *  >  : >  <  >  <
-     *  <  : <  <  >  >
-     *  == : == <  >  ==
-     */
+#if !defined(RV_PORTABLE_ARITHMETIC) && (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__) && defined(__SIZEOF_INT128__)
+inline constexpr bool native_arithmetic = true;
+#else
+inline constexpr bool native_arithmetic = false;
+#endif
 
+template<std::unsigned_integral T>
+constexpr auto portable_signed_compare(T lhs, T rhs) -> std::strong_ordering {
     const auto lhs_sgn = sign_bit(lhs);
     const auto rhs_sgn = sign_bit(rhs);
 
@@ -69,63 +78,134 @@ constexpr auto signed_compare(T lhs, T rhs) -> std::strong_ordering {
         return std::strong_ordering::greater;
     }
 
-    const auto base = (lhs << 1) <=> (rhs << 1);
-
-    if (base == std::strong_ordering::equivalent) {
-        return base;
-    }
+    // two's complement numbers of the same sign are in the same order as their bits
+    return lhs <=> rhs;
+}
 
-    const auto invert = lhs_sgn && rhs_sgn;
+template<std::unsigned_integral T>
+constexpr auto host_signed_compare(T lhs, T rhs) -> std::strong_ordering {
+    using S = std::make_signed_t<T>;
+    return static_cast<S>(lhs) <=> static_cast<S>(rhs);
+}
 
-    if (!invert) {
-        return base;
+template<std::unsigned_integral T, bool UseNative = native_arithmetic>
+constexpr auto signed_compare(T lhs, T rhs) -> std::strong_ordering {
+    if constexpr (UseNative) {
+        if !consteval {
+            return host_signed_compare(lhs, rhs);
+        }
     }
 
-    if (base == std::strong_ordering::less) {
-        return std::strong_ordering::greater;
-    }
+    return portable_signed_compare(lhs, rhs);
+}
 
-    if (base == std::strong_ordering::greater) {
-        return std::strong_ordering::less;
-    }
+/// `amt` has to be less than the width of `T`
+template<std::unsigned_integral T>
+constexpr auto portable_arithmetic_shr(T v, T amt) -> T {
+    // the upper `amt` bits
+    const T mask = static_cast<T>(~((T)-1 >> amt));
+    const auto sgn = sign_bit(v);
+    return static_cast<T>((v >> amt) | (mask * sgn));
+}
 
-    std::unreachable();
+template<std::unsigned_integral T>
+constexpr auto host_arithmetic_shr(T v, T amt) -> T {
+    using S = std::make_signed_t<T>;
+    return static_cast<T>(static_cast<S>(v) >> amt);
 }
 
-template<std::unsigned_integral T, bool UseNative = false>
+template<std::unsigned_integral T, bool UseNative = native_arithmetic>
 constexpr auto arithmetic_shr(T v, T amt) -> T {
     if constexpr (UseNative) {
-        using U = std::make_signed_t<T>;
-        return (T)((U)v >> (U)amt);
+        if !consteval {
+            return host_arithmetic_shr(v, amt);
+        }
     }
 
-    const T mask = (T)-1 >> amt << amt;
-    const auto sgn = sign_bit(v);
-    return (v >> amt) | (mask * sgn);
+    return portable_arithmetic_shr(v, amt);
 }
 
 static_assert(arithmetic_shr<u32>(-8, 2) == (u32)-2);
 static_assert(arithmetic_shr<u32>(-4, 2) == (u32)-1);
 static_assert(arithmetic_shr<u32>(-2, 2) == (u32)-1);
 static_assert(arithmetic_shr<u32>(-1, 2) == (u32)-1);
+static_assert(arithmetic_shr<u32>(0x8000'0010, 4) == 0xF800'0001);
 
-static_assert(arithmetic_shr<u32, true>(-8, 2) == (u32)-2);
-static_assert(arithmetic_shr<u32, true>(-4, 2) == (u32)-1);
-static_assert(arithmetic_shr<u32, true>(-2, 2) == (u32)-1);
-static_assert(arithmetic_shr<u32, true>(-1, 2) == (u32)-1);
+static_assert(signed_compare<u32>(-1, -2) == std::strong_ordering::greater);
+static_assert(signed_compare<u32>(-2, 1) == std::strong_ordering::less);
 
-template<std::unsigned_integral T, bool ExtendLhs = false, bool ExtendRhs = false, bool UseNative = true>
-constexpr auto multiply(T lhs, T rhs) -> std::pair<T, T> {
+/// Returns the upper and the lower half of the double-width product, `ExtendLhs` and `ExtendRhs` make the operands signed.
+template<std::unsigned_integral T, bool ExtendLhs = false, bool ExtendRhs = false>
+constexpr auto portable_multiply(T lhs, T rhs) -> std::pair<T, T> {
     constexpr int base_bits = sizeof(T) * 8;
     using U = stf::nuint<base_bits * 2uz>;
 
     const auto x = ExtendLhs ? sext<U, base_bits>(static_cast<U>(lhs)) : static_cast<U>(lhs);
     const auto y = ExtendRhs ? sext<U, base_bits>(static_cast<U>(rhs)) : static_cast<U>(rhs);
-    const auto res = static_cast<U>(x * y);
+    // at least as wide as `unsigned` so that narrow operands don't get promoted to `int` and overflow
+    using P = std::common_type_t<U, unsigned>;
+    const auto res = static_cast<U>(static_cast<P>(x) * static_cast<P>(y));
 
     return {static_cast<T>(res >> (sizeof(T) * 8)), static_cast<T>(res)};
 }
 
+template<std::unsigned_integral T, bool ExtendLhs = false, bool ExtendRhs = false>
+constexpr auto host_multiply(T lhs, T rhs) -> std::pair<T, T> {
+    constexpr auto bits = std::numeric_limits<T>::digits;
+    using S = std::make_signed_t<T>;
+
+    if constexpr (bits <= 32) {
+        // the signed operands get sign extended by going through the signed type
+        const auto x = ExtendLhs ? static_cast<u64>(static_cast<i64>(static_cast<S>(lhs))) : static_cast<u64>(lhs);
+        const auto y = ExtendRhs ? static_cast<u64>(static_cast<i64>(static_cast<S>(rhs))) : static_cast<u64>(rhs);
+        const auto res = x * y;
+
+        return {static_cast<T>(res >> bits), static_cast<T>(res)};
+    } else {
+#if defined(__SIZEOF_INT128__)
+        auto high = T(0);
+        auto low = T(0);
+
+#if defined(__BMI2__)
+        if !consteval {
+            unsigned long long high_half;
+            low = static_cast<T>(_mulx_u64(lhs, rhs, &high_half));
+            high = static_cast<T>(high_half);
+        } else
+#endif
+        {
+            const auto res = static_cast<unsigned __int128>(lhs) * rhs;
+            high = static_cast<T>(res >> bits);
+            low = static_cast<T>(res);
+        }
+
+        // the product of the unsigned operands is off by 2^64 times the other operand for each negative one
+        if constexpr (ExtendLhs) {
+            high -= static_cast<S>(lhs) < 0 ? rhs : 0;
+        }
+
+        if constexpr (ExtendRhs) {
+            high -= static_cast<S>(rhs) < 0 ? lhs : 0;
+        }
+
+        return {high, low};
+#else
+        return portable_multiply<T, ExtendLhs, ExtendRhs>(lhs, rhs);
+#endif
+    }
+}
+
+template<std::unsigned_integral T, bool ExtendLhs = false, bool ExtendRhs = false, bool UseNative = native_arithmetic>
+constexpr auto multiply(T lhs, T rhs) -> std::pair<T, T> {
+    if constexpr (UseNative) {
+        if !consteval {
+            return host_multiply<T, ExtendLhs, ExtendRhs>(lhs, rhs);
+        }
+    }
+
+    return portable_multiply<T, ExtendLhs, ExtendRhs>(lhs, rhs);
+}
+
 static_assert(multiply<u64, false, false>(1, 2).first == 0);
 static_assert(multiply<u64, false, false>(1, 2).second == 2);
 static_assert(multiply<u64, false, false>(3, 0x7FFF'FFFF'FFFF'FFFFull).first == 1);
@@ -140,4 +220,44 @@ static_assert(multiply<u64, true, true>(1, -2).second == (u64)-2);
 static_assert(multiply<u64, true, true>(-1, -2).second == 2);
 static_assert(multiply<u64, true, true>(3, 0x7FFF'FFFF'FFFF'FFFFull).first == 1);
 
+namespace detail {
+
+/// Whether the host and the portable versions agree on every pair of a set of edge cases, every shift amount and every signedness.
+/// Constant evaluation only sees the paths of the host versions that don't need intrinsics, tests/arith.cpp calls this at runtime too.
+template<std::unsigned_integral T>
+constexpr auto host_matches_portable() -> bool {
+    constexpr auto max = std::numeric_limits<T>::max();
+    constexpr auto bits = static_cast<T>(std::numeric_limits<T>::digits);
+    constexpr T values[]{0, 1, 2, 3, 0x5A, static_cast<T>(max / 2 - 1), static_cast<T>(max / 2), static_cast<T>(max / 2 + 1), static_cast<T>(max / 2 + 2), static_cast<T>(max - 1), max};
+
+    const auto multiplies_match = [](T lhs, T rhs) {
+        return host_multiply<T, false, false>(lhs, rhs) == portable_multiply<T, false, false>(lhs, rhs)  //
+            && host_multiply<T, true, false>(lhs, rhs) == portable_multiply<T, true, false>(lhs, rhs)    //
+            && host_multiply<T, true, true>(lhs, rhs) == portable_multiply<T, true, true>(lhs, rhs);
+    };
+
+    for (const auto lhs : values) {
+        for (const auto rhs : values) {
+            if (host_signed_compare(lhs, rhs) != portable_signed_compare(lhs, rhs) || !multiplies_match(lhs, rhs)) {
+                return false;
+            }
+        }
+
+        for (auto amt = T(0); amt < bits; amt++) {
+            if (host_arithmetic_shr(lhs, amt) != portable_arithmetic_shr(lhs, amt)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+static_assert(host_matches_portable<u8>());
+static_assert(host_matches_portable<u16>());
+static_assert(host_matches_portable<u32>());
+static_assert(host_matches_portable<u64>());
+
+}  // namespace detail
+
 }  // namespace rv::arith
@@ -0,0 +1,394 @@
+#pragma once
+
+#include <rv/detail/observer.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <ostream>
+#include <tuple>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+namespace rv {
+
+/*
+ * Direction predictors for conditional branches, each one has
+ *  `predict(address, target) -> bool` and
+ *  `update(address, target, taken)`, called after every `predict` with the outcome
+ */
+
+/// Backward taken, forward not taken. Loops are predicted to loop.
+struct static_btfn_predictor {
+    constexpr auto predict(u64 address, u64 target) const -> bool { return target < address; }
+    constexpr void update(u64, u64, bool) {}
+};
+
+namespace detail {
+
+/// A saturating counter that predicts taken in its upper half.
+template<u8 Bits>
+struct saturating_counter {
+    static constexpr u8 max = (1u << Bits) - 1;
+
+    u8 value = max / 2;
+
+    constexpr auto taken() const -> bool { return value > max / 2; }
+    constexpr void update(bool taken) { value = taken ? std::min<u8>(value + 1, max) : std::max<u8>(value, 1) - 1; }
+};
+
+/// Branches are at least 2 byte aligned, the lowest bit of their addresses tells them apart only for misaligned ones.
+constexpr auto branch_index(u64 address, usize bits) -> usize {
+    return static_cast<usize>((address >> 1) & ((u64(1) << bits) - 1));
+}
+
+}  // namespace detail
+
+/// A table of 2-bit counters indexed by the address of the branch.
+struct bimodal_predictor {
+    explicit bimodal_predictor(usize index_bits = 12)
+        : m_index_bits(index_bits)
+        , m_counters(1uz << index_bits) {}
+
+    auto predict(u64 address, u64) const -> bool { return m_counters[detail::branch_index(address, m_index_bits)].taken(); }
+    void update(u64 address, u64, bool taken) { m_counters[detail::branch_index(address, m_index_bits)].update(taken); }
+
+private:
+    usize m_index_bits;
+    std::vector<detail::saturating_counter<2>> m_counters;
+};
+
+/// A table of 2-bit counters indexed by the address of the branch xor'd with the outcomes of the last branches.
+struct gshare_predictor {
+    explicit gshare_predictor(usize index_bits = 12, usize history_bits = 12)
+        : m_index_bits(index_bits)
+        , m_history_mask((u64(1) << std::min<usize>(history_bits, 63)) - 1)
+        , m_counters(1uz << index_bits) {}
+
+    auto predict(u64 address, u64) const -> bool { return m_counters[index(address)].taken(); }
+
+    void update(u64 address, u64, bool taken) {
+        m_counters[index(address)].update(taken);
+        m_history = ((m_history << 1) | (taken ? 1 : 0)) & m_history_mask;
+    }
+
+private:
+    usize m_index_bits;
+    u64 m_history_mask;
+    u64 m_history = 0;
+    std::vector<detail::saturating_counter<2>> m_counters;
+
+    auto index(u64 address) const -> usize { return detail::branch_index(address ^ (m_history << 1), m_index_bits); }
+};
+
+/// A small TAGE: a bimodal base predictor and four tagged tables that are indexed with geometrically longer global histories.
+/// The longest history with a matching tag provides the prediction. On a misprediction an entry is allocated in a table with a longer
+/// history than the provider's, if one of them has an entry that hasn't been useful.
+struct tage_lite_predictor {
+    static constexpr usize num_tables = 4;
+    static constexpr std::array<usize, num_tables> history_lengths{5, 11, 23, 47};
+    static constexpr usize tag_bits = 9;
+
+    explicit tage_lite_predictor(usize index_bits = 10)
+        : m_index_bits(index_bits)
+        , m_base(index_bits + 2) {
+        for (auto& table : m_tables) {
+            table.resize(1uz << index_bits);
+        }
+    }
+
+    auto predict(u64 address, u64 target) const -> bool {
+        const auto provider = lookup(address).first;
+        return provider ? m_tables[*provider][index(address, *provider)].counter.taken() : m_base.predict(address, target);
+    }
+
+    void update(u64 address, u64 target, bool taken) {
+        const auto [provider, alternate] = lookup(address);
+        const auto base_prediction = m_base.predict(address, target);
+        const auto alternate_prediction = alternate ? m_tables[*alternate][index(address, *alternate)].counter.taken() : base_prediction;
+        const auto prediction = provider ? m_tables[*provider][index(address, *provider)].counter.taken() : base_prediction;
+
+        if (provider) {
+            auto& entry = m_tables[*provider][index(address, *provider)];
+            entry.counter.update(taken);
+
+            // an entry is useful if it was right where the prediction it overrode would have been wrong
+            if (prediction != alternate_prediction) {
+                entry.useful.update(prediction == taken);
+            }
+        } else {
+            m_base.update(address, target, taken);
+        }
+
+        if (prediction != taken) {
+            allocate(address, provider ? *provider + 1 : 0, taken);
+        }
+
+        m_history = (m_history << 1) | (taken ? 1 : 0);
+    }
+
+private:
+    struct entry {
+        u16 tag = 0;
+        bool valid = false;
+        detail::saturating_counter<3> counter{};
+        detail::saturating_counter<2> useful{0};
+    };
+
+    usize m_index_bits;
+    bimodal_predictor m_base;
+    std::array<std::vector<entry>, num_tables> m_tables{};
+    u64 m_history = 0;
+    /// round-robin start of the allocation search, so that tables with shorter histories don't take all allocations
+    usize m_allocation_tick = 0;
+
+    /// the global history of `table`'s length folded into `bits` bits
+    auto folded_history(usize table, usize bits) const -> u64 {
+        const auto length = history_lengths[table];
+        auto history = length >= 64 ? m_history : m_history & ((u64(1) << length) - 1);
+
+        u64 ret = 0;
+        for (; history != 0; history >>= bits) {
+            ret ^= history & ((u64(1) << bits) - 1);
+        }
+
+        return ret;
+    }
+
+    auto index(u64 address, usize table) const -> usize {
+        return detail::branch_index(address ^ (address >> (m_index_bits + 1)) ^ (folded_history(table, m_index_bits) << 1), m_index_bits);
+    }
+
+    auto tag(u64 address, usize table) const -> u16 {
+        return static_cast<u16>(((address >> 1) ^ folded_history(table, tag_bits) ^ (folded_history(table, tag_bits - 1) << 1)) & ((1u << tag_bits) - 1));
+    }
+
+    auto matches(u64 address, usize table) const -> bool {
+        auto const& entry = m_tables[table][index(address, table)];
+        return entry.valid && entry.tag == tag(address, table);
+    }
+
+    /// the tables with the longest and second longest histories that have a matching entry
+    auto lookup(u64 address) const -> std::pair<std::optional<usize>, std::optional<usize>> {
+        auto provider = std::optional<usize>{};
+        auto alternate = std::optional<usize>{};
+
+        for (usize i = num_tables; i-- != 0;) {
+            if (!matches(address, i)) {
+                continue;
+            }
+
+            if (!provider) {
+                provider = i;
+            } else {
+                alternate = i;
+                break;
+            }
+        }
+
+        return {provider, alternate};
+    }
+
+    void allocate(u64 address, usize first_table, bool taken) {
+        if (first_table >= num_tables) {
+            return;
+        }
+
+        const auto num_candidates = num_tables - first_table;
+        ++m_allocation_tick;
+
+        for (usize i = 0; i < num_candidates; i++) {
+            const auto table = first_table + (m_allocation_tick + i) % num_candidates;
+            auto& entry = m_tables[table][index(address, table)];
+
+            if (entry.valid && entry.useful.value != 0) {
+                continue;
+            }
+
+            entry = {
+              .tag = tag(address, table),
+              .valid = true,
+              .counter = {static_cast<u8>(taken ? 4 : 3)},
+              .useful = {0},
+            };
+            return;
+        }
+
+        // every candidate is useful, age them so that they eventually make room
+        for (auto table = first_table; table < num_tables; table++) {
+            m_tables[table][index(address, table)].useful.update(false);
+        }
+    }
+};
+
+using branch_predictor = std::variant<static_btfn_predictor, bimodal_predictor, gshare_predictor, tage_lite_predictor>;
+
+struct branch_prediction_config {
+    branch_predictor predictor = gshare_predictor{};
+    /// depth of the return address stack, 0 for none
+    usize return_stack_depth = 16;
+    /// the branch target buffer for indirect jumps that aren't returns has `2^target_buffer_bits` entries
+    usize target_buffer_bits = 9;
+};
+
+struct branch_site_statistics {
+    u64 executed = 0;
+    u64 mispredicted = 0;
+
+    constexpr auto misprediction_rate() const -> double { return executed == 0 ? 0. : static_cast<double>(mispredicted) / static_cast<double>(executed); }
+};
+
+/// Predicts conditional branches with a direction predictor and indirect jumps with a return address stack and a target buffer.
+/// `jal` is assumed to be redirected from decode and is never mispredicted, its only part in this is pushing return addresses.
+/// Outcomes are kept for every branch and jump site.
+struct branch_prediction_model {
+    explicit branch_prediction_model(branch_prediction_config config = {})
+        : m_predictor(std::move(config.predictor))
+        , m_return_stack_depth(config.return_stack_depth)
+        , m_target_buffer_bits(config.target_buffer_bits)
+        , m_target_buffer(1uz << config.target_buffer_bits, 0) {}
+
+    /// Returns whether the branch was mispredicted.
+    auto on_branch(u64 address, u64 target, bool taken) -> bool {
+        const auto mispredicted = std::visit(
+          [&](auto& predictor) {
+              const auto prediction = predictor.predict(address, target);
+              predictor.update(address, target, taken);
+              return prediction != taken;
+          },
+          m_predictor
+        );
+
+        record(address, mispredicted);
+        ++m_branches;
+        m_branch_mispredictions += mispredicted ? 1 : 0;
+
+        return mispredicted;
+    }
+
+    /// `size` is the size of the jump instruction, the return address is right after it. Returns whether the target was mispredicted.
+    auto on_jump(u64 from, u64 to, usize size, reg link, reg base) -> bool {
+        // the link register hints of the ISA manual, the same ones `profiler` goes by
+        const auto is_link = [](reg r) { return r == reg::x1 || r == reg::x5; };
+        const auto is_direct = base == reg::zero;
+        const auto is_return = is_link(base) && (!is_link(link) || link != base);
+
+        auto mispredicted = false;
+
+        if (is_return) {
+            mispredicted = m_return_stack.empty() || m_return_stack.back() != to;
+
+            if (!m_return_stack.empty()) {
+                m_return_stack.pop_back();
+            }
+        } else if (!is_direct) {
+            auto& entry = m_target_buffer[detail::branch_index(from, m_target_buffer_bits)];
+            mispredicted = entry != to;
+            entry = to;
+        }
+
+        if (is_link(link) && m_return_stack_depth != 0) {
+            // the oldest entry is lost when the stack overflows, like in a circular hardware stack
+            if (m_return_stack.size() == m_return_stack_depth) {
+                m_return_stack.erase(m_return_stack.begin());
+            }
+
+            m_return_stack.push_back(from + size);
+        }
+
+        if (!is_direct) {
+            record(from, mispredicted);
+            ++m_indirect_jumps;
+            m_jump_mispredictions += mispredicted ? 1 : 0;
+        }
+
+        return mispredicted;
+    }
+
+    auto branches() const -> u64 { return m_branches; }
+    auto indirect_jumps() const -> u64 { return m_indirect_jumps; }
+    auto branch_mispredictions() const -> u64 { return m_branch_mispredictions; }
+    auto jump_mispredictions() const -> u64 { return m_jump_mispredictions; }
+    auto mispredictions() const -> u64 { return m_branch_mispredictions + m_jump_mispredictions; }
+
+    auto sites() const -> std::unordered_map<u64, branch_site_statistics> const& { return m_sites; }
+
+    /// The `count` sites with the most mispredictions, most first.
+    auto worst_sites(usize count) const -> std::vector<std::pair<u64, branch_site_statistics>> {
+        auto ret = std::vector<std::pair<u64, branch_site_statistics>>(m_sites.begin(), m_sites.end());
+        const auto by_mispredictions = [](auto const& lhs, auto const& rhs) {
+            return std::tie(rhs.second.mispredicted, lhs.first) < std::tie(lhs.second.mispredicted, rhs.first);
+        };
+
+        const auto middle = ret.begin() + static_cast<std::ptrdiff_t>(std::min(count, ret.size()));
+        std::ranges::partial_sort(ret.begin(), middle, ret.end(), by_mispredictions);
+        ret.erase(middle, ret.end());
+
+        return ret;
+    }
+
+    /// Writes a line for every site, sorted by address.
+    void dump_csv(std::ostream& os) const {
+        auto sites = std::vector<std::pair<u64, branch_site_statistics>>(m_sites.begin(), m_sites.end());
+        std::ranges::sort(sites, {}, &std::pair<u64, branch_site_statistics>::first);
+
+        os << "address,executed,mispredicted,misprediction_rate\n";
+        for (auto const& [address, site] : sites) {
+            os << fmt::format("{:#x},{},{},{}\n", address, site.executed, site.mispredicted, site.misprediction_rate());
+        }
+    }
+
+private:
+    branch_predictor m_predictor;
+    usize m_return_stack_depth;
+    std::vector<u64> m_return_stack{};
+    usize m_target_buffer_bits;
+    std::vector<u64> m_target_buffer;
+
+    std::unordered_map<u64, branch_site_statistics> m_sites{};
+    u64 m_branches = 0;
+    u64 m_indirect_jumps = 0;
+    u64 m_branch_mispredictions = 0;
+    u64 m_jump_mispredictions = 0;
+
+    void record(u64 address, bool mispredicted) {
+        auto& site = m_sites[address];
+        ++site.executed;
+        site.mispredicted += mispredicted ? 1 : 0;
+    }
+};
+
+/// Runs a `branch_prediction_model` alongside execution, for when there is no `timing_observer` to run one.
+struct branch_prediction_observer : null_observer {
+    branch_prediction_observer() = default;
+
+    explicit branch_prediction_observer(branch_prediction_config config)
+        : m_model(std::move(config)) {}
+
+    template<typename RiscV>
+    void on_branch(RiscV const&, u64 from, u64 target, bool taken) {
+        m_model.on_branch(from, target, taken);
+    }
+
+    template<typename RiscV>
+    void on_jump(RiscV const& self, u64 from, u64 to, reg link, reg base) {
+        m_model.on_jump(from, to, instruction_size(self, from), link, base);
+    }
+
+    template<typename RiscV>
+    constexpr auto event_count(RiscV const&, hpm_event event) const -> std::optional<u64> {
+        return event == hpm_event::branch_mispredicts ? std::optional{m_model.mispredictions()} : std::nullopt;
+    }
+
+    template<typename RiscV>
+    static auto instruction_size(RiscV const& self, u64 address) -> usize {
+        return (self.m_memory.template read<u16>(static_cast<typename RiscV::register_type>(address)) & 0b11) == 0b11 ? 4 : 2;
+    }
+
+    branch_prediction_model m_model{};
+};
+
+}  // namespace rv
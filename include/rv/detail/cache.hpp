@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stuff/core.hpp>
+
+#include <algorithm>
+#include <span>
+#include <vector>
+
+namespace rv {
+
+struct cache_config {
+    usize size_bytes = 16 * 1024;
+    usize line_bytes = 64;
+    usize ways = 4;
+    /// cycles that a miss stalls the pipeline for
+    u64 miss_penalty = 20;
+};
+
+/// A set-associative cache with LRU replacement that only keeps track of the tags, for timing.
+/// Writes allocate like reads do, there is no write-back traffic since nothing is ever dirty as far as timing goes.
+struct cache_model {
+    explicit cache_model(cache_config config = {})
+        : m_config(config)
+        , m_num_sets(std::max<usize>(config.size_bytes / std::max<usize>(config.line_bytes * config.ways, 1), 1))
+        , m_ways(m_num_sets * std::max<usize>(config.ways, 1)) {}
+
+    /// Returns whether the line `address` is in was cached, it is cached afterwards either way.
+    auto access(u64 address) -> bool {
+        const auto line = address / m_config.line_bytes;
+        const auto set = std::span(m_ways).subspan((line % m_num_sets) * num_ways(), num_ways());
+
+        ++m_clock;
+
+        if (auto it = std::ranges::find_if(set, [line](way const& way) { return way.valid && way.line == line; }); it != set.end()) {
+            it->last_used = m_clock;
+            ++m_hits;
+            return true;
+        }
+
+        // invalid ways have never been used, they are the least recently used ones
+        auto& victim = *std::ranges::min_element(set, {}, [](way const& way) { return way.valid ? way.last_used : 0; });
+        victim = {.valid = true, .line = line, .last_used = m_clock};
+        ++m_misses;
+
+        return false;
+    }
+
+    void invalidate() {
+        std::ranges::fill(m_ways, way{});
+    }
+
+    constexpr auto config() const -> cache_config const& { return m_config; }
+    constexpr auto hits() const -> u64 { return m_hits; }
+    constexpr auto misses() const -> u64 { return m_misses; }
+
+private:
+    struct way {
+        bool valid = false;
+        u64 line = 0;
+        u64 last_used = 0;
+    };
+
+    cache_config m_config;
+    usize m_num_sets;
+    /// the ways of a set are next to each other
+    std::vector<way> m_ways;
+    u64 m_clock = 0;
+    u64 m_hits = 0;
+    u64 m_misses = 0;
+
+    constexpr auto num_ways() const -> usize { return m_ways.size() / m_num_sets; }
+};
+
+}  // namespace rv
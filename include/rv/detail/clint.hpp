@@ -0,0 +1,161 @@
+#pragma once
+
+#include <rv/detail/memory.hpp>
+#include <rv/detail/trap.hpp>
+
+#include <stuff/core.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+namespace rv {
+
+enum class clint_timebase {
+    /// `mtime` counts retired instructions, which keeps timer interrupts deterministic
+    retired_instructions,
+    /// `mtime` follows the host's steady clock at `clint_config::frequency`
+    host_clock,
+};
+
+struct clint_config {
+    clint_timebase timebase = clint_timebase::retired_instructions;
+    /// ticks of `mtime` per second with `clint_timebase::host_clock`
+    u64 frequency = 10'000'000;
+    /// With `clint_timebase::host_clock`, the instructions to run between looks at the clock while the timer is armed. Timer interrupts
+    /// come at most this many instructions late.
+    u64 poll_interval = 4096;
+};
+
+/// A SiFive-style core-local interruptor for a single hart: `msip` at 0x0, `mtimecmp` at 0x4000 and `mtime` at 0xBFF8, where QEMU's virt
+/// machine and most SBI implementations expect them relative to the base.
+///
+/// The CLINT never gets polled by the processor. Writes that change what is pending schedule an `event_source::interrupts` event and the
+/// timer schedules an `event_source::timer` event for when `mtime` reaches `mtimecmp` (or for its next look at the host's clock), the
+/// processor only ever asks for `pending` once one of those is due.
+struct clint final : mmio_device {
+    static constexpr usize register_span = 0x1'0000;
+
+    static constexpr u64 msip_offset = 0x0000;
+    static constexpr u64 mtimecmp_offset = 0x4000;
+    static constexpr u64 mtime_offset = 0xBFF8;
+
+    explicit clint(clint_config config = {})
+        : m_config(config)
+        , m_epoch(std::chrono::steady_clock::now()) {}
+
+    /// Hooks the CLINT up to the event queue and the retired instruction count of a processor, see `risc_v::map_clint`.
+    void connect(event_queue& events, u64 const& retired) {
+        m_events = &events;
+        m_retired = &retired;
+        reschedule();
+    }
+
+    auto mtime() const -> u64 { return ticks() + m_time_offset; }
+    auto mtimecmp() const -> u64 { return m_compare; }
+
+    /// `MSIP` and `MTIP` as they are to be in `mip`
+    auto pending() const -> u64 {
+        auto ret = u64(0);
+        if ((m_software & 1) != 0) {
+            ret |= interrupt_bit::machine_software;
+        }
+        if (mtime() >= m_compare) {
+            ret |= interrupt_bit::machine_timer;
+        }
+        return ret;
+    }
+
+    /// What the processor calls when the `event_source::timer` event is due.
+    void on_timer() { reschedule(); }
+
+    /// `mtime` on the host's clock moves on by itself.
+    auto deterministic() const -> bool override { return m_config.timebase == clint_timebase::retired_instructions; }
+
+    /*
+     * guest side, RV32 guests access the 64-bit registers in halves
+     */
+
+    auto load(u64 offset, usize size) -> u64 override {
+        if (offset < 4) {
+            return extract(m_software, offset, size);
+        }
+        if (offset >= mtimecmp_offset && offset < mtimecmp_offset + 8) {
+            return extract(m_compare, offset - mtimecmp_offset, size);
+        }
+        if (offset >= mtime_offset && offset < mtime_offset + 8) {
+            return extract(mtime(), offset - mtime_offset, size);
+        }
+
+        return 0;
+    }
+
+    void store(u64 offset, usize size, u64 value) override {
+        if (offset < 4) {
+            m_software = merge(m_software, offset, size, value) & 1;
+        } else if (offset >= mtimecmp_offset && offset < mtimecmp_offset + 8) {
+            m_compare = merge(m_compare, offset - mtimecmp_offset, size, value);
+        } else if (offset >= mtime_offset && offset < mtime_offset + 8) {
+            m_time_offset = merge(mtime(), offset - mtime_offset, size, value) - ticks();
+        } else {
+            return;
+        }
+
+        reschedule();
+
+        if (m_events != nullptr) {
+            // the store is done by an instruction that hasn't retired yet
+            m_events->schedule(event_source::interrupts, *m_retired + 1);
+        }
+    }
+
+private:
+    clint_config m_config;
+    std::chrono::steady_clock::time_point m_epoch;
+
+    event_queue* m_events = nullptr;
+    u64 const* m_retired = nullptr;
+
+    u64 m_software = 0;
+    /// disarmed until the guest writes to it
+    u64 m_compare = std::numeric_limits<u64>::max();
+    u64 m_time_offset = 0;
+
+    auto ticks() const -> u64 {
+        if (m_config.timebase == clint_timebase::retired_instructions) {
+            return m_retired == nullptr ? 0 : *m_retired;
+        }
+
+        const auto nanoseconds = static_cast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_epoch).count());
+        constexpr auto nanoseconds_per_second = u64(1'000'000'000);
+        return (nanoseconds / nanoseconds_per_second) * m_config.frequency + (nanoseconds % nanoseconds_per_second) * m_config.frequency / nanoseconds_per_second;
+    }
+
+    /// Schedules the timer event for when `mtime` reaches `mtimecmp`, there is nothing to schedule once it has.
+    void reschedule() {
+        if (m_events == nullptr) {
+            return;
+        }
+
+        const auto now = mtime();
+        if (now >= m_compare) {
+            m_events->cancel(event_source::timer);
+            return;
+        }
+
+        const auto distance = m_config.timebase == clint_timebase::retired_instructions ? m_compare - now : std::max<u64>(m_config.poll_interval, 1);
+        const auto deadline = *m_retired > event_queue::never - distance ? event_queue::never : *m_retired + distance;
+        m_events->schedule(event_source::timer, deadline);
+    }
+
+    static constexpr auto size_mask(usize size) -> u64 { return size >= 8 ? ~u64(0) : (u64(1) << (size * 8)) - 1; }
+
+    static constexpr auto extract(u64 reg, u64 offset, usize size) -> u64 { return (reg >> (offset * 8)) & size_mask(size); }
+
+    static constexpr auto merge(u64 reg, u64 offset, usize size, u64 value) -> u64 {
+        const auto mask = size_mask(size) << (offset * 8);
+        return (reg & ~mask) | ((value << (offset * 8)) & mask);
+    }
+};
+
+}  // namespace rv
@@ -0,0 +1,289 @@
+#pragma once
+
+#include <rv/detail/definitions.hpp>
+
+#include <stuff/core.hpp>
+
+#include <fmt/format.h>
+
+#include <array>
+#include <functional>
+#include <optional>
+#include <string>
+
+namespace rv {
+
+enum class csr_write_type {
+    write,
+    set,
+    clear,
+};
+
+namespace csr_address {
+
+inline constexpr u32 fflags = 0x001;
+inline constexpr u32 frm = 0x002;
+inline constexpr u32 fcsr = 0x003;
+
+inline constexpr u32 vstart = 0x008;
+inline constexpr u32 vxsat = 0x009;
+inline constexpr u32 vxrm = 0x00A;
+inline constexpr u32 vcsr = 0x00F;
+inline constexpr u32 vl = 0xC20;
+inline constexpr u32 vtype = 0xC21;
+inline constexpr u32 vlenb = 0xC22;
+
+// the counters are numbered 0 through 31 (`cycle`, `time`, `instret`, `hpmcounter3` ...), their addresses are the base plus the number
+// and the upper halves on RV32 are at the address of the lower half plus 0x80
+
+inline constexpr u32 cycle = 0xC00;
+inline constexpr u32 time = 0xC01;
+inline constexpr u32 instret = 0xC02;
+inline constexpr u32 hpmcounter3 = 0xC03;
+inline constexpr u32 cycleh = 0xC80;
+
+inline constexpr u32 mcycle = 0xB00;
+inline constexpr u32 minstret = 0xB02;
+inline constexpr u32 mhpmcounter3 = 0xB03;
+inline constexpr u32 mcycleh = 0xB80;
+
+inline constexpr u32 mstatus = 0x300;
+inline constexpr u32 mie = 0x304;
+inline constexpr u32 mtvec = 0x305;
+inline constexpr u32 mscratch = 0x340;
+inline constexpr u32 mepc = 0x341;
+inline constexpr u32 mcause = 0x342;
+inline constexpr u32 mtval = 0x343;
+inline constexpr u32 mip = 0x344;
+inline constexpr u32 mhartid = 0xF14;
+
+inline constexpr u32 mcountinhibit = 0x320;
+inline constexpr u32 mhpmevent3 = 0x323;
+
+}  // namespace csr_address
+
+namespace detail {
+
+struct counter_csr {
+    usize index;
+    bool upper_half;
+    bool machine_mode;
+};
+
+constexpr auto decode_counter_csr(u32 address) -> std::optional<counter_csr> {
+    const auto index = static_cast<usize>(address & 0x1F);
+    const auto upper_half = (address & 0x80) != 0;
+    const auto base = address & ~u32(0x9F);
+
+    if (base == csr_address::cycle) {
+        return counter_csr{index, upper_half, false};
+    }
+
+    // there is no machine mode version of `time`, it shadows a memory mapped timer instead
+    if (base == csr_address::mcycle && index != 1) {
+        return counter_csr{index, upper_half, true};
+    }
+
+    return std::nullopt;
+}
+
+}  // namespace detail
+
+/// The name of the CSR at `address`, or the address in hex if it isn't one that is implemented.
+inline auto csr_name(u32 address) -> std::string {
+    if (const auto counter = detail::decode_counter_csr(address); counter) {
+        constexpr std::string_view fixed_names[]{"cycle", "time", "instret"};
+
+        const auto name = counter->index < 3 ? std::string(fixed_names[counter->index]) : fmt::format("hpmcounter{}", counter->index);
+        return fmt::format("{}{}{}", counter->machine_mode ? "m" : "", name, counter->upper_half ? "h" : "");
+    }
+
+    switch (address) {
+        case csr_address::fflags: return "fflags";
+        case csr_address::frm: return "frm";
+        case csr_address::fcsr: return "fcsr";
+        case csr_address::vstart: return "vstart";
+        case csr_address::vxsat: return "vxsat";
+        case csr_address::vxrm: return "vxrm";
+        case csr_address::vcsr: return "vcsr";
+        case csr_address::vl: return "vl";
+        case csr_address::vtype: return "vtype";
+        case csr_address::vlenb: return "vlenb";
+        case csr_address::mstatus: return "mstatus";
+        case csr_address::mie: return "mie";
+        case csr_address::mtvec: return "mtvec";
+        case csr_address::mscratch: return "mscratch";
+        case csr_address::mepc: return "mepc";
+        case csr_address::mcause: return "mcause";
+        case csr_address::mtval: return "mtval";
+        case csr_address::mip: return "mip";
+        case csr_address::mhartid: return "mhartid";
+        case csr_address::mcountinhibit: return "mcountinhibit";
+        default: break;
+    }
+
+    if (address >= csr_address::mhpmevent3 && address < csr_address::mhpmevent3 + 29) {
+        return fmt::format("mhpmevent{}", address - csr_address::mhpmevent3 + 3);
+    }
+
+    return fmt::format("{:#x}", address);
+}
+
+/// The counter CSRs of the Zicntr and Zihpm extensions along with the machine mode registers that set them up.
+/// Counters aren't incremented, each one is the current value of its source (e.g. the amount of retired instructions for `instret`, an
+/// observer's count of an event for an `mhpmcounter`) plus an offset that writes adjust. Reading a counter is the only time anything
+/// happens, so keeping them costs nothing while executing.
+/// Sources are passed in as `source(index) -> u64` where `index` is the number of the counter.
+/// `fcsr` is in here as well, with `fflags` and `frm` being views of parts of it.
+template<typename RegisterType>
+struct csr_file {
+    using register_type = RegisterType;
+
+    static constexpr usize num_counters = 32;
+
+    template<typename Source>
+    constexpr auto read(u32 address, Source&& source) const -> std::optional<register_type> {
+        if (const auto counter = detail::decode_counter_csr(address); counter) {
+            if (counter->upper_half && !has_upper_halves) {
+                return std::nullopt;
+            }
+
+            const auto value = counter_value(counter->index, std::invoke(source, counter->index));
+            return static_cast<register_type>(counter->upper_half ? value >> 32 : value);
+        }
+
+        switch (address) {
+            case csr_address::fflags: return static_cast<register_type>(float_flags());
+            case csr_address::frm: return static_cast<register_type>(float_rounding_mode());
+            case csr_address::fcsr: return static_cast<register_type>(m_float_status);
+            case csr_address::mcountinhibit: return static_cast<register_type>(m_inhibit);
+            default: break;
+        }
+
+        if (const auto index = event_index(address); index) {
+            return static_cast<register_type>(m_events[*index]);
+        }
+
+        return std::nullopt;
+    }
+
+    /// Returns false if there is no such CSR or it is read-only.
+    /// `source` is expected to give the values of the sources as they will be once the writing instruction has retired.
+    template<typename Source>
+    constexpr auto write(u32 address, register_type value, Source&& source) -> bool {
+        // the top two bits of the address being set denotes a read-only CSR
+        if ((address >> 10) == 0b11) {
+            return false;
+        }
+
+        if (const auto counter = detail::decode_counter_csr(address); counter) {
+            if (counter->upper_half && !has_upper_halves) {
+                return false;
+            }
+
+            const auto current = counter_value(counter->index, std::invoke(source, counter->index));
+
+            auto new_value = static_cast<u64>(value);
+            if (counter->upper_half) {
+                new_value = (current & 0xFFFF'FFFFull) | (new_value << 32);
+            } else if (has_upper_halves) {
+                new_value = (current & ~0xFFFF'FFFFull) | new_value;
+            }
+
+            set_counter_value(counter->index, std::invoke(source, counter->index), new_value);
+            return true;
+        }
+
+        switch (address) {
+            case csr_address::fflags: m_float_status = (m_float_status & ~u32(0x1F)) | (static_cast<u32>(value) & 0x1F); return true;
+            case csr_address::frm: m_float_status = (m_float_status & 0x1F) | ((static_cast<u32>(value) & 0b111) << 5); return true;
+            case csr_address::fcsr: m_float_status = static_cast<u32>(value) & 0xFF; return true;
+            default: break;
+        }
+
+        if (address == csr_address::mcountinhibit) {
+            // `time` can't be inhibited, the bit for it is read-only zero
+            const auto new_inhibit = static_cast<u32>(value) & ~u32(0b10);
+
+            for (usize i = 0; i < num_counters; i++) {
+                const auto was_inhibited = ((m_inhibit >> i) & 1) != 0;
+                const auto is_inhibited = ((new_inhibit >> i) & 1) != 0;
+
+                if (was_inhibited == is_inhibited) {
+                    continue;
+                }
+
+                if (is_inhibited) {
+                    m_frozen[i] = counter_value(i, std::invoke(source, i));
+                } else {
+                    m_offsets[i] = m_frozen[i] - std::invoke(source, i);
+                }
+            }
+
+            m_inhibit = new_inhibit;
+            return true;
+        }
+
+        if (const auto index = event_index(address); index) {
+            // the counter keeps its value, it just continues counting something else
+            const auto current = counter_value(*index, std::invoke(source, *index));
+            m_events[*index] = value <= static_cast<register_type>(hpm_event::branch_mispredicts) ? static_cast<hpm_event>(value) : hpm_event::none;
+            set_counter_value(*index, std::invoke(source, *index), current);
+            return true;
+        }
+
+        return false;
+    }
+
+    /// What counter `index` counts, `cycle`, `time` and `instret` have fixed events.
+    constexpr auto event(usize index) const -> hpm_event {
+        switch (index) {
+            case 0: return hpm_event::cycles;
+            case 1: return hpm_event::cycles;
+            case 2: return hpm_event::instructions;
+            default: return m_events[index];
+        }
+    }
+
+    /// `frm`, which can hold values that aren't valid rounding modes
+    constexpr auto float_rounding_mode() const -> u32 { return m_float_status >> 5; }
+    constexpr auto float_flags() const -> u32 { return m_float_status & 0x1F; }
+    constexpr void raise_float_flags(u32 flags) { m_float_status |= flags & 0x1F; }
+
+private:
+    static constexpr bool has_upper_halves = sizeof(register_type) == sizeof(u32);
+
+    std::array<u64, num_counters> m_offsets{};
+    /// the values of the inhibited counters
+    std::array<u64, num_counters> m_frozen{};
+    std::array<hpm_event, num_counters> m_events{};
+    u32 m_inhibit = 0;
+    /// `frm` in bits 7:5 and `fflags` in bits 4:0
+    u32 m_float_status = 0;
+
+    static constexpr auto event_index(u32 address) -> std::optional<usize> {
+        if (address >= csr_address::mhpmevent3 && address < csr_address::mhpmevent3 + 29) {
+            return address - csr_address::mcountinhibit;
+        }
+
+        return std::nullopt;
+    }
+
+    constexpr auto counter_value(usize index, u64 source) const -> u64 {
+        if (((m_inhibit >> index) & 1) != 0) {
+            return m_frozen[index];
+        }
+
+        return source + m_offsets[index];
+    }
+
+    constexpr void set_counter_value(usize index, u64 source, u64 value) {
+        if (((m_inhibit >> index) & 1) != 0) {
+            m_frozen[index] = value;
+        } else {
+            m_offsets[index] = value - source;
+        }
+    }
+};
+
+}  // namespace rv
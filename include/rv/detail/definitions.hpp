@@ -28,8 +28,16 @@ enum class instruction_standard {
     RV32Q,
     RV64Q,
 
+    V,
+
     Zicsr,
     Zifencei,
+
+    Privileged,
+
+    Zba,
+    Zbb,
+    Zbs,
 };
 
 enum class opcode_format {
@@ -56,6 +64,97 @@ enum class opcode_format {
     c_jump,*/
 };
 
+constexpr auto enum_name(instruction_standard standard) -> std::string_view {
+    switch (standard) {
+        case instruction_standard::RV32I: return "RV32I";
+        case instruction_standard::RV64I: return "RV64I";
+        case instruction_standard::RV128I: return "RV128I";
+        case instruction_standard::RV32C: return "RV32C";
+        case instruction_standard::RV64C: return "RV64C";
+        case instruction_standard::RV128C: return "RV128C";
+        case instruction_standard::RV32M: return "RV32M";
+        case instruction_standard::RV64M: return "RV64M";
+        case instruction_standard::RV32A: return "RV32A";
+        case instruction_standard::RV64A: return "RV64A";
+        case instruction_standard::RV32F: return "RV32F";
+        case instruction_standard::RV64F: return "RV64F";
+        case instruction_standard::RV32D: return "RV32D";
+        case instruction_standard::RV64D: return "RV64D";
+        case instruction_standard::RV32Q: return "RV32Q";
+        case instruction_standard::RV64Q: return "RV64Q";
+        case instruction_standard::V: return "V";
+        case instruction_standard::Zicsr: return "Zicsr";
+        case instruction_standard::Zifencei: return "Zifencei";
+        case instruction_standard::Privileged: return "Privileged";
+        case instruction_standard::Zba: return "Zba";
+        case instruction_standard::Zbb: return "Zbb";
+        case instruction_standard::Zbs: return "Zbs";
+    }
+
+    return "unknown";
+}
+
+constexpr auto enum_name(opcode_format format) -> std::string_view {
+    switch (format) {
+        case opcode_format::reg_reg: return "reg_reg";
+        case opcode_format::immediate: return "immediate";
+        case opcode_format::store: return "store";
+        case opcode_format::branch: return "branch";
+        case opcode_format::upper_immediate: return "upper_immediate";
+        case opcode_format::jump: return "jump";
+        case opcode_format::c_reg_reg: return "c_reg_reg";
+        case opcode_format::c_immediate: return "c_immediate";
+        case opcode_format::c_wide_immediate: return "c_wide_immediate";
+        case opcode_format::c_stack_rela_store: return "c_stack_rela_store";
+    }
+
+    return "unknown";
+}
+
+/// Events that the hardware performance monitor counters (`mhpmcounter3` through `mhpmcounter31`) can be set up to count by writing to
+/// the corresponding `mhpmevent` CSR.
+enum class hpm_event : u32 {
+    none = 0,
+
+    cycles,
+    instructions,
+
+    // instruction classes, compressed instructions count towards the class of the instruction they expand into
+    loads,
+    stores,
+    branches,
+    jumps,
+    multiply_divide,
+    atomics,
+    csr_accesses,
+    compressed,
+
+    instruction_cache_misses,
+    data_cache_misses,
+    branch_mispredicts,
+};
+
+constexpr auto enum_name(hpm_event event) -> std::string_view {
+    switch (event) {
+        case hpm_event::none: return "none";
+        case hpm_event::cycles: return "cycles";
+        case hpm_event::instructions: return "instructions";
+        case hpm_event::loads: return "loads";
+        case hpm_event::stores: return "stores";
+        case hpm_event::branches: return "branches";
+        case hpm_event::jumps: return "jumps";
+        case hpm_event::multiply_divide: return "multiply_divide";
+        case hpm_event::atomics: return "atomics";
+        case hpm_event::csr_accesses: return "csr_accesses";
+        case hpm_event::compressed: return "compressed";
+        case hpm_event::instruction_cache_misses: return "instruction_cache_misses";
+        case hpm_event::data_cache_misses: return "data_cache_misses";
+        case hpm_event::branch_mispredicts: return "branch_mispredicts";
+    }
+
+    return "unknown";
+}
+
 enum class reg : u32 {
     // clang-format off
     x0 = 0, zero = x0,
@@ -178,4 +277,39 @@ enum class alu_action {
     remu,
 };
 
+/// what the Zba, Zbb and Zbs instructions do, the `_uw` ones zero extend the lower 32 bits of their first operand
+enum class bitmanip_action {
+    sh1add,
+    sh2add,
+    sh3add,
+    add_uw,
+    sh1add_uw,
+    sh2add_uw,
+    sh3add_uw,
+    slli_uw,
+
+    andn,
+    orn,
+    xnor,
+    clz,
+    ctz,
+    cpop,
+    max,
+    maxu,
+    min,
+    minu,
+    sext_b,
+    sext_h,
+    zext_h,
+    rol,
+    ror,
+    orc_b,
+    rev8,
+
+    bclr,
+    bext,
+    binv,
+    bset,
+};
+
 }  // namespace rv
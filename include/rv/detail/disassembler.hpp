@@ -0,0 +1,231 @@
+#pragma once
+
+#include <rv/detail/elf.hpp>
+#include <rv/detail/instruction_descriptor.hpp>
+
+#include <stuff/core.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <ostream>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace rv {
+
+/// Disassembles the instructions in `code`, which is at `address`, calling `fn(address, word, text)` for each. The text is only valid for
+/// the duration of the call, a single buffer is reused for all of them.
+template<typename RiscV, typename Fn>
+void disassemble(generic_instruction_set<RiscV> const& isa, std::span<const u8> code, u64 address, bool abi_register_names, Fn&& fn) {
+    auto buffer = format_buffer{};
+
+    for (usize offset = 0; offset + 2 <= code.size();) {
+        u32 word = 0;
+        std::memcpy(&word, code.data() + offset, std::min<usize>(sizeof(word), code.size() - offset));
+        word = stf::bit::convert_endian(word, std::endian::little, std::endian::native);
+
+        const auto size = (word & 0b11) == 0b11 ? 4uz : 2uz;
+        if (offset + size > code.size()) {
+            break;
+        }
+
+        buffer.clear();
+        isa.format_to(buffer, word, abi_register_names);
+        std::invoke(fn, address + offset, word, std::string_view(buffer.data(), buffer.size()));
+
+        offset += size;
+    }
+}
+
+/// Where the first instruction that starts at or after each multiple of `chunk_size` in `code` is, with `code.size()` for multiples that
+/// have none and once more at the end. Where instructions start in a stream of mixed 16 and 32-bit instructions depends on everything
+/// before them, so this goes through the whole of `code` from the start. It only looks at the low bits of each instruction, which is a lot
+/// less than decoding it.
+inline auto instruction_boundaries(std::span<const u8> code, usize chunk_size) -> std::vector<usize> {
+    const auto num_chunks = (code.size() + chunk_size - 1) / chunk_size;
+    auto ret = std::vector<usize>(num_chunks + 1, code.size());
+
+    for (usize offset = 0, chunk = 0; offset < code.size() && chunk < num_chunks; offset += (code[offset] & 0b11) == 0b11 ? 4 : 2) {
+        for (; chunk < num_chunks && offset >= chunk * chunk_size; chunk++) {
+            ret[chunk] = offset;
+        }
+    }
+
+    return ret;
+}
+
+struct listing_options {
+    bool abi_register_names = true;
+    /// 0 for one per hardware thread
+    usize num_threads = 0;
+    /// how much of the code a thread takes at a time, chunks start at the first instruction at or after multiples of this
+    usize chunk_size = 1uz << 16;
+    /// functions get a label before their first instruction
+    elf::symbol_table const* symbols = nullptr;
+};
+
+namespace detail {
+
+/// Lists `code[begin, end)`, `code` being at `address`. Parcels that don't make up a whole instruction before `end` are listed as data.
+template<typename RiscV>
+void write_listing_chunk(
+  format_buffer& out, generic_instruction_set<RiscV> const& isa, std::span<const u8> code, u64 address, usize begin, usize end, listing_options const& options
+) {
+    constexpr auto label_digits = sizeof(typename RiscV::register_type) * 2;
+
+    auto symbol = std::span<const elf::symbol>{};
+    if (options.symbols != nullptr) {
+        symbol = options.symbols->symbols();
+        symbol = symbol.subspan(static_cast<usize>(std::ranges::lower_bound(symbol, address + begin, {}, &elf::symbol::address) - symbol.begin()));
+    }
+
+    auto it = std::back_inserter(out);
+
+    for (auto offset = begin; offset < end;) {
+        const auto instruction_address = address + offset;
+
+        // symbols in the middle of instructions have nothing to label
+        while (!symbol.empty() && symbol.front().address <= instruction_address) {
+            if (symbol.front().address == instruction_address && symbol.front().is_function) {
+                fmt::format_to(it, "\n{:0{}x} <{}>:\n", instruction_address, label_digits, symbol.front().display_name);
+            }
+            symbol = symbol.subspan(1);
+        }
+
+        if (offset + 2 > end) {
+            fmt::format_to(it, "{:8x}:\t{:02x}      \t.byte 0x{:02x}\n", instruction_address, code[offset], code[offset]);
+            break;
+        }
+
+        u32 word = 0;
+        std::memcpy(&word, code.data() + offset, std::min<usize>(sizeof(word), end - offset));
+        word = stf::bit::convert_endian(word, std::endian::little, std::endian::native);
+
+        auto size = (word & 0b11) == 0b11 ? 4uz : 2uz;
+        if (offset + size > end) {
+            size = 2;
+            fmt::format_to(it, "{:8x}:\t{:04x}    \t.2byte 0x{:04x}\n", instruction_address, word & 0xFFFF, word & 0xFFFF);
+        } else {
+            word = size == 4 ? word : word & 0xFFFF;
+            fmt::format_to(it, "{:8x}:\t{:0{}x}{:{}}\t", instruction_address, word, size * 2, "", 8 - size * 2);
+            isa.format_to(out, word, options.abi_register_names);
+            out.push_back('\n');
+        }
+
+        offset += size;
+    }
+}
+
+}  // namespace detail
+
+/// Writes an objdump-style listing of `code`, which is at `address`. The code is split into chunks that are listed by a pool of threads into
+/// buffers of their own and written out in order, no strings are made per instruction.
+template<typename RiscV>
+void write_listing(std::ostream& os, generic_instruction_set<RiscV> const& isa, std::span<const u8> code, u64 address, listing_options const& options = {}) {
+    const auto boundaries = instruction_boundaries(code, std::max<usize>(options.chunk_size, 1));
+    const auto num_chunks = boundaries.size() - 1;
+
+    auto buffers = std::vector<format_buffer>(num_chunks);
+    auto next_chunk = std::atomic<usize>{0};
+
+    const auto worker = [&] {
+        for (auto i = next_chunk.fetch_add(1, std::memory_order_relaxed); i < num_chunks; i = next_chunk.fetch_add(1, std::memory_order_relaxed)) {
+            detail::write_listing_chunk(buffers[i], isa, code, address, boundaries[i], boundaries[i + 1], options);
+        }
+    };
+
+    const auto num_threads = std::min<usize>(options.num_threads != 0 ? options.num_threads : std::max(std::thread::hardware_concurrency(), 1u), num_chunks);
+
+    if (num_threads <= 1) {
+        worker();
+    } else {
+        auto threads = std::vector<std::jthread>{};
+        for (usize i = 0; i < num_threads; i++) {
+            threads.emplace_back(worker);
+        }
+    }
+
+    for (auto const& buffer : buffers) {
+        os.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    }
+}
+
+/// A set-associative cache of disassembled instructions with LRU replacement, for views that show the same instructions frame after frame.
+/// Entries are keyed by the instruction set, the word and whether ABI register names were asked for. The text lives in the entries, nothing
+/// is allocated after construction.
+struct disassembly_cache {
+    /// disassemblies longer than this are cut short, the longest ones (compressed instructions with their expansion) are around 50
+    static constexpr usize max_length = 80;
+
+    explicit disassembly_cache(usize num_sets = 64, usize ways = 4)
+        : m_num_sets(std::max<usize>(num_sets, 1))
+        , m_entries(m_num_sets * std::max<usize>(ways, 1)) {}
+
+    /// The disassembly of `word`, valid until the next call.
+    template<typename RiscV>
+    auto format(generic_instruction_set<RiscV> const& isa, u32 word, bool abi_register_names = false) -> std::string_view {
+        const auto* const key = static_cast<const void*>(&isa);
+        const auto set = std::span(m_entries).subspan(set_index(key, word, abi_register_names) * num_ways(), num_ways());
+
+        ++m_clock;
+
+        const auto matches = [&](entry const& entry) { return entry.isa == key && entry.word == word && entry.abi_register_names == abi_register_names; };
+        if (auto it = std::ranges::find_if(set, matches); it != set.end()) {
+            it->last_used = m_clock;
+            ++m_hits;
+            return it->text();
+        }
+
+        // empty entries have never been used, they are the least recently used ones
+        auto& victim = *std::ranges::min_element(set, {}, [](entry const& entry) { return entry.isa == nullptr ? 0 : entry.last_used; });
+        victim.isa = key;
+        victim.word = word;
+        victim.abi_register_names = abi_register_names;
+        victim.last_used = m_clock;
+        victim.length = static_cast<u8>(isa.format_to(std::span(victim.buffer), word, abi_register_names).size());
+        ++m_misses;
+
+        return victim.text();
+    }
+
+    void clear() { std::ranges::fill(m_entries, entry{}); }
+
+    constexpr auto hits() const -> u64 { return m_hits; }
+    constexpr auto misses() const -> u64 { return m_misses; }
+
+private:
+    struct entry {
+        const void* isa = nullptr;
+        u32 word = 0;
+        bool abi_register_names = false;
+        u8 length = 0;
+        u64 last_used = 0;
+        std::array<char, max_length> buffer{};
+
+        constexpr auto text() const -> std::string_view { return {buffer.data(), length}; }
+    };
+
+    usize m_num_sets;
+    /// the ways of a set are next to each other
+    std::vector<entry> m_entries;
+    u64 m_clock = 0;
+    u64 m_hits = 0;
+    u64 m_misses = 0;
+
+    constexpr auto num_ways() const -> usize { return m_entries.size() / m_num_sets; }
+
+    auto set_index(const void* isa, u32 word, bool abi_register_names) const -> usize {
+        // the low bits of words are mostly the opcode, mix the rest in
+        auto hash = static_cast<u64>(word) * 0x9E37'79B9'7F4A'7C15ull;
+        hash ^= reinterpret_cast<std::uintptr_t>(isa) >> 4;
+        hash ^= abi_register_names ? 0x5555 : 0;
+        return static_cast<usize>((hash >> 32) % m_num_sets);
+    }
+};
+
+}  // namespace rv
@@ -0,0 +1,272 @@
+#pragma once
+
+#include <stuff/core.hpp>
+#include <stuff/expected.hpp>
+
+#include <cxxabi.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace rv::elf {
+
+namespace detail {
+
+/// Bounds checked little-endian field reads out of an ELF image.
+struct reader {
+    std::span<const u8> m_image;
+
+    template<typename T>
+    constexpr auto read(usize offset) const -> stf::expected<T, std::string_view> {
+        if (offset > m_image.size() || m_image.size() - offset < sizeof(T)) {
+            return stf::unexpected{"read past the end of the ELF image"};
+        }
+
+        auto ret = T{};
+        std::memcpy(&ret, m_image.data() + offset, sizeof(T));
+        return stf::bit::convert_endian(ret, std::endian::little, std::endian::native);
+    }
+
+    /// reads a field that is 4 bytes wide in ELF32 images and 8 bytes wide in ELF64 ones
+    constexpr auto read_word(usize offset, bool is_64_bit) const -> stf::expected<u64, std::string_view> {
+        if (is_64_bit) {
+            return read<u64>(offset);
+        }
+
+        return TRYX(read<u32>(offset));
+    }
+};
+
+/// Checks the identification bytes of an ELF image, returns whether it is an ELF64 one.
+inline auto check_identification(std::span<const u8> image) -> stf::expected<bool, std::string_view> {
+    if (image.size() < 16 || std::memcmp(image.data(), "\x7F" "ELF", 4) != 0) {
+        return stf::unexpected{"not an ELF image"};
+    }
+
+    const auto elf_class = image[4];
+    if (elf_class != 1 && elf_class != 2) {
+        return stf::unexpected{"bad ELF class"};
+    }
+
+    if (image[5] != 1) {
+        return stf::unexpected{"only little-endian ELF images are supported"};
+    }
+
+    return elf_class == 2;
+}
+
+inline auto demangle(std::string const& name) -> std::string {
+    auto status = 0;
+    auto demangled = std::unique_ptr<char, decltype(&std::free)>(abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status), &std::free);
+
+    if (status != 0 || demangled == nullptr) {
+        return name;
+    }
+
+    return demangled.get();
+}
+
+}  // namespace detail
+
+struct symbol {
+    u64 address;
+    u64 size;
+    bool is_function;
+
+    std::string name;
+    std::string display_name;
+};
+
+/// The function and object symbols of a little-endian ELF32 or ELF64 image, sorted by address.
+struct symbol_table {
+    static auto from_image(std::span<const u8> image) -> stf::expected<symbol_table, std::string_view> {
+        const auto reader = detail::reader{image};
+        const auto is_64_bit = TRYX(detail::check_identification(image));
+
+        const auto section_header_offset = TRYX(reader.read_word(is_64_bit ? 0x28 : 0x20, is_64_bit));
+        const auto section_header_size = TRYX(reader.read<u16>(is_64_bit ? 0x3A : 0x2E));
+        const auto num_section_headers = TRYX(reader.read<u16>(is_64_bit ? 0x3C : 0x30));
+
+        struct section {
+            u32 type;
+            u64 offset;
+            u64 size;
+            u32 link;
+            u64 entry_size;
+        };
+
+        const auto read_section = [&](usize index) -> stf::expected<section, std::string_view> {
+            const auto base = section_header_offset + index * section_header_size;
+
+            return section{
+              .type = TRYX(reader.read<u32>(base + 0x04)),
+              .offset = TRYX(reader.read_word(base + (is_64_bit ? 0x18 : 0x10), is_64_bit)),
+              .size = TRYX(reader.read_word(base + (is_64_bit ? 0x20 : 0x14), is_64_bit)),
+              .link = TRYX(reader.read<u32>(base + (is_64_bit ? 0x28 : 0x18))),
+              .entry_size = TRYX(reader.read_word(base + (is_64_bit ? 0x38 : 0x24), is_64_bit)),
+            };
+        };
+
+        auto ret = symbol_table{};
+
+        for (usize section_index = 0; section_index < num_section_headers; section_index++) {
+            const auto symtab = TRYX(read_section(section_index));
+
+            // SHT_SYMTAB
+            if (symtab.type != 2) {
+                continue;
+            }
+
+            if (symtab.link >= num_section_headers) {
+                return stf::unexpected{"symbol table links to a nonexistent string table"};
+            }
+
+            const auto strtab = TRYX(read_section(symtab.link));
+            if (strtab.offset > image.size() || image.size() - strtab.offset < strtab.size) {
+                return stf::unexpected{"string table extends past the end of the ELF image"};
+            }
+
+            const auto entry_size = symtab.entry_size != 0 ? symtab.entry_size : (is_64_bit ? 24 : 16);
+
+            for (usize offset = symtab.offset; offset + entry_size <= symtab.offset + symtab.size; offset += entry_size) {
+                const auto name_offset = TRYX(reader.read<u32>(offset));
+                const auto info = TRYX(reader.read<u8>(offset + (is_64_bit ? 0x04 : 0x0C)));
+                const auto value = TRYX(reader.read_word(offset + (is_64_bit ? 0x08 : 0x04), is_64_bit));
+                const auto size = TRYX(reader.read_word(offset + (is_64_bit ? 0x10 : 0x08), is_64_bit));
+
+                // STT_OBJECT and STT_FUNC
+                const auto type = info & 0xF;
+                if ((type != 1 && type != 2) || name_offset >= strtab.size) {
+                    continue;
+                }
+
+                const auto* name_begin = reinterpret_cast<const char*>(image.data() + strtab.offset + name_offset);
+                auto name = std::string(name_begin, strnlen(name_begin, strtab.size - name_offset));
+
+                ret.m_symbols.emplace_back(symbol{
+                  .address = value,
+                  .size = size,
+                  .is_function = type == 2,
+                  .name = name,
+                  .display_name = detail::demangle(name),
+                });
+            }
+        }
+
+        std::ranges::sort(ret.m_symbols, {}, &symbol::address);
+
+        return ret;
+    }
+
+    static auto from_file(std::string_view filename) -> stf::expected<symbol_table, std::string_view> {
+        auto ifs = std::ifstream(std::filesystem::path(filename), std::ios::binary);
+        if (!ifs) {
+            return stf::unexpected{"could not open file"};
+        }
+
+        const auto image = std::vector<u8>(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+        return from_image(image);
+    }
+
+    /// The function containing `address`. Functions with no size (hand-written assembly often lacks `.size`) are taken to extend until the
+    /// next function.
+    auto function_at(u64 address) const -> symbol const* {
+        const auto it = std::ranges::upper_bound(m_symbols, address, {}, &symbol::address);
+
+        for (auto rit = std::make_reverse_iterator(it); rit != m_symbols.rend(); rit++) {
+            if (!rit->is_function) {
+                continue;
+            }
+
+            if (rit->size == 0 || address - rit->address < rit->size) {
+                return &*rit;
+            }
+
+            break;
+        }
+
+        return nullptr;
+    }
+
+    auto find(std::string_view name) const -> symbol const* {
+        const auto it = std::ranges::find(m_symbols, name, &symbol::name);
+        return it == m_symbols.end() ? nullptr : &*it;
+    }
+
+    auto symbols() const -> std::span<const symbol> { return m_symbols; }
+
+private:
+    std::vector<symbol> m_symbols{};
+};
+
+struct segment {
+    /// the physical address, like `objcopy` goes by, so that sections that get copied to RAM by the startup code are at their load address
+    u64 address;
+    /// the part of the segment that is in the image, the rest up to `memory_size` is zeroes
+    std::span<const u8> contents;
+    u64 memory_size;
+    /// PF_X, where the code is
+    bool is_executable;
+};
+
+/// The entry point and the loadable segments of a little-endian ELF32 or ELF64 executable. The segments refer into the image.
+struct executable {
+    static auto from_image(std::span<const u8> image) -> stf::expected<executable, std::string_view> {
+        const auto reader = detail::reader{image};
+        const auto is_64_bit = TRYX(detail::check_identification(image));
+
+        auto ret = executable{
+          .entry = TRYX(reader.read_word(0x18, is_64_bit)),
+          .is_64_bit = is_64_bit,
+          .segments = {},
+        };
+
+        const auto program_header_offset = TRYX(reader.read_word(is_64_bit ? 0x20 : 0x1C, is_64_bit));
+        const auto program_header_size = TRYX(reader.read<u16>(is_64_bit ? 0x36 : 0x2A));
+        const auto num_program_headers = TRYX(reader.read<u16>(is_64_bit ? 0x38 : 0x2C));
+
+        for (usize i = 0; i < num_program_headers; i++) {
+            const auto base = program_header_offset + i * program_header_size;
+
+            // PT_LOAD
+            if (TRYX(reader.read<u32>(base)) != 1) {
+                continue;
+            }
+
+            const auto flags = TRYX(reader.read<u32>(base + (is_64_bit ? 0x04 : 0x18)));
+            const auto offset = TRYX(reader.read_word(base + (is_64_bit ? 0x08 : 0x04), is_64_bit));
+            const auto address = TRYX(reader.read_word(base + (is_64_bit ? 0x18 : 0x0C), is_64_bit));
+            const auto file_size = TRYX(reader.read_word(base + (is_64_bit ? 0x20 : 0x10), is_64_bit));
+            const auto memory_size = TRYX(reader.read_word(base + (is_64_bit ? 0x28 : 0x14), is_64_bit));
+
+            if (offset > image.size() || image.size() - offset < file_size) {
+                return stf::unexpected{"segment extends past the end of the ELF image"};
+            }
+
+            if (file_size > memory_size) {
+                return stf::unexpected{"segment is larger in the image than in memory"};
+            }
+
+            ret.segments.emplace_back(segment{
+              .address = address,
+              .contents = image.subspan(offset, file_size),
+              .memory_size = memory_size,
+              .is_executable = (flags & 1) != 0,
+            });
+        }
+
+        return ret;
+    }
+
+    u64 entry;
+    bool is_64_bit;
+    std::vector<segment> segments;
+};
+
+}  // namespace rv::elf
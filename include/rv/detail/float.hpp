@@ -0,0 +1,378 @@
+#pragma once
+
+#include <stuff/core.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cfenv>
+#include <cmath>
+#include <concepts>
+#include <limits>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define RV_HOST_MXCSR 1
+#else
+#define RV_HOST_MXCSR 0
+#endif
+
+namespace rv {
+
+/// The `rm` field of floating point instructions and the `frm` CSR.
+enum class rounding_mode : u32 {
+    nearest_even = 0b000,
+    towards_zero = 0b001,
+    down = 0b010,
+    up = 0b011,
+    nearest_max_magnitude = 0b100,
+    /// only valid in the `rm` field, where it stands for `frm`
+    dynamic = 0b111,
+};
+
+constexpr auto rounding_mode_name(u32 mode) -> std::string_view {
+    constexpr std::string_view names[]{"rne", "rtz", "rdn", "rup", "rmm", "invalid(5)", "invalid(6)", "dyn"};
+    return names[mode & 0b111];
+}
+
+/// The accrued exception flags in `fflags`.
+namespace float_flags {
+
+inline constexpr u32 inexact = 0x01;
+inline constexpr u32 underflow = 0x02;
+inline constexpr u32 overflow = 0x04;
+inline constexpr u32 divide_by_zero = 0x08;
+inline constexpr u32 invalid = 0x10;
+
+}  // namespace float_flags
+
+template<std::floating_point T>
+using float_bits_t = std::conditional_t<sizeof(T) == sizeof(u32), u32, u64>;
+
+template<std::floating_point T>
+    requires(std::numeric_limits<T>::is_iec559 && (sizeof(T) == sizeof(u32) || sizeof(T) == sizeof(u64)))
+constexpr auto canonical_nan() -> T {
+    if constexpr (sizeof(T) == sizeof(u32)) {
+        return std::bit_cast<T>(u32(0x7FC0'0000u));
+    } else {
+        return std::bit_cast<T>(u64(0x7FF8'0000'0000'0000ull));
+    }
+}
+
+template<std::floating_point T>
+constexpr auto is_signaling_nan(T value) -> bool {
+    using bits_type = float_bits_t<T>;
+    constexpr auto exponent_mask = std::bit_cast<bits_type>(std::numeric_limits<T>::infinity());
+    constexpr auto quiet_bit = bits_type(1) << (std::numeric_limits<T>::digits - 2);
+
+    const auto bits = std::bit_cast<bits_type>(value);
+    return (bits & exponent_mask) == exponent_mask && (bits & ~exponent_mask & (quiet_bit - 1)) != 0 && (bits & quiet_bit) == 0;
+}
+
+/// Replaces NaNs with the canonical NaN, RISC-V doesn't propagate NaN payloads.
+template<std::floating_point T>
+constexpr auto canonicalize(T value) -> T {
+    return value != value ? canonical_nan<T>() : value;
+}
+
+/// Single precision values live in the lower half of the 64 bit float registers with the upper half set.
+template<std::floating_point T>
+constexpr auto nan_box_bits(float_bits_t<T> bits) -> u64 {
+    if constexpr (sizeof(T) == sizeof(u32)) {
+        return 0xFFFF'FFFF'0000'0000ull | bits;
+    } else {
+        return bits;
+    }
+}
+
+template<std::floating_point T>
+constexpr auto nan_box(T value) -> u64 {
+    return nan_box_bits<T>(std::bit_cast<float_bits_t<T>>(value));
+}
+
+/// The value in a float register, single precision values that aren't properly NaN-boxed read as the canonical NaN.
+template<std::floating_point T>
+constexpr auto nan_unbox(u64 bits) -> T {
+    if constexpr (sizeof(T) == sizeof(u32)) {
+        return (bits >> 32) == 0xFFFF'FFFFu ? std::bit_cast<T>(static_cast<u32>(bits)) : canonical_nan<T>();
+    } else {
+        return std::bit_cast<T>(bits);
+    }
+}
+
+/// The mask `fclass` writes.
+template<std::floating_point T>
+constexpr auto classify(T value) -> u32 {
+    const auto negative = std::signbit(value);
+
+    switch (std::fpclassify(value)) {
+        case FP_INFINITE: return negative ? 1u << 0 : 1u << 7;
+        case FP_NORMAL: return negative ? 1u << 1 : 1u << 6;
+        case FP_SUBNORMAL: return negative ? 1u << 2 : 1u << 5;
+        case FP_ZERO: return negative ? 1u << 3 : 1u << 4;
+        default: return is_signaling_nan(value) ? 1u << 8 : 1u << 9;
+    }
+}
+
+namespace detail {
+
+/// Keeps the compiler from moving the arithmetic that `value` goes into or comes out of across changes to the floating point environment.
+template<typename T>
+inline auto float_barrier(T value) -> T {
+#if defined(__GNUC__)
+    asm volatile("" : "+m"(value));
+#endif
+    return value;
+}
+
+/// Makes a value that was rounded towards zero odd if the rounding was inexact, rounding that again into a format at least two bits
+/// narrower gives what rounding the exact value into it would have.
+template<std::floating_point T>
+auto round_to_odd(T truncated) -> T {
+    if (!std::isfinite(truncated)) {
+        return truncated;
+    }
+
+    int exponent;
+    const auto significand = std::ldexp(std::frexp(truncated, &exponent), std::numeric_limits<T>::digits);
+    if (std::fmod(significand, T(2)) != 0) {
+        return truncated;
+    }
+
+    return std::nextafter(truncated, std::copysign(std::numeric_limits<T>::infinity(), truncated));
+}
+
+}  // namespace detail
+
+/// Runs floating point operations on the host in a rounding mode and collects the exceptions they raise, the environment of the host is
+/// restored afterwards. `rounding_mode::nearest_max_magnitude` has no host equivalent and is not to be passed in.
+///
+/// Only the SSE control register gets touched on x86-64, which is quicker than going through `<cfenv>`. Operations on `long double` (which
+/// is x87 there) need `LongDouble` to be set.
+template<bool LongDouble = false>
+struct host_float_scope {
+    explicit host_float_scope(rounding_mode mode) {
+#if RV_HOST_MXCSR
+        if constexpr (!LongDouble) {
+            m_saved_csr = _mm_getcsr();
+            // all exceptions masked and their flags cleared, subnormals neither flushed nor treated as zero
+            _mm_setcsr(0x1F80u | (mxcsr_rounding(mode) << 13));
+            return;
+        }
+#endif
+
+        std::fegetenv(&m_saved_environment);
+        std::feclearexcept(FE_ALL_EXCEPT);
+        std::fesetround(host_rounding(mode));
+    }
+
+    ~host_float_scope() {
+#if RV_HOST_MXCSR
+        if constexpr (!LongDouble) {
+            _mm_setcsr(m_saved_csr);
+            return;
+        }
+#endif
+
+        std::fesetenv(&m_saved_environment);
+    }
+
+    host_float_scope(host_float_scope const&) = delete;
+    host_float_scope(host_float_scope&&) = delete;
+
+    /// the `float_flags` raised since the scope was entered
+    auto flags() const -> u32 {
+#if RV_HOST_MXCSR
+        if constexpr (!LongDouble) {
+            // the denormal operand flag (bit 1) has no counterpart
+            const auto csr = _mm_getcsr();
+            return ((csr & 0x01) != 0 ? float_flags::invalid : 0u)         //
+                 | ((csr & 0x04) != 0 ? float_flags::divide_by_zero : 0u)  //
+                 | ((csr & 0x08) != 0 ? float_flags::overflow : 0u)        //
+                 | ((csr & 0x10) != 0 ? float_flags::underflow : 0u)       //
+                 | ((csr & 0x20) != 0 ? float_flags::inexact : 0u);
+        }
+#endif
+
+        const auto raised = std::fetestexcept(FE_ALL_EXCEPT);
+        return ((raised & FE_INVALID) != 0 ? float_flags::invalid : 0u)         //
+             | ((raised & FE_DIVBYZERO) != 0 ? float_flags::divide_by_zero : 0u)  //
+             | ((raised & FE_OVERFLOW) != 0 ? float_flags::overflow : 0u)        //
+             | ((raised & FE_UNDERFLOW) != 0 ? float_flags::underflow : 0u)      //
+             | ((raised & FE_INEXACT) != 0 ? float_flags::inexact : 0u);
+    }
+
+private:
+    std::fenv_t m_saved_environment{};
+    u32 m_saved_csr = 0;
+
+    static constexpr auto mxcsr_rounding(rounding_mode mode) -> u32 {
+        switch (mode) {
+            case rounding_mode::towards_zero: return 0b11;
+            case rounding_mode::down: return 0b01;
+            case rounding_mode::up: return 0b10;
+            default: return 0b00;
+        }
+    }
+
+    static constexpr auto host_rounding(rounding_mode mode) -> int {
+        switch (mode) {
+            case rounding_mode::towards_zero: return FE_TOWARDZERO;
+            case rounding_mode::down: return FE_DOWNWARD;
+            case rounding_mode::up: return FE_UPWARD;
+            default: return FE_TONEAREST;
+        }
+    }
+};
+
+/// Rounds `value` into `T` to the nearest, with ties away from zero, along with the flags that raises. Tininess is detected after
+/// rounding, like RISC-V does.
+template<std::floating_point T, std::floating_point Wide>
+auto round_to_nearest_max_magnitude(Wide value) -> std::pair<T, u32> {
+    if (!std::isfinite(value) || value == 0) {
+        return {static_cast<T>(value), 0};
+    }
+
+    constexpr auto digits = std::numeric_limits<T>::digits;
+    constexpr auto min_exponent = std::numeric_limits<T>::min_exponent - 1;
+
+    const auto magnitude = std::fabs(value);
+    const auto exponent = static_cast<int>(std::ilogb(magnitude));
+
+    // all of these are exact, `Wide` has the range and the precision for it
+    const auto round = [magnitude](int quantum_exponent) -> std::pair<Wide, bool> {
+        const auto scaled = std::ldexp(magnitude, -quantum_exponent);
+        const auto integral = std::trunc(scaled);
+        const auto fraction = scaled - integral;
+        return {std::ldexp(fraction >= Wide(0.5) ? integral + 1 : integral, quantum_exponent), fraction != 0};
+    };
+
+    const auto [rounded, inexact] = round(std::max(exponent, min_exponent) - (digits - 1));
+
+    if (rounded > static_cast<Wide>(std::numeric_limits<T>::max())) {
+        constexpr auto infinity = std::numeric_limits<T>::infinity();
+        return {std::signbit(value) ? -infinity : infinity, float_flags::overflow | float_flags::inexact};
+    }
+
+    if (!inexact) {
+        return {static_cast<T>(value), 0};
+    }
+
+    auto flags = float_flags::inexact;
+
+    if (exponent < min_exponent && round(exponent - (digits - 1)).first < std::ldexp(Wide(1), min_exponent)) {
+        flags |= float_flags::underflow;
+    }
+
+    return {static_cast<T>(std::copysign(rounded, value)), flags};
+}
+
+namespace detail {
+
+template<std::floating_point T>
+using wider_float_t = std::conditional_t<sizeof(T) == sizeof(u32), double, long double>;
+
+}  // namespace detail
+
+/// Evaluates `op(operands...)` as an operation that rounds into `T` in `mode`, returning the result with NaNs canonicalized along with the
+/// flags it raised.
+///
+/// The host does the arithmetic. For `rounding_mode::nearest_max_magnitude`, which hosts don't have, the operation is done in a wider
+/// format rounding to odd and the result gets rounded into `T` in software. Where `long double` isn't wide enough for that (it has to have
+/// at least 55 bits of precision) double precision operations in that mode get rounded to the nearest even instead.
+template<std::floating_point T, typename Op, typename... Ts>
+auto host_evaluate(rounding_mode mode, Op&& op, Ts... operands) -> std::pair<T, u32> {
+    using wide_type = detail::wider_float_t<T>;
+    constexpr auto wide_enough = std::numeric_limits<wide_type>::digits >= std::numeric_limits<T>::digits + 2;
+
+    if (mode != rounding_mode::nearest_max_magnitude || !wide_enough) [[likely]] {
+        const auto scope = host_float_scope<>(mode == rounding_mode::nearest_max_magnitude ? rounding_mode::nearest_even : mode);
+        const auto result = detail::float_barrier(static_cast<T>(op(detail::float_barrier(operands)...)));
+        return {canonicalize(result), scope.flags()};
+    }
+
+    auto signaling = false;
+    ([&] {
+        if constexpr (std::floating_point<Ts>) {
+            signaling |= is_signaling_nan(operands);
+        }
+    }(), ...);
+
+    auto wide_result = wide_type(0);
+    auto wide_flags = u32(0);
+    {
+        const auto scope = host_float_scope<std::is_same_v<wide_type, long double>>(rounding_mode::towards_zero);
+        wide_result = detail::float_barrier(static_cast<wide_type>(op(static_cast<wide_type>(detail::float_barrier(operands))...)));
+        wide_flags = scope.flags();
+    }
+
+    if ((wide_flags & float_flags::inexact) != 0) {
+        wide_result = detail::round_to_odd(wide_result);
+    }
+
+    const auto [result, flags] = round_to_nearest_max_magnitude<T>(wide_result);
+    const auto invalid = signaling ? float_flags::invalid : 0u;
+    return {canonicalize(result), (wide_flags & (float_flags::invalid | float_flags::divide_by_zero)) | invalid | flags};
+}
+
+/// Converts `value` into an integer the way `fcvt.w.s` and friends do: out of range values saturate, NaNs become the largest integer and
+/// both raise the invalid flag (without raising inexact).
+template<std::integral I, std::floating_point T>
+auto convert_to_integer(T value, rounding_mode mode) -> std::pair<I, u32> {
+    if (value != value) {
+        return {std::numeric_limits<I>::max(), float_flags::invalid};
+    }
+
+    // none of these depend on the floating point environment, `nearbyint` rounds to the nearest even in the default one
+    const auto rounded = ([&] {
+        switch (mode) {
+            case rounding_mode::towards_zero: return std::trunc(value);
+            case rounding_mode::down: return std::floor(value);
+            case rounding_mode::up: return std::ceil(value);
+            case rounding_mode::nearest_max_magnitude: return std::round(value);
+            default: return std::nearbyint(value);
+        }
+    })();
+
+    constexpr auto bits = std::numeric_limits<I>::digits;
+    const auto lower = std::is_signed_v<I> ? -std::ldexp(T(1), bits) : T(0);
+    const auto upper = std::ldexp(T(1), bits);
+
+    if (rounded < lower) {
+        return {std::numeric_limits<I>::min(), float_flags::invalid};
+    }
+
+    if (rounded >= upper) {
+        return {std::numeric_limits<I>::max(), float_flags::invalid};
+    }
+
+    return {static_cast<I>(rounded), rounded != value ? float_flags::inexact : 0u};
+}
+
+/// `fmin`/`fmax`: a NaN operand loses to a number, -0 is less than +0 and signaling NaNs raise the invalid flag.
+template<bool Max, std::floating_point T>
+constexpr auto float_min_max(T lhs, T rhs) -> std::pair<T, u32> {
+    const auto flags = is_signaling_nan(lhs) || is_signaling_nan(rhs) ? float_flags::invalid : 0u;
+
+    if (lhs != lhs && rhs != rhs) {
+        return {canonical_nan<T>(), flags};
+    }
+
+    if (lhs != lhs) {
+        return {rhs, flags};
+    }
+
+    if (rhs != rhs) {
+        return {lhs, flags};
+    }
+
+    if (lhs == rhs) {
+        return {std::signbit(lhs) != Max ? lhs : rhs, flags};
+    }
+
+    return {(lhs < rhs) != Max ? lhs : rhs, flags};
+}
+
+}  // namespace rv
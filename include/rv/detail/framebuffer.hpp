@@ -0,0 +1,182 @@
+#pragma once
+
+#include <rv/detail/memory.hpp>
+
+#include <stuff/core.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+namespace rv {
+
+enum class pixel_format : u32 {
+    gray8 = 0,
+    rgb565 = 1,
+    /// bytes in R, G, B, A order
+    rgba8888 = 2,
+};
+
+constexpr auto bytes_per_pixel(pixel_format format) -> usize {
+    switch (format) {
+        case pixel_format::gray8: return 1;
+        case pixel_format::rgb565: return 2;
+        case pixel_format::rgba8888: return 4;
+    }
+    return 1;
+}
+
+struct framebuffer_config {
+    /// where the pixels are in RAM
+    u64 address = 0;
+    u32 width = 0;
+    u32 height = 0;
+    pixel_format format = pixel_format::gray8;
+
+    constexpr auto operator==(framebuffer_config const&) const -> bool = default;
+
+    constexpr auto stride() const -> usize { return width * bytes_per_pixel(format); }
+    constexpr auto size() const -> usize { return stride() * height; }
+    constexpr auto enabled() const -> bool { return width != 0 && height != 0; }
+};
+
+/// The control registers of a display that scans out of guest RAM, like the display controllers of most SoCs do.
+///
+/// The pixels are plain RAM, the guest draws at full speed and what changed is found through the page generations of the memory (or of a
+/// `memory_snapshot` of it) with `dirty_rows`. The registers are:
+/// - 0x00: the address of the pixels, 8 bytes
+/// - 0x08: the width, 4 bytes
+/// - 0x0C: the height, 4 bytes
+/// - 0x10: the `pixel_format`, 4 bytes
+/// Setting the width or the height to zero turns the display off. The registers can be read from any thread through `config`.
+struct framebuffer final : mmio_device {
+    static constexpr usize register_span = 0x14;
+
+    explicit framebuffer(framebuffer_config config = {}) { set_config(config); }
+
+    auto load(u64 offset, usize size) -> u64 override {
+        auto registers = std::array<u8, register_span>{};
+        const auto config = this->config();
+        std::memcpy(registers.data() + 0x00, &config.address, 8);
+        std::memcpy(registers.data() + 0x08, &config.width, 4);
+        std::memcpy(registers.data() + 0x0C, &config.height, 4);
+        std::memcpy(registers.data() + 0x10, &config.format, 4);
+
+        u64 ret = 0;
+        std::memcpy(&ret, registers.data() + offset, std::min(size, register_span - offset));
+        return ret;
+    }
+
+    void store(u64 offset, usize size, u64 value) override {
+        auto config = this->config();
+
+        const auto write = [&](auto& field, u64 field_offset) {
+            for (usize i = 0; i < size; i++) {
+                if (offset + i < field_offset || offset + i >= field_offset + sizeof(field)) {
+                    continue;
+                }
+
+                const auto shift = (offset + i - field_offset) * 8;
+                auto bits = static_cast<u64>(field);
+                bits = (bits & ~(u64(0xFF) << shift)) | (((value >> (i * 8)) & 0xFF) << shift);
+                field = static_cast<std::remove_cvref_t<decltype(field)>>(bits);
+            }
+        };
+
+        write(config.address, 0x00);
+        write(config.width, 0x08);
+        write(config.height, 0x0C);
+        write(config.format, 0x10);
+
+        if (static_cast<u32>(config.format) > static_cast<u32>(pixel_format::rgba8888)) {
+            config.format = pixel_format::gray8;
+        }
+
+        set_config(config);
+    }
+
+    auto config() const -> framebuffer_config {
+        return {
+          .address = m_address.load(std::memory_order_relaxed),
+          .width = m_width.load(std::memory_order_relaxed),
+          .height = m_height.load(std::memory_order_relaxed),
+          .format = m_format.load(std::memory_order_relaxed),
+        };
+    }
+
+    void set_config(framebuffer_config const& config) {
+        m_address.store(config.address, std::memory_order_relaxed);
+        m_width.store(config.width, std::memory_order_relaxed);
+        m_height.store(config.height, std::memory_order_relaxed);
+        m_format.store(config.format, std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<u64> m_address{0};
+    std::atomic<u32> m_width{0};
+    std::atomic<u32> m_height{0};
+    std::atomic<pixel_format> m_format{pixel_format::gray8};
+};
+
+/// The first and one past the last row of the framebuffer in `memory` that are on pages with a generation of at least `since`.
+template<typename Memory>
+auto dirty_rows(Memory const& memory, framebuffer_config const& config, u64 since) -> std::optional<std::pair<u32, u32>> {
+    if (!config.enabled() || config.address >= memory.size() || memory.size() - config.address < config.size()) {
+        return std::nullopt;
+    }
+
+    const auto first_page = config.address / Memory::page_size;
+    const auto last_page = (config.address + config.size() - 1) / Memory::page_size;
+
+    auto first_dirty = std::optional<usize>{};
+    auto last_dirty = usize(0);
+    for (auto page = first_page; page <= last_page; page++) {
+        if (memory.page_generation(page) >= since) {
+            first_dirty = first_dirty.value_or(page);
+            last_dirty = page;
+        }
+    }
+
+    if (!first_dirty) {
+        return std::nullopt;
+    }
+
+    const auto begin = std::max<u64>(*first_dirty * Memory::page_size, config.address) - config.address;
+    const auto end = std::min<u64>((last_dirty + 1) * Memory::page_size - config.address, config.size());
+    return std::pair{static_cast<u32>(begin / config.stride()), static_cast<u32>((end + config.stride() - 1) / config.stride())};
+}
+
+/// Converts `width` pixels of `format` into RGBA8888.
+inline void convert_to_rgba(pixel_format format, std::span<const u8> pixels, u8* out, usize width) {
+    for (usize x = 0; x < width; x++, out += 4) {
+        switch (format) {
+            case pixel_format::gray8: {
+                out[0] = out[1] = out[2] = pixels[x];
+                out[3] = 0xFF;
+                break;
+            }
+            case pixel_format::rgb565: {
+                const auto pixel = static_cast<u16>(pixels[x * 2] | (pixels[x * 2 + 1] << 8));
+                const auto r = (pixel >> 11) & 0x1F;
+                const auto g = (pixel >> 5) & 0x3F;
+                const auto b = pixel & 0x1F;
+                out[0] = static_cast<u8>((r << 3) | (r >> 2));
+                out[1] = static_cast<u8>((g << 2) | (g >> 4));
+                out[2] = static_cast<u8>((b << 3) | (b >> 2));
+                out[3] = 0xFF;
+                break;
+            }
+            case pixel_format::rgba8888: {
+                std::memcpy(out, pixels.data() + x * 4, 4);
+                break;
+            }
+        }
+    }
+}
+
+}  // namespace rv
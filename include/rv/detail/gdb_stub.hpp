@@ -0,0 +1,599 @@
+#pragma once
+
+#include <rv/detail/rv.hpp>
+
+#include <stuff/core.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <charconv>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace rv {
+
+enum class gdb_stub_state {
+    /// waiting for commands
+    stopped,
+    /// continuing, `gdb_stub::resume` is to be called until the target stops
+    running,
+    detached,
+    killed,
+};
+
+namespace detail {
+
+inline auto parse_hex(std::string_view str) -> std::optional<u64> {
+    u64 ret = 0;
+    const auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), ret, 16);
+    if (str.empty() || ec != std::errc{} || ptr != str.data() + str.size()) {
+        return std::nullopt;
+    }
+
+    return ret;
+}
+
+/// splits "addr,length" as found in `m`, `M`, `X` and `Z` packets
+inline auto parse_address_length(std::string_view str) -> std::optional<std::pair<u64, u64>> {
+    const auto comma = str.find(',');
+    if (comma == std::string_view::npos) {
+        return std::nullopt;
+    }
+
+    const auto address = parse_hex(str.substr(0, comma));
+    const auto length = parse_hex(str.substr(comma + 1));
+    if (!address || !length) {
+        return std::nullopt;
+    }
+
+    return std::pair{*address, *length};
+}
+
+/// whether an instruction can go anywhere but to the next one: branches, jumps and everything under SYSTEM (traps, returns from traps and
+/// the CSR accesses, which can change what the traps do)
+/// With `memory_accesses` loads, stores and atomics count too, so that a block has at most one access to check for watch hits.
+constexpr auto ends_block(u32 word, bool memory_accesses) -> bool {
+    switch (word & 0x7F) {
+        case 0b11000'11:
+        case 0b11011'11:
+        case 0b11001'11:
+        case 0b11100'11: return true;
+        case 0b00000'11:
+        case 0b01000'11:
+        case 0b01011'11: return memory_accesses;
+        default: return false;
+    }
+}
+
+}  // namespace detail
+
+/// A GDB remote serial protocol stub, it handles the packets and leaves the transport to the caller.
+/// Breakpoints are kept by the stub rather than patched into memory, and hardware breakpoints are the same as software ones. Continuing runs
+/// straight-line blocks of instructions through `risc_v::run` and only looks for breakpoints between blocks. The blocks are cut short
+/// before breakpoints and are cached until breakpoints change or the memory they are in gets written.
+/// Watchpoints are `memory` watches, blocks end after every memory access while there are any so that the target stops right after the
+/// access that hit.
+template<typename RiscV>
+struct gdb_stub {
+    using register_type = typename RiscV::register_type;
+
+    static constexpr usize max_block_length = 64;
+
+    explicit gdb_stub(RiscV& risc_v)
+        : m_risc_v(risc_v) {}
+
+    auto state() const -> gdb_stub_state { return m_state; }
+
+    /// Handles `data` received from the debugger, returns what to send back.
+    auto receive(std::string_view data) -> std::string {
+        auto ret = std::string{};
+        m_input.append(data);
+
+        while (!m_input.empty()) {
+            const auto c = m_input.front();
+
+            if (c == '\x03') {
+                m_input.erase(0, 1);
+                if (m_state == gdb_stub_state::running) {
+                    ret += stop(2);
+                }
+                continue;
+            }
+
+            if (c == '-') {
+                m_input.erase(0, 1);
+                ret += m_last_reply;
+                continue;
+            }
+
+            if (c != '$') {
+                // acks and line noise
+                m_input.erase(0, 1);
+                continue;
+            }
+
+            const auto end = m_input.find('#');
+            if (end == std::string::npos || m_input.size() < end + 3) {
+                break;
+            }
+
+            const auto body = std::string(m_input, 1, end - 1);
+            const auto checksum = detail::parse_hex(std::string_view(m_input).substr(end + 1, 2));
+            m_input.erase(0, end + 3);
+
+            if (checksum != checksum_of(body)) {
+                ret += '-';
+                continue;
+            }
+
+            if (!m_no_ack) {
+                ret += '+';
+            }
+
+            if (const auto reply = handle(body); reply) {
+                ret += frame(*reply);
+            }
+        }
+
+        return ret;
+    }
+
+    /// Continues for at most `max_instructions`, returns the stop reply to send if the target stopped.
+    auto resume(u64 max_instructions) -> std::string {
+        auto executed = u64(0);
+
+        while (m_state == gdb_stub_state::running && executed < max_instructions) {
+            auto const& block = block_at(static_cast<u64>(m_risc_v.m_program_counter));
+            const auto taken = m_risc_v.m_trap.taken();
+            // a trap ends the block where it is taken, whatever of the block is left doesn't run and the handler is a block of its own
+            const auto block_executed = m_risc_v.template run<true>(block.length);
+            executed += block_executed;
+
+            if (!m_risc_v.m_memory.watches().empty()) {
+                if (const auto hits = m_risc_v.m_memory.consume_watch_hits(); !hits.empty()) {
+                    return stop(5, watch_stop_reason(hits.front()));
+                }
+            }
+
+            const auto program_counter = static_cast<u64>(m_risc_v.m_program_counter);
+            if (taken != m_risc_v.m_trap.taken()) {
+                if (m_breakpoints.contains(program_counter)) {
+                    return stop(5);
+                }
+
+                continue;
+            }
+
+            // instructions that don't go anywhere, e.g. `j .`, halt and make `run` stop early unless they are the last one
+            if (block_executed != block.length || program_counter == block.last || m_breakpoints.contains(program_counter)) {
+                return stop(5);
+            }
+        }
+
+        return {};
+    }
+
+private:
+    struct block {
+        /// in instructions
+        usize length;
+        /// the address of the last instruction
+        u64 last;
+        /// `memory::advance_generation` at the time the block was decoded, it is stale if its pages got written after
+        u64 generation;
+        usize first_page;
+        usize last_page;
+    };
+
+    RiscV& m_risc_v;
+    gdb_stub_state m_state = gdb_stub_state::stopped;
+
+    std::string m_input{};
+    std::string m_last_reply{};
+    bool m_no_ack = false;
+    u8 m_last_signal = 5;
+
+    std::unordered_set<u64> m_breakpoints{};
+    std::unordered_map<u64, block> m_blocks{};
+
+    static constexpr auto xlen = sizeof(register_type);
+    static constexpr auto page_shift = decltype(std::declval<RiscV&>().m_memory)::page_shift;
+
+    static auto checksum_of(std::string_view data) -> u8 {
+        u8 ret = 0;
+        for (const auto c : data) {
+            ret += static_cast<u8>(c);
+        }
+        return ret;
+    }
+
+    auto frame(std::string_view reply) -> std::string {
+        auto escaped = std::string{};
+        escaped.reserve(reply.size());
+
+        for (const auto c : reply) {
+            if (c == '$' || c == '#' || c == '}' || c == '*') {
+                escaped += '}';
+                escaped += static_cast<char>(c ^ 0x20);
+            } else {
+                escaped += c;
+            }
+        }
+
+        m_last_reply = fmt::format("${}#{:02x}", escaped, checksum_of(escaped));
+        return m_last_reply;
+    }
+
+    auto stop(u8 signal, std::string_view reason = {}) -> std::string {
+        m_state = gdb_stub_state::stopped;
+        m_last_signal = signal;
+        return frame(reason.empty() ? fmt::format("S{:02x}", signal) : fmt::format("T{:02x}{}", signal, reason));
+    }
+
+    /// gdb finds the watchpoint by the address, which has to be in the watched range even if the access starts before it
+    static auto watch_stop_reason(memory_watch_hit<register_type> const& hit) -> std::string {
+        const auto* const kind = hit.watch.type == watch_type::write ? "watch" : hit.watch.type == watch_type::read ? "rwatch" : "awatch";
+        return fmt::format("{}:{:x};", kind, static_cast<u64>(std::max(hit.address, hit.watch.address)));
+    }
+
+    /// the block that starts at `address`, it ends after the first instruction that changes the control flow or before the first breakpoint
+    auto block_at(u64 address) -> block const& {
+        auto& memory = m_risc_v.m_memory;
+
+        if (const auto it = m_blocks.find(address); it != m_blocks.end()) {
+            auto const& cached = it->second;
+
+            auto stale = false;
+            for (auto page = cached.first_page; page <= cached.last_page && !stale; page++) {
+                stale = memory.page_generation(page) > cached.generation;
+            }
+
+            if (!stale) {
+                return cached;
+            }
+        }
+
+        auto length = 0uz;
+        auto last = address;
+        auto end = address;
+
+        while (length < max_block_length && end < memory.size()) {
+            if (length != 0 && m_breakpoints.contains(end)) {
+                break;
+            }
+
+            const auto word = memory.template read<u32>(static_cast<register_type>(end));
+            auto expanded = word;
+            if (const auto props = m_risc_v.m_isa.match(word); props && props->translator != nullptr) {
+                expanded = props->translator(word);
+            }
+
+            length++;
+            last = end;
+            end += (word & 0b11) == 0b11 ? 4 : 2;
+
+            if (detail::ends_block(expanded, !memory.watches().empty())) {
+                break;
+            }
+        }
+
+        const auto clamped_end = std::min<u64>(std::max<u64>(end, address + 1), memory.size());
+
+        return m_blocks[address] = block{
+                 .length = std::max(length, 1uz),
+                 .last = last,
+                 .generation = memory.advance_generation(),
+                 .first_page = static_cast<usize>(std::min<u64>(address, memory.size() - 1) >> page_shift),
+                 .last_page = static_cast<usize>((clamped_end - 1) >> page_shift),
+               };
+    }
+
+    auto read_registers() -> std::string {
+        auto ret = std::string{};
+        for (usize i = 0; i < 32; i++) {
+            append_register(ret, m_risc_v.read_register(static_cast<reg>(i)));
+        }
+        append_register(ret, m_risc_v.m_program_counter);
+        return ret;
+    }
+
+    static void append_register(std::string& out, register_type value) {
+        for (usize i = 0; i < xlen; i++) {
+            fmt::format_to(std::back_inserter(out), "{:02x}", static_cast<u8>(value >> (i * 8)));
+        }
+    }
+
+    static auto parse_register(std::string_view hex) -> std::optional<register_type> {
+        if (hex.size() != xlen * 2) {
+            return std::nullopt;
+        }
+
+        auto ret = register_type(0);
+        for (usize i = 0; i < xlen; i++) {
+            const auto byte = detail::parse_hex(hex.substr(i * 2, 2));
+            if (!byte) {
+                return std::nullopt;
+            }
+            ret |= static_cast<register_type>(*byte) << (i * 8);
+        }
+
+        return ret;
+    }
+
+    /// registers are numbered like in the target description: x0 to x31, then the pc
+    auto write_register(usize number, register_type value) -> bool {
+        if (number < 32) {
+            m_risc_v.m_register_bank.write_register(static_cast<reg>(number), value);
+        } else if (number == 32) {
+            m_risc_v.m_program_counter = value;
+        } else {
+            return false;
+        }
+
+        return true;
+    }
+
+    /// the part of `[address, address + length)` that is in memory, nothing if `address` isn't
+    auto memory_range(u64 address, u64 length) const -> std::optional<std::span<u8>> {
+        auto& memory = m_risc_v.m_memory;
+        if (address >= memory.size()) {
+            return std::nullopt;
+        }
+
+        return std::span<u8>(memory.data() + address, std::min<u64>(length, memory.size() - address));
+    }
+
+    auto target_description() const -> std::string {
+        auto ret = std::string{};
+        ret += R"(<?xml version="1.0"?><!DOCTYPE target SYSTEM "gdb-target.dtd"><target version="1.0">)";
+        fmt::format_to(std::back_inserter(ret), "<architecture>riscv:rv{}</architecture>", xlen * 8);
+        ret += R"(<feature name="org.gnu.gdb.riscv.cpu">)";
+
+        for (usize i = 0; i < 32; i++) {
+            const auto type = i == 1 ? "code_ptr" : i == 2 || i == 8 ? "data_ptr" : "int";
+            fmt::format_to(std::back_inserter(ret), R"(<reg name="x{}" bitsize="{}" type="{}" regnum="{}"/>)", i, xlen * 8, type, i);
+        }
+
+        fmt::format_to(std::back_inserter(ret), R"(<reg name="pc" bitsize="{}" type="code_ptr" regnum="32"/>)", xlen * 8);
+        ret += "</feature></target>";
+
+        return ret;
+    }
+
+    /// the reply to `packet`, nothing if there is none yet (i.e. when continuing)
+    auto handle(std::string_view packet) -> std::optional<std::string> {
+        if (packet.empty()) {
+            return "";
+        }
+
+        const auto command = packet.front();
+        const auto args = packet.substr(1);
+
+        switch (command) {
+            case '?': return fmt::format("S{:02x}", m_last_signal);
+            case 'g': return read_registers();
+            case 'G': {
+                for (usize i = 0; i < 33; i++) {
+                    const auto value = parse_register(args.substr(std::min(args.size(), i * xlen * 2), xlen * 2));
+                    if (!value) {
+                        return "E01";
+                    }
+                    write_register(i, *value);
+                }
+                return "OK";
+            }
+            case 'p': {
+                const auto number = detail::parse_hex(args);
+                if (!number || *number > 32) {
+                    return "E01";
+                }
+
+                auto ret = std::string{};
+                append_register(ret, *number == 32 ? m_risc_v.m_program_counter : m_risc_v.read_register(static_cast<reg>(*number)));
+                return ret;
+            }
+            case 'P': {
+                const auto equals = args.find('=');
+                const auto number = detail::parse_hex(args.substr(0, equals));
+                const auto value = equals == std::string_view::npos ? std::nullopt : parse_register(args.substr(equals + 1));
+                if (!number || !value || !write_register(*number, *value)) {
+                    return "E01";
+                }
+                return "OK";
+            }
+            case 'm': {
+                const auto address_length = detail::parse_address_length(args);
+                const auto range = address_length ? memory_range(address_length->first, address_length->second) : std::nullopt;
+                if (!range) {
+                    return "E01";
+                }
+
+                auto ret = std::string{};
+                ret.reserve(range->size() * 2);
+                for (const auto byte : *range) {
+                    fmt::format_to(std::back_inserter(ret), "{:02x}", byte);
+                }
+                return ret;
+            }
+            case 'M':
+            case 'X': {
+                const auto colon = args.find(':');
+                const auto address_length = detail::parse_address_length(args.substr(0, colon));
+                if (colon == std::string_view::npos || !address_length) {
+                    return "E01";
+                }
+
+                auto data = std::string{};
+                const auto payload = args.substr(colon + 1);
+                if (command == 'M') {
+                    for (usize i = 0; i + 1 < payload.size(); i += 2) {
+                        const auto byte = detail::parse_hex(payload.substr(i, 2));
+                        if (!byte) {
+                            return "E01";
+                        }
+                        data += static_cast<char>(*byte);
+                    }
+                } else {
+                    for (usize i = 0; i < payload.size(); i++) {
+                        data += payload[i] == '}' && i + 1 < payload.size() ? static_cast<char>(payload[++i] ^ 0x20) : payload[i];
+                    }
+                }
+
+                // a zero length `X` is how gdb probes for it
+                if (address_length->second == 0) {
+                    return "OK";
+                }
+
+                const auto range = memory_range(address_length->first, address_length->second);
+                if (data.size() != address_length->second || !range || range->size() != data.size()) {
+                    return "E01";
+                }
+
+                std::ranges::copy(data, range->begin());
+                m_risc_v.m_memory.mark_written(static_cast<register_type>(address_length->first), data.size());
+                return "OK";
+            }
+            case 'c':
+            case 's': {
+                if (!args.empty()) {
+                    const auto address = detail::parse_hex(args);
+                    if (!address) {
+                        return "E01";
+                    }
+                    m_risc_v.m_program_counter = static_cast<register_type>(*address);
+                }
+
+                // hits from before don't count
+                m_risc_v.m_memory.consume_watch_hits();
+
+                if (command == 's') {
+                    m_risc_v.run(1);
+                    m_last_signal = 5;
+
+                    const auto hits = m_risc_v.m_memory.consume_watch_hits();
+                    return hits.empty() ? "S05" : fmt::format("T05{}", watch_stop_reason(hits.front()));
+                }
+
+                m_state = gdb_stub_state::running;
+                return std::nullopt;
+            }
+            case 'Z':
+            case 'z': {
+                // 0 and 1 are software and hardware breakpoints, 2 to 4 are write, read and access watchpoints
+                if (args.size() < 2 || args[0] < '0' || args[0] > '4' || args[1] != ',') {
+                    return "";
+                }
+
+                const auto address_kind = detail::parse_address_length(args.substr(2));
+                if (!address_kind) {
+                    return "E01";
+                }
+
+                const auto type = args[0] - '0';
+                const auto insert = command == 'Z';
+
+                if (type <= 1 && insert) {
+                    m_breakpoints.insert(address_kind->first);
+                } else if (type <= 1) {
+                    m_breakpoints.erase(address_kind->first);
+                } else {
+                    constexpr watch_type watch_types[]{watch_type::write, watch_type::read, watch_type::access};
+                    const auto watch = memory_watch<register_type>{
+                      static_cast<register_type>(address_kind->first),
+                      static_cast<usize>(address_kind->second),
+                      watch_types[type - 2],
+                    };
+
+                    if (insert) {
+                        m_risc_v.m_memory.add_watch(watch);
+                    } else if (!m_risc_v.m_memory.remove_watch(watch)) {
+                        return "E01";
+                    }
+                }
+
+                m_blocks.clear();
+                return "OK";
+            }
+            case 'H': return "OK";
+            case 'T': return "OK";
+            case 'D':
+                m_state = gdb_stub_state::detached;
+                return "OK";
+            case 'k': m_state = gdb_stub_state::killed; return std::nullopt;
+            case 'v': {
+                if (packet == "vCont?") {
+                    return "vCont;c;C;s;S";
+                }
+
+                if (packet.starts_with("vCont;")) {
+                    // there is a single thread, the first action is the one for it, signals aren't delivered
+                    const auto action = packet.substr(6, 1);
+                    if (action == "s" || action == "S") {
+                        return handle("s");
+                    }
+                    if (action == "c" || action == "C") {
+                        return handle("c");
+                    }
+                    return "E01";
+                }
+
+                if (packet.starts_with("vKill")) {
+                    m_state = gdb_stub_state::killed;
+                    return "OK";
+                }
+
+                return "";
+            }
+            case 'q':
+            case 'Q': return handle_query(packet);
+            default: return "";
+        }
+    }
+
+    auto handle_query(std::string_view packet) -> std::string {
+        if (packet.starts_with("qSupported")) {
+            return "PacketSize=4000;qXfer:features:read+;QStartNoAckMode+;vContSupported+";
+        }
+
+        if (packet == "QStartNoAckMode") {
+            m_no_ack = true;
+            return "OK";
+        }
+
+        if (packet == "qAttached") {
+            return "1";
+        }
+
+        if (packet == "qC") {
+            return "QC1";
+        }
+
+        if (packet == "qfThreadInfo") {
+            return "m1";
+        }
+
+        if (packet == "qsThreadInfo") {
+            return "l";
+        }
+
+        if (constexpr auto prefix = std::string_view("qXfer:features:read:target.xml:"); packet.starts_with(prefix)) {
+            const auto offset_length = detail::parse_address_length(packet.substr(prefix.size()));
+            if (!offset_length) {
+                return "E01";
+            }
+
+            const auto description = target_description();
+            const auto offset = std::min<u64>(offset_length->first, description.size());
+            const auto part = std::string_view(description).substr(offset, offset_length->second);
+            return (offset + part.size() == description.size() ? "l" : "m") + std::string(part);
+        }
+
+        return "";
+    }
+};
+
+}  // namespace rv
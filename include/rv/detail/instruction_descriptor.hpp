@@ -1,13 +1,21 @@
 #pragma once
 
 #include <rv/detail/arith.hpp>
+#include <rv/detail/csr.hpp>
 #include <rv/detail/definitions.hpp>
+#include <rv/detail/float.hpp>
+#include <rv/detail/trap.hpp>
+#include <rv/detail/vector.hpp>
 
 #include <stuff/expected.hpp>
 
 #include <fmt/format.h>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <span>
+#include <string>
+
 namespace rv {
 
 struct instruction_descriptor {
@@ -29,6 +37,31 @@ struct instruction_descriptor {
 
     constexpr auto c_reg_src_2() const -> reg { return static_cast<reg>((word >> 2u) & 0b1'1111u); }
 
+    // the same fields as above for instructions that operate on float registers
+
+    constexpr auto float_dst() const -> float_reg { return static_cast<float_reg>((word >> 7u) & 0b1'1111u); }
+
+    constexpr auto float_src_1() const -> float_reg { return static_cast<float_reg>((word >> 15u) & 0b1'1111u); }
+
+    constexpr auto float_src_2() const -> float_reg { return static_cast<float_reg>((word >> 20u) & 0b1'1111u); }
+
+    /// the third source of the fused multiply-add instructions
+    constexpr auto float_src_3() const -> float_reg { return static_cast<float_reg>((word >> 27u) & 0b1'1111u); }
+
+    /// the rm field of floating point instructions, which is where funct3 is
+    constexpr auto rm() const -> u32 { return (word >> 12u) & 0b111u; }
+
+    // the same fields again for instructions that operate on vector registers, which are only ever named by their number
+
+    constexpr auto vector_dst() const -> u32 { return (word >> 7u) & 0b1'1111u; }
+
+    constexpr auto vector_src_1() const -> u32 { return (word >> 15u) & 0b1'1111u; }
+
+    constexpr auto vector_src_2() const -> u32 { return (word >> 20u) & 0b1'1111u; }
+
+    /// vm being clear means that the instruction is masked by `v0`
+    constexpr auto vector_masked() const -> bool { return ((word >> 25u) & 1u) == 0; }
+
     template<std::unsigned_integral T = u32>
     constexpr auto immediate() const -> T {
         const u32 imm_11_0 = (word >> 20u) & 0xFFFu;
@@ -135,6 +168,9 @@ static_assert(bit_matcher<u8>{0b1111'0000, 0b1010'1010}.match(0b1010'1100));
 static_assert(bit_matcher<u8>{0b1100'0000, 0b1010'1010}.combine(0b0011'0000, 0b1010'1010).match(0b1010'1100));
 static_assert(!bit_matcher<u8>{0b1111'0000, 0b1010'1010}.match(0b1000'1100));
 
+/// What instructions are formatted into, an instruction fits into the inline storage so formatting into a reused buffer doesn't allocate.
+using format_buffer = fmt::memory_buffer;
+
 template<typename RiscV>
 struct instruction_properties {
     using processor_type = RiscV;
@@ -142,7 +178,7 @@ struct instruction_properties {
 
     using executor_type = void (*)(processor_type&, instruction_descriptor);
     using translator_type = u32 (*)(u32);
-    using formatter_type = std::string (*)(instruction_descriptor, bool);
+    using formatter_type = void (*)(format_buffer&, instruction_descriptor, bool);
 
     std::string_view mnemonic;
     instruction_standard standard;
@@ -212,15 +248,14 @@ inline constexpr bit_matcher<u32> aluw_matcher = opcode_matcher<0b01110'11>.comb
 
 namespace detail {
 
-constexpr auto default_formatter(instruction_descriptor instruction, bool abi_registers = false) -> std::string {
-    auto str = std::string{};
-    auto it = std::back_inserter(str);
+constexpr void default_formatter(format_buffer& out, instruction_descriptor instruction, bool abi_registers = false) {
+    auto it = std::back_inserter(out);
     it = fmt::format_to(it, "{}", instruction.mnemonic);
 
     const auto reg_name = abi_registers ? ::rv::register_name<true> : ::rv::register_name<false>;
 
     if (instruction.mnemonic == "unknown") {
-        return str;
+        return;
     }
 
     switch (instruction.format) {
@@ -248,23 +283,13 @@ constexpr auto default_formatter(instruction_descriptor instruction, bool abi_re
         case ::rv::opcode_format::c_wide_immediate: [[fallthrough]];
         case ::rv::opcode_format::c_stack_rela_store: break;
     }
-
-    return str;
 }
 
-constexpr auto mnemonic_only_formatter(instruction_descriptor instruction, bool abi_registers) -> std::string {
-    auto str = std::string{};
-    auto it = std::back_inserter(str);
-    const auto reg_name = abi_registers ? ::rv::register_name<true> : ::rv::register_name<false>;
-
-    it = fmt::format_to(it, "{}", instruction.mnemonic);
-
-    return str;
+constexpr void mnemonic_only_formatter(format_buffer& out, instruction_descriptor instruction, bool) {
+    fmt::format_to(std::back_inserter(out), "{}", instruction.mnemonic);
 }
 
-constexpr auto imm_shift_formatter(instruction_descriptor instruction, bool abi_registers) -> std::string {
-    auto str = std::string{};
-    auto it = std::back_inserter(str);
+constexpr void imm_shift_formatter(format_buffer& out, instruction_descriptor instruction, bool abi_registers) {
     const auto reg_name = abi_registers ? ::rv::register_name<true> : ::rv::register_name<false>;
 
     auto imm_to_print = static_cast<i32>(instruction.immediate());
@@ -274,14 +299,10 @@ constexpr auto imm_shift_formatter(instruction_descriptor instruction, bool abi_
         imm_to_print &= 0b1'1111;
     }
 
-    it = fmt::format_to(it, "{} {}, {}, {}", instruction.mnemonic, reg_name(instruction.reg_dst()), reg_name(instruction.reg_src_1()), imm_to_print);
-
-    return str;
+    fmt::format_to(std::back_inserter(out), "{} {}, {}, {}", instruction.mnemonic, reg_name(instruction.reg_dst()), reg_name(instruction.reg_src_1()), imm_to_print);
 }
 
-constexpr auto fence_formatter(instruction_descriptor instruction, bool abi_registers) -> std::string {
-    auto str = std::string{};
-    auto it = std::back_inserter(str);
+constexpr void fence_formatter(format_buffer& out, instruction_descriptor instruction, bool) {
     const u32 pred = (instruction.immediate() >> 4u) & 0xFu;
     const u32 succ = (instruction.immediate()) & 0xFu;
 
@@ -295,19 +316,29 @@ constexpr auto fence_formatter(instruction_descriptor instruction, bool abi_regi
     };
 #pragma clang diagnostic pop
 
-    it = fmt::format_to(it, "{} {}, {}", instruction.mnemonic, iorw_lookup[pred], iorw_lookup[succ]);
+    fmt::format_to(std::back_inserter(out), "{} {}, {}", instruction.mnemonic, iorw_lookup[pred], iorw_lookup[succ]);
+}
 
-    return str;
+constexpr void load_formatter(format_buffer& out, instruction_descriptor instruction, bool abi_registers) {
+    const auto reg_name = abi_registers ? ::rv::register_name<true> : ::rv::register_name<false>;
+
+    fmt::format_to(
+      std::back_inserter(out), "{} {}, {}({})", instruction.mnemonic, reg_name(instruction.reg_dst()), static_cast<i32>(instruction.immediate()),
+      reg_name(instruction.reg_src_1())
+    );
 }
 
-constexpr auto load_formatter(instruction_descriptor instruction, bool abi_registers) -> std::string {
-    auto str = std::string{};
-    auto it = std::back_inserter(str);
+constexpr void csr_formatter(format_buffer& out, instruction_descriptor instruction, bool abi_registers) {
     const auto reg_name = abi_registers ? ::rv::register_name<true> : ::rv::register_name<false>;
 
-    it = fmt::format_to(it, "{} {}, {}({})", instruction.mnemonic, reg_name(instruction.reg_dst()), static_cast<i32>(instruction.immediate()), reg_name(instruction.reg_src_1()));
+    const auto csr = csr_name(instruction.immediate<u32>() & 0xFFFu);
 
-    return str;
+    // the immediate forms have a 5 bit unsigned immediate where the source register would be
+    if (instruction.mnemonic.ends_with('i')) {
+        fmt::format_to(std::back_inserter(out), "{} {}, {}, {}", instruction.mnemonic, reg_name(instruction.reg_dst()), csr, static_cast<u32>(instruction.reg_src_1()));
+    } else {
+        fmt::format_to(std::back_inserter(out), "{} {}, {}, {}", instruction.mnemonic, reg_name(instruction.reg_dst()), csr, reg_name(instruction.reg_src_1()));
+    }
 }
 
 }  // namespace detail
@@ -318,9 +349,27 @@ struct generic_instruction_set {
 
     virtual constexpr auto operator[](size_t i) const -> instruction_properties<RiscV> const& = 0;
     virtual constexpr auto operator[](size_t i) -> instruction_properties<RiscV>& = 0;
+    virtual constexpr auto num_instructions() const -> usize = 0;
 
     virtual constexpr auto match(u32 instruction_word) const -> std::optional<instruction_properties<RiscV>> = 0;
-    virtual auto format(u32 instruction_word, bool abi_register_names = false) const -> std::string = 0;
+    /// Appends the disassembly of `instruction_word` to `out`, compressed instructions are followed by what they expand into.
+    virtual void format_to(format_buffer& out, u32 instruction_word, bool abi_register_names = false) const = 0;
+
+    auto format(u32 instruction_word, bool abi_register_names = false) const -> std::string {
+        auto buffer = format_buffer{};
+        format_to(buffer, instruction_word, abi_register_names);
+        return fmt::to_string(buffer);
+    }
+
+    /// Formats into `out`, cutting the disassembly short if it doesn't fit. Returns the part of `out` that got used.
+    auto format_to(std::span<char> out, u32 instruction_word, bool abi_register_names = false) const -> std::string_view {
+        auto buffer = format_buffer{};
+        format_to(buffer, instruction_word, abi_register_names);
+
+        const auto size = std::min(buffer.size(), out.size());
+        std::copy_n(buffer.data(), size, out.data());
+        return {out.data(), size};
+    }
     virtual constexpr auto get_descriptor_for(instruction_properties<RiscV> const& props, u32 instruction_word) -> instruction_descriptor = 0;
 
     virtual constexpr void try_step(RiscV& self) const = 0;
@@ -354,39 +403,41 @@ struct instruction_set final : generic_instruction_set<RiscV> {
 
     constexpr auto operator[](size_t i) const -> instruction_properties<RiscV> const& { return m_instructions[i]; }
     constexpr auto operator[](size_t i) -> instruction_properties<RiscV>& { return m_instructions[i]; }
+    constexpr auto num_instructions() const -> usize { return NumInstructions; }
 
-    constexpr auto match(u32 instruction_word) const -> std::optional<instruction_properties<RiscV>> {
+    /// returns the index of the first matching instruction, `size()` if there is none
+    constexpr auto match_slot(u32 instruction_word) const -> usize {
         auto it = std::find_if(m_instructions.begin(), m_instructions.end(), [instruction_word](auto const& insn_prop) { return insn_prop.matcher.match(instruction_word); });
+        return static_cast<usize>(std::distance(m_instructions.begin(), it));
+    }
 
-        if (it == m_instructions.end()) {
+    constexpr auto match(u32 instruction_word) const -> std::optional<instruction_properties<RiscV>> {
+        const auto slot = match_slot(instruction_word);
+
+        if (slot == NumInstructions) {
             return std::nullopt;
         }
 
-        return *it;
+        return m_instructions[slot];
     }
 
-    auto format(u32 instruction_word, bool abi_register_names = false) const -> std::string {
-        /*return match(instruction_word)  //
-          .transform([instruction_word, abi_register_names](auto const& insn_prop) {
-              return insn_prop.formatter(get_descriptor_for_impl(insn_prop, instruction_word), abi_register_names);
-          })  //
-          .value_or("unknown"s);*/
-
-        const auto res = match(instruction_word);
-        if (!res) {
-            return "unknown";
-        }
+    using generic_instruction_set<RiscV>::format;
+    using generic_instruction_set<RiscV>::format_to;
 
-        const auto desc = get_descriptor_for_impl(*res, instruction_word);
+    void format_to(format_buffer& out, u32 instruction_word, bool abi_register_names = false) const {
+        const auto slot = match_slot(instruction_word);
+        if (slot == NumInstructions) {
+            fmt::format_to(std::back_inserter(out), "unknown");
+            return;
+        }
 
-        const auto formatted = (res->formatter)(desc, abi_register_names);
+        auto const& props = m_instructions[slot];
+        (props.formatter)(out, get_descriptor_for_impl(props, instruction_word), abi_register_names);
 
-        if (res->translator) {
-            const auto translated = (res->translator)(instruction_word);
-            return fmt::format("{} -> {}", formatted, format(translated, abi_register_names));
+        if (props.translator) {
+            fmt::format_to(std::back_inserter(out), " -> ");
+            format_to(out, (props.translator)(instruction_word), abi_register_names);
         }
-
-        return formatted;
     }
 
     static constexpr auto get_descriptor_for_impl(instruction_properties<RiscV> const& props, u32 instruction_word) -> instruction_descriptor {
@@ -413,22 +464,26 @@ struct instruction_set final : generic_instruction_set<RiscV> {
         return try_execute(self, instruction_word);
     }
 
-    constexpr void try_execute(RiscV& self, u32 instruction_word) const {
-        const auto res = match(instruction_word);
+    constexpr void try_execute(RiscV& self, u32 instruction_word, bool translated = false) const {
+        const auto slot = match_slot(instruction_word);
 
-        if (!res) {
-            self.m_next_step_sz = 0;
-            spdlog::warn("unknown instruction @ {:#010x}", self.m_program_counter);
+        if (slot == NumInstructions) {
+            self.raise_illegal_instruction();
             return;
         }
 
+        const auto* const res = &m_instructions[slot];
         const auto desc = get_descriptor_for_impl(*res, instruction_word);
 
+        if (!translated) {
+            self.m_observer.on_execute(self, slot);
+        }
+
         if (res->translator != nullptr) {
             const auto translation = (res->translator)(instruction_word);
             // const auto formatted = (res->formatter)(desc, true);
             // spdlog::trace("@{:#010x}: {:#06x} ({}) translated into {:#010x}", self.m_program_counter, instruction_word & 0xFFFF, formatted, (u32)translation);
-            return try_execute(self, translation);
+            return try_execute(self, translation, true);
         }
 
         // spdlog::trace("@{:#010x}: executing {:#010x} ({})", self.m_program_counter, instruction_word, format(instruction_word, true));
@@ -493,7 +548,7 @@ struct functor_alu {
             res = arith::sext<register_type, 32>((register_type)(u32)res);
         }
 
-        self.m_register_bank.write_register(desc.reg_dst(), res);
+        self.write_register(desc.reg_dst(), res);
     }
 
 private:
@@ -528,7 +583,7 @@ struct functor_store {
     constexpr auto operator()(Self& self, instruction_descriptor desc) {
         const auto reg_src_1 = self.m_register_bank.read_register(desc.reg_src_1());
         const auto reg_src_2 = self.m_register_bank.read_register(desc.reg_src_2());
-        self.m_memory.template write<StoreAs>(reg_src_1 + desc.store_offset<typename Self::register_type>(), (StoreAs)reg_src_2);
+        self.template write_memory<StoreAs>(reg_src_1 + desc.store_offset<typename Self::register_type>(), (StoreAs)reg_src_2);
     }
 };
 
@@ -540,8 +595,8 @@ struct functor_load {
         const auto reg_src_1 = self.m_register_bank.read_register(desc.reg_src_1());
         const auto immediate = desc.immediate<u64>();
         const auto addr = reg_src_1 + immediate;
-        const auto res = arith::sext<register_type, sizeof(LoadAs) * 8>((register_type)self.m_memory.template read<LoadAs>(addr));
-        self.m_register_bank.write_register(desc.reg_dst(), res);
+        const auto res = arith::sext<register_type, sizeof(LoadAs) * 8>((register_type)self.template read_memory<LoadAs>(addr));
+        self.write_register(desc.reg_dst(), res);
     }
 };
 
@@ -552,7 +607,7 @@ struct functor_load_unsigned {
 
         const auto reg_src_1 = self.m_register_bank.read_register(desc.reg_src_1());
         const auto immediate = desc.immediate<register_type>();
-        self.m_register_bank.write_register(desc.reg_dst(), (register_type)self.m_memory.template read<u8>(reg_src_1 + immediate));
+        self.write_register(desc.reg_dst(), (register_type)self.template read_memory<u8>(reg_src_1 + immediate));
     }
 };
 
@@ -564,8 +619,29 @@ struct functor_branch {
         const auto reg_src_1 = self.m_register_bank.read_register(desc.reg_src_1());
         const auto reg_src_2 = self.m_register_bank.read_register(desc.reg_src_2());
 
-        if (std::invoke(Predicate{}, reg_src_1, reg_src_2)) {
-            self.jump(desc.branch_offset<register_type>());
+        const auto taken = std::invoke(Predicate{}, reg_src_1, reg_src_2);
+        const auto offset = desc.branch_offset<register_type>();
+
+        if (taken) {
+            self.jump(offset);
+        }
+
+        self.m_observer.on_branch(self, self.m_program_counter, self.m_program_counter + offset, taken);
+    }
+};
+
+template<typename Self, csr_write_type Type, bool Imm = false>
+struct functor_csr {
+    constexpr auto operator()(Self& self, instruction_descriptor desc) {
+        using register_type = typename Self::register_type;
+
+        const auto value = Imm ? static_cast<register_type>(desc.reg_src_1()) : self.m_register_bank.read_register(desc.reg_src_1());
+        // setting or clearing no bits is not a write, which lets csrrs and csrrc read read-only CSRs
+        const auto write = Type == csr_write_type::write || desc.reg_src_1() != reg::zero;
+        const auto address = desc.immediate<u32>() & 0xFFFu;
+
+        if (!self.template csr_read_write<Type>(desc.reg_dst(), value, address, write)) {
+            self.raise_illegal_instruction();
         }
     }
 };
@@ -575,19 +651,29 @@ struct functor_branch {
 #include <rv/detail/instructions/rv32i.ipp>
 #include <rv/detail/instructions/rv64i.ipp>
 #include <rv/detail/instructions/rv64m.ipp>
+#include <rv/detail/instructions/rv64b.ipp>
 
 #include <rv/detail/instructions/rv64a.ipp>
 
+#include <rv/detail/instructions/rv64f.ipp>
+#include <rv/detail/instructions/rv64d.ipp>
+
+#include <rv/detail/instructions/rvv.ipp>
+
 #include <rv/detail/instructions/rv128c.ipp>
 
 namespace rv {
 
 template<typename RiscV>
 inline constexpr auto is_rv32 =
-  instruction_set(std::type_identity<RiscV>{}, detail::is_rv32i<RiscV>, detail::is_rv32m<RiscV>, detail::is_rv32zifencei<RiscV>, detail::is_rv32zicsr<RiscV>, detail::is_rv32c<RiscV>, detail::is_rv32a<RiscV>);
+  instruction_set(std::type_identity<RiscV>{}, detail::is_rv32i<RiscV>, detail::is_rv32m<RiscV>, detail::is_rv32zifencei<RiscV>, detail::is_rv32zicsr<RiscV>, detail::is_rv32_privileged<RiscV>, detail::is_rv32c<RiscV>, detail::is_rv32a<RiscV>,
+    detail::is_rv32f<RiscV>, detail::is_rv32d<RiscV>, detail::is_rv32zba<RiscV>, detail::is_rv32zbb<RiscV>, detail::is_rv32zbs<RiscV>, detail::is_rvv<RiscV>
+  );
 
 template<typename RiscV>
 inline constexpr auto is_rv64 =
-  instruction_set(std::type_identity<RiscV>{}, detail::is_rv64i<RiscV>, detail::is_rv64m<RiscV>, detail::is_rv32zifencei<RiscV>, detail::is_rv32zicsr<RiscV>, detail::is_rv64c<RiscV>, detail::is_rv64a<RiscV>);
+  instruction_set(std::type_identity<RiscV>{}, detail::is_rv64i<RiscV>, detail::is_rv64m<RiscV>, detail::is_rv32zifencei<RiscV>, detail::is_rv32zicsr<RiscV>, detail::is_rv32_privileged<RiscV>, detail::is_rv64c<RiscV>, detail::is_rv64a<RiscV>,
+    detail::is_rv64f<RiscV>, detail::is_rv64d<RiscV>, detail::is_rv64zba<RiscV>, detail::is_rv64zbb<RiscV>, detail::is_rv32zbs<RiscV>, detail::is_rvv<RiscV>
+  );
 
 }  // namespace rv
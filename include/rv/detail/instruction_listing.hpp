@@ -0,0 +1,259 @@
+#pragma once
+
+#include <rv/detail/instruction_descriptor.hpp>
+
+#include <stuff/bit.hpp>
+#include <stuff/core.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace rv {
+
+struct instruction_listing_row {
+    u64 address;
+    /// the upper half is zero for compressed instructions
+    u32 word;
+    usize size;
+};
+
+/// The rows of a disassembly view over a window of pages around some address, for views that only ever draw a few of them at a time.
+///
+/// Where instructions start in a stream of mixed 16 and 32-bit instructions depends on where decoding started. Every page is decoded from
+/// where the instructions of the page before it end, that one being decoded from its own start. Streams resynchronise within a few
+/// instructions, so looking back a page is good enough and keeps pages independent of everything before them.
+///
+/// Pages are laid out into rows when they come into the window and rows are disassembled when they are first asked for. Both are kept while
+/// the page stays in the window, until it or one of its neighbours gets written to, which is found through the generations of the pages.
+/// Writes stamp pages with the current generation, so whoever writes the memory has to advance it every now and then for the rows to stay
+/// cached.
+template<typename RiscV>
+struct instruction_listing {
+    using memory_type = std::remove_cvref_t<decltype(std::declval<RiscV const&>().memory())>;
+
+    static constexpr usize page_size = memory_type::page_size;
+
+    explicit instruction_listing(usize window_pages = 64)
+        : m_slots(std::max<usize>(window_pages, 1)) {}
+
+    /// Moves the window so that `address` is in its middle and lays out the pages that changed since. Rows are only valid until the next call.
+    void update(RiscV const& risc_v, u64 address) { update(risc_v.memory(), address); }
+
+    /// `update` over anything that pages like the memory does, e.g. a `memory_snapshot` of it
+    template<typename Memory>
+    void update(Memory const& memory, u64 address) {
+        static_assert(Memory::page_size == page_size);
+
+        const auto num_pages = memory.num_pages();
+
+        if (num_pages == 0) {
+            m_num_window_pages = 0;
+            m_row_starts.assign(1, 0);
+            return;
+        }
+
+        const auto num_window_pages = std::min(m_slots.size(), num_pages);
+        const auto center_page = std::min<usize>(address / page_size, num_pages - 1);
+
+        m_first_page = std::min(center_page - std::min(center_page, num_window_pages / 2), num_pages - num_window_pages);
+        m_num_window_pages = num_window_pages;
+
+        m_row_starts.resize(num_window_pages + 1);
+        m_row_starts[0] = 0;
+
+        for (usize i = 0; i < num_window_pages; i++) {
+            const auto page = m_first_page + i;
+            if (slot(page).page != page || is_stale(memory, page)) {
+                lay_out(memory, page);
+            }
+
+            m_row_starts[i + 1] = m_row_starts[i] + slot(page).rows.size();
+        }
+    }
+
+    constexpr auto num_rows() const -> usize { return m_row_starts.back(); }
+
+    auto row(usize index) const -> instruction_listing_row {
+        const auto [page, i] = locate(index);
+        auto const& row = slot(page).rows[i];
+        return {
+          .address = page * page_size + row.offset,
+          .word = row.word,
+          .size = row.size,
+        };
+    }
+
+    /// the row of the instruction that `address` is in, if it is in the window
+    auto row_of(u64 address) const -> std::optional<usize> {
+        const auto page = address / page_size;
+        if (page < m_first_page || page >= m_first_page + m_num_window_pages) {
+            return std::nullopt;
+        }
+
+        auto const& rows = slot(page).rows;
+        const auto it = std::ranges::upper_bound(rows, address % page_size, {}, &row_entry::offset);
+
+        // the address is in the middle of an instruction that started in the page before
+        if (it == rows.begin()) {
+            if (page == m_first_page) {
+                return std::nullopt;
+            }
+            return m_row_starts[page - m_first_page] - 1;
+        }
+
+        return m_row_starts[page - m_first_page] + static_cast<usize>(it - rows.begin()) - 1;
+    }
+
+    /// The disassembly of the instruction at `index`, valid until the next call.
+    auto row_text(RiscV const& risc_v, usize index, bool abi_register_names = false) -> std::string_view {
+        if (abi_register_names != m_abi_register_names) {
+            m_abi_register_names = abi_register_names;
+            for (auto& entry : m_slots) {
+                entry.text.clear();
+                std::ranges::for_each(entry.rows, [](row_entry& row) { row.text_length = not_formatted; });
+            }
+        }
+
+        const auto [page, i] = locate(index);
+        auto& entry = slot(page);
+        auto& row = entry.rows[i];
+
+        if (row.text_length == not_formatted) {
+            m_buffer.clear();
+            risc_v.m_isa.format_to(m_buffer, row.word, abi_register_names);
+
+            row.text_begin = static_cast<u32>(entry.text.size());
+            row.text_length = static_cast<u16>(std::min<usize>(m_buffer.size(), not_formatted - 1));
+            entry.text.append(m_buffer.data(), row.text_length);
+        }
+
+        return std::string_view(entry.text).substr(row.text_begin, row.text_length);
+    }
+
+    /// how many times pages were laid out into rows
+    constexpr auto layouts() const -> u64 { return m_layouts; }
+
+private:
+    static constexpr u16 not_formatted = 0xFFFF;
+
+    struct row_entry {
+        u32 word;
+        u32 text_begin;
+        u16 offset;
+        u16 text_length;
+        u8 size;
+    };
+
+    struct page_entry {
+        /// the page that is laid out in the slot
+        usize page = ~0uz;
+        /// `memory::generation` as of the layout
+        u64 generation = 0;
+        std::vector<row_entry> rows{};
+        /// the disassemblies of the rows that were asked for, one after the other
+        std::string text{};
+    };
+
+    /// page `i` goes into slot `i % size`, the buffers of the pages that leave the window are reused by the ones that come in
+    std::vector<page_entry> m_slots;
+    usize m_first_page = 0;
+    usize m_num_window_pages = 0;
+
+    /// the first row of each page in the window and the number of rows past the last
+    std::vector<usize> m_row_starts{0};
+
+    format_buffer m_buffer{};
+    bool m_abi_register_names = false;
+    u64 m_layouts = 0;
+
+    auto slot(usize page) -> page_entry& { return m_slots[page % m_slots.size()]; }
+    auto slot(usize page) const -> page_entry const& { return m_slots[page % m_slots.size()]; }
+
+    static constexpr auto instruction_size(u16 parcel) -> usize { return (parcel & 0b11) == 0b11 ? 4 : 2; }
+
+    /// parcels past the end of the memory are zeroes
+    template<typename Memory>
+    static auto read_parcel(Memory const& memory, usize address) -> u16 {
+        u16 parcel = 0;
+        if (address + sizeof(parcel) <= memory.size()) [[likely]] {
+            std::memcpy(&parcel, memory.data() + address, sizeof(parcel));
+        } else if (address < memory.size()) {
+            parcel = memory.data()[address];
+        }
+        return stf::bit::convert_endian(parcel, std::endian::little, std::endian::native);
+    }
+
+    auto locate(usize index) const -> std::pair<usize, usize> {
+        const auto it = std::ranges::upper_bound(m_row_starts, index) - 1;
+        return {m_first_page + static_cast<usize>(it - m_row_starts.begin()), index - *it};
+    }
+
+    /// the layout of a page depends on the page before it and the last instruction in it may spill over into the one after it
+    template<typename Memory>
+    auto is_stale(Memory const& memory, usize page) const -> bool {
+        const auto generation = slot(page).generation;
+        const auto first = page - std::min<usize>(page, 1);
+        const auto last = std::min(page + 1, memory.num_pages() - 1);
+        for (auto i = first; i <= last; i++) {
+            // a write stamped with the generation of the layout might have happened after it
+            if (memory.page_generation(i) >= generation) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /// where the first instruction that starts in `page` is
+    template<typename Memory>
+    static auto entry_offset(Memory const& memory, usize page) -> usize {
+        if (page == 0) {
+            return 0;
+        }
+
+        const auto base = (page - 1) * page_size;
+        auto offset = 0uz;
+        while (offset < page_size) {
+            offset += instruction_size(read_parcel(memory, base + offset));
+        }
+
+        return offset - page_size;
+    }
+
+    template<typename Memory>
+    void lay_out(Memory const& memory, usize page) {
+        auto& entry = slot(page);
+        entry.page = page;
+
+        // before reading anything, writes from here on stamp the pages with at least this
+        entry.generation = memory.generation();
+        entry.rows.clear();
+        entry.rows.reserve(page_size / 2);
+        entry.text.clear();
+
+        const auto base = page * page_size;
+        const auto end = std::min(base + page_size, memory.size());
+
+        for (auto offset = entry_offset(memory, page); base + offset < end;) {
+            const auto low = read_parcel(memory, base + offset);
+
+            // an instruction cut short by the end of the memory is shown as its first parcel
+            const auto size = base + offset + 4 <= memory.size() ? instruction_size(low) : 2uz;
+            const auto word = size == 4 ? low | static_cast<u32>(read_parcel(memory, base + offset + 2)) << 16 : low;
+
+            entry.rows.push_back({.word = word, .text_begin = 0, .offset = static_cast<u16>(offset), .text_length = not_formatted, .size = static_cast<u8>(size)});
+            offset += size;
+        }
+
+        ++m_layouts;
+    }
+};
+
+}  // namespace rv
@@ -37,7 +37,14 @@ constexpr auto alu(reg rd, reg rs_1, reg rs_2) -> u32 {
             case alu_action::sra: mask = 0b101'00000'01100'11 | 0x4000'0000; break;
             case alu_action::bor: mask = 0b110'00000'01100'11; break;
             case alu_action::band: mask = 0b111'00000'01100'11; break;
-            default: throw 1;
+            case alu_action::mul: mask = 0b000'00000'01100'11 | 0x0200'0000; break;
+            case alu_action::mulhss: mask = 0b001'00000'01100'11 | 0x0200'0000; break;
+            case alu_action::mulhsu: mask = 0b010'00000'01100'11 | 0x0200'0000; break;
+            case alu_action::mulhuu: mask = 0b011'00000'01100'11 | 0x0200'0000; break;
+            case alu_action::div: mask = 0b100'00000'01100'11 | 0x0200'0000; break;
+            case alu_action::divu: mask = 0b101'00000'01100'11 | 0x0200'0000; break;
+            case alu_action::rem: mask = 0b110'00000'01100'11 | 0x0200'0000; break;
+            case alu_action::remu: mask = 0b111'00000'01100'11 | 0x0200'0000; break;
         }
         return mask;
     })();
@@ -117,6 +124,18 @@ constexpr auto load(reg rd, i32 offset, reg rs_1) -> u32 {
          | ((static_cast<u32>(offset) & 0xFFF) << 20);
 }
 
+template<bool Double>
+constexpr auto load_float(float_reg rd, i32 offset, reg rs_1) -> u32 {
+    return asm_immediate(static_cast<u32>(offset) & 0xFFF, rs_1, Double ? 0b011 : 0b010, static_cast<reg>(rd), 0b00001'11);  // fl? f?, ?(x?)
+}
+
+template<bool Double>
+constexpr auto store_float(float_reg rs_2, i32 offset, reg rs_1) -> u32 {
+    // the same as an integer store apart from the opcode
+    constexpr auto type = Double ? ld_st_type::dword : ld_st_type::word;
+    return store<type>(static_cast<reg>(rs_2), offset, rs_1) | 0b00001'00u;  // fs? f?, ?(x?)
+}
+
 constexpr auto jalr(reg rd, reg rs_1, i32 offset) -> u32 { return asm_immediate(offset, rs_1, 0b000, rd, 0b11001'11); }
 
 constexpr auto jal(reg rd, i32 offset) -> u32 {
@@ -152,6 +171,25 @@ constexpr auto branch(reg rs_1, reg rs_2, i32 offset) -> u32 {
          | ((static_cast<u32>(offset) << 19) & 0x8000'0000);
 }
 
+template<bool DoubleWord>
+constexpr auto load_reserved(reg rd, reg rs_1) -> u32 {
+    constexpr auto base = (0b00010u << 27) | ((DoubleWord ? 0b011u : 0b010u) << 12) | 0b01011'11u;  // lr.? x?, (x?)
+
+    return base                           //
+         | (static_cast<u32>(rd) << 7)    //
+         | (static_cast<u32>(rs_1) << 15);
+}
+
+template<bool DoubleWord>
+constexpr auto store_conditional(reg rd, reg rs_2, reg rs_1) -> u32 {
+    constexpr auto base = (0b00011u << 27) | ((DoubleWord ? 0b011u : 0b010u) << 12) | 0b01011'11u;  // sc.? x?, x?, (x?)
+
+    return base                            //
+         | (static_cast<u32>(rd) << 7)     //
+         | (static_cast<u32>(rs_1) << 15)  //
+         | (static_cast<u32>(rs_2) << 20);
+}
+
 }  // namespace assembler
 
 struct translator_addi4spn {
@@ -328,6 +366,10 @@ struct translator_jr {
     }
 };
 
+struct translator_ebreak {
+    constexpr auto operator()(u32) const -> u32 { return 0x0010'0073; }
+};
+
 struct translator_jal {
     constexpr auto operator()(u32 compressed_word) const -> u32 {
         const auto imm = stf::bit::extract<u32, 12, "11|4|9:8|10|6|7|3:1|5">(compressed_word);
@@ -394,6 +436,52 @@ struct translator_ld {
     }
 };
 
+/// c.flw and c.fld
+template<bool Double>
+struct translator_float_load {
+    constexpr auto operator()(u32 compressed_word) const -> u32 {
+        const auto rs_1 = static_cast<reg>(stf::bit::extract<u32, 9, "2:0">(compressed_word) + 8u);
+        const auto rd = static_cast<float_reg>(stf::bit::extract<u32, 4, "2:0">(compressed_word) + 8u);
+        const auto uimm = Double ? stf::bit::extract<u32, 12, "5:3|9~7|7:6">(compressed_word) : stf::bit::extract<u32, 12, "5:3|9~7|2|6">(compressed_word);
+
+        return assembler::load_float<Double>(rd, uimm, rs_1);
+    }
+};
+
+/// c.fsw and c.fsd
+template<bool Double>
+struct translator_float_store {
+    constexpr auto operator()(u32 compressed_word) const -> u32 {
+        const auto rs_1 = static_cast<reg>(stf::bit::extract<u32, 9, "2:0">(compressed_word) + 8u);
+        const auto rs_2 = static_cast<float_reg>(stf::bit::extract<u32, 4, "2:0">(compressed_word) + 8u);
+        const auto uimm = Double ? stf::bit::extract<u32, 12, "5:3|9~7|7:6">(compressed_word) : stf::bit::extract<u32, 12, "5:3|9~7|2|6">(compressed_word);
+
+        return assembler::store_float<Double>(rs_2, uimm, rs_1);
+    }
+};
+
+/// c.flwsp and c.fldsp, unlike the integer loads these can load into f0
+template<bool Double>
+struct translator_float_load_sp {
+    constexpr auto operator()(u32 compressed_word) const -> u32 {
+        const auto rd = static_cast<float_reg>(stf::bit::extract<u32, 11, "4:0">(compressed_word));
+        const auto uimm = Double ? stf::bit::extract<u32, 12, "5|11~7|4:3|8:6">(compressed_word) : stf::bit::extract<u32, 12, "5|11~7|4:2|7:6">(compressed_word);
+
+        return assembler::load_float<Double>(rd, uimm, reg::x2);
+    }
+};
+
+/// c.fswsp and c.fsdsp
+template<bool Double>
+struct translator_float_store_sp {
+    constexpr auto operator()(u32 compressed_word) const -> u32 {
+        const auto rs_2 = static_cast<float_reg>(stf::bit::extract<u32, 6, "4:0">(compressed_word));
+        const auto uimm = Double ? stf::bit::extract<u32, 12, "5:3|8:6">(compressed_word) : stf::bit::extract<u32, 12, "5:2|7:6">(compressed_word);
+
+        return assembler::store_float<Double>(rs_2, uimm, reg::x2);
+    }
+};
+
 // clang-format off
 
 template<typename RiscV>
@@ -403,12 +491,12 @@ inline constexpr auto is_rv32c = instruction_set(
     RV_QUICK_INSN(RiscV, "c.invalid", RV32C, c_immediate, (bit_matcher<u32>{0xFFFF, 0x0000}), functor_nyi<RiscV>, mnemonic_only_formatter),
     RV_QUICK_INSN(RiscV, "reserved(c.addi4spn)", RV32C, c_immediate, (bit_matcher<u32>{0xFFE3, 0x0000}), functor_reserved<RiscV>, default_formatter),
     RV_QUICK_INSN_TR(RiscV, "c.addi4spn", RV32C, c_immediate, (bit_matcher<u32>{0xE003, 0x0000}), translator_addi4spn, default_formatter),
-    RV_QUICK_INSN(RiscV, "c.fld", RV32C, c_immediate, (bit_matcher<u32>{0xE003, 0x2000}), functor_nyi<RiscV>, default_formatter), // overridden by c.lq (RV128C)
+    RV_QUICK_INSN_TR(RiscV, "c.fld", RV32C, c_immediate, (bit_matcher<u32>{0xE003, 0x2000}), translator_float_load<true>, default_formatter), // overridden by c.lq (RV128C)
     RV_QUICK_INSN_TR(RiscV, "c.lw", RV32C, c_immediate, (bit_matcher<u32>{0xE003, 0x4000}), translator_lw, default_formatter),
-    RV_QUICK_INSN(RiscV, "c.flw", RV32C, c_immediate, (bit_matcher<u32>{0xE003, 0x6000}), functor_nyi<RiscV>, default_formatter), // overridden by c.ld (RV64C, RV128C)
-    RV_QUICK_INSN(RiscV, "c.fsd", RV32C, c_immediate, (bit_matcher<u32>{0xE003, 0xA000}), functor_nyi<RiscV>, default_formatter), // overriden by c.sq (RV128)
+    RV_QUICK_INSN_TR(RiscV, "c.flw", RV32C, c_immediate, (bit_matcher<u32>{0xE003, 0x6000}), translator_float_load<false>, default_formatter), // overridden by c.ld (RV64C, RV128C)
+    RV_QUICK_INSN_TR(RiscV, "c.fsd", RV32C, c_immediate, (bit_matcher<u32>{0xE003, 0xA000}), translator_float_store<true>, default_formatter), // overriden by c.sq (RV128)
     RV_QUICK_INSN_TR(RiscV, "c.sw", RV32C, c_immediate, (bit_matcher<u32>{0xE003, 0xC000}), translator_sw, default_formatter),
-    RV_QUICK_INSN(RiscV, "c.fsw", RV32C, c_immediate, (bit_matcher<u32>{0xE003, 0xE000}), functor_nyi<RiscV>, default_formatter), // overridden by c.sd (RV64C, RV128C)
+    RV_QUICK_INSN_TR(RiscV, "c.fsw", RV32C, c_immediate, (bit_matcher<u32>{0xE003, 0xE000}), translator_float_store<false>, default_formatter), // overridden by c.sd (RV64C, RV128C)
 
     // quadrant 1
     RV_QUICK_INSN(RiscV, "c.nop", RV32C, c_immediate, (bit_matcher<u32>{0xFFFF, 0x0001}), functor_nop<RiscV>, default_formatter),
@@ -454,26 +542,26 @@ inline constexpr auto is_rv32c = instruction_set(
     RV_QUICK_INSN(RiscV, "hint(c.slli)", RV32C, c_immediate, (bit_matcher<u32>{0xEF83, 0x0002}), functor_hint<RiscV>, default_formatter), // hint rd=0
     RV_QUICK_INSN_TR(RiscV, "c.slli", RV32C, c_immediate, (bit_matcher<u32>{0xE003, 0x0002}), translator_slli, default_formatter),
 
-    RV_QUICK_INSN(RiscV, "c.fldsp", RV32C, c_immediate, (bit_matcher<u32>{0xE003, 0x2002}), functor_nyi<RiscV>, default_formatter), // overridden by c.lqsp (RV128C)
+    RV_QUICK_INSN_TR(RiscV, "c.fldsp", RV32C, c_immediate, (bit_matcher<u32>{0xE003, 0x2002}), translator_float_load_sp<true>, default_formatter), // overridden by c.lqsp (RV128C)
 
     RV_QUICK_INSN(RiscV, "reserved(c.lwsp)", RV32C, c_immediate, (bit_matcher<u32>{0xEF83, 0x4002}), functor_reserved<RiscV>, default_formatter), // RES, rd=0
     RV_QUICK_INSN_TR(RiscV, "c.lwsp", RV32C, c_immediate, (bit_matcher<u32>{0xE003, 0x4002}), translator_lwsp, default_formatter),
 
-    RV_QUICK_INSN(RiscV, "c.flwsp", RV32C, c_immediate, (bit_matcher<u32>{0xE003, 0x6002}), functor_nyi<RiscV>, default_formatter), // overridden by c.ldsp (RV64C, RV128C)
+    RV_QUICK_INSN_TR(RiscV, "c.flwsp", RV32C, c_immediate, (bit_matcher<u32>{0xE003, 0x6002}), translator_float_load_sp<false>, default_formatter), // overridden by c.ldsp (RV64C, RV128C)
 
     RV_QUICK_INSN(RiscV, "reserved(c.jr)", RV32C, c_immediate, (bit_matcher<u32>{0xFFFF, 0x8002}), functor_reserved<RiscV>, default_formatter),
     RV_QUICK_INSN_TR(RiscV, "c.jr", RV32C, c_immediate, (bit_matcher<u32>{0xF07F, 0x8002}), translator_jr, default_formatter),
     RV_QUICK_INSN(RiscV, "hint(c.mv)", RV32C, c_immediate, (bit_matcher<u32>{0xFF83, 0x8002}), functor_hint<RiscV>, default_formatter),
     RV_QUICK_INSN_TR(RiscV, "c.mv", RV32C, c_immediate, (bit_matcher<u32>{0xF003, 0x8002}), translator_mv, default_formatter),
 
-    RV_QUICK_INSN(RiscV, "c.ebreak", RV32C, c_immediate, (bit_matcher<u32>{0xFFFF, 0x9002}), functor_nyi<RiscV>, default_formatter),
+    RV_QUICK_INSN_TR(RiscV, "c.ebreak", RV32C, c_immediate, (bit_matcher<u32>{0xFFFF, 0x9002}), translator_ebreak, default_formatter),
     RV_QUICK_INSN_TR(RiscV, "c.jalr", RV32C, c_immediate, (bit_matcher<u32>{0xF07F, 0x9002}), translator_jalr, default_formatter),
     RV_QUICK_INSN(RiscV, "hint(c.add)", RV32C, c_immediate, (bit_matcher<u32>{0xFF83, 0x9002}), functor_hint<RiscV>, default_formatter),
     RV_QUICK_INSN_TR(RiscV, "c.add", RV32C, c_immediate, (bit_matcher<u32>{0xF003, 0x9002}), translator_add, default_formatter),
 
-    RV_QUICK_INSN(RiscV, "c.fsdsp", RV32C, c_immediate, (bit_matcher<u32>{0xE003, 0xA002}), functor_nyi<RiscV>, default_formatter), // overridden by c.sqsp (RV128C)
+    RV_QUICK_INSN_TR(RiscV, "c.fsdsp", RV32C, c_immediate, (bit_matcher<u32>{0xE003, 0xA002}), translator_float_store_sp<true>, default_formatter), // overridden by c.sqsp (RV128C)
     RV_QUICK_INSN_TR(RiscV, "c.swsp", RV32C, c_immediate, (bit_matcher<u32>{0xE003, 0xC002}), translator_swsp, default_formatter),
-    RV_QUICK_INSN(RiscV, "c.fswsp", RV32C, c_immediate, (bit_matcher<u32>{0xE003, 0xE002}), functor_nyi<RiscV>, default_formatter) // overridden by c.sdsp (RV64C, RV128C)*/
+    RV_QUICK_INSN_TR(RiscV, "c.fswsp", RV32C, c_immediate, (bit_matcher<u32>{0xE003, 0xE002}), translator_float_store_sp<false>, default_formatter) // overridden by c.sdsp (RV64C, RV128C)*/
 );
 
 template<typename RiscV>
@@ -7,24 +7,27 @@ namespace rv::detail {
 template<typename RiscV>
 inline constexpr auto is_rv32i = instruction_set(std::type_identity<RiscV> {},
     RV_QUICK_INSN_FN(RiscV, "lui", RV32I, upper_immediate, uimm_matcher<0b01101'11u>, default_formatter, {
-        self.m_register_bank.write_register(desc.reg_dst(), desc.upper_immediate<u64>());
+        self.write_register(desc.reg_dst(), desc.upper_immediate<u64>());
     }),
 
     RV_QUICK_INSN_FN(RiscV, "auipc", RV32I, upper_immediate, uimm_matcher<0b00101'11u>, default_formatter, {
-        self.m_register_bank.write_register(desc.reg_dst(), self.m_program_counter + desc.upper_immediate<u64>());
+        self.write_register(desc.reg_dst(), self.m_program_counter + desc.upper_immediate<u64>());
     }),
 
     RV_QUICK_INSN_FN(RiscV, "jal", RV32I, jump, uimm_matcher<0b11011'11>, default_formatter, {
         bool is_compressed = (self.m_memory.template read<u32>(self.m_program_counter) & 0b11) != 0b11;
-        self.m_register_bank.write_register(desc.reg_dst(), self.m_program_counter + self.m_next_step_sz);
+        self.write_register(desc.reg_dst(), self.m_program_counter + self.m_next_step_sz);
         self.jump(desc.jump_offset<u64>());
+        self.m_observer.on_jump(self, self.m_program_counter, self.m_program_counter + self.m_next_step_sz, desc.reg_dst(), reg::zero);
     }),
 
     RV_QUICK_INSN_FN(RiscV, "jalr", RV32I, immediate, (imm_matcher<0b11001'11, 0b000>), default_formatter, {
         bool is_compressed = (self.m_memory.template read<u32>(self.m_program_counter) & 0b11) != 0b11;
         const auto temp = self.m_program_counter + self.m_next_step_sz;
+        const auto from = self.m_program_counter;
         self.jump_to((self.m_register_bank.read_register(desc.reg_src_1()) + desc.immediate<u64>()) & (~(u64)1));
-        self.m_register_bank.write_register(desc.reg_dst(), temp);
+        self.write_register(desc.reg_dst(), temp);
+        self.m_observer.on_jump(self, from, self.m_program_counter, desc.reg_dst(), desc.reg_src_1());
     }),
 
     RV_QUICK_INSN(RiscV, "addi", RV32I, immediate, alu_imm_matcher<0>, (functor_alu<RiscV, alu_action::add>), default_formatter),
@@ -50,8 +53,13 @@ inline constexpr auto is_rv32i = instruction_set(std::type_identity<RiscV> {},
 
     RV_QUICK_INSN(RiscV, "fence", RV32I, immediate, (bit_matcher<u32>{0xF00F'FFFF, 0b00011'11}), functor_nop<RiscV>, fence_formatter),
 
-    RV_QUICK_INSN(RiscV, "ecall", RV32I, immediate, (bit_matcher<u32>{0xFFFF'FFFF, 0b11100'11}), functor_nop<RiscV>, mnemonic_only_formatter),
-    RV_QUICK_INSN(RiscV, "ebreak", RV32I, immediate, (bit_matcher<u32>{0xFFFF'FFFF, 0b11100'11 | (1 << 20)}), functor_nop<RiscV>, mnemonic_only_formatter),
+    RV_QUICK_INSN_FN(RiscV, "ecall", RV32I, immediate, (bit_matcher<u32>{0xFFFF'FFFF, 0b11100'11}), mnemonic_only_formatter, {
+        self.raise_exception(static_cast<typename RiscV::register_type>(trap_cause::environment_call_from_m));
+    }),
+
+    RV_QUICK_INSN_FN(RiscV, "ebreak", RV32I, immediate, (bit_matcher<u32>{0xFFFF'FFFF, 0b11100'11 | (1 << 20)}), mnemonic_only_formatter, {
+        self.raise_exception(static_cast<typename RiscV::register_type>(trap_cause::breakpoint), self.m_program_counter);
+    }),
 
     RV_QUICK_INSN(RiscV, "lb", RV32I, immediate, (imm_matcher<0b00000'11, 0b000>), (functor_load<RiscV, u8>), load_formatter),
     RV_QUICK_INSN(RiscV, "lh", RV32I, immediate, (imm_matcher<0b00000'11, 0b001>), (functor_load<RiscV, u16>), load_formatter),
@@ -81,12 +89,20 @@ inline constexpr auto is_rv32zifencei = instruction_set(
 template<typename RiscV>
 inline constexpr auto is_rv32zicsr = instruction_set(
   std::type_identity<RiscV>{},
-  RV_QUICK_INSN(RiscV, "csrrw", Zicsr, immediate, (imm_matcher<0b11100'11, 1>), functor_nop<RiscV>, mnemonic_only_formatter),
-  RV_QUICK_INSN(RiscV, "csrrs", Zicsr, immediate, (imm_matcher<0b11100'11, 2>), functor_nop<RiscV>, mnemonic_only_formatter),
-  RV_QUICK_INSN(RiscV, "csrrc", Zicsr, immediate, (imm_matcher<0b11100'11, 3>), functor_nop<RiscV>, mnemonic_only_formatter),
-  RV_QUICK_INSN(RiscV, "csrrwi", Zicsr, immediate, (imm_matcher<0b11100'11, 5>), functor_nop<RiscV>, mnemonic_only_formatter),
-  RV_QUICK_INSN(RiscV, "csrrsi", Zicsr, immediate, (imm_matcher<0b11100'11, 6>), functor_nop<RiscV>, mnemonic_only_formatter),
-  RV_QUICK_INSN(RiscV, "csrrci", Zicsr, immediate, (imm_matcher<0b11100'11, 7>), functor_nop<RiscV>, mnemonic_only_formatter)
+  RV_QUICK_INSN(RiscV, "csrrw", Zicsr, immediate, (imm_matcher<0b11100'11, 1>), (functor_csr<RiscV, csr_write_type::write>), csr_formatter),
+  RV_QUICK_INSN(RiscV, "csrrs", Zicsr, immediate, (imm_matcher<0b11100'11, 2>), (functor_csr<RiscV, csr_write_type::set>), csr_formatter),
+  RV_QUICK_INSN(RiscV, "csrrc", Zicsr, immediate, (imm_matcher<0b11100'11, 3>), (functor_csr<RiscV, csr_write_type::clear>), csr_formatter),
+  RV_QUICK_INSN(RiscV, "csrrwi", Zicsr, immediate, (imm_matcher<0b11100'11, 5>), (functor_csr<RiscV, csr_write_type::write, true>), csr_formatter),
+  RV_QUICK_INSN(RiscV, "csrrsi", Zicsr, immediate, (imm_matcher<0b11100'11, 6>), (functor_csr<RiscV, csr_write_type::set, true>), csr_formatter),
+  RV_QUICK_INSN(RiscV, "csrrci", Zicsr, immediate, (imm_matcher<0b11100'11, 7>), (functor_csr<RiscV, csr_write_type::clear, true>), csr_formatter)
+);
+
+/// the machine mode instructions of the privileged architecture, `wfi` is allowed to be a `nop` and is one
+template<typename RiscV>
+inline constexpr auto is_rv32_privileged = instruction_set(
+  std::type_identity<RiscV>{},
+  RV_QUICK_INSN_FN(RiscV, "mret", Privileged, immediate, (bit_matcher<u32>{0xFFFF'FFFF, 0x3020'0073}), mnemonic_only_formatter, { self.return_from_trap(); }),
+  RV_QUICK_INSN(RiscV, "wfi", Privileged, immediate, (bit_matcher<u32>{0xFFFF'FFFF, 0x1050'0073}), functor_nop<RiscV>, mnemonic_only_formatter)
 );
 
 }  // namespace rv::detail
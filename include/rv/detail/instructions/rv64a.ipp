@@ -34,7 +34,7 @@ struct functor_amo {
         using ld_st_type = std::conditional_t<DoubleWord, u64, u32>;
 
         const auto addr = self.m_register_bank.read_register(desc.reg_src_1());
-        const auto ldval_raw = self.m_memory.template read<ld_st_type>(addr);
+        const auto ldval_raw = self.template read_memory<ld_st_type>(addr);
         const auto ldval = arith::sext<typename Self::register_type, sizeof(ld_st_type) * 8>(ldval_raw);
 
         const auto reg_src_2 = self.m_register_bank.read_register(desc.reg_src_2());
@@ -53,8 +53,8 @@ struct functor_amo {
             }
         })();
 
-        self.m_register_bank.write_register(desc.reg_dst(), ldval);
-        self.m_memory.template write<ld_st_type>(addr, write_back);
+        self.write_register(desc.reg_dst(), ldval);
+        self.template write_memory<ld_st_type>(addr, write_back);
 
         // self.jump(0);
     }
@@ -69,9 +69,10 @@ struct functor_load_reserved {
         const auto release = ((desc.word >> 25u) & 1u) != 0u;
 
         const auto addr = self.m_register_bank.read_register(desc.reg_src_1());
+        self.m_observer.on_memory_access(self, addr, sizeof(ld_st_type), memory_access_type::read);
         const auto ld_val_raw = self.m_memory.template load_reserved<ld_st_type>(addr);
         const auto ld_val = arith::sext<typename Self::register_type, sizeof(ld_st_type) * 8>(ld_val_raw);
-        self.m_register_bank.write_register(desc.reg_dst(), ld_val);
+        self.write_register(desc.reg_dst(), ld_val);
     }
 };
 
@@ -85,18 +86,20 @@ struct functor_store_conditional {
 
         const auto addr = self.m_register_bank.read_register(desc.reg_src_1());
         const auto st_val = self.m_register_bank.read_register(desc.reg_src_2());
+        self.m_observer.on_memory_access(self, addr, sizeof(ld_st_type), memory_access_type::write);
         const auto success = self.m_memory.template store_conditional<ld_st_type>(addr, st_val);
-        self.m_register_bank.write_register(desc.reg_dst(), success ? 0u : 1u);
+        self.write_register(desc.reg_dst(), success ? 0u : 1u);
     }
 };
 
-inline auto formatter_amo(instruction_descriptor desc, bool abi_registers = false) -> std::string {
+inline void formatter_amo(format_buffer& out, instruction_descriptor desc, bool abi_registers = false) {
     const auto reg_name = abi_registers ? ::rv::register_name<true> : ::rv::register_name<false>;
 
     const auto acquire = ((desc.word >> 26u) & 1u) != 0u;
     const auto release = ((desc.word >> 25u) & 1u) != 0u;
 
-    return fmt::format(
+    fmt::format_to(
+      std::back_inserter(out),        //
       "{}{}{}{} {}, {}, ({})",        //
       desc.mnemonic,                  //
       acquire || release ? "." : "",  //
@@ -0,0 +1,187 @@
+#pragma once
+
+namespace rv::detail {
+
+/// `clz rd, rs1` and the rest of the instructions that only have the one source
+constexpr void unary_formatter(format_buffer& out, instruction_descriptor instruction, bool abi_registers) {
+    const auto reg_name = abi_registers ? ::rv::register_name<true> : ::rv::register_name<false>;
+
+    fmt::format_to(std::back_inserter(out), "{} {}, {}", instruction.mnemonic, reg_name(instruction.reg_dst()), reg_name(instruction.reg_src_1()));
+}
+
+/// the immediate rotates, bit operations and `slli.uw`, which have `ShiftBits` bits of shift amount or bit index under their funct6 or funct7
+template<u32 ShiftBits>
+constexpr void shift_amount_formatter(format_buffer& out, instruction_descriptor instruction, bool abi_registers) {
+    const auto reg_name = abi_registers ? ::rv::register_name<true> : ::rv::register_name<false>;
+
+    fmt::format_to(
+      std::back_inserter(out), "{} {}, {}, {}", instruction.mnemonic, reg_name(instruction.reg_dst()), reg_name(instruction.reg_src_1()),
+      instruction.shift_amt<u32, ShiftBits>()
+    );
+}
+
+/// the immediate forms of the Zbb and Zbs instructions that take a shift amount or bit index, the upper 6 bits of the immediate are a funct6
+/// On RV32 the shift amount only has 5 bits, the encodings with bit 25 set are reserved.
+template<typename RiscV, u32 Action, u32 Funct6>
+inline constexpr auto shift_imm_matcher = alu_imm_matcher<Action>.combine(sizeof(typename RiscV::register_type) == 4 ? 0xFE00'0000u : 0xFC00'0000u, Funct6 << 26);
+
+/// the unary Zbb instructions, which have a funct12 where the immediate would be
+template<u32 Opcode, u32 Action, u32 Funct12>
+inline constexpr auto unary_matcher = imm_matcher<Opcode, Action>.combine(0xFFF0'0000u, Funct12 << 20);
+
+/// `rev8` has the log2 of XLEN in its funct12
+template<typename RiscV>
+inline constexpr auto rev8_matcher = unary_matcher<0b00100'11, 5, sizeof(typename RiscV::register_type) == 4 ? 0x698u : 0x6B8u>;
+
+/// `zext.h` is `pack`/`packw` with rs2 = x0, which are OP on RV32 and OP-32 on RV64
+template<typename RiscV>
+inline constexpr auto zext_h_matcher = (sizeof(typename RiscV::register_type) == 4 ? alu_matcher<4, 0b00001'00> : aluw_matcher<4, 0b00001'00>).combine(0x01F0'0000u, 0);
+
+/// `orc.b`, every byte that isn't zero becomes 0xFF
+template<std::unsigned_integral T>
+constexpr auto or_combine_bytes(T v) -> T {
+    constexpr auto low_bits = static_cast<T>(~T(0) / 0xFF * 0x7F);
+
+    // the high bit of each byte gets set if any of the bits of the byte are, without carries between the bytes
+    const auto high_bits = static_cast<T>((((v & low_bits) + low_bits) | v) & ~low_bits);
+    return static_cast<T>((high_bits >> 7) * 0xFF);
+}
+
+static_assert(or_combine_bytes<u64>(0x0080'0100'0000'FF01ull) == 0x00FF'FF00'0000'FFFFull);
+static_assert(or_combine_bytes<u32>(0x0100'007F) == 0xFF00'00FF);
+
+/// The Zba, Zbb and Zbs instructions. `Word` instructions work on the lower 32 bits and sign extend their result.
+template<typename Self, bitmanip_action Act, bool Imm = false, bool Word = false>
+struct functor_bitmanip {
+    constexpr void operator()(Self& self, instruction_descriptor desc) const {
+        using register_type = typename Self::register_type;
+
+        const auto op_1 = self.m_register_bank.read_register(desc.reg_src_1());
+        const auto op_2 = Imm ? desc.immediate<register_type>() : self.m_register_bank.read_register(desc.reg_src_2());
+
+        if constexpr (Word) {
+            self.write_register(desc.reg_dst(), arith::sext<register_type, 32>(static_cast<register_type>(impl<u32>(static_cast<u32>(op_1), static_cast<u32>(op_2)))));
+        } else {
+            self.write_register(desc.reg_dst(), impl<register_type>(op_1, op_2));
+        }
+    }
+
+private:
+    template<std::unsigned_integral T>
+    static constexpr auto impl(T a, T b) -> T {
+        using signed_type = std::make_signed_t<T>;
+
+        constexpr auto bits = static_cast<T>(std::numeric_limits<T>::digits);
+        // shift amounts and bit indices
+        const auto index = static_cast<int>(b & (bits - 1));
+        const auto word = static_cast<T>(static_cast<u32>(a));
+
+        switch (Act) {
+            case bitmanip_action::sh1add: return static_cast<T>((a << 1) + b);
+            case bitmanip_action::sh2add: return static_cast<T>((a << 2) + b);
+            case bitmanip_action::sh3add: return static_cast<T>((a << 3) + b);
+            case bitmanip_action::add_uw: return static_cast<T>(word + b);
+            case bitmanip_action::sh1add_uw: return static_cast<T>((word << 1) + b);
+            case bitmanip_action::sh2add_uw: return static_cast<T>((word << 2) + b);
+            case bitmanip_action::sh3add_uw: return static_cast<T>((word << 3) + b);
+            case bitmanip_action::slli_uw: return static_cast<T>(word << index);
+
+            case bitmanip_action::andn: return a & ~b;
+            case bitmanip_action::orn: return a | ~b;
+            case bitmanip_action::xnor: return ~(a ^ b);
+            case bitmanip_action::clz: return static_cast<T>(std::countl_zero(a));
+            case bitmanip_action::ctz: return static_cast<T>(std::countr_zero(a));
+            case bitmanip_action::cpop: return static_cast<T>(std::popcount(a));
+            case bitmanip_action::max: return static_cast<T>(std::max(static_cast<signed_type>(a), static_cast<signed_type>(b)));
+            case bitmanip_action::maxu: return std::max(a, b);
+            case bitmanip_action::min: return static_cast<T>(std::min(static_cast<signed_type>(a), static_cast<signed_type>(b)));
+            case bitmanip_action::minu: return std::min(a, b);
+            case bitmanip_action::sext_b: return arith::sext<T, 8>(static_cast<T>(static_cast<u8>(a)));
+            case bitmanip_action::sext_h: return arith::sext<T, 16>(static_cast<T>(static_cast<u16>(a)));
+            case bitmanip_action::zext_h: return static_cast<T>(static_cast<u16>(a));
+            case bitmanip_action::rol: return std::rotl(a, index);
+            case bitmanip_action::ror: return std::rotr(a, index);
+            case bitmanip_action::orc_b: return or_combine_bytes(a);
+            case bitmanip_action::rev8: return std::byteswap(a);
+
+            case bitmanip_action::bclr: return a & ~(T(1) << index);
+            case bitmanip_action::bext: return (a >> index) & 1;
+            case bitmanip_action::binv: return a ^ (T(1) << index);
+            case bitmanip_action::bset: return a | (T(1) << index);
+        }
+    }
+};
+
+// clang-format off
+template<typename RiscV>
+inline constexpr auto is_rv32zba = instruction_set(
+    std::type_identity<RiscV> {},
+    RV_QUICK_INSN(RiscV, "sh1add", Zba, reg_reg, (alu_matcher<2, 0b00100'00>), (functor_bitmanip<RiscV, bitmanip_action::sh1add>), default_formatter),
+    RV_QUICK_INSN(RiscV, "sh2add", Zba, reg_reg, (alu_matcher<4, 0b00100'00>), (functor_bitmanip<RiscV, bitmanip_action::sh2add>), default_formatter),
+    RV_QUICK_INSN(RiscV, "sh3add", Zba, reg_reg, (alu_matcher<6, 0b00100'00>), (functor_bitmanip<RiscV, bitmanip_action::sh3add>), default_formatter)
+);
+
+template<typename RiscV>
+inline constexpr auto is_rv64zba = instruction_set(instruction_set(
+    std::type_identity<RiscV> {},
+    // `add.uw rd, rs1, x0`, this has to come before add.uw
+    RV_QUICK_INSN(RiscV, "zext.w", Zba, reg_reg, (aluw_matcher<0, 0b00001'00>.combine(0x01F0'0000u, 0)), (functor_bitmanip<RiscV, bitmanip_action::add_uw>), unary_formatter),
+    RV_QUICK_INSN(RiscV, "add.uw", Zba, reg_reg, (aluw_matcher<0, 0b00001'00>), (functor_bitmanip<RiscV, bitmanip_action::add_uw>), default_formatter),
+    RV_QUICK_INSN(RiscV, "sh1add.uw", Zba, reg_reg, (aluw_matcher<2, 0b00100'00>), (functor_bitmanip<RiscV, bitmanip_action::sh1add_uw>), default_formatter),
+    RV_QUICK_INSN(RiscV, "sh2add.uw", Zba, reg_reg, (aluw_matcher<4, 0b00100'00>), (functor_bitmanip<RiscV, bitmanip_action::sh2add_uw>), default_formatter),
+    RV_QUICK_INSN(RiscV, "sh3add.uw", Zba, reg_reg, (aluw_matcher<6, 0b00100'00>), (functor_bitmanip<RiscV, bitmanip_action::sh3add_uw>), default_formatter),
+    RV_QUICK_INSN(RiscV, "slli.uw", Zba, immediate, (aluw_imm_matcher<1>.combine(0xFC00'0000u, 0b000010u << 26)), (functor_bitmanip<RiscV, bitmanip_action::slli_uw, true>), shift_amount_formatter<6>)
+), is_rv32zba<RiscV>);
+
+template<typename RiscV>
+inline constexpr auto is_rv32zbb = instruction_set(
+    std::type_identity<RiscV> {},
+    RV_QUICK_INSN(RiscV, "andn", Zbb, reg_reg, (alu_matcher<7, 0b01000'00>), (functor_bitmanip<RiscV, bitmanip_action::andn>), default_formatter),
+    RV_QUICK_INSN(RiscV, "orn", Zbb, reg_reg, (alu_matcher<6, 0b01000'00>), (functor_bitmanip<RiscV, bitmanip_action::orn>), default_formatter),
+    RV_QUICK_INSN(RiscV, "xnor", Zbb, reg_reg, (alu_matcher<4, 0b01000'00>), (functor_bitmanip<RiscV, bitmanip_action::xnor>), default_formatter),
+
+    RV_QUICK_INSN(RiscV, "clz", Zbb, immediate, (unary_matcher<0b00100'11, 1, 0x600>), (functor_bitmanip<RiscV, bitmanip_action::clz>), unary_formatter),
+    RV_QUICK_INSN(RiscV, "ctz", Zbb, immediate, (unary_matcher<0b00100'11, 1, 0x601>), (functor_bitmanip<RiscV, bitmanip_action::ctz>), unary_formatter),
+    RV_QUICK_INSN(RiscV, "cpop", Zbb, immediate, (unary_matcher<0b00100'11, 1, 0x602>), (functor_bitmanip<RiscV, bitmanip_action::cpop>), unary_formatter),
+    RV_QUICK_INSN(RiscV, "sext.b", Zbb, immediate, (unary_matcher<0b00100'11, 1, 0x604>), (functor_bitmanip<RiscV, bitmanip_action::sext_b>), unary_formatter),
+    RV_QUICK_INSN(RiscV, "sext.h", Zbb, immediate, (unary_matcher<0b00100'11, 1, 0x605>), (functor_bitmanip<RiscV, bitmanip_action::sext_h>), unary_formatter),
+    RV_QUICK_INSN(RiscV, "zext.h", Zbb, reg_reg, zext_h_matcher<RiscV>, (functor_bitmanip<RiscV, bitmanip_action::zext_h>), unary_formatter),
+    RV_QUICK_INSN(RiscV, "orc.b", Zbb, immediate, (unary_matcher<0b00100'11, 5, 0x287>), (functor_bitmanip<RiscV, bitmanip_action::orc_b>), unary_formatter),
+    RV_QUICK_INSN(RiscV, "rev8", Zbb, immediate, rev8_matcher<RiscV>, (functor_bitmanip<RiscV, bitmanip_action::rev8>), unary_formatter),
+
+    RV_QUICK_INSN(RiscV, "max", Zbb, reg_reg, (alu_matcher<6, 0b00001'01>), (functor_bitmanip<RiscV, bitmanip_action::max>), default_formatter),
+    RV_QUICK_INSN(RiscV, "maxu", Zbb, reg_reg, (alu_matcher<7, 0b00001'01>), (functor_bitmanip<RiscV, bitmanip_action::maxu>), default_formatter),
+    RV_QUICK_INSN(RiscV, "min", Zbb, reg_reg, (alu_matcher<4, 0b00001'01>), (functor_bitmanip<RiscV, bitmanip_action::min>), default_formatter),
+    RV_QUICK_INSN(RiscV, "minu", Zbb, reg_reg, (alu_matcher<5, 0b00001'01>), (functor_bitmanip<RiscV, bitmanip_action::minu>), default_formatter),
+
+    RV_QUICK_INSN(RiscV, "rol", Zbb, reg_reg, (alu_matcher<1, 0b01100'00>), (functor_bitmanip<RiscV, bitmanip_action::rol>), default_formatter),
+    RV_QUICK_INSN(RiscV, "ror", Zbb, reg_reg, (alu_matcher<5, 0b01100'00>), (functor_bitmanip<RiscV, bitmanip_action::ror>), default_formatter),
+    RV_QUICK_INSN(RiscV, "rori", Zbb, immediate, (shift_imm_matcher<RiscV, 5, 0b011000>), (functor_bitmanip<RiscV, bitmanip_action::ror, true>), shift_amount_formatter<6>)
+);
+
+template<typename RiscV>
+inline constexpr auto is_rv64zbb = instruction_set(instruction_set(
+    std::type_identity<RiscV> {},
+    RV_QUICK_INSN(RiscV, "clzw", Zbb, immediate, (unary_matcher<0b00110'11, 1, 0x600>), (functor_bitmanip<RiscV, bitmanip_action::clz, false, true>), unary_formatter),
+    RV_QUICK_INSN(RiscV, "ctzw", Zbb, immediate, (unary_matcher<0b00110'11, 1, 0x601>), (functor_bitmanip<RiscV, bitmanip_action::ctz, false, true>), unary_formatter),
+    RV_QUICK_INSN(RiscV, "cpopw", Zbb, immediate, (unary_matcher<0b00110'11, 1, 0x602>), (functor_bitmanip<RiscV, bitmanip_action::cpop, false, true>), unary_formatter),
+    RV_QUICK_INSN(RiscV, "rolw", Zbb, reg_reg, (aluw_matcher<1, 0b01100'00>), (functor_bitmanip<RiscV, bitmanip_action::rol, false, true>), default_formatter),
+    RV_QUICK_INSN(RiscV, "rorw", Zbb, reg_reg, (aluw_matcher<5, 0b01100'00>), (functor_bitmanip<RiscV, bitmanip_action::ror, false, true>), default_formatter),
+    RV_QUICK_INSN(RiscV, "roriw", Zbb, immediate, (aluw_imm_matcher<5>.combine(0xFE00'0000u, 0b01100'00u << 25)), (functor_bitmanip<RiscV, bitmanip_action::ror, true, true>), shift_amount_formatter<5>)
+), is_rv32zbb<RiscV>);
+
+template<typename RiscV>
+inline constexpr auto is_rv32zbs = instruction_set(
+    std::type_identity<RiscV> {},
+    RV_QUICK_INSN(RiscV, "bclr", Zbs, reg_reg, (alu_matcher<1, 0b01001'00>), (functor_bitmanip<RiscV, bitmanip_action::bclr>), default_formatter),
+    RV_QUICK_INSN(RiscV, "bclri", Zbs, immediate, (shift_imm_matcher<RiscV, 1, 0b010010>), (functor_bitmanip<RiscV, bitmanip_action::bclr, true>), shift_amount_formatter<6>),
+    RV_QUICK_INSN(RiscV, "bext", Zbs, reg_reg, (alu_matcher<5, 0b01001'00>), (functor_bitmanip<RiscV, bitmanip_action::bext>), default_formatter),
+    RV_QUICK_INSN(RiscV, "bexti", Zbs, immediate, (shift_imm_matcher<RiscV, 5, 0b010010>), (functor_bitmanip<RiscV, bitmanip_action::bext, true>), shift_amount_formatter<6>),
+    RV_QUICK_INSN(RiscV, "binv", Zbs, reg_reg, (alu_matcher<1, 0b01101'00>), (functor_bitmanip<RiscV, bitmanip_action::binv>), default_formatter),
+    RV_QUICK_INSN(RiscV, "binvi", Zbs, immediate, (shift_imm_matcher<RiscV, 1, 0b011010>), (functor_bitmanip<RiscV, bitmanip_action::binv, true>), shift_amount_formatter<6>),
+    RV_QUICK_INSN(RiscV, "bset", Zbs, reg_reg, (alu_matcher<1, 0b00101'00>), (functor_bitmanip<RiscV, bitmanip_action::bset>), default_formatter),
+    RV_QUICK_INSN(RiscV, "bseti", Zbs, immediate, (shift_imm_matcher<RiscV, 1, 0b001010>), (functor_bitmanip<RiscV, bitmanip_action::bset, true>), shift_amount_formatter<6>)
+);
+// clang-format on
+
+}  // namespace rv::detail
@@ -0,0 +1,54 @@
+#pragma once
+
+namespace rv::detail {
+
+// clang-format off
+template<typename RiscV>
+inline constexpr auto is_rv32d = instruction_set(
+    std::type_identity<RiscV> {},
+    RV_QUICK_INSN(RiscV, "fld", RV32D, immediate, (imm_matcher<0b00001'11, 0b011>), (functor_float_load<RiscV, double>), float_load_formatter),
+    RV_QUICK_INSN(RiscV, "fsd", RV32D, store, (imm_matcher<0b01001'11, 0b011>), (functor_float_store<RiscV, double>), float_store_formatter),
+
+    RV_QUICK_INSN(RiscV, "fmadd.d", RV32D, reg_reg, (fused_matcher<0b10000'11, double>), (functor_float_arith<RiscV, double, float_operation::fmadd>), (float_formatter<float_operands::fused, true>)),
+    RV_QUICK_INSN(RiscV, "fmsub.d", RV32D, reg_reg, (fused_matcher<0b10001'11, double>), (functor_float_arith<RiscV, double, float_operation::fmsub>), (float_formatter<float_operands::fused, true>)),
+    RV_QUICK_INSN(RiscV, "fnmsub.d", RV32D, reg_reg, (fused_matcher<0b10010'11, double>), (functor_float_arith<RiscV, double, float_operation::fnmsub>), (float_formatter<float_operands::fused, true>)),
+    RV_QUICK_INSN(RiscV, "fnmadd.d", RV32D, reg_reg, (fused_matcher<0b10011'11, double>), (functor_float_arith<RiscV, double, float_operation::fnmadd>), (float_formatter<float_operands::fused, true>)),
+
+    RV_QUICK_INSN(RiscV, "fadd.d", RV32D, reg_reg, (float_matcher<0b00000, double>), (functor_float_arith<RiscV, double, float_operation::add>), (float_formatter<float_operands::float_float_float, true>)),
+    RV_QUICK_INSN(RiscV, "fsub.d", RV32D, reg_reg, (float_matcher<0b00001, double>), (functor_float_arith<RiscV, double, float_operation::sub>), (float_formatter<float_operands::float_float_float, true>)),
+    RV_QUICK_INSN(RiscV, "fmul.d", RV32D, reg_reg, (float_matcher<0b00010, double>), (functor_float_arith<RiscV, double, float_operation::mul>), (float_formatter<float_operands::float_float_float, true>)),
+    RV_QUICK_INSN(RiscV, "fdiv.d", RV32D, reg_reg, (float_matcher<0b00011, double>), (functor_float_arith<RiscV, double, float_operation::div>), (float_formatter<float_operands::float_float_float, true>)),
+    RV_QUICK_INSN(RiscV, "fsqrt.d", RV32D, reg_reg, (float_rs_2_matcher<0b01011, double, 0>), (functor_float_arith<RiscV, double, float_operation::sqrt>), (float_formatter<float_operands::float_float, true>)),
+
+    RV_QUICK_INSN(RiscV, "fsgnj.d", RV32D, reg_reg, (float_funct_3_matcher<0b00100, double, 0b000>), (functor_float_sign_injection<RiscV, double, sign_injection::copy>), (float_formatter<float_operands::float_float_float, false>)),
+    RV_QUICK_INSN(RiscV, "fsgnjn.d", RV32D, reg_reg, (float_funct_3_matcher<0b00100, double, 0b001>), (functor_float_sign_injection<RiscV, double, sign_injection::negate>), (float_formatter<float_operands::float_float_float, false>)),
+    RV_QUICK_INSN(RiscV, "fsgnjx.d", RV32D, reg_reg, (float_funct_3_matcher<0b00100, double, 0b010>), (functor_float_sign_injection<RiscV, double, sign_injection::bxor>), (float_formatter<float_operands::float_float_float, false>)),
+    RV_QUICK_INSN(RiscV, "fmin.d", RV32D, reg_reg, (float_funct_3_matcher<0b00101, double, 0b000>), (functor_float_min_max<RiscV, double, false>), (float_formatter<float_operands::float_float_float, false>)),
+    RV_QUICK_INSN(RiscV, "fmax.d", RV32D, reg_reg, (float_funct_3_matcher<0b00101, double, 0b001>), (functor_float_min_max<RiscV, double, true>), (float_formatter<float_operands::float_float_float, false>)),
+
+    RV_QUICK_INSN(RiscV, "fcvt.s.d", RV32D, reg_reg, (float_rs_2_matcher<0b01000, float, 1>), (functor_float_convert<RiscV, double, float>), (float_formatter<float_operands::float_float, true>)),
+    RV_QUICK_INSN(RiscV, "fcvt.d.s", RV32D, reg_reg, (float_rs_2_matcher<0b01000, double, 0>), (functor_float_convert<RiscV, float, double>), (float_formatter<float_operands::float_float, true>)),
+
+    RV_QUICK_INSN(RiscV, "fcvt.w.d", RV32D, reg_reg, (float_rs_2_matcher<0b11000, double, 0>), (functor_float_to_integer<RiscV, double, i32>), (float_formatter<float_operands::integer_float, true>)),
+    RV_QUICK_INSN(RiscV, "fcvt.wu.d", RV32D, reg_reg, (float_rs_2_matcher<0b11000, double, 1>), (functor_float_to_integer<RiscV, double, u32>), (float_formatter<float_operands::integer_float, true>)),
+    RV_QUICK_INSN(RiscV, "feq.d", RV32D, reg_reg, (float_funct_3_matcher<0b10100, double, 0b010>), (functor_float_compare<RiscV, double, float_comparison::equal>), (float_formatter<float_operands::integer_float_float, false>)),
+    RV_QUICK_INSN(RiscV, "flt.d", RV32D, reg_reg, (float_funct_3_matcher<0b10100, double, 0b001>), (functor_float_compare<RiscV, double, float_comparison::less>), (float_formatter<float_operands::integer_float_float, false>)),
+    RV_QUICK_INSN(RiscV, "fle.d", RV32D, reg_reg, (float_funct_3_matcher<0b10100, double, 0b000>), (functor_float_compare<RiscV, double, float_comparison::less_equal>), (float_formatter<float_operands::integer_float_float, false>)),
+    RV_QUICK_INSN(RiscV, "fclass.d", RV32D, reg_reg, (float_rs_2_matcher<0b11100, double, 0>.combine_with(funct_3_matcher<0b001>)), (functor_float_classify<RiscV, double>), (float_formatter<float_operands::integer_float, false>)),
+    RV_QUICK_INSN(RiscV, "fcvt.d.w", RV32D, reg_reg, (float_rs_2_matcher<0b11010, double, 0>), (functor_integer_to_float<RiscV, i32, double>), (float_formatter<float_operands::float_integer, true>)),
+    RV_QUICK_INSN(RiscV, "fcvt.d.wu", RV32D, reg_reg, (float_rs_2_matcher<0b11010, double, 1>), (functor_integer_to_float<RiscV, u32, double>), (float_formatter<float_operands::float_integer, true>))
+);
+
+template<typename RiscV>
+inline constexpr auto is_rv64d = instruction_set(instruction_set(
+    std::type_identity<RiscV> {},
+    RV_QUICK_INSN(RiscV, "fcvt.l.d", RV64D, reg_reg, (float_rs_2_matcher<0b11000, double, 2>), (functor_float_to_integer<RiscV, double, i64>), (float_formatter<float_operands::integer_float, true>)),
+    RV_QUICK_INSN(RiscV, "fcvt.lu.d", RV64D, reg_reg, (float_rs_2_matcher<0b11000, double, 3>), (functor_float_to_integer<RiscV, double, u64>), (float_formatter<float_operands::integer_float, true>)),
+    RV_QUICK_INSN(RiscV, "fmv.x.d", RV64D, reg_reg, (float_rs_2_matcher<0b11100, double, 0>.combine_with(funct_3_matcher<0b000>)), (functor_float_move_to_integer<RiscV, double>), (float_formatter<float_operands::integer_float, false>)),
+    RV_QUICK_INSN(RiscV, "fcvt.d.l", RV64D, reg_reg, (float_rs_2_matcher<0b11010, double, 2>), (functor_integer_to_float<RiscV, i64, double>), (float_formatter<float_operands::float_integer, true>)),
+    RV_QUICK_INSN(RiscV, "fcvt.d.lu", RV64D, reg_reg, (float_rs_2_matcher<0b11010, double, 3>), (functor_integer_to_float<RiscV, u64, double>), (float_formatter<float_operands::float_integer, true>)),
+    RV_QUICK_INSN(RiscV, "fmv.d.x", RV64D, reg_reg, (float_rs_2_matcher<0b11110, double, 0>.combine_with(funct_3_matcher<0b000>)), (functor_float_move_from_integer<RiscV, double>), (float_formatter<float_operands::float_integer, false>))
+), is_rv32d<RiscV>);
+// clang-format on
+
+}  // namespace rv::detail
@@ -0,0 +1,353 @@
+#pragma once
+
+namespace rv::detail {
+
+template<std::floating_point T>
+inline constexpr u32 float_format = sizeof(T) == sizeof(u32) ? 0b00 : 0b01;
+
+template<u32 Funct5, std::floating_point T>
+inline constexpr auto float_matcher = opcode_matcher<0b10100'11>.combine_with(funct_7_matcher<(Funct5 << 2) | float_format<T>>);
+
+/// for the instructions that have something other than the rounding mode in funct3
+template<u32 Funct5, std::floating_point T, u32 Funct3>
+inline constexpr auto float_funct_3_matcher = float_matcher<Funct5, T>.combine_with(funct_3_matcher<Funct3>);
+
+/// for the instructions that have something other than a register in rs2
+template<u32 Funct5, std::floating_point T, u32 Rs2>
+inline constexpr auto float_rs_2_matcher = float_matcher<Funct5, T>.combine(0x01F0'0000u, Rs2 << 20);
+
+template<u32 Opcode, std::floating_point T>
+inline constexpr auto fused_matcher = opcode_matcher<Opcode>.combine(0x0600'0000u, float_format<T> << 25);
+
+enum class float_operands {
+    /// fd, fs1, fs2
+    float_float_float,
+    /// fd, fs1, fs2, fs3
+    fused,
+    /// fd, fs1
+    float_float,
+    /// rd, fs1
+    integer_float,
+    /// rd, fs1, fs2
+    integer_float_float,
+    /// fd, rs1
+    float_integer,
+};
+
+template<float_operands Operands, bool RoundingMode>
+constexpr void float_formatter(format_buffer& out, instruction_descriptor instruction, bool abi_registers) {
+    const auto reg_name = abi_registers ? ::rv::register_name<true> : ::rv::register_name<false>;
+    const auto float_name = [abi_registers](float_reg reg) { return abi_registers ? enum_name<true>(reg) : enum_name<false>(reg); };
+
+    auto it = fmt::format_to(std::back_inserter(out), "{}", instruction.mnemonic);
+
+    switch (Operands) {
+        case float_operands::float_float_float:
+            it = fmt::format_to(it, " {}, {}, {}", float_name(instruction.float_dst()), float_name(instruction.float_src_1()), float_name(instruction.float_src_2()));
+            break;
+        case float_operands::fused:
+            it = fmt::format_to(
+              it, " {}, {}, {}, {}", float_name(instruction.float_dst()), float_name(instruction.float_src_1()), float_name(instruction.float_src_2()),
+              float_name(instruction.float_src_3())
+            );
+            break;
+        case float_operands::float_float: it = fmt::format_to(it, " {}, {}", float_name(instruction.float_dst()), float_name(instruction.float_src_1())); break;
+        case float_operands::integer_float: it = fmt::format_to(it, " {}, {}", reg_name(instruction.reg_dst()), float_name(instruction.float_src_1())); break;
+        case float_operands::integer_float_float:
+            it = fmt::format_to(it, " {}, {}, {}", reg_name(instruction.reg_dst()), float_name(instruction.float_src_1()), float_name(instruction.float_src_2()));
+            break;
+        case float_operands::float_integer: it = fmt::format_to(it, " {}, {}", float_name(instruction.float_dst()), reg_name(instruction.reg_src_1())); break;
+    }
+
+    // like objdump, the rounding mode is only shown if it isn't the dynamic one
+    if (RoundingMode && instruction.rm() != static_cast<u32>(rounding_mode::dynamic)) {
+        fmt::format_to(it, ", {}", rounding_mode_name(instruction.rm()));
+    }
+}
+
+constexpr void float_load_formatter(format_buffer& out, instruction_descriptor instruction, bool abi_registers) {
+    const auto reg_name = abi_registers ? ::rv::register_name<true> : ::rv::register_name<false>;
+    const auto float_name = abi_registers ? enum_name<true>(instruction.float_dst()) : enum_name<false>(instruction.float_dst());
+
+    fmt::format_to(std::back_inserter(out), "{} {}, {}({})", instruction.mnemonic, float_name, static_cast<i32>(instruction.immediate()), reg_name(instruction.reg_src_1()));
+}
+
+constexpr void float_store_formatter(format_buffer& out, instruction_descriptor instruction, bool abi_registers) {
+    const auto reg_name = abi_registers ? ::rv::register_name<true> : ::rv::register_name<false>;
+    const auto float_name = abi_registers ? enum_name<true>(instruction.float_src_2()) : enum_name<false>(instruction.float_src_2());
+
+    fmt::format_to(std::back_inserter(out), "{} {}, {}({})", instruction.mnemonic, float_name, static_cast<i32>(instruction.store_offset()), reg_name(instruction.reg_src_1()));
+}
+
+/// The rounding mode an instruction is to use, `frm` for the dynamic one. Invalid rounding modes raise the illegal instruction
+/// exception, the instruction is not to do anything else then.
+template<typename Self>
+constexpr auto instruction_rounding_mode(Self& self, instruction_descriptor desc) -> std::optional<rounding_mode> {
+    auto mode = desc.rm();
+    if (mode == static_cast<u32>(rounding_mode::dynamic)) {
+        mode = self.m_csr.float_rounding_mode();
+    }
+
+    if (mode > static_cast<u32>(rounding_mode::nearest_max_magnitude)) {
+        self.raise_illegal_instruction();
+        return std::nullopt;
+    }
+
+    return static_cast<rounding_mode>(mode);
+}
+
+template<typename Self, std::floating_point T>
+struct functor_float_load {
+    constexpr void operator()(Self& self, instruction_descriptor desc) const {
+        const auto address = self.m_register_bank.read_register(desc.reg_src_1()) + desc.immediate<typename Self::register_type>();
+        self.m_register_bank.write_register(desc.float_dst(), nan_box_bits<T>(self.template read_memory<float_bits_t<T>>(address)));
+    }
+};
+
+/// Stores the bits in the register as they are, NaN-boxed or not.
+template<typename Self, std::floating_point T>
+struct functor_float_store {
+    constexpr void operator()(Self& self, instruction_descriptor desc) const {
+        const auto address = self.m_register_bank.read_register(desc.reg_src_1()) + desc.store_offset<typename Self::register_type>();
+        self.template write_memory<float_bits_t<T>>(address, static_cast<float_bits_t<T>>(self.m_register_bank.read_register(desc.float_src_2())));
+    }
+};
+
+enum class float_operation {
+    add,
+    sub,
+    mul,
+    div,
+    sqrt,
+
+    /// (rs1 * rs2) + rs3
+    fmadd,
+    /// (rs1 * rs2) - rs3
+    fmsub,
+    /// -(rs1 * rs2) + rs3
+    fnmsub,
+    /// -(rs1 * rs2) - rs3
+    fnmadd,
+};
+
+template<typename Self, std::floating_point T, float_operation Op>
+struct functor_float_arith {
+    constexpr void operator()(Self& self, instruction_descriptor desc) const {
+        const auto mode = instruction_rounding_mode(self, desc);
+        if (!mode) {
+            return;
+        }
+
+        const auto a = self.template read_float<T>(desc.float_src_1());
+        const auto b = self.template read_float<T>(desc.float_src_2());
+
+        const auto [result, flags] = ([&] {
+            if constexpr (Op == float_operation::add) {
+                return host_evaluate<T>(*mode, [](auto x, auto y) { return x + y; }, a, b);
+            } else if constexpr (Op == float_operation::sub) {
+                return host_evaluate<T>(*mode, [](auto x, auto y) { return x - y; }, a, b);
+            } else if constexpr (Op == float_operation::mul) {
+                return host_evaluate<T>(*mode, [](auto x, auto y) { return x * y; }, a, b);
+            } else if constexpr (Op == float_operation::div) {
+                return host_evaluate<T>(*mode, [](auto x, auto y) { return x / y; }, a, b);
+            } else if constexpr (Op == float_operation::sqrt) {
+                return host_evaluate<T>(*mode, [](auto x) { return std::sqrt(x); }, a);
+            } else {
+                const auto c = self.template read_float<T>(desc.float_src_3());
+                // negating is exact, the products only get rounded once
+                constexpr auto negate_product = Op == float_operation::fnmsub || Op == float_operation::fnmadd;
+                constexpr auto negate_addend = Op == float_operation::fmsub || Op == float_operation::fnmadd;
+
+                return host_evaluate<T>(
+                  *mode, [](auto x, auto y, auto z) { return std::fma(negate_product ? -x : x, y, negate_addend ? -z : z); }, a, b, c
+                );
+            }
+        })();
+
+        self.write_float(desc.float_dst(), result);
+        self.m_csr.raise_float_flags(flags);
+    }
+};
+
+template<typename Self, std::floating_point T, bool Max>
+struct functor_float_min_max {
+    constexpr void operator()(Self& self, instruction_descriptor desc) const {
+        const auto [result, flags] = float_min_max<Max>(self.template read_float<T>(desc.float_src_1()), self.template read_float<T>(desc.float_src_2()));
+        self.write_float(desc.float_dst(), result);
+        self.m_csr.raise_float_flags(flags);
+    }
+};
+
+enum class sign_injection {
+    copy,
+    negate,
+    bxor,
+};
+
+/// `fsgnj` and friends, these work on the bits and never raise anything.
+template<typename Self, std::floating_point T, sign_injection Kind>
+struct functor_float_sign_injection {
+    constexpr void operator()(Self& self, instruction_descriptor desc) const {
+        using bits_type = float_bits_t<T>;
+        constexpr auto sign = bits_type(1) << (sizeof(bits_type) * 8 - 1);
+
+        const auto a = std::bit_cast<bits_type>(self.template read_float<T>(desc.float_src_1()));
+        const auto b = std::bit_cast<bits_type>(self.template read_float<T>(desc.float_src_2()));
+
+        const auto sign_bit = ([&] -> bits_type {
+            switch (Kind) {
+                case sign_injection::copy: return b & sign;
+                case sign_injection::negate: return ~b & sign;
+                case sign_injection::bxor: return (a ^ b) & sign;
+            }
+        })();
+
+        self.m_register_bank.write_register(desc.float_dst(), nan_box_bits<T>((a & ~sign) | sign_bit));
+    }
+};
+
+enum class float_comparison {
+    equal,
+    less,
+    less_equal,
+};
+
+/// `feq` is a quiet comparison which only raises the invalid flag for signaling NaNs, `flt` and `fle` raise it for any NaN.
+template<typename Self, std::floating_point T, float_comparison Cmp>
+struct functor_float_compare {
+    constexpr void operator()(Self& self, instruction_descriptor desc) const {
+        const auto a = self.template read_float<T>(desc.float_src_1());
+        const auto b = self.template read_float<T>(desc.float_src_2());
+
+        const auto invalid = Cmp == float_comparison::equal ? is_signaling_nan(a) || is_signaling_nan(b) : a != a || b != b;
+        if (invalid) {
+            self.m_csr.raise_float_flags(float_flags::invalid);
+        }
+
+        const auto result = ([&] {
+            switch (Cmp) {
+                case float_comparison::equal: return a == b;
+                case float_comparison::less: return a < b;
+                case float_comparison::less_equal: return a <= b;
+            }
+        })();
+
+        self.write_register(desc.reg_dst(), static_cast<typename Self::register_type>(result));
+    }
+};
+
+template<typename Self, std::floating_point T>
+struct functor_float_classify {
+    constexpr void operator()(Self& self, instruction_descriptor desc) const {
+        self.write_register(desc.reg_dst(), static_cast<typename Self::register_type>(classify(self.template read_float<T>(desc.float_src_1()))));
+    }
+};
+
+/// `fcvt.w.s` and friends, 32 bit results get sign extended on RV64 even if they are unsigned.
+template<typename Self, std::floating_point T, std::integral I>
+struct functor_float_to_integer {
+    constexpr void operator()(Self& self, instruction_descriptor desc) const {
+        const auto mode = instruction_rounding_mode(self, desc);
+        if (!mode) {
+            return;
+        }
+
+        const auto [result, flags] = convert_to_integer<I>(self.template read_float<T>(desc.float_src_1()), *mode);
+        self.write_register(desc.reg_dst(), static_cast<std::make_unsigned_t<I>>(result));
+        self.m_csr.raise_float_flags(flags);
+    }
+};
+
+template<typename Self, std::integral I, std::floating_point T>
+struct functor_integer_to_float {
+    constexpr void operator()(Self& self, instruction_descriptor desc) const {
+        const auto mode = instruction_rounding_mode(self, desc);
+        if (!mode) {
+            return;
+        }
+
+        const auto value = static_cast<I>(static_cast<std::make_unsigned_t<I>>(self.m_register_bank.read_register(desc.reg_src_1())));
+        const auto [result, flags] = host_evaluate<T>(*mode, [](auto x) { return x; }, value);
+        self.write_float(desc.float_dst(), result);
+        self.m_csr.raise_float_flags(flags);
+    }
+};
+
+/// `fcvt.s.d` and `fcvt.d.s`
+template<typename Self, std::floating_point From, std::floating_point To>
+struct functor_float_convert {
+    constexpr void operator()(Self& self, instruction_descriptor desc) const {
+        const auto mode = instruction_rounding_mode(self, desc);
+        if (!mode) {
+            return;
+        }
+
+        const auto [result, flags] = host_evaluate<To>(*mode, [](auto x) { return x; }, self.template read_float<From>(desc.float_src_1()));
+        self.write_float(desc.float_dst(), result);
+        self.m_csr.raise_float_flags(flags);
+    }
+};
+
+/// `fmv.x.w` and `fmv.x.d` move the bits as they are, `fmv.x.w` sign extends them on RV64.
+template<typename Self, std::floating_point T>
+struct functor_float_move_to_integer {
+    constexpr void operator()(Self& self, instruction_descriptor desc) const {
+        self.write_register(desc.reg_dst(), static_cast<float_bits_t<T>>(self.m_register_bank.read_register(desc.float_src_1())));
+    }
+};
+
+template<typename Self, std::floating_point T>
+struct functor_float_move_from_integer {
+    constexpr void operator()(Self& self, instruction_descriptor desc) const {
+        const auto bits = static_cast<float_bits_t<T>>(self.m_register_bank.read_register(desc.reg_src_1()));
+        self.m_register_bank.write_register(desc.float_dst(), nan_box_bits<T>(bits));
+    }
+};
+
+// clang-format off
+template<typename RiscV>
+inline constexpr auto is_rv32f = instruction_set(
+    std::type_identity<RiscV> {},
+    RV_QUICK_INSN(RiscV, "flw", RV32F, immediate, (imm_matcher<0b00001'11, 0b010>), (functor_float_load<RiscV, float>), float_load_formatter),
+    RV_QUICK_INSN(RiscV, "fsw", RV32F, store, (imm_matcher<0b01001'11, 0b010>), (functor_float_store<RiscV, float>), float_store_formatter),
+
+    RV_QUICK_INSN(RiscV, "fmadd.s", RV32F, reg_reg, (fused_matcher<0b10000'11, float>), (functor_float_arith<RiscV, float, float_operation::fmadd>), (float_formatter<float_operands::fused, true>)),
+    RV_QUICK_INSN(RiscV, "fmsub.s", RV32F, reg_reg, (fused_matcher<0b10001'11, float>), (functor_float_arith<RiscV, float, float_operation::fmsub>), (float_formatter<float_operands::fused, true>)),
+    RV_QUICK_INSN(RiscV, "fnmsub.s", RV32F, reg_reg, (fused_matcher<0b10010'11, float>), (functor_float_arith<RiscV, float, float_operation::fnmsub>), (float_formatter<float_operands::fused, true>)),
+    RV_QUICK_INSN(RiscV, "fnmadd.s", RV32F, reg_reg, (fused_matcher<0b10011'11, float>), (functor_float_arith<RiscV, float, float_operation::fnmadd>), (float_formatter<float_operands::fused, true>)),
+
+    RV_QUICK_INSN(RiscV, "fadd.s", RV32F, reg_reg, (float_matcher<0b00000, float>), (functor_float_arith<RiscV, float, float_operation::add>), (float_formatter<float_operands::float_float_float, true>)),
+    RV_QUICK_INSN(RiscV, "fsub.s", RV32F, reg_reg, (float_matcher<0b00001, float>), (functor_float_arith<RiscV, float, float_operation::sub>), (float_formatter<float_operands::float_float_float, true>)),
+    RV_QUICK_INSN(RiscV, "fmul.s", RV32F, reg_reg, (float_matcher<0b00010, float>), (functor_float_arith<RiscV, float, float_operation::mul>), (float_formatter<float_operands::float_float_float, true>)),
+    RV_QUICK_INSN(RiscV, "fdiv.s", RV32F, reg_reg, (float_matcher<0b00011, float>), (functor_float_arith<RiscV, float, float_operation::div>), (float_formatter<float_operands::float_float_float, true>)),
+    RV_QUICK_INSN(RiscV, "fsqrt.s", RV32F, reg_reg, (float_rs_2_matcher<0b01011, float, 0>), (functor_float_arith<RiscV, float, float_operation::sqrt>), (float_formatter<float_operands::float_float, true>)),
+
+    RV_QUICK_INSN(RiscV, "fsgnj.s", RV32F, reg_reg, (float_funct_3_matcher<0b00100, float, 0b000>), (functor_float_sign_injection<RiscV, float, sign_injection::copy>), (float_formatter<float_operands::float_float_float, false>)),
+    RV_QUICK_INSN(RiscV, "fsgnjn.s", RV32F, reg_reg, (float_funct_3_matcher<0b00100, float, 0b001>), (functor_float_sign_injection<RiscV, float, sign_injection::negate>), (float_formatter<float_operands::float_float_float, false>)),
+    RV_QUICK_INSN(RiscV, "fsgnjx.s", RV32F, reg_reg, (float_funct_3_matcher<0b00100, float, 0b010>), (functor_float_sign_injection<RiscV, float, sign_injection::bxor>), (float_formatter<float_operands::float_float_float, false>)),
+    RV_QUICK_INSN(RiscV, "fmin.s", RV32F, reg_reg, (float_funct_3_matcher<0b00101, float, 0b000>), (functor_float_min_max<RiscV, float, false>), (float_formatter<float_operands::float_float_float, false>)),
+    RV_QUICK_INSN(RiscV, "fmax.s", RV32F, reg_reg, (float_funct_3_matcher<0b00101, float, 0b001>), (functor_float_min_max<RiscV, float, true>), (float_formatter<float_operands::float_float_float, false>)),
+
+    RV_QUICK_INSN(RiscV, "fcvt.w.s", RV32F, reg_reg, (float_rs_2_matcher<0b11000, float, 0>), (functor_float_to_integer<RiscV, float, i32>), (float_formatter<float_operands::integer_float, true>)),
+    RV_QUICK_INSN(RiscV, "fcvt.wu.s", RV32F, reg_reg, (float_rs_2_matcher<0b11000, float, 1>), (functor_float_to_integer<RiscV, float, u32>), (float_formatter<float_operands::integer_float, true>)),
+    RV_QUICK_INSN(RiscV, "fmv.x.w", RV32F, reg_reg, (float_rs_2_matcher<0b11100, float, 0>.combine_with(funct_3_matcher<0b000>)), (functor_float_move_to_integer<RiscV, float>), (float_formatter<float_operands::integer_float, false>)),
+    RV_QUICK_INSN(RiscV, "feq.s", RV32F, reg_reg, (float_funct_3_matcher<0b10100, float, 0b010>), (functor_float_compare<RiscV, float, float_comparison::equal>), (float_formatter<float_operands::integer_float_float, false>)),
+    RV_QUICK_INSN(RiscV, "flt.s", RV32F, reg_reg, (float_funct_3_matcher<0b10100, float, 0b001>), (functor_float_compare<RiscV, float, float_comparison::less>), (float_formatter<float_operands::integer_float_float, false>)),
+    RV_QUICK_INSN(RiscV, "fle.s", RV32F, reg_reg, (float_funct_3_matcher<0b10100, float, 0b000>), (functor_float_compare<RiscV, float, float_comparison::less_equal>), (float_formatter<float_operands::integer_float_float, false>)),
+    RV_QUICK_INSN(RiscV, "fclass.s", RV32F, reg_reg, (float_rs_2_matcher<0b11100, float, 0>.combine_with(funct_3_matcher<0b001>)), (functor_float_classify<RiscV, float>), (float_formatter<float_operands::integer_float, false>)),
+    RV_QUICK_INSN(RiscV, "fcvt.s.w", RV32F, reg_reg, (float_rs_2_matcher<0b11010, float, 0>), (functor_integer_to_float<RiscV, i32, float>), (float_formatter<float_operands::float_integer, true>)),
+    RV_QUICK_INSN(RiscV, "fcvt.s.wu", RV32F, reg_reg, (float_rs_2_matcher<0b11010, float, 1>), (functor_integer_to_float<RiscV, u32, float>), (float_formatter<float_operands::float_integer, true>)),
+    RV_QUICK_INSN(RiscV, "fmv.w.x", RV32F, reg_reg, (float_rs_2_matcher<0b11110, float, 0>.combine_with(funct_3_matcher<0b000>)), (functor_float_move_from_integer<RiscV, float>), (float_formatter<float_operands::float_integer, false>))
+);
+
+template<typename RiscV>
+inline constexpr auto is_rv64f = instruction_set(instruction_set(
+    std::type_identity<RiscV> {},
+    RV_QUICK_INSN(RiscV, "fcvt.l.s", RV64F, reg_reg, (float_rs_2_matcher<0b11000, float, 2>), (functor_float_to_integer<RiscV, float, i64>), (float_formatter<float_operands::integer_float, true>)),
+    RV_QUICK_INSN(RiscV, "fcvt.lu.s", RV64F, reg_reg, (float_rs_2_matcher<0b11000, float, 3>), (functor_float_to_integer<RiscV, float, u64>), (float_formatter<float_operands::integer_float, true>)),
+    RV_QUICK_INSN(RiscV, "fcvt.s.l", RV64F, reg_reg, (float_rs_2_matcher<0b11010, float, 2>), (functor_integer_to_float<RiscV, i64, float>), (float_formatter<float_operands::float_integer, true>)),
+    RV_QUICK_INSN(RiscV, "fcvt.s.lu", RV64F, reg_reg, (float_rs_2_matcher<0b11010, float, 3>), (functor_integer_to_float<RiscV, u64, float>), (float_formatter<float_operands::float_integer, true>))
+), is_rv32f<RiscV>);
+// clang-format on
+
+}  // namespace rv::detail
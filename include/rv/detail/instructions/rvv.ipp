@@ -0,0 +1,771 @@
+#pragma once
+
+namespace rv::detail {
+
+/// funct3 of OP-V, which says where the operands come from
+namespace vector_category {
+
+inline constexpr u32 opivv = 0b000;
+inline constexpr u32 opmvv = 0b010;
+inline constexpr u32 opivi = 0b011;
+inline constexpr u32 opivx = 0b100;
+inline constexpr u32 opmvx = 0b110;
+inline constexpr u32 opcfg = 0b111;
+
+}  // namespace vector_category
+
+template<u32 Funct6, u32 Category>
+inline constexpr auto vector_matcher = opcode_matcher<0b10101'11>.combine_with(funct_3_matcher<Category>).combine(0xFC00'0000u, Funct6 << 26);
+
+/// for the instructions that can't be masked
+template<u32 Funct6, u32 Category>
+inline constexpr auto unmasked_vector_matcher = vector_matcher<Funct6, Category>.combine(0x0200'0000u, 0x0200'0000u);
+
+/// for the instructions that have something other than a register in vs1
+template<u32 Funct6, u32 Category, u32 Vs1>
+inline constexpr auto vector_vs_1_matcher = vector_matcher<Funct6, Category>.combine(0x000F'8000u, Vs1 << 15);
+
+/// for the instructions that have something other than a register in vs2
+template<u32 Funct6, u32 Category, u32 Vs2>
+inline constexpr auto vector_vs_2_matcher = vector_matcher<Funct6, Category>.combine(0x01F0'0000u, Vs2 << 20);
+
+/// the width field of vector loads and stores, which is where funct3 is
+template<std::unsigned_integral T>
+inline constexpr u32 vector_width = sizeof(T) == 1 ? 0b000 : sizeof(T) == 2 ? 0b101 : sizeof(T) == 4 ? 0b110 : 0b111;
+
+enum class vector_addressing {
+    unit_stride,
+    strided,
+    /// `vlm.v` and `vsm.v`, which move the `ceil(vl / 8)` bytes of a mask
+    mask,
+};
+
+/// Loads (`Opcode` = LOAD-FP) and stores (`Opcode` = STORE-FP) without segments, mop is in bits 27:26 and lumop/sumop is where rs2 would be.
+template<u32 Opcode, std::unsigned_integral T, vector_addressing Addressing>
+inline constexpr auto vector_memory_matcher = ([] {
+    const auto base = opcode_matcher<Opcode>.combine_with(funct_3_matcher<vector_width<T>>);
+
+    switch (Addressing) {
+        case vector_addressing::unit_stride: return base.combine(0xFDF0'0000u, 0);
+        case vector_addressing::strided: return base.combine(0xFC00'0000u, 0b10u << 26);
+        case vector_addressing::mask: return base.combine(0xFFF0'0000u, (1u << 25) | (0b01011u << 20));
+    }
+})();
+
+enum class vector_operands {
+    /// vd, vs2, vs1
+    vector_vector,
+    /// vd, vs2, rs1
+    vector_scalar,
+    /// vd, vs2, simm5
+    vector_immediate,
+    /// vd, vs2, uimm5
+    vector_unsigned_immediate,
+    /// vd, vs1, vs2, the multiply-adds name the multiplicands the other way around
+    multiply_add_vector,
+    /// vd, rs1, vs2
+    multiply_add_scalar,
+    /// vd, vs1
+    move_vector,
+    /// vd, rs1
+    move_scalar,
+    /// vd, simm5
+    move_immediate,
+    /// rd, vs2
+    to_scalar,
+    /// vd
+    destination,
+};
+
+template<vector_operands Operands>
+constexpr void vector_formatter(format_buffer& out, instruction_descriptor instruction, bool abi_registers) {
+    const auto reg_name = abi_registers ? ::rv::register_name<true> : ::rv::register_name<false>;
+
+    const auto vd = instruction.vector_dst();
+    const auto vs1 = instruction.vector_src_1();
+    const auto vs2 = instruction.vector_src_2();
+    const auto simm5 = static_cast<i32>(arith::sext<u32, 5>(vs1));
+
+    auto it = fmt::format_to(std::back_inserter(out), "{}", instruction.mnemonic);
+
+    switch (Operands) {
+        case vector_operands::vector_vector: it = fmt::format_to(it, " v{}, v{}, v{}", vd, vs2, vs1); break;
+        case vector_operands::vector_scalar: it = fmt::format_to(it, " v{}, v{}, {}", vd, vs2, reg_name(instruction.reg_src_1())); break;
+        case vector_operands::vector_immediate: it = fmt::format_to(it, " v{}, v{}, {}", vd, vs2, simm5); break;
+        case vector_operands::vector_unsigned_immediate: it = fmt::format_to(it, " v{}, v{}, {}", vd, vs2, vs1); break;
+        case vector_operands::multiply_add_vector: it = fmt::format_to(it, " v{}, v{}, v{}", vd, vs1, vs2); break;
+        case vector_operands::multiply_add_scalar: it = fmt::format_to(it, " v{}, {}, v{}", vd, reg_name(instruction.reg_src_1()), vs2); break;
+        case vector_operands::move_vector: it = fmt::format_to(it, " v{}, v{}", vd, vs1); break;
+        case vector_operands::move_scalar: it = fmt::format_to(it, " v{}, {}", vd, reg_name(instruction.reg_src_1())); break;
+        case vector_operands::move_immediate: it = fmt::format_to(it, " v{}, {}", vd, simm5); break;
+        case vector_operands::to_scalar: it = fmt::format_to(it, " {}, v{}", reg_name(instruction.reg_dst()), vs2); break;
+        case vector_operands::destination: it = fmt::format_to(it, " v{}", vd); break;
+    }
+
+    if (instruction.vector_masked()) {
+        fmt::format_to(it, ", v0.t");
+    }
+}
+
+template<bool Store, vector_addressing Addressing>
+constexpr void vector_memory_formatter(format_buffer& out, instruction_descriptor instruction, bool abi_registers) {
+    const auto reg_name = abi_registers ? ::rv::register_name<true> : ::rv::register_name<false>;
+
+    // stores have vs3 where loads have vd
+    auto it = fmt::format_to(std::back_inserter(out), "{} v{}, ({})", instruction.mnemonic, instruction.vector_dst(), reg_name(instruction.reg_src_1()));
+
+    if (Addressing == vector_addressing::strided) {
+        it = fmt::format_to(it, ", {}", reg_name(instruction.reg_src_2()));
+    }
+
+    if (instruction.vector_masked()) {
+        fmt::format_to(it, ", v0.t");
+    }
+}
+
+enum class vset_kind {
+    /// AVL from rs1, vtype from an 11 bit immediate
+    vsetvli,
+    /// AVL from a 5 bit immediate, vtype from a 10 bit immediate
+    vsetivli,
+    /// AVL from rs1, vtype from rs2
+    vsetvl,
+};
+
+/// vtype like the assembler takes it (`e32, m1, ta, ma`), the bits in hex for vtypes that are reserved.
+constexpr void vector_type_format(format_buffer& out, u32 bits) {
+    const auto type = vector_type::from_bits(bits);
+    if (type.illegal) {
+        fmt::format_to(std::back_inserter(out), "{:#x}", bits);
+        return;
+    }
+
+    const auto lmul = type.lmul_shift >= 0 ? fmt::format("m{}", 1 << type.lmul_shift) : fmt::format("mf{}", 1 << -type.lmul_shift);
+    fmt::format_to(std::back_inserter(out), "e{}, {}, {}, {}", type.sew(), lmul, type.tail_agnostic ? "ta" : "tu", type.mask_agnostic ? "ma" : "mu");
+}
+
+template<vset_kind Kind>
+constexpr void vset_formatter(format_buffer& out, instruction_descriptor instruction, bool abi_registers) {
+    const auto reg_name = abi_registers ? ::rv::register_name<true> : ::rv::register_name<false>;
+
+    fmt::format_to(std::back_inserter(out), "{} {}, ", instruction.mnemonic, reg_name(instruction.reg_dst()));
+
+    switch (Kind) {
+        case vset_kind::vsetvli:
+            fmt::format_to(std::back_inserter(out), "{}, ", reg_name(instruction.reg_src_1()));
+            vector_type_format(out, (instruction.word >> 20) & 0x7FF);
+            break;
+        case vset_kind::vsetivli:
+            fmt::format_to(std::back_inserter(out), "{}, ", instruction.vector_src_1());
+            vector_type_format(out, (instruction.word >> 20) & 0x3FF);
+            break;
+        case vset_kind::vsetvl: fmt::format_to(std::back_inserter(out), "{}, {}", reg_name(instruction.reg_src_1()), reg_name(instruction.reg_src_2())); break;
+    }
+}
+
+template<typename Self>
+constexpr void illegal_vector_instruction(Self& self) {
+    self.raise_illegal_instruction();
+}
+
+template<typename Self, vset_kind Kind>
+struct functor_vset {
+    constexpr void operator()(Self& self, instruction_descriptor desc) const {
+        using register_type = typename Self::register_type;
+
+        const auto type = ([&] {
+            switch (Kind) {
+                case vset_kind::vsetvli: return vector_type::from_bits((desc.word >> 20) & 0x7FF);
+                case vset_kind::vsetivli: return vector_type::from_bits((desc.word >> 20) & 0x3FF);
+                case vset_kind::vsetvl: return vector_type::from_bits(static_cast<u64>(self.m_register_bank.read_register(desc.reg_src_2())));
+            }
+        })();
+
+        // rs1 = x0 asks for VLMAX, or for keeping vl if rd = x0 too
+        const auto avl = ([&] -> u64 {
+            if (Kind == vset_kind::vsetivli) {
+                return desc.vector_src_1();
+            }
+
+            if (desc.reg_src_1() != reg::zero) {
+                return static_cast<u64>(self.m_register_bank.read_register(desc.reg_src_1()));
+            }
+
+            return desc.reg_dst() != reg::zero ? std::numeric_limits<u64>::max() : self.m_vector.vl();
+        })();
+
+        self.write_register(desc.reg_dst(), static_cast<register_type>(self.m_vector.configure(avl, type)));
+    }
+};
+
+template<typename Self, std::unsigned_integral T, vector_addressing Addressing, bool Store>
+struct functor_vector_memory {
+    constexpr void operator()(Self& self, instruction_descriptor desc) const {
+        using register_type = typename Self::register_type;
+
+        auto& vector = self.m_vector;
+        const auto type = vector.type();
+
+        // the elements are EEW (`T`) wide instead of SEW, the groups are as much bigger or smaller as that makes them
+        const auto emul_shift = Addressing == vector_addressing::mask ? 0 : type.lmul_shift + std::countr_zero(sizeof(T)) - static_cast<i32>(type.sew_shift);
+        const auto masked = desc.vector_masked();
+
+        if (type.illegal || !vector.group_is_legal(desc.vector_dst(), emul_shift) || (masked && !Store && desc.vector_dst() == 0)) {
+            illegal_vector_instruction(self);
+            return;
+        }
+
+        const auto count = Addressing == vector_addressing::mask ? (vector.vl() + 7) / 8 : vector.vl();
+        const auto start = vector.vstart();
+        auto* const elements = vector.template group<T>(desc.vector_dst());
+
+        const auto base = self.m_register_bank.read_register(desc.reg_src_1());
+        const auto stride = Addressing == vector_addressing::strided ? self.m_register_bank.read_register(desc.reg_src_2()) : static_cast<register_type>(sizeof(T));
+
+        if (Addressing != vector_addressing::strided && !masked) {
+            const auto address = base + static_cast<register_type>(start * sizeof(T));
+
+            if (start < count) {
+                if constexpr (Store) {
+                    self.write_memory(address, std::span<const T>(elements + start, count - start));
+                } else {
+                    self.read_memory(address, std::span<T>(elements + start, count - start));
+                }
+            }
+
+            vector.set_vstart(0);
+            return;
+        }
+
+        for (auto i = start; i < count; i++) {
+            if (masked && !vector_mask_bit(vector.mask(), i)) {
+                continue;
+            }
+
+            const auto address = base + static_cast<register_type>(i) * stride;
+            if constexpr (Store) {
+                self.template write_memory<T>(address, elements[i]);
+            } else {
+                elements[i] = self.template read_memory<T>(address);
+            }
+        }
+
+        vector.set_vstart(0);
+    }
+};
+
+/// where the second operand of an element-wise instruction comes from
+enum class vector_source {
+    /// `.vv`, vs1
+    vector,
+    /// `.vx`, rs1
+    scalar,
+    /// `.vi`, a 5 bit immediate that is sign extended
+    immediate,
+    /// `.vi` for shifts, a 5 bit immediate that isn't
+    unsigned_immediate,
+};
+
+enum class vector_operation {
+    add,
+    sub,
+    /// rhs - vs2
+    rsub,
+    minu,
+    min,
+    maxu,
+    max,
+    band,
+    bor,
+    bxor,
+    sll,
+    srl,
+    sra,
+    mul,
+    mulh,
+    mulhu,
+    /// vd + vs2 * rhs
+    macc,
+    /// `vmv.v.*`, rhs
+    move,
+};
+
+/// the second operand of an element-wise instruction, a pointer to the elements of vs1 or a scalar that all elements get
+template<typename Self, std::unsigned_integral T, vector_source Source>
+constexpr auto vector_rhs(Self& self, instruction_descriptor desc) {
+    if constexpr (Source == vector_source::vector) {
+        return static_cast<T const*>(self.m_vector.template group<T>(desc.vector_src_1()));
+    } else if constexpr (Source == vector_source::scalar) {
+        return static_cast<T>(self.m_register_bank.read_register(desc.reg_src_1()));
+    } else if constexpr (Source == vector_source::immediate) {
+        return static_cast<T>(arith::sext<u64, 5>(desc.vector_src_1()));
+    } else {
+        return static_cast<T>(desc.vector_src_1());
+    }
+}
+
+template<typename Self, vector_operation Op, vector_source Source>
+struct functor_vector_arith {
+    constexpr void operator()(Self& self, instruction_descriptor desc) const {
+        auto& vector = self.m_vector;
+        const auto type = vector.type();
+        const auto masked = desc.vector_masked();
+
+        const auto legal = !type.illegal && vector.group_is_legal(desc.vector_dst(), type.lmul_shift) && vector.group_is_legal(desc.vector_src_2(), type.lmul_shift)
+                        && (Source != vector_source::vector || vector.group_is_legal(desc.vector_src_1(), type.lmul_shift)) && !(masked && desc.vector_dst() == 0);
+
+        if (!legal) {
+            illegal_vector_instruction(self);
+            return;
+        }
+
+        vector_dispatch(type, [&]<std::unsigned_integral T> {
+            vector_map(
+              vector.template group<T>(desc.vector_dst()), static_cast<T const*>(vector.template group<T>(desc.vector_src_2())), vector_rhs<Self, T, Source>(self, desc),
+              vector.vstart(), vector.vl(), masked ? vector.mask() : nullptr, [](T d, T a, T b) -> T { return apply(d, a, b); }
+            );
+        });
+
+        vector.set_vstart(0);
+    }
+
+private:
+    template<std::unsigned_integral T>
+    static constexpr auto apply(T d, T a, T b) -> T {
+        using signed_type = std::make_signed_t<T>;
+        // u8 and u16 would get promoted to int, whose products can overflow
+        using wide_type = std::common_type_t<T, unsigned>;
+        constexpr auto shift_mask = static_cast<T>(sizeof(T) * 8 - 1);
+
+        switch (Op) {
+            case vector_operation::add: return a + b;
+            case vector_operation::sub: return a - b;
+            case vector_operation::rsub: return b - a;
+            case vector_operation::minu: return std::min(a, b);
+            case vector_operation::min: return static_cast<T>(std::min(static_cast<signed_type>(a), static_cast<signed_type>(b)));
+            case vector_operation::maxu: return std::max(a, b);
+            case vector_operation::max: return static_cast<T>(std::max(static_cast<signed_type>(a), static_cast<signed_type>(b)));
+            case vector_operation::band: return a & b;
+            case vector_operation::bor: return a | b;
+            case vector_operation::bxor: return a ^ b;
+            case vector_operation::sll: return static_cast<T>(a << (b & shift_mask));
+            case vector_operation::srl: return static_cast<T>(a >> (b & shift_mask));
+            case vector_operation::sra: return static_cast<T>(static_cast<signed_type>(a) >> (b & shift_mask));
+            case vector_operation::mul: return static_cast<T>(static_cast<wide_type>(a) * b);
+            case vector_operation::mulh: return arith::multiply<T, true, true>(a, b).first;
+            case vector_operation::mulhu: return arith::multiply<T, false, false>(a, b).first;
+            case vector_operation::macc: return static_cast<T>(d + static_cast<wide_type>(a) * b);
+            case vector_operation::move: return b;
+        }
+    }
+};
+
+enum class vector_comparison {
+    eq,
+    ne,
+    ltu,
+    lt,
+    leu,
+    le,
+    gtu,
+    gt,
+};
+
+/// The comparisons write a mask into vd, which is a single register and can be `v0` even if they are masked.
+template<typename Self, vector_comparison Cmp, vector_source Source>
+struct functor_vector_compare {
+    constexpr void operator()(Self& self, instruction_descriptor desc) const {
+        auto& vector = self.m_vector;
+        const auto type = vector.type();
+
+        const auto legal = !type.illegal && vector.group_is_legal(desc.vector_src_2(), type.lmul_shift)
+                        && (Source != vector_source::vector || vector.group_is_legal(desc.vector_src_1(), type.lmul_shift));
+
+        if (!legal) {
+            illegal_vector_instruction(self);
+            return;
+        }
+
+        vector_dispatch(type, [&]<std::unsigned_integral T> {
+            vector_compare(
+              vector.template group<u8>(desc.vector_dst()), static_cast<T const*>(vector.template group<T>(desc.vector_src_2())), vector_rhs<Self, T, Source>(self, desc),
+              vector.vstart(), vector.vl(), desc.vector_masked() ? vector.mask() : nullptr, [](T a, T b) { return apply(a, b); }
+            );
+        });
+
+        vector.set_vstart(0);
+    }
+
+private:
+    template<std::unsigned_integral T>
+    static constexpr auto apply(T a, T b) -> bool {
+        using signed_type = std::make_signed_t<T>;
+
+        switch (Cmp) {
+            case vector_comparison::eq: return a == b;
+            case vector_comparison::ne: return a != b;
+            case vector_comparison::ltu: return a < b;
+            case vector_comparison::lt: return static_cast<signed_type>(a) < static_cast<signed_type>(b);
+            case vector_comparison::leu: return a <= b;
+            case vector_comparison::le: return static_cast<signed_type>(a) <= static_cast<signed_type>(b);
+            case vector_comparison::gtu: return a > b;
+            case vector_comparison::gt: return static_cast<signed_type>(a) > static_cast<signed_type>(b);
+        }
+    }
+};
+
+enum class vector_reduction {
+    sum,
+    band,
+    bor,
+    bxor,
+    minu,
+    min,
+    maxu,
+    max,
+};
+
+/// `vd[0] = vs1[0] op vs2[0] op vs2[1] ...` over the active elements, vd and vs1 are single registers.
+template<typename Self, vector_reduction Red>
+struct functor_vector_reduce {
+    constexpr void operator()(Self& self, instruction_descriptor desc) const {
+        auto& vector = self.m_vector;
+        const auto type = vector.type();
+
+        // reductions can't be resumed part way through
+        if (type.illegal || !vector.group_is_legal(desc.vector_src_2(), type.lmul_shift) || vector.vstart() != 0) {
+            illegal_vector_instruction(self);
+            return;
+        }
+
+        if (vector.vl() == 0) {
+            return;
+        }
+
+        vector_dispatch(type, [&]<std::unsigned_integral T> {
+            const auto init = vector.template group<T>(desc.vector_src_1())[0];
+            const auto result =
+              vector_reduce(init, static_cast<T const*>(vector.template group<T>(desc.vector_src_2())), vector.vl(), desc.vector_masked() ? vector.mask() : nullptr, [](T a, T b) {
+                  return apply(a, b);
+              });
+            vector.template group<T>(desc.vector_dst())[0] = result;
+        });
+    }
+
+private:
+    template<std::unsigned_integral T>
+    static constexpr auto apply(T a, T b) -> T {
+        using signed_type = std::make_signed_t<T>;
+
+        switch (Red) {
+            case vector_reduction::sum: return static_cast<T>(a + b);
+            case vector_reduction::band: return a & b;
+            case vector_reduction::bor: return a | b;
+            case vector_reduction::bxor: return a ^ b;
+            case vector_reduction::minu: return std::min(a, b);
+            case vector_reduction::min: return static_cast<T>(std::min(static_cast<signed_type>(a), static_cast<signed_type>(b)));
+            case vector_reduction::maxu: return std::max(a, b);
+            case vector_reduction::max: return static_cast<T>(std::max(static_cast<signed_type>(a), static_cast<signed_type>(b)));
+        }
+    }
+};
+
+enum class mask_operation {
+    andn,
+    band,
+    bor,
+    bxor,
+    orn,
+    nand,
+    nor,
+    xnor,
+};
+
+/// `vmand.mm` and friends, `vd = vs2 op vs1` on the first vl bits, which is done a byte at a time.
+template<typename Self, mask_operation Op>
+struct functor_mask_logical {
+    constexpr void operator()(Self& self, instruction_descriptor desc) const {
+        auto& vector = self.m_vector;
+
+        auto* const vd = vector.template group<u8>(desc.vector_dst());
+        auto const* const vs2 = vector.template group<u8>(desc.vector_src_2());
+        auto const* const vs1 = vector.template group<u8>(desc.vector_src_1());
+
+        const auto vl = vector.vl();
+        const auto full_bytes = vl / 8;
+
+        for (usize i = 0; i < full_bytes; i++) {
+            vd[i] = apply(vs2[i], vs1[i]);
+        }
+
+        if (const auto rest = vl % 8; rest != 0) {
+            const auto keep = static_cast<u8>(0xFFu << rest);
+            vd[full_bytes] = static_cast<u8>((vd[full_bytes] & keep) | (apply(vs2[full_bytes], vs1[full_bytes]) & ~keep));
+        }
+
+        vector.set_vstart(0);
+    }
+
+private:
+    static constexpr auto apply(u8 a, u8 b) -> u8 {
+        switch (Op) {
+            case mask_operation::andn: return a & ~b;
+            case mask_operation::band: return a & b;
+            case mask_operation::bor: return a | b;
+            case mask_operation::bxor: return a ^ b;
+            case mask_operation::orn: return a | ~b;
+            case mask_operation::nand: return ~(a & b);
+            case mask_operation::nor: return ~(a | b);
+            case mask_operation::xnor: return ~(a ^ b);
+        }
+    }
+};
+
+/// `vcpop.m` (the amount of set bits) and `vfirst.m` (the index of the first one, -1 if there is none) of the active bits of vs2
+template<typename Self, bool First>
+struct functor_mask_count {
+    constexpr void operator()(Self& self, instruction_descriptor desc) const {
+        using register_type = typename Self::register_type;
+
+        auto& vector = self.m_vector;
+        if (vector.vstart() != 0) {
+            illegal_vector_instruction(self);
+            return;
+        }
+
+        auto const* const vs2 = vector.template group<u8>(desc.vector_src_2());
+        auto const* const mask = desc.vector_masked() ? vector.mask() : nullptr;
+        const auto vl = vector.vl();
+
+        auto count = register_type(0);
+        auto first = ~register_type(0);
+
+        for (usize byte = 0; byte * 8 < vl; byte++) {
+            const auto valid = vl - byte * 8 >= 8 ? 0xFFu : (1u << (vl - byte * 8)) - 1;
+            const auto bits = vs2[byte] & valid & (mask == nullptr ? 0xFFu : mask[byte]);
+
+            if (First && bits != 0) {
+                first = static_cast<register_type>(byte * 8 + static_cast<usize>(std::countr_zero(bits)));
+                break;
+            }
+
+            count += static_cast<register_type>(std::popcount(bits));
+        }
+
+        self.write_register(desc.reg_dst(), First ? first : count);
+    }
+};
+
+/// `vmv.x.s`, element 0 of vs2 sign extended into rd
+template<typename Self>
+struct functor_vector_move_to_scalar {
+    constexpr void operator()(Self& self, instruction_descriptor desc) const {
+        using register_type = typename Self::register_type;
+
+        auto& vector = self.m_vector;
+        if (vector.type().illegal) {
+            illegal_vector_instruction(self);
+            return;
+        }
+
+        vector_dispatch(vector.type(), [&]<std::unsigned_integral T> {
+            const auto element = vector.template group<T>(desc.vector_src_2())[0];
+            self.write_register(desc.reg_dst(), arith::sext<register_type, sizeof(T) * 8>(static_cast<register_type>(element)));
+        });
+    }
+};
+
+/// `vmv.s.x`, rs1 into element 0 of vd unless vstart is past it
+template<typename Self>
+struct functor_vector_move_from_scalar {
+    constexpr void operator()(Self& self, instruction_descriptor desc) const {
+        auto& vector = self.m_vector;
+        if (vector.type().illegal) {
+            illegal_vector_instruction(self);
+            return;
+        }
+
+        if (vector.vstart() < vector.vl()) {
+            vector_dispatch(vector.type(), [&]<std::unsigned_integral T> {
+                vector.template group<T>(desc.vector_dst())[0] = static_cast<T>(self.m_register_bank.read_register(desc.reg_src_1()));
+            });
+        }
+
+        vector.set_vstart(0);
+    }
+};
+
+/// `vid.v`, the index of each active element
+template<typename Self>
+struct functor_vector_index {
+    constexpr void operator()(Self& self, instruction_descriptor desc) const {
+        auto& vector = self.m_vector;
+        const auto type = vector.type();
+        const auto masked = desc.vector_masked();
+
+        if (type.illegal || !vector.group_is_legal(desc.vector_dst(), type.lmul_shift) || (masked && desc.vector_dst() == 0)) {
+            illegal_vector_instruction(self);
+            return;
+        }
+
+        vector_dispatch(type, [&]<std::unsigned_integral T> {
+            auto* const vd = vector.template group<T>(desc.vector_dst());
+            for (auto i = vector.vstart(); i < vector.vl(); i++) {
+                vd[i] = masked && !vector_mask_bit(vector.mask(), i) ? vd[i] : static_cast<T>(i);
+            }
+        });
+
+        vector.set_vstart(0);
+    }
+};
+
+// clang-format off
+template<typename RiscV>
+inline constexpr auto is_rvv_config = instruction_set(
+    std::type_identity<RiscV> {},
+    RV_QUICK_INSN(RiscV, "vsetvli", V, immediate, (opcode_matcher<0b10101'11>.combine_with(funct_3_matcher<vector_category::opcfg>).combine(0x8000'0000u, 0)), (functor_vset<RiscV, vset_kind::vsetvli>), vset_formatter<vset_kind::vsetvli>),
+    RV_QUICK_INSN(RiscV, "vsetivli", V, immediate, (opcode_matcher<0b10101'11>.combine_with(funct_3_matcher<vector_category::opcfg>).combine(0xC000'0000u, 0xC000'0000u)), (functor_vset<RiscV, vset_kind::vsetivli>), vset_formatter<vset_kind::vsetivli>),
+    RV_QUICK_INSN(RiscV, "vsetvl", V, reg_reg, (opcode_matcher<0b10101'11>.combine_with(funct_3_matcher<vector_category::opcfg>).combine(0xFE00'0000u, 0x8000'0000u)), (functor_vset<RiscV, vset_kind::vsetvl>), vset_formatter<vset_kind::vsetvl>)
+);
+
+template<typename RiscV>
+inline constexpr auto is_rvv_memory = instruction_set(
+    std::type_identity<RiscV> {},
+    RV_QUICK_INSN(RiscV, "vlm.v", V, immediate, (vector_memory_matcher<0b00001'11, u8, vector_addressing::mask>), (functor_vector_memory<RiscV, u8, vector_addressing::mask, false>), (vector_memory_formatter<false, vector_addressing::mask>)),
+    RV_QUICK_INSN(RiscV, "vle8.v", V, immediate, (vector_memory_matcher<0b00001'11, u8, vector_addressing::unit_stride>), (functor_vector_memory<RiscV, u8, vector_addressing::unit_stride, false>), (vector_memory_formatter<false, vector_addressing::unit_stride>)),
+    RV_QUICK_INSN(RiscV, "vle16.v", V, immediate, (vector_memory_matcher<0b00001'11, u16, vector_addressing::unit_stride>), (functor_vector_memory<RiscV, u16, vector_addressing::unit_stride, false>), (vector_memory_formatter<false, vector_addressing::unit_stride>)),
+    RV_QUICK_INSN(RiscV, "vle32.v", V, immediate, (vector_memory_matcher<0b00001'11, u32, vector_addressing::unit_stride>), (functor_vector_memory<RiscV, u32, vector_addressing::unit_stride, false>), (vector_memory_formatter<false, vector_addressing::unit_stride>)),
+    RV_QUICK_INSN(RiscV, "vle64.v", V, immediate, (vector_memory_matcher<0b00001'11, u64, vector_addressing::unit_stride>), (functor_vector_memory<RiscV, u64, vector_addressing::unit_stride, false>), (vector_memory_formatter<false, vector_addressing::unit_stride>)),
+    RV_QUICK_INSN(RiscV, "vlse8.v", V, immediate, (vector_memory_matcher<0b00001'11, u8, vector_addressing::strided>), (functor_vector_memory<RiscV, u8, vector_addressing::strided, false>), (vector_memory_formatter<false, vector_addressing::strided>)),
+    RV_QUICK_INSN(RiscV, "vlse16.v", V, immediate, (vector_memory_matcher<0b00001'11, u16, vector_addressing::strided>), (functor_vector_memory<RiscV, u16, vector_addressing::strided, false>), (vector_memory_formatter<false, vector_addressing::strided>)),
+    RV_QUICK_INSN(RiscV, "vlse32.v", V, immediate, (vector_memory_matcher<0b00001'11, u32, vector_addressing::strided>), (functor_vector_memory<RiscV, u32, vector_addressing::strided, false>), (vector_memory_formatter<false, vector_addressing::strided>)),
+    RV_QUICK_INSN(RiscV, "vlse64.v", V, immediate, (vector_memory_matcher<0b00001'11, u64, vector_addressing::strided>), (functor_vector_memory<RiscV, u64, vector_addressing::strided, false>), (vector_memory_formatter<false, vector_addressing::strided>)),
+
+    RV_QUICK_INSN(RiscV, "vsm.v", V, store, (vector_memory_matcher<0b01001'11, u8, vector_addressing::mask>), (functor_vector_memory<RiscV, u8, vector_addressing::mask, true>), (vector_memory_formatter<true, vector_addressing::mask>)),
+    RV_QUICK_INSN(RiscV, "vse8.v", V, store, (vector_memory_matcher<0b01001'11, u8, vector_addressing::unit_stride>), (functor_vector_memory<RiscV, u8, vector_addressing::unit_stride, true>), (vector_memory_formatter<true, vector_addressing::unit_stride>)),
+    RV_QUICK_INSN(RiscV, "vse16.v", V, store, (vector_memory_matcher<0b01001'11, u16, vector_addressing::unit_stride>), (functor_vector_memory<RiscV, u16, vector_addressing::unit_stride, true>), (vector_memory_formatter<true, vector_addressing::unit_stride>)),
+    RV_QUICK_INSN(RiscV, "vse32.v", V, store, (vector_memory_matcher<0b01001'11, u32, vector_addressing::unit_stride>), (functor_vector_memory<RiscV, u32, vector_addressing::unit_stride, true>), (vector_memory_formatter<true, vector_addressing::unit_stride>)),
+    RV_QUICK_INSN(RiscV, "vse64.v", V, store, (vector_memory_matcher<0b01001'11, u64, vector_addressing::unit_stride>), (functor_vector_memory<RiscV, u64, vector_addressing::unit_stride, true>), (vector_memory_formatter<true, vector_addressing::unit_stride>)),
+    RV_QUICK_INSN(RiscV, "vsse8.v", V, store, (vector_memory_matcher<0b01001'11, u8, vector_addressing::strided>), (functor_vector_memory<RiscV, u8, vector_addressing::strided, true>), (vector_memory_formatter<true, vector_addressing::strided>)),
+    RV_QUICK_INSN(RiscV, "vsse16.v", V, store, (vector_memory_matcher<0b01001'11, u16, vector_addressing::strided>), (functor_vector_memory<RiscV, u16, vector_addressing::strided, true>), (vector_memory_formatter<true, vector_addressing::strided>)),
+    RV_QUICK_INSN(RiscV, "vsse32.v", V, store, (vector_memory_matcher<0b01001'11, u32, vector_addressing::strided>), (functor_vector_memory<RiscV, u32, vector_addressing::strided, true>), (vector_memory_formatter<true, vector_addressing::strided>)),
+    RV_QUICK_INSN(RiscV, "vsse64.v", V, store, (vector_memory_matcher<0b01001'11, u64, vector_addressing::strided>), (functor_vector_memory<RiscV, u64, vector_addressing::strided, true>), (vector_memory_formatter<true, vector_addressing::strided>))
+);
+
+#define RV_VECTOR_ARITH(_rv, _mnemonic, _funct6, _op)                                                                                                                                           \
+    RV_QUICK_INSN(_rv, _mnemonic ".vv", V, reg_reg, (vector_matcher<_funct6, vector_category::opivv>), (functor_vector_arith<_rv, vector_operation::_op, vector_source::vector>), vector_formatter<vector_operands::vector_vector>), \
+    RV_QUICK_INSN(_rv, _mnemonic ".vx", V, reg_reg, (vector_matcher<_funct6, vector_category::opivx>), (functor_vector_arith<_rv, vector_operation::_op, vector_source::scalar>), vector_formatter<vector_operands::vector_scalar>)
+
+#define RV_VECTOR_ARITH_I(_rv, _mnemonic, _funct6, _op, _source, _operands) \
+    RV_QUICK_INSN(_rv, _mnemonic ".vi", V, immediate, (vector_matcher<_funct6, vector_category::opivi>), (functor_vector_arith<_rv, vector_operation::_op, vector_source::_source>), vector_formatter<vector_operands::_operands>)
+
+#define RV_VECTOR_COMPARE(_rv, _mnemonic, _funct6, _cmp, _category, _source, _operands) \
+    RV_QUICK_INSN(_rv, _mnemonic, V, reg_reg, (vector_matcher<_funct6, vector_category::_category>), (functor_vector_compare<_rv, vector_comparison::_cmp, vector_source::_source>), vector_formatter<vector_operands::_operands>)
+
+template<typename RiscV>
+inline constexpr auto is_rvv_integer = instruction_set(
+    std::type_identity<RiscV> {},
+    // the moves are vmerge with vm set and vs2 = v0, they have to come before what the vs2 = v0 encodings would otherwise match
+    RV_QUICK_INSN(RiscV, "vmv.v.v", V, reg_reg, (unmasked_vector_matcher<0b010111, vector_category::opivv>.combine(0x01F0'0000u, 0)), (functor_vector_arith<RiscV, vector_operation::move, vector_source::vector>), vector_formatter<vector_operands::move_vector>),
+    RV_QUICK_INSN(RiscV, "vmv.v.x", V, reg_reg, (unmasked_vector_matcher<0b010111, vector_category::opivx>.combine(0x01F0'0000u, 0)), (functor_vector_arith<RiscV, vector_operation::move, vector_source::scalar>), vector_formatter<vector_operands::move_scalar>),
+    RV_QUICK_INSN(RiscV, "vmv.v.i", V, immediate, (unmasked_vector_matcher<0b010111, vector_category::opivi>.combine(0x01F0'0000u, 0)), (functor_vector_arith<RiscV, vector_operation::move, vector_source::immediate>), vector_formatter<vector_operands::move_immediate>),
+
+    RV_VECTOR_ARITH(RiscV, "vadd", 0b000000, add),
+    RV_VECTOR_ARITH_I(RiscV, "vadd", 0b000000, add, immediate, vector_immediate),
+    RV_VECTOR_ARITH(RiscV, "vsub", 0b000010, sub),
+    RV_QUICK_INSN(RiscV, "vrsub.vx", V, reg_reg, (vector_matcher<0b000011, vector_category::opivx>), (functor_vector_arith<RiscV, vector_operation::rsub, vector_source::scalar>), vector_formatter<vector_operands::vector_scalar>),
+    RV_VECTOR_ARITH_I(RiscV, "vrsub", 0b000011, rsub, immediate, vector_immediate),
+
+    RV_VECTOR_ARITH(RiscV, "vminu", 0b000100, minu),
+    RV_VECTOR_ARITH(RiscV, "vmin", 0b000101, min),
+    RV_VECTOR_ARITH(RiscV, "vmaxu", 0b000110, maxu),
+    RV_VECTOR_ARITH(RiscV, "vmax", 0b000111, max),
+
+    RV_VECTOR_ARITH(RiscV, "vand", 0b001001, band),
+    RV_VECTOR_ARITH_I(RiscV, "vand", 0b001001, band, immediate, vector_immediate),
+    RV_VECTOR_ARITH(RiscV, "vor", 0b001010, bor),
+    RV_VECTOR_ARITH_I(RiscV, "vor", 0b001010, bor, immediate, vector_immediate),
+    RV_VECTOR_ARITH(RiscV, "vxor", 0b001011, bxor),
+    RV_VECTOR_ARITH_I(RiscV, "vxor", 0b001011, bxor, immediate, vector_immediate),
+
+    RV_VECTOR_ARITH(RiscV, "vsll", 0b100101, sll),
+    RV_VECTOR_ARITH_I(RiscV, "vsll", 0b100101, sll, unsigned_immediate, vector_unsigned_immediate),
+    RV_VECTOR_ARITH(RiscV, "vsrl", 0b101000, srl),
+    RV_VECTOR_ARITH_I(RiscV, "vsrl", 0b101000, srl, unsigned_immediate, vector_unsigned_immediate),
+    RV_VECTOR_ARITH(RiscV, "vsra", 0b101001, sra),
+    RV_VECTOR_ARITH_I(RiscV, "vsra", 0b101001, sra, unsigned_immediate, vector_unsigned_immediate),
+
+    RV_VECTOR_COMPARE(RiscV, "vmseq.vv", 0b011000, eq, opivv, vector, vector_vector),
+    RV_VECTOR_COMPARE(RiscV, "vmseq.vx", 0b011000, eq, opivx, scalar, vector_scalar),
+    RV_VECTOR_COMPARE(RiscV, "vmseq.vi", 0b011000, eq, opivi, immediate, vector_immediate),
+    RV_VECTOR_COMPARE(RiscV, "vmsne.vv", 0b011001, ne, opivv, vector, vector_vector),
+    RV_VECTOR_COMPARE(RiscV, "vmsne.vx", 0b011001, ne, opivx, scalar, vector_scalar),
+    RV_VECTOR_COMPARE(RiscV, "vmsne.vi", 0b011001, ne, opivi, immediate, vector_immediate),
+    RV_VECTOR_COMPARE(RiscV, "vmsltu.vv", 0b011010, ltu, opivv, vector, vector_vector),
+    RV_VECTOR_COMPARE(RiscV, "vmsltu.vx", 0b011010, ltu, opivx, scalar, vector_scalar),
+    RV_VECTOR_COMPARE(RiscV, "vmslt.vv", 0b011011, lt, opivv, vector, vector_vector),
+    RV_VECTOR_COMPARE(RiscV, "vmslt.vx", 0b011011, lt, opivx, scalar, vector_scalar),
+    RV_VECTOR_COMPARE(RiscV, "vmsleu.vv", 0b011100, leu, opivv, vector, vector_vector),
+    RV_VECTOR_COMPARE(RiscV, "vmsleu.vx", 0b011100, leu, opivx, scalar, vector_scalar),
+    RV_VECTOR_COMPARE(RiscV, "vmsleu.vi", 0b011100, leu, opivi, immediate, vector_immediate),
+    RV_VECTOR_COMPARE(RiscV, "vmsle.vv", 0b011101, le, opivv, vector, vector_vector),
+    RV_VECTOR_COMPARE(RiscV, "vmsle.vx", 0b011101, le, opivx, scalar, vector_scalar),
+    RV_VECTOR_COMPARE(RiscV, "vmsle.vi", 0b011101, le, opivi, immediate, vector_immediate),
+    RV_VECTOR_COMPARE(RiscV, "vmsgtu.vx", 0b011110, gtu, opivx, scalar, vector_scalar),
+    RV_VECTOR_COMPARE(RiscV, "vmsgtu.vi", 0b011110, gtu, opivi, immediate, vector_immediate),
+    RV_VECTOR_COMPARE(RiscV, "vmsgt.vx", 0b011111, gt, opivx, scalar, vector_scalar),
+    RV_VECTOR_COMPARE(RiscV, "vmsgt.vi", 0b011111, gt, opivi, immediate, vector_immediate)
+);
+
+template<typename RiscV>
+inline constexpr auto is_rvv_multiply = instruction_set(
+    std::type_identity<RiscV> {},
+    RV_QUICK_INSN(RiscV, "vmul.vv", V, reg_reg, (vector_matcher<0b100101, vector_category::opmvv>), (functor_vector_arith<RiscV, vector_operation::mul, vector_source::vector>), vector_formatter<vector_operands::vector_vector>),
+    RV_QUICK_INSN(RiscV, "vmul.vx", V, reg_reg, (vector_matcher<0b100101, vector_category::opmvx>), (functor_vector_arith<RiscV, vector_operation::mul, vector_source::scalar>), vector_formatter<vector_operands::vector_scalar>),
+    RV_QUICK_INSN(RiscV, "vmulh.vv", V, reg_reg, (vector_matcher<0b100111, vector_category::opmvv>), (functor_vector_arith<RiscV, vector_operation::mulh, vector_source::vector>), vector_formatter<vector_operands::vector_vector>),
+    RV_QUICK_INSN(RiscV, "vmulh.vx", V, reg_reg, (vector_matcher<0b100111, vector_category::opmvx>), (functor_vector_arith<RiscV, vector_operation::mulh, vector_source::scalar>), vector_formatter<vector_operands::vector_scalar>),
+    RV_QUICK_INSN(RiscV, "vmulhu.vv", V, reg_reg, (vector_matcher<0b100100, vector_category::opmvv>), (functor_vector_arith<RiscV, vector_operation::mulhu, vector_source::vector>), vector_formatter<vector_operands::vector_vector>),
+    RV_QUICK_INSN(RiscV, "vmulhu.vx", V, reg_reg, (vector_matcher<0b100100, vector_category::opmvx>), (functor_vector_arith<RiscV, vector_operation::mulhu, vector_source::scalar>), vector_formatter<vector_operands::vector_scalar>),
+    RV_QUICK_INSN(RiscV, "vmacc.vv", V, reg_reg, (vector_matcher<0b101101, vector_category::opmvv>), (functor_vector_arith<RiscV, vector_operation::macc, vector_source::vector>), vector_formatter<vector_operands::multiply_add_vector>),
+    RV_QUICK_INSN(RiscV, "vmacc.vx", V, reg_reg, (vector_matcher<0b101101, vector_category::opmvx>), (functor_vector_arith<RiscV, vector_operation::macc, vector_source::scalar>), vector_formatter<vector_operands::multiply_add_scalar>)
+);
+
+template<typename RiscV>
+inline constexpr auto is_rvv_reduction_mask = instruction_set(
+    std::type_identity<RiscV> {},
+    RV_QUICK_INSN(RiscV, "vredsum.vs", V, reg_reg, (vector_matcher<0b000000, vector_category::opmvv>), (functor_vector_reduce<RiscV, vector_reduction::sum>), vector_formatter<vector_operands::vector_vector>),
+    RV_QUICK_INSN(RiscV, "vredand.vs", V, reg_reg, (vector_matcher<0b000001, vector_category::opmvv>), (functor_vector_reduce<RiscV, vector_reduction::band>), vector_formatter<vector_operands::vector_vector>),
+    RV_QUICK_INSN(RiscV, "vredor.vs", V, reg_reg, (vector_matcher<0b000010, vector_category::opmvv>), (functor_vector_reduce<RiscV, vector_reduction::bor>), vector_formatter<vector_operands::vector_vector>),
+    RV_QUICK_INSN(RiscV, "vredxor.vs", V, reg_reg, (vector_matcher<0b000011, vector_category::opmvv>), (functor_vector_reduce<RiscV, vector_reduction::bxor>), vector_formatter<vector_operands::vector_vector>),
+    RV_QUICK_INSN(RiscV, "vredminu.vs", V, reg_reg, (vector_matcher<0b000100, vector_category::opmvv>), (functor_vector_reduce<RiscV, vector_reduction::minu>), vector_formatter<vector_operands::vector_vector>),
+    RV_QUICK_INSN(RiscV, "vredmin.vs", V, reg_reg, (vector_matcher<0b000101, vector_category::opmvv>), (functor_vector_reduce<RiscV, vector_reduction::min>), vector_formatter<vector_operands::vector_vector>),
+    RV_QUICK_INSN(RiscV, "vredmaxu.vs", V, reg_reg, (vector_matcher<0b000110, vector_category::opmvv>), (functor_vector_reduce<RiscV, vector_reduction::maxu>), vector_formatter<vector_operands::vector_vector>),
+    RV_QUICK_INSN(RiscV, "vredmax.vs", V, reg_reg, (vector_matcher<0b000111, vector_category::opmvv>), (functor_vector_reduce<RiscV, vector_reduction::max>), vector_formatter<vector_operands::vector_vector>),
+
+    RV_QUICK_INSN(RiscV, "vmandn.mm", V, reg_reg, (unmasked_vector_matcher<0b011000, vector_category::opmvv>), (functor_mask_logical<RiscV, mask_operation::andn>), vector_formatter<vector_operands::vector_vector>),
+    RV_QUICK_INSN(RiscV, "vmand.mm", V, reg_reg, (unmasked_vector_matcher<0b011001, vector_category::opmvv>), (functor_mask_logical<RiscV, mask_operation::band>), vector_formatter<vector_operands::vector_vector>),
+    RV_QUICK_INSN(RiscV, "vmor.mm", V, reg_reg, (unmasked_vector_matcher<0b011010, vector_category::opmvv>), (functor_mask_logical<RiscV, mask_operation::bor>), vector_formatter<vector_operands::vector_vector>),
+    RV_QUICK_INSN(RiscV, "vmxor.mm", V, reg_reg, (unmasked_vector_matcher<0b011011, vector_category::opmvv>), (functor_mask_logical<RiscV, mask_operation::bxor>), vector_formatter<vector_operands::vector_vector>),
+    RV_QUICK_INSN(RiscV, "vmorn.mm", V, reg_reg, (unmasked_vector_matcher<0b011100, vector_category::opmvv>), (functor_mask_logical<RiscV, mask_operation::orn>), vector_formatter<vector_operands::vector_vector>),
+    RV_QUICK_INSN(RiscV, "vmnand.mm", V, reg_reg, (unmasked_vector_matcher<0b011101, vector_category::opmvv>), (functor_mask_logical<RiscV, mask_operation::nand>), vector_formatter<vector_operands::vector_vector>),
+    RV_QUICK_INSN(RiscV, "vmnor.mm", V, reg_reg, (unmasked_vector_matcher<0b011110, vector_category::opmvv>), (functor_mask_logical<RiscV, mask_operation::nor>), vector_formatter<vector_operands::vector_vector>),
+    RV_QUICK_INSN(RiscV, "vmxnor.mm", V, reg_reg, (unmasked_vector_matcher<0b011111, vector_category::opmvv>), (functor_mask_logical<RiscV, mask_operation::xnor>), vector_formatter<vector_operands::vector_vector>),
+
+    RV_QUICK_INSN(RiscV, "vmv.x.s", V, reg_reg, (vector_vs_1_matcher<0b010000, vector_category::opmvv, 0b00000>.combine(0x0200'0000u, 0x0200'0000u)), functor_vector_move_to_scalar<RiscV>, vector_formatter<vector_operands::to_scalar>),
+    RV_QUICK_INSN(RiscV, "vcpop.m", V, reg_reg, (vector_vs_1_matcher<0b010000, vector_category::opmvv, 0b10000>), (functor_mask_count<RiscV, false>), vector_formatter<vector_operands::to_scalar>),
+    RV_QUICK_INSN(RiscV, "vfirst.m", V, reg_reg, (vector_vs_1_matcher<0b010000, vector_category::opmvv, 0b10001>), (functor_mask_count<RiscV, true>), vector_formatter<vector_operands::to_scalar>),
+    RV_QUICK_INSN(RiscV, "vmv.s.x", V, reg_reg, (vector_vs_2_matcher<0b010000, vector_category::opmvx, 0b00000>.combine(0x0200'0000u, 0x0200'0000u)), functor_vector_move_from_scalar<RiscV>, vector_formatter<vector_operands::move_scalar>),
+    RV_QUICK_INSN(RiscV, "vid.v", V, reg_reg, (vector_vs_1_matcher<0b010100, vector_category::opmvv, 0b10001>.combine(0x01F0'0000u, 0)), functor_vector_index<RiscV>, vector_formatter<vector_operands::destination>)
+);
+// clang-format on
+
+#undef RV_VECTOR_ARITH
+#undef RV_VECTOR_ARITH_I
+#undef RV_VECTOR_COMPARE
+
+/// A subset of RVV 1.0: configuration, unit-stride and strided loads and stores, integer arithmetic, comparisons, reductions and masks.
+/// Every instruction goes through all of its active elements in one go, see `vector_map` and friends.
+template<typename RiscV>
+inline constexpr auto is_rvv = instruction_set(std::type_identity<RiscV>{}, is_rvv_config<RiscV>, is_rvv_memory<RiscV>, is_rvv_integer<RiscV>, is_rvv_multiply<RiscV>, is_rvv_reduction_mask<RiscV>);
+
+}  // namespace rv::detail
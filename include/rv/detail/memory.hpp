@@ -2,10 +2,20 @@
 
 #include <stuff/expected.hpp>
 
+#include <rv/detail/elf.hpp>
+#include <rv/detail/observer.hpp>
 #include <rv/detail/rand.hpp>
 
+#include <algorithm>
+#include <bit>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
+#include <functional>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
 
 namespace rv {
 
@@ -133,22 +143,78 @@ struct infmt_ihex_tag {};
 struct infmt_bin_tag {};
 struct infmt_elf_tag {};
 
+enum class watch_type : u8 {
+    read = 1,
+    write = 2,
+    access = read | write,
+};
+
+template<typename RegisterType>
+struct memory_watch {
+    RegisterType address;
+    usize size;
+    watch_type type;
+
+    constexpr auto operator==(memory_watch const&) const -> bool = default;
+
+    constexpr auto triggered_by(memory_access_type access) const -> bool {
+        const auto bit = access == memory_access_type::read ? watch_type::read : watch_type::write;
+        return (static_cast<u8>(type) & static_cast<u8>(bit)) != 0;
+    }
+};
+
+template<typename RegisterType>
+struct memory_watch_hit {
+    memory_watch<RegisterType> watch;
+    /// of the access, not of the watch
+    RegisterType address;
+    memory_access_type access;
+};
+
+/// Something on the bus other than RAM, like a UART. `offset` is from where the device is mapped and accesses are at most 8 bytes wide.
+struct mmio_device {
+    virtual constexpr ~mmio_device() = default;
+
+    virtual auto load(u64 offset, usize size) -> u64 = 0;
+    virtual void store(u64 offset, usize size, u64 value) = 0;
+
+    /// Whether executing the same accesses again gives the same values again, which going back in time relies on. Devices that get fed
+    /// from outside of the emulation stop being deterministic once they have been.
+    virtual auto deterministic() const -> bool { return true; }
+};
+
+template<typename RegisterType>
+struct mapped_device {
+    RegisterType address;
+    usize size;
+    /// not owned, has to outlive the memory it is mapped into
+    mmio_device* device;
+};
+
 template<typename RegisterType = u64, typename Allocator = std::allocator<u8>>
 struct memory {
     using register_type = RegisterType;
 
+    static constexpr usize page_shift = 12;
+    static constexpr usize page_size = 1uz << page_shift;
+
     constexpr memory(register_type ram_sz, Allocator const& allocator = Allocator())
         : m_allocator(allocator)
         , m_memory_size((usize)ram_sz)
-        , m_memory(m_allocator.allocate(ram_sz)) {
+        , m_memory(m_allocator.allocate(ram_sz))
+        , m_page_generations(((usize)ram_sz + page_size - 1) / page_size, 1)
+        , m_watched_pages(m_page_generations.size(), 0) {
         if consteval {
             for (usize i = 0; i < m_memory_size; i++) {
                 std::construct_at(m_memory + i, 0);
             }
         } else {
+            // a word of garbage at a time, a byte at a time is most of the startup time for memories of a few megabytes
             auto gen = detail::prepare_rng();
-            auto dist = std::uniform_int_distribution<u8>{};
-            std::generate(m_memory, m_memory + m_memory_size, [&dist, &gen] { return dist(gen); });
+            for (usize i = 0; i < m_memory_size; i += sizeof(u64)) {
+                const auto word = static_cast<u64>(gen());
+                std::memcpy(m_memory + i, &word, std::min(sizeof(u64), m_memory_size - i));
+            }
         }
     }
 
@@ -186,11 +252,36 @@ struct memory {
             }
         }
 
+        mark_written(0, size());
         return {};
     }
 
     auto load_from(std::basic_istream<char>& input_stream, infmt_bin_tag, usize offset = 0) -> stf::expected<void, std::string_view> {
         std::copy(std::istreambuf_iterator<char>(input_stream), std::istreambuf_iterator<char>(), m_memory);
+        mark_written(0, size());
+        return {};
+    }
+
+    auto load_from(std::basic_istream<char>& input_stream, infmt_elf_tag, usize offset = 0) -> stf::expected<void, std::string_view> {
+        const auto image = std::vector<u8>(std::istreambuf_iterator<char>(input_stream), std::istreambuf_iterator<char>());
+        return load_from(std::span<const u8>(image), infmt_elf_tag{}, offset);
+    }
+
+    /// Loads the segments of an ELF executable `offset` bytes above their addresses, the entry point is left for the caller to go to.
+    auto load_from(std::span<const u8> image, infmt_elf_tag, usize offset = 0) -> stf::expected<void, std::string_view> {
+        const auto executable = TRYX(elf::executable::from_image(image));
+
+        for (auto const& segment : executable.segments) {
+            const auto address = segment.address + offset;
+            if (address > size() || size() - address < segment.memory_size) {
+                return stf::unexpected{"segment doesn't fit into memory"};
+            }
+
+            std::ranges::copy(segment.contents, m_memory + address);
+            std::fill_n(m_memory + address + segment.contents.size(), segment.memory_size - segment.contents.size(), 0);
+            mark_written(address, segment.memory_size);
+        }
+
         return {};
     }
 
@@ -205,18 +296,184 @@ struct memory {
     constexpr void write(register_type address, T data) {
         const auto buf = std::bit_cast<std::array<u8, sizeof(T)>>(stf::bit::convert_endian(data, std::endian::native, std::endian::little));
         std::copy_n(buf.data(), std::min<T>(m_memory_size - address, buf.size()), m_memory + address);
+
+        if (m_track_writes) {
+            mark_written(address, sizeof(T));
+        }
+    }
+
+    /// `read` for the data accesses of instructions, which can hit watches unlike instruction fetches and accesses from the outside
+    template<std::unsigned_integral T>
+    constexpr auto load(register_type address) -> T {
+        if (!m_watches.empty()) [[unlikely]] {
+            check_watches(address, sizeof(T), memory_access_type::read);
+        }
+
+        if ((usize)address >= m_memory_size) [[unlikely]] {
+            return static_cast<T>(load_device(address, sizeof(T)));
+        }
+
+        return read<T>(address);
+    }
+
+    /// `write` for the data accesses of instructions
+    template<std::unsigned_integral T>
+    constexpr void store(register_type address, T data) {
+        if (!m_watches.empty()) [[unlikely]] {
+            check_watches(address, sizeof(T), memory_access_type::write);
+        }
+
+        if ((usize)address >= m_memory_size) [[unlikely]] {
+            store_device(address, sizeof(T), static_cast<u64>(data));
+            return;
+        }
+
+        write<T>(address, data);
+    }
+
+    /// `load` for `out.size()` consecutive elements, which get copied in one go when they are all in RAM. Watches see a single access.
+    template<std::unsigned_integral T>
+    constexpr void load(register_type address, std::span<T> out) {
+        if (!m_watches.empty()) [[unlikely]] {
+            check_watches(address, out.size_bytes(), memory_access_type::read);
+        }
+
+        if !consteval {
+            if (std::endian::native == std::endian::little && in_ram(address, out.size_bytes())) {
+                std::memcpy(out.data(), m_memory + (usize)address, out.size_bytes());
+                return;
+            }
+        }
+
+        for (usize i = 0; i < out.size(); i++) {
+            const auto element_address = address + (register_type)(i * sizeof(T));
+            out[i] = (usize)element_address >= m_memory_size ? static_cast<T>(load_device(element_address, sizeof(T))) : read<T>(element_address);
+        }
     }
 
+    /// `store` for consecutive elements, see `load`
+    template<std::unsigned_integral T>
+    constexpr void store(register_type address, std::span<const T> data) {
+        if (!m_watches.empty()) [[unlikely]] {
+            check_watches(address, data.size_bytes(), memory_access_type::write);
+        }
+
+        if !consteval {
+            if (std::endian::native == std::endian::little && in_ram(address, data.size_bytes())) {
+                std::memcpy(m_memory + (usize)address, data.data(), data.size_bytes());
+                if (m_track_writes) {
+                    mark_written(address, data.size_bytes());
+                }
+                return;
+            }
+        }
+
+        for (usize i = 0; i < data.size(); i++) {
+            const auto element_address = address + (register_type)(i * sizeof(T));
+            if ((usize)element_address >= m_memory_size) {
+                store_device(element_address, sizeof(T), static_cast<u64>(data[i]));
+            } else {
+                write<T>(element_address, data[i]);
+            }
+        }
+    }
+
+    /*
+     * Dirty page tracking
+     * Writes stamp their pages with the current generation. Whoever wants to know about the pages written after some point calls
+     * `advance_generation` at that point, the pages written afterwards are the ones with a generation greater than what it returned.
+     * Until the first call nobody has a point to compare against, so `write` doesn't stamp anything before it.
+     */
+
+    constexpr auto num_pages() const -> usize { return m_page_generations.size(); }
+    constexpr auto page_generation(usize page) const -> u64 { return m_page_generations[page]; }
+    constexpr auto advance_generation() -> u64 {
+        m_track_writes = true;
+        return m_generation++;
+    }
+    /// the generation that writes stamp pages with right now
+    constexpr auto generation() const -> u64 { return m_generation; }
+
+    /// for writes that don't go through `write`, e.g. through `data()`
+    constexpr void mark_written(register_type address, usize size) {
+        if (size == 0 || (usize)address >= m_memory_size) {
+            return;
+        }
+
+        const auto first_page = (usize)address >> page_shift;
+        const auto last_page = std::min((usize)address + size - 1, (usize)m_memory_size - 1) >> page_shift;
+
+        for (auto page = first_page; page <= last_page; page++) {
+            m_page_generations[page] = m_generation;
+        }
+    }
+
+    /*
+     * Watches
+     * The pages that watches overlap are marked as watched. Without any watches `load` and `store` only check that there are none, with
+     * some they look up the pages of the access and only accesses to watched pages get compared against the watches. Accesses that overlap
+     * a watch of their kind are recorded as hits until they get consumed, up to `max_watch_hits` of them so that hits nobody consumes
+     * can't pile up without bound. The ones past that are dropped.
+     */
+
+    static constexpr usize max_watch_hits = 64;
+
+    constexpr void add_watch(memory_watch<register_type> watch) {
+        for_each_page(watch.address, watch.size, [this](usize page) { ++m_watched_pages[page]; });
+        m_watches.emplace_back(watch);
+    }
+
+    /// Removes one watch equal to `watch`, returns false if there is none.
+    constexpr auto remove_watch(memory_watch<register_type> watch) -> bool {
+        const auto it = std::ranges::find(m_watches, watch);
+        if (it == m_watches.end()) {
+            return false;
+        }
+
+        for_each_page(watch.address, watch.size, [this](usize page) { --m_watched_pages[page]; });
+        m_watches.erase(it);
+        return true;
+    }
+
+    constexpr auto watches() const -> std::span<const memory_watch<register_type>> { return m_watches; }
+
+    /// The first `max_watch_hits` hits since the last call, in the order of the accesses.
+    constexpr auto consume_watch_hits() -> std::vector<memory_watch_hit<register_type>> { return std::exchange(m_watch_hits, {}); }
+
+    /*
+     * Devices
+     * Devices are mapped past the end of RAM, `load` and `store` only look for them when an access misses RAM, so accesses to RAM don't pay
+     * for them. Accesses that miss both RAM and the devices read zeroes and don't write anything.
+     */
+
+    constexpr auto map_device(mapped_device<register_type> device) -> stf::expected<void, std::string_view> {
+        if (device.size == 0 || (usize)device.address < m_memory_size) {
+            return stf::unexpected{"devices have to be mapped past the end of RAM"};
+        }
+
+        const auto overlaps = [&device](auto const& other) { return device.address < other.address + other.size && other.address < device.address + device.size; };
+        if (std::ranges::any_of(m_devices, overlaps)) {
+            return stf::unexpected{"device overlaps another device"};
+        }
+
+        m_devices.emplace_back(device);
+        return {};
+    }
+
+    constexpr auto devices() const -> std::span<const mapped_device<register_type>> { return m_devices; }
+
     constexpr auto data() -> u8* { return m_memory; }
     constexpr auto data() const -> const u8* { return m_memory; }
 
     constexpr auto size() const -> usize { return (usize)m_memory_size; }
 
+    constexpr auto reservation() const -> std::optional<register_type> { return m_reservation; }
+    constexpr void set_reservation(std::optional<register_type> reservation) { m_reservation = reservation; }
 
     template<std::unsigned_integral T>
     constexpr auto load_reserved(register_type address) -> T {
         m_reservation = address;
-        return read<T>(address);
+        return load<T>(address);
     }
 
     template<std::unsigned_integral T>
@@ -230,7 +487,7 @@ struct memory {
         }
 
         m_reservation = std::nullopt;
-        write<T>(address, v);
+        store<T>(address, v);
 
         return true;
     }
@@ -241,6 +498,68 @@ private:
     std::optional<register_type> m_reservation = std::nullopt;
     register_type m_memory_size = 0;
     u8* m_memory = nullptr;
+
+    std::vector<u64> m_page_generations;
+    u64 m_generation = 1;
+    /// set by the first `advance_generation`
+    bool m_track_writes = false;
+
+    /// the amount of watches overlapping each page
+    std::vector<u16> m_watched_pages;
+    std::vector<memory_watch<register_type>> m_watches{};
+    std::vector<memory_watch_hit<register_type>> m_watch_hits{};
+
+    std::vector<mapped_device<register_type>> m_devices{};
+
+    constexpr auto find_device(register_type address, usize size) const -> mapped_device<register_type> const* {
+        const auto it = std::ranges::find_if(m_devices, [&](auto const& device) { return address >= device.address && address - device.address + size <= device.size; });
+        return it == m_devices.end() ? nullptr : &*it;
+    }
+
+    constexpr auto load_device(register_type address, usize size) const -> u64 {
+        if (auto const* device = find_device(address, size); device != nullptr) {
+            return device->device->load((u64)(address - device->address), size);
+        }
+
+        return 0;
+    }
+
+    constexpr void store_device(register_type address, usize size, u64 value) const {
+        if (auto const* device = find_device(address, size); device != nullptr) {
+            device->device->store((u64)(address - device->address), size, value);
+        }
+    }
+
+    constexpr auto in_ram(register_type address, usize size) const -> bool { return (usize)address <= (usize)m_memory_size && (usize)m_memory_size - (usize)address >= size; }
+
+    /// calls `fn` with the pages that overlap the part of the range that is in memory
+    template<typename Fn>
+    constexpr void for_each_page(register_type address, usize size, Fn&& fn) const {
+        if (size == 0 || (usize)address >= m_memory_size) {
+            return;
+        }
+
+        const auto last_page = std::min((usize)address + size - 1, (usize)m_memory_size - 1) >> page_shift;
+        for (auto page = (usize)address >> page_shift; page <= last_page; page++) {
+            std::invoke(fn, page);
+        }
+    }
+
+    constexpr void check_watches(register_type address, usize size, memory_access_type access) {
+        auto watched = false;
+        for_each_page(address, size, [&](usize page) { watched |= m_watched_pages[page] != 0; });
+
+        if (!watched) {
+            return;
+        }
+
+        for (auto const& watch : m_watches) {
+            const auto overlaps = address < watch.address + watch.size && watch.address < address + size;
+            if (overlaps && watch.triggered_by(access) && m_watch_hits.size() < max_watch_hits) {
+                m_watch_hits.emplace_back(watch, address, access);
+            }
+        }
+    }
 };
 
 }  // namespace rv
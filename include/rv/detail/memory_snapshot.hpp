@@ -0,0 +1,135 @@
+#pragma once
+
+#include <stuff/bit.hpp>
+#include <stuff/core.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <concepts>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace rv {
+
+/// A copy of a memory for a thread other than the one running the processor to look at.
+///
+/// There are two buffers. The reader owns the front one. The writer brings the back one up to date and publishes it, after which it belongs
+/// to the reader until the reader takes it and gives the front one back in exchange. Only the pages that were written since a buffer was
+/// last published get copied into it, which are found through the page generations of the memory.
+///
+/// Towards the reader the front buffer pages like the memory does. Its pages are stamped with a generation of their own whenever a buffer
+/// that they were copied into is taken, so an `instruction_listing` can be laid out over it.
+template<typename Memory>
+struct memory_snapshot {
+    static constexpr usize page_size = Memory::page_size;
+
+    explicit memory_snapshot(usize size)
+        : m_buffers{buffer(size), buffer(size)}
+        , m_page_generations((size + page_size - 1) / page_size, 0) {}
+
+    memory_snapshot(memory_snapshot const&) = delete;
+    memory_snapshot(memory_snapshot&&) = delete;
+
+    /*
+     * writer side
+     */
+
+    /// whether the reader took the last publication, the back buffer can't be touched otherwise
+    auto can_publish() const -> bool { return !m_published.load(std::memory_order_acquire); }
+
+    /// blocks until `can_publish`
+    void wait_for_reader() const { m_published.wait(true, std::memory_order_acquire); }
+
+    /// Copies the pages written since the back buffer was last published into it and publishes it. Only to be called if `can_publish`.
+    void publish(Memory& memory) {
+        auto& back = m_buffers[1 - m_front];
+
+        // pages written from here on get stamped with something greater than this
+        const auto since = std::exchange(back.generation, memory.advance_generation());
+        back.written_pages.clear();
+
+        const auto num_pages = std::min(memory.num_pages(), m_page_generations.size());
+        for (usize page = 0; page < num_pages; page++) {
+            if (memory.page_generation(page) <= since) {
+                continue;
+            }
+
+            const auto offset = page * page_size;
+            std::memcpy(back.data.data() + offset, memory.data() + offset, std::min(page_size, back.data.size() - offset));
+            back.written_pages.push_back(page);
+        }
+
+        m_pages_copied += back.written_pages.size();
+        m_published.store(true, std::memory_order_release);
+    }
+
+    /// how many pages were copied into the buffers in total
+    constexpr auto pages_copied() const -> u64 { return m_pages_copied; }
+
+    /*
+     * reader side
+     */
+
+    /// Takes the last publication if there is one that wasn't taken yet, returns whether there was.
+    auto take() -> bool {
+        if (!m_published.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        m_front = 1 - m_front;
+
+        // the other buffer was brought up to date on these pages since the one that was in front got the rest of them
+        for (const auto page : m_buffers[m_front].written_pages) {
+            m_page_generations[page] = m_generation;
+        }
+        ++m_generation;
+
+        m_published.store(false, std::memory_order_release);
+        m_published.notify_one();
+
+        return true;
+    }
+
+    constexpr auto data() const -> const u8* { return m_buffers[m_front].data.data(); }
+    constexpr auto size() const -> usize { return m_buffers[m_front].data.size(); }
+
+    constexpr auto num_pages() const -> usize { return m_page_generations.size(); }
+    constexpr auto page_generation(usize page) const -> u64 { return m_page_generations[page]; }
+    /// the generation that pages get stamped with by the next `take`
+    constexpr auto generation() const -> u64 { return m_generation; }
+
+    template<std::unsigned_integral T>
+    constexpr auto read(usize address) const -> T {
+        std::array<u8, sizeof(T)> buf{0};
+        if (address < size()) {
+            std::copy_n(data() + address, std::min(size() - address, sizeof(T)), buf.data());
+        }
+        return stf::bit::convert_endian(std::bit_cast<T>(buf), std::endian::little, std::endian::native);
+    }
+
+private:
+    struct buffer {
+        explicit buffer(usize size)
+            : data(size, 0) {}
+
+        std::vector<u8> data;
+        /// `memory::advance_generation` as of the last publication, pages with a greater generation were written since
+        u64 generation = 0;
+        /// the pages copied by the last publication
+        std::vector<usize> written_pages{};
+    };
+
+    std::array<buffer, 2> m_buffers;
+    /// only changed by the reader and only while it owns both buffers
+    usize m_front = 0;
+    std::atomic<bool> m_published{false};
+    u64 m_pages_copied = 0;
+
+    std::vector<u64> m_page_generations;
+    u64 m_generation = 1;
+};
+
+}  // namespace rv
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <rv/detail/definitions.hpp>
+
+#include <stuff/core.hpp>
+
+#include <optional>
+#include <tuple>
+
+namespace rv {
+
+enum class memory_access_type {
+    read,
+    write,
+};
+
+/// Observers get notified of execution events by the interpreter. The observer is a template parameter of `risc_v` so that a processor
+/// without any instrumentation (the default) compiles down to the bare interpreter.
+/// Observers only interested in some of the events can inherit from this to get no-op defaults for the rest.
+struct null_observer {
+    /// Called once per executed instruction with the slot of the matching entry in the instruction set.
+    /// Compressed instructions are reported with their own slot, the instruction they get translated into is not reported.
+    template<typename RiscV>
+    constexpr void on_execute(RiscV const&, usize) {}
+
+    /// Called after every `jal` and `jalr` (and their compressed forms) with the address of the jump, its target and the link and base
+    /// registers. `jal` reports `reg::zero` as its base.
+    template<typename RiscV>
+    constexpr void on_jump(RiscV const&, u64, u64, reg, reg) {}
+
+    /// Called after every conditional branch with its address, its target and whether it was taken.
+    template<typename RiscV>
+    constexpr void on_branch(RiscV const&, u64, u64, bool) {}
+
+    /// Called after an instruction writes to an integer register, with the value that got written.
+    template<typename RiscV>
+    constexpr void on_register_write(RiscV const&, reg, u64) {}
+
+    /// Called before an instruction accesses memory, with the address and the size of the access in bytes.
+    template<typename RiscV>
+    constexpr void on_memory_access(RiscV const&, u64, usize, memory_access_type) {}
+
+    /// Asked for the amount of `event`s so far when a performance counter that counts them gets read, observers that don't keep track of
+    /// the event return nothing. Observers that do are the event sources of the counters, they are only ever asked and never notified.
+    template<typename RiscV>
+    constexpr auto event_count(RiscV const&, hpm_event) const -> std::optional<u64> {
+        return std::nullopt;
+    }
+};
+
+/// Forwards every event to each of the `Observers`, in order.
+template<typename... Observers>
+struct observer_list {
+    constexpr observer_list() = default;
+
+    explicit constexpr observer_list(Observers... observers)
+        : m_observers(std::move(observers)...) {}
+
+    template<typename RiscV>
+    constexpr void on_execute(RiscV const& self, usize slot) {
+        std::apply([&](auto&... observers) { (observers.on_execute(self, slot), ...); }, m_observers);
+    }
+
+    template<typename RiscV>
+    constexpr void on_jump(RiscV const& self, u64 from, u64 to, reg link, reg base) {
+        std::apply([&](auto&... observers) { (observers.on_jump(self, from, to, link, base), ...); }, m_observers);
+    }
+
+    template<typename RiscV>
+    constexpr void on_branch(RiscV const& self, u64 from, u64 target, bool taken) {
+        std::apply([&](auto&... observers) { (observers.on_branch(self, from, target, taken), ...); }, m_observers);
+    }
+
+    template<typename RiscV>
+    constexpr void on_register_write(RiscV const& self, reg reg, u64 value) {
+        std::apply([&](auto&... observers) { (observers.on_register_write(self, reg, value), ...); }, m_observers);
+    }
+
+    template<typename RiscV>
+    constexpr void on_memory_access(RiscV const& self, u64 address, usize size, memory_access_type type) {
+        std::apply([&](auto&... observers) { (observers.on_memory_access(self, address, size, type), ...); }, m_observers);
+    }
+
+    /// The count of the first observer that keeps track of `event`.
+    template<typename RiscV>
+    constexpr auto event_count(RiscV const& self, hpm_event event) const -> std::optional<u64> {
+        auto ret = std::optional<u64>{};
+        std::apply([&](auto const&... observers) { ((ret = ret ? ret : observers.event_count(self, event)), ...); }, m_observers);
+        return ret;
+    }
+
+    template<typename T>
+    constexpr auto get() -> T& {
+        return std::get<T>(m_observers);
+    }
+
+    template<typename T>
+    constexpr auto get() const -> T const& {
+        return std::get<T>(m_observers);
+    }
+
+private:
+    std::tuple<Observers...> m_observers;
+};
+
+}  // namespace rv
@@ -0,0 +1,324 @@
+#pragma once
+
+#include <rv/detail/elf.hpp>
+#include <rv/detail/observer.hpp>
+#include <rv/detail/ring_buffer.hpp>
+
+#include <fmt/format.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+namespace rv {
+
+enum class sampling_mode {
+    /// a sample every `profiler_config::interval_instructions` executed instructions, deterministic across runs
+    instruction_count,
+    /// a sample every `profiler_config::interval_cycles` cycles as counted by the processor, for attributing the cycles of a timing model
+    /// to functions
+    cycle_count,
+    /// a sample every `profiler_config::interval_time` of wall-clock time, as a native profiler would take them
+    host_timer,
+};
+
+struct profiler_config {
+    sampling_mode mode = sampling_mode::instruction_count;
+    u64 interval_instructions = 10'000;
+    u64 interval_cycles = 10'000;
+    std::chrono::microseconds interval_time{100};
+    usize ring_capacity = 4096;
+};
+
+struct profile_sample {
+    static constexpr usize max_depth = 32;
+
+    u64 program_counter;
+    /// entry addresses of the functions on the call stack, outermost first
+    std::array<u64, max_depth> frames;
+    u32 depth;
+    /// set if the outermost frames of a deeper stack were dropped
+    bool truncated;
+};
+
+/// A sampling profiler for guest code.
+/// The executing thread samples the program counter along with a shadow call stack that is maintained from `jal`/`jalr` through the link
+/// register hints of the ISA manual: a jump that writes `ra` or `t0` is a call, one that jumps through `ra` or `t0` without writing it is a
+/// return. Samples travel to the consumer through a lock-free ring and are dropped (and counted) if the consumer falls behind.
+/// The consumer aggregates them and symbolizes them against an ELF symbol table into the collapsed-stack format that flamegraph tools read.
+struct profiler {
+    explicit profiler(profiler_config config = {})
+        : m_config(config)
+        , m_shared(std::make_unique<shared_state>(config.ring_capacity)) {
+        m_countdown = countdown_interval();
+
+        if (m_config.mode == sampling_mode::host_timer) {
+            m_timer_thread = std::jthread([shared = m_shared.get(), interval = m_config.interval_time](std::stop_token token) {
+                while (!token.stop_requested()) {
+                    std::this_thread::sleep_for(interval);
+                    shared->m_sample_requested.store(true, std::memory_order_relaxed);
+                }
+            });
+        }
+    }
+
+    /*
+     * Producer side, to be called by the executing thread only
+     */
+
+    /// `weight` is the amount of instructions or cycles that the instruction counts as, an instruction can be sampled more than once if
+    /// it spans several intervals
+    void on_instruction(u64 program_counter, u64 weight = 1) {
+        if (weight < m_countdown) [[likely]] {
+            m_countdown -= weight;
+            return;
+        }
+
+        weight -= m_countdown;
+
+        const auto interval = countdown_interval();
+        const auto samples = 1 + weight / interval;
+        m_countdown = interval - weight % interval;
+
+        if (!m_shared->m_enabled.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        if (m_config.mode == sampling_mode::host_timer && !m_shared->m_sample_requested.exchange(false, std::memory_order_relaxed)) {
+            return;
+        }
+
+        for (u64 i = 0; i < samples; i++) {
+            take_sample(program_counter);
+        }
+    }
+
+    constexpr auto config() const -> profiler_config const& { return m_config; }
+
+    void on_jump(u64 to, reg link, reg base) {
+        const auto is_link = [](reg r) { return r == reg::x1 || r == reg::x5; };
+
+        if (is_link(base) && (!is_link(link) || link != base)) {
+            pop_frame();
+        }
+
+        if (is_link(link)) {
+            push_frame(to);
+        }
+    }
+
+    /*
+     * Consumer side, to be called by a single thread other than the executing one
+     */
+
+    void set_enabled(bool enabled) { m_shared->m_enabled.store(enabled, std::memory_order_relaxed); }
+    auto enabled() const -> bool { return m_shared->m_enabled.load(std::memory_order_relaxed); }
+
+    /// Moves pending samples out of the ring into the aggregate, returns how many were moved.
+    auto drain() -> usize {
+        usize ret = 0;
+
+        while (auto sample = m_shared->m_ring.try_pop()) {
+            auto key = std::vector<u64>(sample->frames.begin(), sample->frames.begin() + sample->depth);
+            key.push_back(sample->truncated ? 1 : 0);
+            key.push_back(sample->program_counter);
+
+            ++m_stacks[std::move(key)];
+            ++m_total_samples;
+            ++ret;
+        }
+
+        return ret;
+    }
+
+    void clear() {
+        drain();
+        m_stacks.clear();
+        m_total_samples = 0;
+    }
+
+    auto total_samples() const -> u64 { return m_total_samples; }
+    auto dropped_samples() const -> u64 { return m_shared->m_dropped.load(std::memory_order_relaxed); }
+
+    /// Writes one `frame;frame;...;leaf count` line per unique stack. Addresses without a symbol are written in hex.
+    void write_collapsed(std::ostream& os, elf::symbol_table const* symbols = nullptr) const {
+        auto collapsed = std::map<std::string, u64>{};
+
+        for (auto const& [key, count] : m_stacks) {
+            collapsed[collapse(key, symbols)] += count;
+        }
+
+        for (auto const& [stack, count] : collapsed) {
+            os << fmt::format("{} {}\n", stack, count);
+        }
+    }
+
+    /// Samples per leaf function, most sampled first.
+    auto self_samples(elf::symbol_table const* symbols = nullptr) const -> std::vector<std::pair<std::string, u64>> {
+        auto per_function = std::map<std::string, u64>{};
+
+        for (auto const& [key, count] : m_stacks) {
+            per_function[leaf_name(key, symbols)] += count;
+        }
+
+        auto ret = std::vector<std::pair<std::string, u64>>(per_function.begin(), per_function.end());
+        std::ranges::stable_sort(ret, std::greater{}, &std::pair<std::string, u64>::second);
+
+        return ret;
+    }
+
+private:
+    static constexpr usize max_shadow_depth = 1uz << 12;
+
+    struct shared_state {
+        explicit shared_state(usize ring_capacity)
+            : m_ring(ring_capacity) {}
+
+        detail::spsc_ring<profile_sample> m_ring;
+        std::atomic<u64> m_dropped{0};
+        std::atomic<bool> m_enabled{false};
+        std::atomic<bool> m_sample_requested{false};
+    };
+
+    profiler_config m_config;
+    std::unique_ptr<shared_state> m_shared;
+    /// declared after `m_shared` so that it is stopped and joined before the state it writes to is freed
+    std::jthread m_timer_thread{};
+
+    // producer state
+    u64 m_countdown;
+    std::vector<u64> m_shadow_stack{};
+    /// calls that went past `max_shadow_depth` and were not pushed
+    usize m_shadow_overflow = 0;
+
+    // consumer state
+    std::map<std::vector<u64>, u64> m_stacks{};
+    u64 m_total_samples = 0;
+
+    auto countdown_interval() const -> u64 {
+        switch (m_config.mode) {
+            case sampling_mode::instruction_count: return std::max<u64>(m_config.interval_instructions, 1);
+            case sampling_mode::cycle_count: return std::max<u64>(m_config.interval_cycles, 1);
+            // the timer only raises a flag, polling it every few instructions instead of on every one is plenty accurate
+            case sampling_mode::host_timer: return 64;
+        }
+
+        return 1;
+    }
+
+    void push_frame(u64 entry) {
+        if (m_shadow_stack.size() == max_shadow_depth) {
+            ++m_shadow_overflow;
+            return;
+        }
+
+        m_shadow_stack.push_back(entry);
+    }
+
+    void pop_frame() {
+        if (m_shadow_overflow != 0) {
+            --m_shadow_overflow;
+        } else if (!m_shadow_stack.empty()) {
+            m_shadow_stack.pop_back();
+        }
+    }
+
+    void take_sample(u64 program_counter) {
+        auto sample = profile_sample{
+          .program_counter = program_counter,
+          .frames = {},
+          .depth = static_cast<u32>(std::min(m_shadow_stack.size(), profile_sample::max_depth)),
+          .truncated = m_shadow_stack.size() > profile_sample::max_depth,
+        };
+
+        std::copy(m_shadow_stack.end() - sample.depth, m_shadow_stack.end(), sample.frames.begin());
+
+        if (!m_shared->m_ring.try_push(sample)) {
+            m_shared->m_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    static auto symbolize(u64 address, elf::symbol_table const* symbols) -> std::string {
+        if (symbols != nullptr) {
+            if (auto const* symbol = symbols->function_at(address); symbol != nullptr) {
+                return symbol->display_name;
+            }
+        }
+
+        return fmt::format("{:#x}", address);
+    }
+
+    /// `key` is the frames, the truncation flag and the program counter
+    static auto num_frames(std::vector<u64> const& key) -> usize { return key.size() - 2; }
+
+    /// The function the program counter of a sample is in. Without a symbol for it, the innermost frame is the best guess.
+    static auto leaf_name(std::vector<u64> const& key, elf::symbol_table const* symbols) -> std::string {
+        const auto has_symbol = symbols != nullptr && symbols->function_at(key.back()) != nullptr;
+
+        if (has_symbol || num_frames(key) == 0) {
+            return symbolize(key.back(), symbols);
+        }
+
+        return symbolize(key[num_frames(key) - 1], symbols);
+    }
+
+    static auto collapse(std::vector<u64> const& key, elf::symbol_table const* symbols) -> std::string {
+        auto ret = std::string(key[key.size() - 2] != 0 ? "[truncated]" : "");
+        auto last = std::string{};
+
+        const auto append = [&](std::string name) {
+            ret += ret.empty() ? "" : ";";
+            ret += name;
+            last = std::move(name);
+        };
+
+        for (usize i = 0; i < num_frames(key); i++) {
+            append(symbolize(key[i], symbols));
+        }
+
+        // the leaf is normally inside the innermost frame, it is only a separate frame before the first call or after a tail call
+        if (auto leaf = leaf_name(key, symbols); num_frames(key) == 0 || leaf != last) {
+            append(std::move(leaf));
+        }
+
+        return ret;
+    }
+};
+
+/// Feeds a `profiler` from the interpreter.
+/// Sampling by cycles asks the processor for the cycle count after each instruction, with a `timing_observer` before this one in an
+/// `observer_list` the cycles are the ones of the timing model.
+struct profiler_observer : null_observer {
+    profiler_observer() = default;
+
+    explicit profiler_observer(profiler_config config)
+        : m_profiler(config) {}
+
+    template<typename RiscV>
+    constexpr void on_execute(RiscV const& self, usize) {
+        if (m_profiler.config().mode != sampling_mode::cycle_count) {
+            m_profiler.on_instruction(self.m_program_counter);
+            return;
+        }
+
+        // the instruction hasn't retired yet, without a model this would lag one cycle behind
+        const auto cycles = self.event_count(hpm_event::cycles, self.retired_instructions() + 1);
+        m_profiler.on_instruction(self.m_program_counter, cycles - m_last_cycles);
+        m_last_cycles = cycles;
+    }
+
+    template<typename RiscV>
+    constexpr void on_jump(RiscV const&, u64, u64 to, reg link, reg base) {
+        m_profiler.on_jump(to, link, base);
+    }
+
+    profiler m_profiler;
+    u64 m_last_cycles = 0;
+};
+
+}  // namespace rv
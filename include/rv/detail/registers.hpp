@@ -6,10 +6,11 @@
 
 namespace rv {
 
-template<typename RegisterType = u64, typename FloatType = RegisterType>
+/// The float registers are as wide as the widest supported float (FLEN), narrower floats are NaN-boxed into them.
+template<typename RegisterType = u64, typename FloatType = u64>
 struct register_bank {
     using register_type = RegisterType;
-    using float_type = RegisterType;
+    using float_type = FloatType;
 
     constexpr register_bank() {
         if consteval {
@@ -31,7 +32,11 @@ struct register_bank {
         return std::make_pair(read_register(reg_src_1), read_register(reg_src_2));
     }
 
-    constexpr void write_register(rv::reg reg, std::unsigned_integral auto val) { m_registers[static_cast<u32>(reg)] = arith::sext<register_type, 32>((register_type)val); }
+    /// 32 bit values get sign extended, like the results of the word instructions on RV64 are.
+    template<std::unsigned_integral T>
+    constexpr void write_register(rv::reg reg, T val) {
+        m_registers[static_cast<u32>(reg)] = arith::sext<register_type, std::max(std::numeric_limits<T>::digits, 32)>((register_type)val);
+    }
     constexpr auto read_register(rv::reg reg) -> register_type { return reg == rv::reg::zero ? (register_type)0 : m_registers[static_cast<u32>(reg)]; }
 
     constexpr void write_register(rv::float_reg reg, float_type val) { m_float_registers[static_cast<u32>(reg)] = val; }
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stuff/core.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <optional>
+#include <vector>
+
+namespace rv::detail {
+
+/// A bounded, lock-free, single-producer single-consumer queue.
+/// Neither side ever blocks: pushing into a full ring and popping from an empty one fail instead.
+template<typename T>
+struct spsc_ring {
+    explicit spsc_ring(usize capacity)
+        : m_data(std::bit_ceil(std::max<usize>(capacity, 2)))
+        , m_mask(m_data.size() - 1) {}
+
+    spsc_ring(spsc_ring const&) = delete;
+    spsc_ring(spsc_ring&&) = delete;
+
+    /// producer side
+    auto try_push(T const& value) -> bool {
+        const auto tail = m_tail.load(std::memory_order_relaxed);
+
+        if (tail - m_cached_head == m_data.size()) {
+            m_cached_head = m_head.load(std::memory_order_acquire);
+            if (tail - m_cached_head == m_data.size()) {
+                return false;
+            }
+        }
+
+        m_data[tail & m_mask] = value;
+        m_tail.store(tail + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    /// consumer side
+    auto try_pop() -> std::optional<T> {
+        const auto head = m_head.load(std::memory_order_relaxed);
+
+        if (head == m_cached_tail) {
+            m_cached_tail = m_tail.load(std::memory_order_acquire);
+            if (head == m_cached_tail) {
+                return std::nullopt;
+            }
+        }
+
+        auto ret = std::optional<T>{std::move(m_data[head & m_mask])};
+        m_head.store(head + 1, std::memory_order_release);
+
+        return ret;
+    }
+
+    constexpr auto capacity() const -> usize { return m_data.size(); }
+
+    /// may be stale by the time it returns if the other side is active
+    auto size() const -> usize { return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire); }
+
+private:
+    std::vector<T> m_data;
+    usize m_mask;
+
+    alignas(64) std::atomic<usize> m_head{0};
+    usize m_cached_tail = 0;
+
+    alignas(64) std::atomic<usize> m_tail{0};
+    usize m_cached_head = 0;
+};
+
+}  // namespace rv::detail
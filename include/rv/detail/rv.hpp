@@ -1,25 +1,31 @@
 #pragma once
 
+#include <rv/detail/clint.hpp>
+#include <rv/detail/csr.hpp>
+#include <rv/detail/float.hpp>
 #include <rv/detail/memory.hpp>
+#include <rv/detail/observer.hpp>
 #include <rv/detail/registers.hpp>
+#include <rv/detail/trap.hpp>
+#include <rv/detail/vector.hpp>
 
 namespace rv {
 
 template<typename RiscV>
 struct generic_instruction_set;
 
-enum class csr_write_type {
-    write,
-    set,
-    clear,
-};
-
-template<typename RegisterType, typename Allocator = std::allocator<u8>>
+template<typename RegisterType, typename Allocator = std::allocator<u8>, typename Observer = null_observer>
 struct risc_v {
     using register_type = RegisterType;
-    using float_type = RegisterType;
+    using float_type = typename register_bank<RegisterType>::float_type;
+    using observer_type = Observer;
 
-    constexpr risc_v(generic_instruction_set<risc_v<RegisterType, Allocator>> const& isa, usize ram_sz = 0x1'0000, Allocator const& allocator = Allocator());
+    constexpr risc_v(
+      generic_instruction_set<risc_v<RegisterType, Allocator, Observer>> const& isa,
+      usize ram_sz = 0x1'0000,
+      Allocator const& allocator = Allocator(),
+      Observer observer = Observer()
+    );
 
     constexpr void reset();
 
@@ -31,6 +37,29 @@ struct risc_v {
 
     constexpr auto step() -> stf::expected<void, std::string_view>;
 
+    /// Executes at most `max_steps` instructions and returns the amount that got executed.
+    /// Execution stops early if an instruction doesn't change the program counter (e.g. `j .` which is used to halt).
+    /// Nothing but that gets checked between instructions, interrupts are only looked at once the next deadline of `m_events` is reached.
+    /// With `StopOnTrap`, execution also stops right after a trap is taken, with the program counter at the handler.
+    template<bool StopOnTrap = false>
+    constexpr auto run(usize max_steps) -> usize;
+
+    /// Maps `device` at `address` and makes it the source of timer and software interrupts and of the `time` CSR.
+    /// The CLINT has to outlive the processor, which can't be moved afterwards as the CLINT keeps track of its retired instructions.
+    constexpr auto map_clint(clint& device, register_type address) -> stf::expected<void, std::string_view>;
+
+    /// Takes the trap with `mcause` = `cause` from the current instruction, `value` goes into `mtval`.
+    constexpr void raise_exception(register_type cause, register_type value = 0);
+
+    /// Takes the illegal instruction exception from the current instruction, whose bits go into `mtval`.
+    constexpr void raise_illegal_instruction();
+
+    /// `mret`
+    constexpr void return_from_trap();
+
+    /// Handles the events of `m_events` that are due and takes the interrupt that is pending and enabled, if any.
+    constexpr void service_events();
+
     // observers
 
     constexpr auto memory() const -> rv::memory<register_type, Allocator> const& { return m_memory; }
@@ -38,11 +67,17 @@ struct risc_v {
     constexpr auto program_counter() -> register_type { return m_program_counter; }
     constexpr auto read_register(reg reg) -> register_type { return m_register_bank.read_register(reg); }
 
+    /// Reads the CSR at `address` into `destination` (unless it is `x0` for `csr_write_type::write`) and then writes, sets or clears the
+    /// bits of `value` in it if `write` is set. Returns false without changing anything if the access is illegal.
     template<csr_write_type Type>
-    constexpr auto csr_read_write(reg destination, register_type value, u32 addr) {
-        //auto val = m_register_bank.read_register(src);
-        //
-    }
+    constexpr auto csr_read_write(reg destination, register_type value, u32 address, bool write = true) -> bool;
+
+    /// The amount of instructions retired since the last reset.
+    constexpr auto retired_instructions() const -> u64 { return m_retired; }
+
+    /// The current value of what `event` counts, `retired` being the amount of retired instructions to go by.
+    /// Without an observer counting them, cycles are assumed to be one per instruction.
+    constexpr auto event_count(hpm_event event, u64 retired) const -> u64;
 
     constexpr auto jump(register_type offset) {
         m_next_step_sz = offset;
@@ -53,10 +88,69 @@ struct risc_v {
         m_next_step_sz = 0;
     }
 
-    generic_instruction_set<risc_v<RegisterType, Allocator>> const& m_isa;
+    // register and memory accesses of instructions go through these so that the observer gets to see them
+
+    constexpr void write_register(reg reg, std::unsigned_integral auto value) {
+        m_register_bank.write_register(reg, value);
+        m_observer.on_register_write(*this, reg, static_cast<u64>(m_register_bank.read_register(reg)));
+    }
+
+    /// The value of a float register as a `T`, see `nan_unbox`. Float registers aren't shown to the observer.
+    template<std::floating_point T>
+    constexpr auto read_float(float_reg reg) -> T {
+        return nan_unbox<T>(m_register_bank.read_register(reg));
+    }
+
+    template<std::floating_point T>
+    constexpr void write_float(float_reg reg, T value) {
+        m_register_bank.write_register(reg, nan_box(value));
+    }
+
+    template<std::unsigned_integral T>
+    constexpr auto read_memory(register_type address) -> T {
+        m_observer.on_memory_access(*this, address, sizeof(T), memory_access_type::read);
+        return m_memory.template load<T>(address);
+    }
+
+    template<std::unsigned_integral T>
+    constexpr void write_memory(register_type address, T value) {
+        m_observer.on_memory_access(*this, address, sizeof(T), memory_access_type::write);
+        m_memory.template store<T>(address, value);
+    }
+
+    /// Consecutive elements for the accesses of vector instructions, these get copied in one go but the observer still sees an access per
+    /// element. That is a loop of nothing without an observer.
+    template<std::unsigned_integral T>
+    constexpr void read_memory(register_type address, std::span<T> out) {
+        for (usize i = 0; i < out.size(); i++) {
+            m_observer.on_memory_access(*this, address + (register_type)(i * sizeof(T)), sizeof(T), memory_access_type::read);
+        }
+        m_memory.load(address, out);
+    }
+
+    template<std::unsigned_integral T>
+    constexpr void write_memory(register_type address, std::span<const T> values) {
+        for (usize i = 0; i < values.size(); i++) {
+            m_observer.on_memory_access(*this, address + (register_type)(i * sizeof(T)), sizeof(T), memory_access_type::write);
+        }
+        m_memory.store(address, values);
+    }
+
+    generic_instruction_set<risc_v<RegisterType, Allocator, Observer>> const& m_isa;
+    /// takes no space with the default `null_observer`
+    [[no_unique_address]] Observer m_observer;
     register_bank<register_type> m_register_bank;
     rv::memory<register_type, Allocator> m_memory;
     register_type m_program_counter = 0;
+    csr_file<register_type> m_csr{};
+    vector_register_file m_vector{};
+    trap_state<register_type> m_trap{};
+    event_queue m_events{};
+    /// not owned, see `map_clint`
+    rv::clint* m_clint = nullptr;
+
+    /// instructions retired since the last reset, `run` and `step` count these rather than the instructions themselves
+    u64 m_retired = 0;
 
     register_type m_next_step_sz = 4;
 };
@@ -5,20 +5,214 @@
 
 namespace rv {
 
-template<typename RegisterType, typename Allocator>
-constexpr void risc_v<RegisterType, Allocator>::reset() {
+template<typename RegisterType, typename Allocator, typename Observer>
+constexpr void risc_v<RegisterType, Allocator, Observer>::reset() {
     m_program_counter = 0;
+    m_csr = {};
+    m_vector.reset();
+    m_trap = {};
+    m_events = {};
+    m_retired = 0;
+
+    if (m_clint != nullptr) {
+        m_clint->connect(m_events, m_retired);
+    }
 }
 
-template<typename RegisterType, typename Allocator>
-constexpr risc_v<RegisterType, Allocator>::risc_v(generic_instruction_set<risc_v<RegisterType, Allocator>> const& isa, usize ram_sz, Allocator const& allocator)
+template<typename RegisterType, typename Allocator, typename Observer>
+constexpr risc_v<RegisterType, Allocator, Observer>::risc_v(
+  generic_instruction_set<risc_v<RegisterType, Allocator, Observer>> const& isa,
+  usize ram_sz,
+  Allocator const& allocator,
+  Observer observer
+)
     : m_isa(isa)
+    , m_observer(std::move(observer))
     , m_memory(ram_sz, allocator) {}
 
-template<typename RegisterType, typename Allocator>
-constexpr auto risc_v<RegisterType, Allocator>::step() -> stf::expected<void, std::string_view> {
+template<typename RegisterType, typename Allocator, typename Observer>
+constexpr auto risc_v<RegisterType, Allocator, Observer>::step() -> stf::expected<void, std::string_view> {
     m_isa.try_step(*this);
+    ++m_retired;
+
+    if (m_retired >= m_events.next()) {
+        service_events();
+    }
+
+    return {};
+}
+
+template<typename RegisterType, typename Allocator, typename Observer>
+template<bool StopOnTrap>
+constexpr auto risc_v<RegisterType, Allocator, Observer>::run(usize max_steps) -> usize {
+    // the step counter doubles as `instret`, so that there is nothing else to count per instruction
+    const auto first = m_retired;
+    const auto last = first + max_steps;
+
+    // the limit is an event like any other so that the loop below compares against a single deadline
+    m_events.schedule(event_source::run_limit, last);
+
+    for (auto halted = false; !halted && m_retired != last;) {
+        if (m_retired >= m_events.next()) {
+            const auto taken = m_trap.taken();
+            service_events();
+
+            if (StopOnTrap && taken != m_trap.taken()) {
+                break;
+            }
+        }
+
+        // instructions that schedule an event (e.g. a store to the CLINT) pull `next` in, which ends the block after them
+        while (m_retired < m_events.next()) {
+            const auto pc_0 = m_program_counter;
+            [[maybe_unused]] const auto taken = m_trap.taken();
+            m_isa.try_step(*this);
+            ++m_retired;
+
+            if (pc_0 == m_program_counter) [[unlikely]] {
+                halted = true;
+                break;
+            }
+
+            if constexpr (StopOnTrap) {
+                if (taken != m_trap.taken()) {
+                    halted = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    m_events.cancel(event_source::run_limit);
+
+    return static_cast<usize>(m_retired - first);
+}
+
+template<typename RegisterType, typename Allocator, typename Observer>
+constexpr void risc_v<RegisterType, Allocator, Observer>::service_events() {
+    m_events.pop_due(m_retired, [this](event_source source) {
+        if (source == event_source::timer && m_clint != nullptr) {
+            m_clint->on_timer();
+        }
+    });
+
+    if (m_clint != nullptr) {
+        m_trap.set_pending(interrupt_bit::machine_software | interrupt_bit::machine_timer, m_clint->pending());
+    }
+
+    if (const auto cause = m_trap.pending_interrupt(); cause) {
+        // the instruction at the program counter hasn't been executed yet, it is where the handler returns to
+        jump_to(m_trap.enter(m_program_counter, *cause, 0));
+    }
+}
+
+template<typename RegisterType, typename Allocator, typename Observer>
+constexpr auto risc_v<RegisterType, Allocator, Observer>::map_clint(clint& device, register_type address) -> stf::expected<void, std::string_view> {
+    if (auto mapped = m_memory.map_device({address, clint::register_span, &device}); !mapped) {
+        return mapped;
+    }
+
+    m_clint = &device;
+    m_clint->connect(m_events, m_retired);
     return {};
 }
 
+template<typename RegisterType, typename Allocator, typename Observer>
+constexpr void risc_v<RegisterType, Allocator, Observer>::raise_exception(register_type cause, register_type value) {
+    jump_to(m_trap.enter(m_program_counter, cause, value));
+}
+
+template<typename RegisterType, typename Allocator, typename Observer>
+constexpr void risc_v<RegisterType, Allocator, Observer>::raise_illegal_instruction() {
+    // `desc.word` would be the translation of a compressed instruction, `mtval` is to have the instruction as it is in memory
+    const auto word = m_memory.template read<u32>(m_program_counter);
+    raise_exception(static_cast<register_type>(trap_cause::illegal_instruction), (word & 0b11) == 0b11 ? word : word & 0xFFFF);
+}
+
+template<typename RegisterType, typename Allocator, typename Observer>
+constexpr void risc_v<RegisterType, Allocator, Observer>::return_from_trap() {
+    jump_to(m_trap.leave());
+    // `mstatus.MIE` might have just been set again with interrupts pending
+    m_events.schedule(event_source::interrupts, m_retired + 1);
+}
+
+template<typename RegisterType, typename Allocator, typename Observer>
+constexpr auto risc_v<RegisterType, Allocator, Observer>::event_count(hpm_event event, u64 retired) const -> u64 {
+    switch (event) {
+        case hpm_event::none: return 0;
+        case hpm_event::instructions: return retired;
+        default: break;
+    }
+
+    if (const auto count = m_observer.event_count(*this, event); count) {
+        return *count;
+    }
+
+    return event == hpm_event::cycles ? retired : 0;
+}
+
+template<typename RegisterType, typename Allocator, typename Observer>
+template<csr_write_type Type>
+constexpr auto risc_v<RegisterType, Allocator, Observer>::csr_read_write(reg destination, register_type value, u32 address, bool write) -> bool {
+    // `time` is the CLINT's `mtime` if there is one
+    const auto source = [this](usize index) { return index == 1 && m_clint != nullptr ? m_clint->mtime() : event_count(m_csr.event(index), m_retired); };
+    // writes take effect after the writing instruction retires, which it hasn't yet
+    const auto source_after = [this](usize index) { return event_count(m_csr.event(index), m_retired + 1); };
+
+    // the vector and trap CSRs are kept with the rest of the vector and trap state
+    const auto is_vector = vector_register_file::is_csr(address);
+    const auto is_trap = trap_state<register_type>::is_csr(address);
+
+    if (address == csr_address::mip && m_clint != nullptr) {
+        m_trap.set_pending(interrupt_bit::machine_software | interrupt_bit::machine_timer, m_clint->pending());
+    }
+
+    const auto read = [&]() -> std::optional<register_type> {
+        if (is_vector) {
+            return m_vector.read_csr<register_type>(address);
+        }
+        if (is_trap) {
+            return m_trap.read_csr(address);
+        }
+        return m_csr.read(address, source);
+    };
+
+    const auto skip_read = Type == csr_write_type::write && destination == reg::zero;
+    const auto old_value = skip_read ? std::optional<register_type>{0} : read();
+
+    if (!old_value) {
+        return false;
+    }
+
+    if (write) {
+        auto new_value = value;
+        if constexpr (Type == csr_write_type::set) {
+            new_value = *old_value | value;
+        } else if constexpr (Type == csr_write_type::clear) {
+            new_value = *old_value & ~value;
+        }
+
+        if (is_vector) {
+            if (!m_vector.write_csr(address, new_value)) {
+                return false;
+            }
+        } else if (is_trap) {
+            if (!m_trap.write_csr(address, new_value)) {
+                return false;
+            }
+
+            // `mstatus` and `mie` decide what is taken, the check happens once this instruction retires
+            m_events.schedule(event_source::interrupts, m_retired + 1);
+        } else if (!m_csr.write(address, new_value, source_after)) {
+            return false;
+        }
+    }
+
+    if (destination != reg::zero) {
+        write_register(destination, *old_value);
+    }
+
+    return true;
+}
+
 }  // namespace rv
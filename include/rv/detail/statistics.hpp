@@ -0,0 +1,212 @@
+#pragma once
+
+#include <rv/detail/instruction_descriptor.hpp>
+#include <rv/detail/observer.hpp>
+
+#include <fmt/format.h>
+
+#include <atomic>
+#include <map>
+#include <optional>
+#include <ostream>
+
+namespace rv {
+
+/// Whether executing the instruction in `props` is an occurrence of the instruction class `event`.
+template<typename RiscV>
+constexpr auto counts_towards(instruction_properties<RiscV> const& props, hpm_event event) -> bool {
+    const auto is_compressed = props.standard == instruction_standard::RV32C || props.standard == instruction_standard::RV64C || props.standard == instruction_standard::RV128C;
+
+    if (event == hpm_event::compressed) {
+        return is_compressed;
+    }
+
+    // the bits that a matcher wants are an instance of the instruction, for compressed ones the instance can be expanded for its class
+    if (is_compressed && props.translator == nullptr) {
+        return false;
+    }
+
+    const auto word = is_compressed ? props.translator(props.matcher.want) : props.matcher.want;
+    const auto opcode = word & 0x7Fu;
+    const auto funct_3 = (word >> 12) & 0b111u;
+    const auto funct_7 = word >> 25;
+
+    switch (event) {
+        case hpm_event::loads: return opcode == 0b00000'11;
+        case hpm_event::stores: return opcode == 0b01000'11;
+        case hpm_event::branches: return opcode == 0b11000'11;
+        case hpm_event::jumps: return opcode == 0b11011'11 || opcode == 0b11001'11;
+        case hpm_event::multiply_divide: return (opcode == 0b01100'11 || opcode == 0b01110'11) && funct_7 == 1;
+        case hpm_event::atomics: return opcode == 0b01011'11;
+        case hpm_event::csr_accesses: return opcode == 0b11100'11 && funct_3 != 0;
+        default: return false;
+    }
+}
+
+/// Execution counts for every slot of an instruction set.
+/// Counts per instruction standard and per opcode format are derived from the slot counts when they are asked for, so that counting an
+/// instruction costs a single increment.
+///
+/// The counters belong to the executing thread. `reset` doesn't write to them, it moves the baseline the counts are reported against, so
+/// that it can be called from another thread (the GUI's) without an increment in flight writing the old count back over the reset.
+struct execution_statistics {
+    constexpr execution_statistics() = default;
+
+    explicit constexpr execution_statistics(usize num_slots)
+        : m_counts(num_slots, 0)
+        , m_baseline(num_slots, 0) {}
+
+    template<typename RiscV>
+    explicit constexpr execution_statistics(generic_instruction_set<RiscV> const& isa)
+        : execution_statistics(isa.num_instructions()) {}
+
+    constexpr void count(usize slot) {
+        if consteval {
+            ++m_counts[slot];
+        } else {
+            // the counters are only ever written by the executing thread, this lets others read them while it runs without a locked increment
+            auto ref = std::atomic_ref<u64>(m_counts[slot]);
+            ref.store(ref.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+    }
+
+    auto slot_count(usize slot) const -> u64 { return load(m_counts[slot]) - load(m_baseline[slot]); }
+
+    constexpr auto num_slots() const -> usize { return m_counts.size(); }
+
+    auto total() const -> u64 {
+        u64 ret = 0;
+        for (usize i = 0; i < num_slots(); i++) {
+            ret += slot_count(i);
+        }
+        return ret;
+    }
+
+    /// Counts start over from zero, executions that are counted while this runs may or may not be in the new counts.
+    void reset() {
+        for (usize i = 0; i < num_slots(); i++) {
+            std::atomic_ref<u64>(m_baseline[i]).store(load(m_counts[i]), std::memory_order_relaxed);
+        }
+    }
+
+    template<typename RiscV>
+    auto per_standard(generic_instruction_set<RiscV> const& isa) const -> std::map<instruction_standard, u64> {
+        return aggregate(isa, [](auto const& props) { return props.standard; });
+    }
+
+    template<typename RiscV>
+    auto per_format(generic_instruction_set<RiscV> const& isa) const -> std::map<opcode_format, u64> {
+        return aggregate(isa, [](auto const& props) { return props.format; });
+    }
+
+    /// Executions of the instructions of an instruction class, nothing for events that aren't one.
+    template<typename RiscV>
+    auto event_count(generic_instruction_set<RiscV> const& isa, hpm_event event) const -> std::optional<u64> {
+        switch (event) {
+            case hpm_event::loads: [[fallthrough]];
+            case hpm_event::stores: [[fallthrough]];
+            case hpm_event::branches: [[fallthrough]];
+            case hpm_event::jumps: [[fallthrough]];
+            case hpm_event::multiply_divide: [[fallthrough]];
+            case hpm_event::atomics: [[fallthrough]];
+            case hpm_event::csr_accesses: [[fallthrough]];
+            case hpm_event::compressed: break;
+            default: return std::nullopt;
+        }
+
+        u64 ret = 0;
+        for (usize i = 0; i < num_slots(); i++) {
+            if (counts_towards(isa[i], event)) {
+                ret += slot_count(i);
+            }
+        }
+
+        return ret;
+    }
+
+    template<typename RiscV>
+    void dump_csv(std::ostream& os, generic_instruction_set<RiscV> const& isa) const {
+        os << "slot,mnemonic,standard,format,count\n";
+
+        for (usize i = 0; i < num_slots(); i++) {
+            auto const& props = isa[i];
+            os << fmt::format("{},\"{}\",{},{},{}\n", i, props.mnemonic, enum_name(props.standard), enum_name(props.format), slot_count(i));
+        }
+    }
+
+    template<typename RiscV>
+    void dump_json(std::ostream& os, generic_instruction_set<RiscV> const& isa) const {
+        os << "{\n  \"instructions\": [\n";
+
+        for (usize i = 0; i < num_slots(); i++) {
+            auto const& props = isa[i];
+            os << fmt::format(
+              R"(    {{"slot": {}, "mnemonic": "{}", "standard": "{}", "format": "{}", "count": {}}}{})",  //
+              i, props.mnemonic, enum_name(props.standard), enum_name(props.format), slot_count(i), i + 1 == num_slots() ? "\n" : ",\n"
+            );
+        }
+
+        os << "  ],\n";
+
+        const auto dump_map = [&os](std::string_view name, auto const& map, bool last) {
+            os << fmt::format("  \"{}\": {{", name);
+
+            for (bool first = true; auto const& [key, count] : map) {
+                os << fmt::format("{}\"{}\": {}", first ? "" : ", ", enum_name(key), count);
+                first = false;
+            }
+
+            os << (last ? "}\n" : "},\n");
+        };
+
+        dump_map("standards", per_standard(isa), false);
+        dump_map("formats", per_format(isa), true);
+
+        os << "}\n";
+    }
+
+private:
+    std::vector<u64> m_counts{};
+    /// what the counters were at the last `reset`
+    std::vector<u64> m_baseline{};
+
+    static auto load(u64 const& value) -> u64 { return std::atomic_ref<u64>(const_cast<u64&>(value)).load(std::memory_order_relaxed); }
+
+    template<typename RiscV, typename KeyFn>
+    auto aggregate(generic_instruction_set<RiscV> const& isa, KeyFn&& key_fn) const {
+        std::map<std::invoke_result_t<KeyFn, instruction_properties<RiscV> const&>, u64> ret{};
+
+        for (usize i = 0; i < num_slots(); i++) {
+            ret[std::invoke(key_fn, isa[i])] += slot_count(i);
+        }
+
+        return ret;
+    }
+};
+
+/// Counts executions per instruction set slot, see `execution_statistics`.
+struct statistics_observer : null_observer {
+    constexpr statistics_observer() = default;
+
+    explicit constexpr statistics_observer(usize num_slots)
+        : m_statistics(num_slots) {}
+
+    template<typename RiscV>
+    constexpr void on_execute(RiscV const&, usize slot) {
+        m_statistics.count(slot);
+    }
+
+    /// The source of the instruction class events of the performance counters, which are summed up from the slots only when read.
+    template<typename RiscV>
+    auto event_count(RiscV const& self, hpm_event event) const -> std::optional<u64> {
+        if (m_statistics.num_slots() == 0) {
+            return std::nullopt;
+        }
+
+        return m_statistics.event_count(self.m_isa, event);
+    }
+
+    execution_statistics m_statistics;
+};
+
+}  // namespace rv
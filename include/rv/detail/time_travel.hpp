@@ -0,0 +1,366 @@
+#pragma once
+
+#include <rv/detail/rv.hpp>
+
+#include <stuff/core.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace rv {
+
+struct time_travel_config {
+    /// instructions between checkpoints
+    u64 checkpoint_interval = 1'000'000;
+    /// Upper bound for the page copies kept by checkpoints, not counting the oldest checkpoint which is a full image of memory.
+    /// Checkpoints get thinned out to stay under it, and once only the oldest and the newest are left, the oldest moves forward.
+    usize memory_budget = 64uz << 20;
+};
+
+/// Reverse execution for a `risc_v` through periodic checkpoints.
+/// A checkpoint holds the registers, the program counter and copies of the memory pages written since the previous checkpoint. Going back
+/// restores the nearest checkpoint before the target and executes forward from it, which works out as long as execution is deterministic.
+/// The observer of the processor sees re-executed instructions again, performance counters counting events of observers can't go back.
+/// The registers of the processor's CLINT are part of checkpoints, other mapped devices aren't. Going back is refused once any device got
+/// something from outside of the emulation, e.g. a CLINT on the host's clock or a UART that was typed into, see `can_go_back`.
+template<typename RiscV>
+struct time_travel {
+    using register_type = typename RiscV::register_type;
+
+    struct executed_instruction {
+        u64 position;
+        register_type program_counter;
+    };
+
+    explicit time_travel(RiscV& risc_v, time_travel_config config = {})
+        : m_risc_v(risc_v)
+        , m_config(config) {
+        take_checkpoint();
+    }
+
+    /// The amount of instructions executed since time travel started.
+    auto position() const -> u64 { return m_position; }
+
+    /// The earliest position that can be gone back to, it only moves forward if the memory budget gets exceeded.
+    auto earliest_position() const -> u64 { return m_checkpoints.front().position; }
+
+    auto num_checkpoints() const -> usize { return m_checkpoints.size(); }
+
+    /// Whether execution is still deterministic enough to be re-executed from a checkpoint, see `mmio_device::deterministic`.
+    auto can_go_back() const -> bool {
+        return std::ranges::all_of(m_risc_v.m_memory.devices(), [](auto const& device) { return device.device->deterministic(); });
+    }
+    auto checkpoint_bytes() const -> usize { return m_delta_bytes; }
+
+    /// Like `risc_v::run`, taking checkpoints along the way.
+    auto run(usize max_steps) -> usize {
+        const auto interval = std::max<u64>(m_config.checkpoint_interval, 1);
+        usize executed = 0;
+
+        while (executed < max_steps) {
+            const auto next_checkpoint = (m_position / interval + 1) * interval;
+            const auto to_execute = std::min<u64>(max_steps - executed, next_checkpoint - m_position);
+            const auto chunk_executed = m_risc_v.run(to_execute);
+
+            executed += chunk_executed;
+            m_position += chunk_executed;
+
+            // there are checkpoints past the current position if we went back in time
+            if (m_position == next_checkpoint && m_checkpoints.back().position < m_position) {
+                take_checkpoint();
+            }
+
+            if (chunk_executed != to_execute) {
+                break;
+            }
+        }
+
+        return executed;
+    }
+
+    /// Moves to `position`, which has to be at or after `earliest_position`. Returns false without doing anything if that is going back
+    /// and `can_go_back` isn't.
+    auto seek(u64 position) -> bool {
+        if (position >= m_position) {
+            replay(position - m_position);
+            return true;
+        }
+
+        if (!can_go_back()) {
+            return false;
+        }
+
+        restore(checkpoint_before(position + 1));
+        replay(position - m_position);
+        return true;
+    }
+
+    /// Goes back `count` instructions, returns false without doing anything if that would be before `earliest_position`.
+    auto reverse_step(u64 count = 1) -> bool {
+        if (m_position - earliest_position() < count) {
+            return false;
+        }
+
+        return seek(m_position - count);
+    }
+
+    /// Goes back to the last point at which the instruction at one of `breakpoints` was about to be executed, returns false without doing
+    /// anything if there is no such point.
+    auto reverse_continue(std::span<const register_type> breakpoints) -> bool {
+        if (!can_go_back()) {
+            return false;
+        }
+
+        const auto found = find_last([breakpoints](register_type program_counter) { return std::ranges::find(breakpoints, program_counter) != breakpoints.end(); });
+
+        if (!found) {
+            return false;
+        }
+
+        seek(found->position);
+        return true;
+    }
+
+    /// The last instruction before the current position that wrote to any of `size` bytes at `address`.
+    auto last_write(register_type address, usize size = 1) -> std::optional<executed_instruction> {
+        if (!can_go_back()) {
+            return std::nullopt;
+        }
+
+        auto& memory = m_risc_v.m_memory;
+        const auto watch = memory_watch<register_type>{address, size, watch_type::write};
+
+        // other watches are left alone, their hits on the way are dropped
+        memory.add_watch(watch);
+        const auto ret = find_last([&memory, watch](register_type) {
+            return std::ranges::any_of(memory.consume_watch_hits(), [watch](auto const& hit) { return hit.watch == watch; });
+        });
+        memory.remove_watch(watch);
+
+        return ret;
+    }
+
+private:
+    struct page_copy {
+        usize page;
+        std::vector<u8> data;
+    };
+
+    struct checkpoint {
+        u64 position;
+        /// pages written after `memory::advance_generation` returned this were not captured by this checkpoint
+        u64 generation;
+
+        register_bank<register_type> registers;
+        register_type program_counter;
+        std::optional<register_type> reservation;
+        csr_file<register_type> csr;
+        vector_register_file vector;
+        trap_state<register_type> trap;
+        event_queue events;
+        u64 retired;
+        /// `mtime` goes by `retired`, the rest of the CLINT is what the guest wrote to it
+        std::optional<rv::clint> clint;
+
+        /// sorted by page
+        std::vector<page_copy> pages;
+    };
+
+    RiscV& m_risc_v;
+    time_travel_config m_config;
+
+    u64 m_position = 0;
+    std::vector<checkpoint> m_checkpoints{};
+    usize m_delta_bytes = 0;
+
+    static constexpr auto page_size = decltype(std::declval<RiscV&>().m_memory)::page_size;
+
+    static auto bytes_of(checkpoint const& checkpoint) -> usize {
+        usize ret = 0;
+        for (auto const& copy : checkpoint.pages) {
+            ret += copy.data.size();
+        }
+        return ret;
+    }
+
+    auto page_span(usize page) const -> std::span<u8> {
+        auto& memory = m_risc_v.m_memory;
+        const auto begin = page * page_size;
+        return {memory.data() + begin, std::min(page_size, memory.size() - begin)};
+    }
+
+    /// the index of the last checkpoint taken before `position`, `checkpoint_before(p + 1)` is the last one at or before `p`
+    auto checkpoint_before(u64 position) const -> usize {
+        const auto it = std::ranges::lower_bound(m_checkpoints, position, {}, &checkpoint::position);
+        return static_cast<usize>(it - m_checkpoints.begin()) - 1;
+    }
+
+    void take_checkpoint() {
+        auto& memory = m_risc_v.m_memory;
+
+        const auto is_first = m_checkpoints.empty();
+        const auto since = is_first ? 0 : m_checkpoints.back().generation;
+
+        auto checkpoint = time_travel::checkpoint{
+          .position = m_position,
+          .generation = memory.advance_generation(),
+          .registers = m_risc_v.m_register_bank,
+          .program_counter = m_risc_v.m_program_counter,
+          .reservation = memory.reservation(),
+          .csr = m_risc_v.m_csr,
+          .vector = m_risc_v.m_vector,
+          .trap = m_risc_v.m_trap,
+          .events = m_risc_v.m_events,
+          .retired = m_risc_v.m_retired,
+          .clint = m_risc_v.m_clint == nullptr ? std::nullopt : std::optional<rv::clint>(*m_risc_v.m_clint),
+          .pages = {},
+        };
+
+        for (usize page = 0; page < memory.num_pages(); page++) {
+            if (is_first || memory.page_generation(page) > since) {
+                const auto span = page_span(page);
+                checkpoint.pages.emplace_back(page, std::vector<u8>(span.begin(), span.end()));
+            }
+        }
+
+        if (!is_first) {
+            m_delta_bytes += bytes_of(checkpoint);
+        }
+
+        m_checkpoints.emplace_back(std::move(checkpoint));
+        enforce_budget();
+    }
+
+    /// folds the checkpoint at `index` into the one after it, the contents of the pages it has and its successor doesn't are still the
+    /// contents at the successor
+    void merge_into_next(usize index) {
+        auto& from = m_checkpoints[index];
+        auto& into = m_checkpoints[index + 1];
+
+        auto merged = std::vector<page_copy>{};
+        merged.reserve(from.pages.size() + into.pages.size());
+
+        auto from_it = from.pages.begin();
+        auto into_it = into.pages.begin();
+
+        while (from_it != from.pages.end() || into_it != into.pages.end()) {
+            if (into_it == into.pages.end() || (from_it != from.pages.end() && from_it->page < into_it->page)) {
+                merged.emplace_back(std::move(*from_it++));
+            } else {
+                if (from_it != from.pages.end() && from_it->page == into_it->page) {
+                    ++from_it;
+                }
+                merged.emplace_back(std::move(*into_it++));
+            }
+        }
+
+        into.pages = std::move(merged);
+        m_checkpoints.erase(m_checkpoints.begin() + static_cast<std::ptrdiff_t>(index));
+    }
+
+    void enforce_budget() {
+        while (m_delta_bytes > m_config.memory_budget && m_checkpoints.size() > 1) {
+            if (m_checkpoints.size() == 2) {
+                // nothing left to thin out, give up on the oldest history instead
+                m_delta_bytes -= bytes_of(m_checkpoints[1]);
+                merge_into_next(0);
+                continue;
+            }
+
+            // drop the interior checkpoint that leaves the smallest gap behind
+            const auto gap = [this](usize i) { return m_checkpoints[i + 1].position - m_checkpoints[i - 1].position; };
+            auto best = 1uz;
+            for (usize i = 2; i + 1 < m_checkpoints.size(); i++) {
+                if (gap(i) < gap(best)) {
+                    best = i;
+                }
+            }
+
+            const auto bytes_before = bytes_of(m_checkpoints[best]) + bytes_of(m_checkpoints[best + 1]);
+            merge_into_next(best);
+            m_delta_bytes = m_delta_bytes - bytes_before + bytes_of(m_checkpoints[best]);
+        }
+    }
+
+    void restore(usize index) {
+        auto& memory = m_risc_v.m_memory;
+        auto const& target = m_checkpoints[index];
+
+        // pages that weren't written since the checkpoint still hold what they held back then
+        for (usize page = 0; page < memory.num_pages(); page++) {
+            if (memory.page_generation(page) <= target.generation) {
+                continue;
+            }
+
+            for (auto i = index;; i--) {
+                auto const& pages = m_checkpoints[i].pages;
+                const auto it = std::ranges::lower_bound(pages, page, {}, &page_copy::page);
+
+                if (it != pages.end() && it->page == page) {
+                    std::ranges::copy(it->data, page_span(page).begin());
+                    memory.mark_written(page * page_size, it->data.size());
+                    break;
+                }
+            }
+        }
+
+        m_risc_v.m_register_bank = target.registers;
+        m_risc_v.m_program_counter = target.program_counter;
+        memory.set_reservation(target.reservation);
+        m_risc_v.m_csr = target.csr;
+        m_risc_v.m_vector = target.vector;
+        m_risc_v.m_trap = target.trap;
+        m_risc_v.m_events = target.events;
+        m_risc_v.m_retired = target.retired;
+        if (target.clint && m_risc_v.m_clint != nullptr) {
+            *m_risc_v.m_clint = *target.clint;
+        }
+
+        m_position = target.position;
+    }
+
+    /// executes `count` instructions, instructions that halt (e.g. `j .`) count as executed like they do in `run`
+    void replay(u64 count) {
+        while (count != 0) {
+            const auto executed = m_risc_v.run(count);
+            count -= executed;
+            m_position += executed;
+        }
+    }
+
+    /// The last instruction before the current position for which `matches` is true. `matches` is called right after each instruction is
+    /// executed with the address of the instruction. The position is left unchanged.
+    template<typename Fn>
+    auto find_last(Fn&& matches) -> std::optional<executed_instruction> {
+        const auto target = m_position;
+        auto ret = std::optional<executed_instruction>{};
+
+        // go through the intervals between checkpoints from the newest to the oldest, the last match in the first interval with one wins
+        for (auto end = target, index = checkpoint_before(target + 1); !ret; end = m_checkpoints[index--].position) {
+            if (m_checkpoints[index].position != end) {
+                restore(index);
+            }
+
+            while (m_position < end) {
+                const auto program_counter = m_risc_v.m_program_counter;
+                replay(1);
+
+                if (std::invoke(matches, program_counter)) {
+                    ret = executed_instruction{m_position - 1, program_counter};
+                }
+            }
+
+            if (index == 0) {
+                break;
+            }
+        }
+
+        seek(target);
+        return ret;
+    }
+};
+
+}  // namespace rv
@@ -0,0 +1,294 @@
+#pragma once
+
+#include <rv/detail/branch_prediction.hpp>
+#include <rv/detail/cache.hpp>
+#include <rv/detail/instruction_descriptor.hpp>
+#include <rv/detail/observer.hpp>
+
+#include <algorithm>
+#include <array>
+#include <optional>
+
+namespace rv {
+
+struct timing_config {
+    /// bubbles after a `jal`, whose target is known in decode
+    u64 jump_penalty = 1;
+    /// bubbles after a taken branch or a `jalr`, which are resolved in execute, or after a misprediction of either if there is prediction
+    u64 branch_penalty = 2;
+    /// cycles from a load entering execute until its result can be forwarded, 2 makes for the classic single load-use stall
+    u64 load_latency = 2;
+    /// multiplies are pipelined, divides block the divider until they are done
+    u64 multiply_latency = 3;
+    u64 divide_latency = 34;
+
+    std::optional<cache_config> instruction_cache = std::nullopt;
+    std::optional<cache_config> data_cache = std::nullopt;
+    std::optional<branch_prediction_config> branch_prediction = std::nullopt;
+};
+
+/// Where the cycles that weren't spent issuing an instruction went.
+struct timing_stalls {
+    /// waiting for the result of an earlier instruction, e.g. load-use
+    u64 data = 0;
+    /// bubbles after a change of control flow
+    u64 control = 0;
+    /// waiting for the divider
+    u64 structural = 0;
+    /// cache misses
+    u64 memory = 0;
+};
+
+namespace detail {
+
+enum class timing_class : u8 {
+    alu,
+    load,
+    store,
+    multiply,
+    divide,
+    branch,
+    jump,
+    indirect_jump,
+};
+
+/// The operands of an instruction as far as the pipeline is concerned, `reg::zero` for the ones that it doesn't have.
+struct timing_operands {
+    timing_class type;
+    reg destination;
+    reg source_1;
+    reg source_2;
+};
+
+/// `word` is expected to be a 32-bit instruction, compressed ones need expanding first
+constexpr auto timing_operands_of(u32 word) -> timing_operands {
+    const auto opcode = word & 0x7Fu;
+    const auto funct_3 = (word >> 12) & 0b111u;
+    const auto funct_7 = word >> 25;
+    const auto rd = static_cast<reg>((word >> 7) & 0x1F);
+    const auto rs_1 = static_cast<reg>((word >> 15) & 0x1F);
+    const auto rs_2 = static_cast<reg>((word >> 20) & 0x1F);
+
+    switch (opcode) {
+        case 0b01100'11:
+        case 0b01110'11:
+            if (funct_7 == 1) {
+                return {(funct_3 & 0b100) != 0 ? timing_class::divide : timing_class::multiply, rd, rs_1, rs_2};
+            }
+            return {timing_class::alu, rd, rs_1, rs_2};
+        case 0b00100'11:
+        case 0b00110'11: return {timing_class::alu, rd, rs_1, reg::zero};
+        case 0b01101'11:
+        case 0b00101'11: return {timing_class::alu, rd, reg::zero, reg::zero};
+        case 0b00000'11: return {timing_class::load, rd, rs_1, reg::zero};
+        // atomics go through the memory stage like loads and have their result as late
+        case 0b01011'11: return {timing_class::load, rd, rs_1, rs_2};
+        case 0b01000'11: return {timing_class::store, reg::zero, rs_1, rs_2};
+        case 0b11000'11: return {timing_class::branch, reg::zero, rs_1, rs_2};
+        case 0b11011'11: return {timing_class::jump, rd, reg::zero, reg::zero};
+        case 0b11001'11: return {timing_class::indirect_jump, rd, rs_1, reg::zero};
+        // the immediate forms of the CSR instructions have the immediate where `rs1` would be
+        case 0b11100'11: return {timing_class::alu, rd, (funct_3 & 0b100) != 0 ? reg::zero : rs_1, reg::zero};
+        default: return {timing_class::alu, reg::zero, reg::zero, reg::zero};
+    }
+}
+
+}  // namespace detail
+
+/// A cycle-approximate model of a classic 5-stage in-order pipeline (fetch, decode, execute, memory, writeback) with full forwarding.
+/// Every instruction is assigned the cycle it enters execute in, which is the cycle after the previous one did unless:
+///  - an operand isn't ready yet, results are ready `load_latency` or the M extension latencies after the producer entered execute
+///  - the previous instruction changed the control flow, without branch prediction fetch continues sequentially and with it only
+///    mispredictions cost anything
+///  - it divides and the divider is busy
+///  - it misses in the instruction cache, or the previous one missed in the data cache (the caches are blocking)
+/// The cycle count is the cycle that the next instruction could enter execute in, the cycles to fill the pipeline aren't counted.
+struct timing_model {
+    explicit timing_model(timing_config config = {})
+        : m_config(config) {
+        if (m_config.instruction_cache) {
+            m_instruction_cache.emplace(*m_config.instruction_cache);
+        }
+
+        if (m_config.data_cache) {
+            m_data_cache.emplace(*m_config.data_cache);
+        }
+
+        if (m_config.branch_prediction) {
+            m_branch_prediction.emplace(*m_config.branch_prediction);
+        }
+    }
+
+    /// Accounts for the instruction at `program_counter`, `size` bytes long, with `operands`.
+    constexpr void on_instruction(u64 program_counter, usize size, detail::timing_operands operands) {
+        auto issue = m_cycles;
+
+        if (m_last_class) {
+            const auto redirected = program_counter != m_last_program_counter + m_last_size;
+
+            auto penalty = u64(0);
+            if (*m_last_class == detail::timing_class::jump) {
+                penalty = redirected ? m_config.jump_penalty : 0;
+            } else if (m_branch_prediction) {
+                penalty = m_last_mispredicted ? m_config.branch_penalty : 0;
+            } else {
+                penalty = redirected ? m_config.branch_penalty : 0;
+            }
+
+            m_stalls.control += penalty;
+            issue += penalty;
+        }
+
+        if (m_instruction_cache && !m_instruction_cache->access(program_counter)) {
+            m_stalls.memory += m_config.instruction_cache->miss_penalty;
+            issue += m_config.instruction_cache->miss_penalty;
+        }
+
+        if (const auto ready = std::max(ready_at(operands.source_1), ready_at(operands.source_2)); ready > issue) {
+            m_stalls.data += ready - issue;
+            issue = ready;
+        }
+
+        if (operands.type == detail::timing_class::divide && m_divider_free_at > issue) {
+            m_stalls.structural += m_divider_free_at - issue;
+            issue = m_divider_free_at;
+        }
+
+        auto latency = u64(1);
+        switch (operands.type) {
+            case detail::timing_class::load: latency = m_config.load_latency; break;
+            case detail::timing_class::multiply: latency = m_config.multiply_latency; break;
+            case detail::timing_class::divide:
+                latency = m_config.divide_latency;
+                m_divider_free_at = issue + latency;
+                break;
+            default: break;
+        }
+
+        if (operands.destination != reg::zero) {
+            m_ready_at[static_cast<usize>(operands.destination)] = issue + latency;
+        }
+
+        const auto is_control = operands.type == detail::timing_class::branch || operands.type == detail::timing_class::jump ||
+                                operands.type == detail::timing_class::indirect_jump;
+
+        m_last_class = is_control ? std::optional{operands.type} : std::nullopt;
+        m_last_mispredicted = false;
+        m_last_program_counter = program_counter;
+        m_last_size = size;
+        m_last_destination = operands.destination;
+        m_cycles = issue + 1;
+    }
+
+    /// Accounts for a data access of the instruction that was last passed to `on_instruction`.
+    constexpr void on_data_access(u64 address) {
+        if (!m_data_cache || m_data_cache->access(address)) {
+            return;
+        }
+
+        const auto penalty = m_config.data_cache->miss_penalty;
+        m_stalls.memory += penalty;
+        m_cycles += penalty;
+
+        if (m_last_destination != reg::zero) {
+            m_ready_at[static_cast<usize>(m_last_destination)] += penalty;
+        }
+    }
+
+    /// Accounts for the outcome of the conditional branch that was last passed to `on_instruction`.
+    void on_branch(u64 address, u64 target, bool taken) {
+        if (m_branch_prediction) {
+            m_last_mispredicted = m_branch_prediction->on_branch(address, target, taken);
+        }
+    }
+
+    /// Accounts for the target of the jump that was last passed to `on_instruction`.
+    void on_jump(u64 from, u64 to, reg link, reg base) {
+        if (m_branch_prediction) {
+            m_last_mispredicted = m_branch_prediction->on_jump(from, to, m_last_size, link, base);
+        }
+    }
+
+    constexpr auto config() const -> timing_config const& { return m_config; }
+    constexpr auto cycles() const -> u64 { return m_cycles; }
+    constexpr auto stalls() const -> timing_stalls const& { return m_stalls; }
+
+    constexpr auto instruction_cache() const -> std::optional<cache_model> const& { return m_instruction_cache; }
+    constexpr auto data_cache() const -> std::optional<cache_model> const& { return m_data_cache; }
+    constexpr auto branch_prediction() const -> std::optional<branch_prediction_model> const& { return m_branch_prediction; }
+
+private:
+    timing_config m_config;
+    std::optional<cache_model> m_instruction_cache = std::nullopt;
+    std::optional<cache_model> m_data_cache = std::nullopt;
+    std::optional<branch_prediction_model> m_branch_prediction = std::nullopt;
+
+    u64 m_cycles = 0;
+    timing_stalls m_stalls{};
+    /// the cycle from which on the value of each register can be forwarded
+    std::array<u64, 32> m_ready_at{};
+    u64 m_divider_free_at = 0;
+
+    /// set if the last instruction could have changed the control flow
+    std::optional<detail::timing_class> m_last_class = std::nullopt;
+    u64 m_last_program_counter = 0;
+    usize m_last_size = 0;
+    reg m_last_destination = reg::zero;
+    bool m_last_mispredicted = false;
+
+    constexpr auto ready_at(reg reg) const -> u64 { return m_ready_at[static_cast<usize>(reg)]; }
+};
+
+/// Runs a `timing_model` alongside execution. It is the source of the `cycle` counter, of the cache miss events when it has caches and of
+/// the branch misprediction event when it predicts branches.
+/// The model decodes every instruction a second time to get at its operands, which is why it is an observer that processors only pay for
+/// when they have it.
+struct timing_observer : null_observer {
+    timing_observer() = default;
+
+    explicit timing_observer(timing_config config)
+        : m_model(config) {}
+
+    template<typename RiscV>
+    constexpr void on_execute(RiscV const& self, usize slot) {
+        const auto program_counter = static_cast<u64>(self.m_program_counter);
+        auto word = self.m_memory.template read<u32>(self.m_program_counter);
+        const auto size = (word & 0b11) == 0b11 ? 4uz : 2uz;
+
+        if (auto const& props = self.m_isa[slot]; props.translator != nullptr) {
+            word = props.translator(word);
+        }
+
+        m_model.on_instruction(program_counter, size, detail::timing_operands_of(word));
+    }
+
+    template<typename RiscV>
+    constexpr void on_memory_access(RiscV const&, u64 address, usize, memory_access_type) {
+        m_model.on_data_access(address);
+    }
+
+    template<typename RiscV>
+    void on_branch(RiscV const&, u64 from, u64 target, bool taken) {
+        m_model.on_branch(from, target, taken);
+    }
+
+    template<typename RiscV>
+    void on_jump(RiscV const&, u64 from, u64 to, reg link, reg base) {
+        m_model.on_jump(from, to, link, base);
+    }
+
+    template<typename RiscV>
+    constexpr auto event_count(RiscV const&, hpm_event event) const -> std::optional<u64> {
+        switch (event) {
+            case hpm_event::cycles: return m_model.cycles();
+            case hpm_event::instruction_cache_misses: return m_model.instruction_cache().transform(&cache_model::misses);
+            case hpm_event::data_cache_misses: return m_model.data_cache().transform(&cache_model::misses);
+            case hpm_event::branch_mispredicts: return m_model.branch_prediction().transform(&branch_prediction_model::mispredictions);
+            default: return std::nullopt;
+        }
+    }
+
+    timing_model m_model{};
+};
+
+}  // namespace rv
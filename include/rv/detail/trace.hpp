@@ -0,0 +1,432 @@
+#pragma once
+
+#include <rv/detail/observer.hpp>
+
+#include <stuff/core.hpp>
+#include <stuff/expected.hpp>
+
+#include <array>
+#include <bit>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+namespace rv {
+
+/*
+ * Trace format
+ *
+ * An 8 byte header ("RVTRACE" and a version byte) followed by a stream of items, each starting with a tag byte:
+ *  - 0b0000'000c: an instruction, `c` is set for compressed ones. Followed by the zigzag varint difference between its address and the
+ *    address right after the previous instruction, then by the instruction word as 2 or 4 little-endian bytes.
+ *  - 0b010r'rrrr: a write of register `r` by the last instruction. Followed by the zigzag varint difference from the previous value
+ *    written to that register.
+ *  - 0b1000'0wss: a memory access of `1 << ss` bytes by the last instruction, a write if `w` is set. Followed by the zigzag varint
+ *    difference from the address of the previous access.
+ *
+ * All the differences start off from zero. Straight-line code costs 3 or 5 bytes per instruction plus 2-3 for its writeback.
+ */
+
+namespace detail {
+
+inline constexpr std::array<u8, 8> trace_magic{'R', 'V', 'T', 'R', 'A', 'C', 'E', 1};
+
+inline constexpr u8 trace_tag_instruction = 0b0000'0000;
+inline constexpr u8 trace_tag_register_write = 0b0100'0000;
+inline constexpr u8 trace_tag_memory_access = 0b1000'0000;
+
+constexpr auto zigzag_encode(u64 v) -> u64 { return (v << 1) ^ static_cast<u64>(static_cast<i64>(v) >> 63); }
+constexpr auto zigzag_decode(u64 v) -> u64 { return (v >> 1) ^ (0 - (v & 1)); }
+
+/// LEB128, at most 10 bytes
+constexpr auto put_varint(u8* out, u64 v) -> u8* {
+    while (v >= 0x80) {
+        *out++ = static_cast<u8>(v) | 0x80;
+        v >>= 7;
+    }
+
+    *out++ = static_cast<u8>(v);
+    return out;
+}
+
+/// Hands filled buffers over to a background thread that writes them out, so that the executing thread never waits on I/O unless the
+/// writer falls more than `max_buffers_in_flight` buffers behind.
+struct trace_writer {
+    static constexpr usize buffer_size = 1uz << 20;
+    static constexpr usize max_buffers_in_flight = 16;
+
+    explicit trace_writer(std::ostream& os)
+        : m_stream(os) {
+        m_stream.write(reinterpret_cast<const char*>(trace_magic.data()), trace_magic.size());
+        m_thread = std::jthread([this](std::stop_token token) { worker(std::move(token)); });
+    }
+
+    trace_writer(trace_writer const&) = delete;
+    trace_writer(trace_writer&&) = delete;
+
+    ~trace_writer() {
+        m_thread.request_stop();
+        m_thread.join();
+        m_stream.flush();
+    }
+
+    auto acquire_buffer() -> std::vector<u8> {
+        auto lock = std::unique_lock(m_mutex);
+        m_cv.wait(lock, [this] { return m_in_flight < max_buffers_in_flight; });
+
+        ++m_in_flight;
+
+        auto ret = std::vector<u8>{};
+        if (!m_free_buffers.empty()) {
+            ret = std::move(m_free_buffers.back());
+            m_free_buffers.pop_back();
+        }
+
+        ret.resize(buffer_size);
+        return ret;
+    }
+
+    void submit(std::vector<u8> buffer) {
+        {
+            auto lock = std::lock_guard(m_mutex);
+            m_queue.emplace_back(std::move(buffer));
+        }
+
+        m_cv.notify_all();
+    }
+
+private:
+    std::ostream& m_stream;
+
+    std::mutex m_mutex{};
+    std::condition_variable_any m_cv{};
+    std::deque<std::vector<u8>> m_queue{};
+    std::vector<std::vector<u8>> m_free_buffers{};
+    usize m_in_flight = 0;
+
+    std::jthread m_thread{};
+
+    void worker(std::stop_token token) {
+        for (auto lock = std::unique_lock(m_mutex);;) {
+            m_cv.wait(lock, token, [&] { return !m_queue.empty(); });
+
+            if (m_queue.empty()) {
+                return;
+            }
+
+            auto buffer = std::move(m_queue.front());
+            m_queue.pop_front();
+
+            lock.unlock();
+            m_stream.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+            buffer.clear();
+            lock.lock();
+
+            m_free_buffers.emplace_back(std::move(buffer));
+            --m_in_flight;
+            m_cv.notify_all();
+        }
+    }
+};
+
+}  // namespace detail
+
+/// Records every executed instruction along with its register writebacks and memory accesses, see the format description above.
+/// Each recorder fills a buffer of its own, only full buffers are handed to the writer thread.
+struct trace_observer : null_observer {
+    trace_observer() = default;
+
+    explicit trace_observer(std::ostream& os)
+        : m_writer(std::make_unique<detail::trace_writer>(os))
+        , m_buffer(m_writer->acquire_buffer()) {}
+
+    trace_observer(trace_observer&&) = default;
+    auto operator=(trace_observer&&) -> trace_observer& = default;
+
+    ~trace_observer() {
+        if (m_writer != nullptr) {
+            submit();
+        }
+    }
+
+    template<typename RiscV>
+    constexpr void on_execute(RiscV const& self, usize) {
+        if (m_writer == nullptr) {
+            return;
+        }
+
+        reserve();
+
+        const auto pc = static_cast<u64>(self.m_program_counter);
+        const auto word = self.m_memory.template read<u32>(self.m_program_counter);
+        const auto compressed = (word & 0b11) != 0b11;
+
+        auto* out = m_buffer.data() + m_used;
+        *out++ = detail::trace_tag_instruction | (compressed ? 1 : 0);
+        out = detail::put_varint(out, detail::zigzag_encode(pc - m_next_pc));
+        for (usize i = 0; i < (compressed ? 2uz : 4uz); i++) {
+            *out++ = static_cast<u8>(word >> (i * 8));
+        }
+
+        commit(out);
+        m_next_pc = pc + (compressed ? 2 : 4);
+    }
+
+    template<typename RiscV>
+    constexpr void on_register_write(RiscV const&, reg reg, u64 value) {
+        if (m_writer == nullptr || reg == reg::zero) {
+            return;
+        }
+
+        reserve();
+
+        auto& last = m_register_values[static_cast<u32>(reg)];
+
+        auto* out = m_buffer.data() + m_used;
+        *out++ = detail::trace_tag_register_write | static_cast<u8>(reg);
+        out = detail::put_varint(out, detail::zigzag_encode(value - last));
+
+        commit(out);
+        last = value;
+    }
+
+    template<typename RiscV>
+    constexpr void on_memory_access(RiscV const&, u64 address, usize size, memory_access_type type) {
+        if (m_writer == nullptr) {
+            return;
+        }
+
+        reserve();
+
+        auto* out = m_buffer.data() + m_used;
+        *out++ = detail::trace_tag_memory_access | (type == memory_access_type::write ? 0b100 : 0) | static_cast<u8>(std::countr_zero(size));
+        out = detail::put_varint(out, detail::zigzag_encode(address - m_last_address));
+
+        commit(out);
+        m_last_address = address;
+    }
+
+private:
+    /// the largest item: a tag, a 10 byte varint and an instruction word
+    static constexpr usize max_item_size = 1 + 10 + 4;
+
+    std::unique_ptr<detail::trace_writer> m_writer{};
+    std::vector<u8> m_buffer{};
+    usize m_used = 0;
+
+    u64 m_next_pc = 0;
+    u64 m_last_address = 0;
+    std::array<u64, 32> m_register_values{};
+
+    void submit() {
+        m_buffer.resize(m_used);
+        m_writer->submit(std::move(m_buffer));
+        m_used = 0;
+    }
+
+    /// makes sure that an item fits into the buffer, items are written through a raw pointer and then `commit`ted
+    void reserve() {
+        if (m_buffer.size() - m_used < max_item_size) [[unlikely]] {
+            submit();
+            m_buffer = m_writer->acquire_buffer();
+        }
+    }
+
+    void commit(u8* end) { m_used = static_cast<usize>(end - m_buffer.data()); }
+};
+
+struct trace_record {
+    struct register_write {
+        reg destination;
+        u64 value;
+
+        constexpr auto operator==(register_write const&) const -> bool = default;
+    };
+
+    struct memory_access {
+        u64 address;
+        u8 size;
+        memory_access_type type;
+
+        constexpr auto operator==(memory_access const&) const -> bool = default;
+    };
+
+    u64 program_counter;
+    u32 instruction_word;
+
+    std::vector<register_write> register_writes;
+    std::vector<memory_access> memory_accesses;
+
+    auto operator==(trace_record const&) const -> bool = default;
+};
+
+/// Streams records out of a trace.
+struct trace_reader {
+    static auto open(std::istream& is) -> stf::expected<trace_reader, std::string_view> {
+        auto magic = std::array<u8, 8>{};
+        is.read(reinterpret_cast<char*>(magic.data()), magic.size());
+
+        if (!is || magic != detail::trace_magic) {
+            return stf::unexpected{"not a trace or a trace of a different version"};
+        }
+
+        return trace_reader(*is.rdbuf());
+    }
+
+    /// The next record, or nothing at the end of the trace or if the trace is malformed (see `error`).
+    auto next() -> std::optional<trace_record> {
+        if (m_error) {
+            return std::nullopt;
+        }
+
+        auto tag = m_buffer.sgetc();
+        if (tag == std::char_traits<char>::eof()) {
+            return std::nullopt;
+        }
+
+        if ((static_cast<u8>(tag) & 0b1100'0000) != detail::trace_tag_instruction) {
+            m_error = "trace doesn't start at an instruction";
+            return std::nullopt;
+        }
+
+        m_buffer.sbumpc();
+
+        const auto compressed = (static_cast<u8>(tag) & 1) != 0;
+        auto ret = trace_record{};
+
+        const auto pc_delta = read_varint();
+        ret.program_counter = m_next_pc + detail::zigzag_decode(pc_delta.value_or(0));
+        ret.instruction_word = 0;
+        for (usize i = 0; i < (compressed ? 2uz : 4uz); i++) {
+            ret.instruction_word |= static_cast<u32>(read_byte().value_or(0)) << (i * 8);
+        }
+
+        m_next_pc = ret.program_counter + (compressed ? 2 : 4);
+
+        while ((tag = m_buffer.sgetc()) != std::char_traits<char>::eof()) {
+            const auto byte = static_cast<u8>(tag);
+
+            if ((byte & 0b1110'0000) == detail::trace_tag_register_write) {
+                m_buffer.sbumpc();
+
+                auto& last = m_register_values[byte & 0b1'1111];
+                last += detail::zigzag_decode(read_varint().value_or(0));
+                ret.register_writes.emplace_back(static_cast<reg>(byte & 0b1'1111), last);
+            } else if ((byte & 0b1111'1000) == detail::trace_tag_memory_access) {
+                m_buffer.sbumpc();
+
+                m_last_address += detail::zigzag_decode(read_varint().value_or(0));
+                const auto type = (byte & 0b100) != 0 ? memory_access_type::write : memory_access_type::read;
+                ret.memory_accesses.emplace_back(m_last_address, static_cast<u8>(1u << (byte & 0b11)), type);
+            } else {
+                break;
+            }
+        }
+
+        if (m_error) {
+            return std::nullopt;
+        }
+
+        ++m_index;
+        return ret;
+    }
+
+    /// The index the next record will have.
+    auto index() const -> u64 { return m_index; }
+
+    auto error() const -> std::optional<std::string_view> { return m_error; }
+
+private:
+    explicit trace_reader(std::streambuf& buffer)
+        : m_buffer(buffer) {}
+
+    std::streambuf& m_buffer;
+
+    u64 m_index = 0;
+    u64 m_next_pc = 0;
+    u64 m_last_address = 0;
+    std::array<u64, 32> m_register_values{};
+
+    std::optional<std::string_view> m_error{};
+
+    auto read_byte() -> std::optional<u8> {
+        const auto c = m_buffer.sbumpc();
+        if (c == std::char_traits<char>::eof()) {
+            m_error = "trace ends in the middle of a record";
+            return std::nullopt;
+        }
+
+        return static_cast<u8>(c);
+    }
+
+    auto read_varint() -> std::optional<u64> {
+        u64 ret = 0;
+
+        for (u32 shift = 0; shift < 64; shift += 7) {
+            const auto byte = read_byte();
+            if (!byte) {
+                return std::nullopt;
+            }
+
+            ret |= static_cast<u64>(*byte & 0x7F) << shift;
+
+            if ((*byte & 0x80) == 0) {
+                return ret;
+            }
+        }
+
+        m_error = "overlong varint";
+        return std::nullopt;
+    }
+};
+
+/// The first record satisfying `predicate` along with its index.
+template<typename Predicate>
+auto trace_find(trace_reader& reader, Predicate&& predicate) -> std::optional<std::pair<u64, trace_record>> {
+    for (;;) {
+        const auto index = reader.index();
+        auto record = reader.next();
+
+        if (!record) {
+            return std::nullopt;
+        }
+
+        if (std::invoke(predicate, *record)) {
+            return std::pair{index, std::move(*record)};
+        }
+    }
+}
+
+struct trace_divergence {
+    u64 index;
+    /// either is empty if its trace ended before the other one
+    std::optional<trace_record> lhs;
+    std::optional<trace_record> rhs;
+};
+
+/// The first record at which two traces differ, nothing if they are identical.
+inline auto trace_first_divergence(trace_reader& lhs, trace_reader& rhs) -> std::optional<trace_divergence> {
+    for (;;) {
+        const auto index = lhs.index();
+        auto lhs_record = lhs.next();
+        auto rhs_record = rhs.next();
+
+        if (!lhs_record && !rhs_record) {
+            return std::nullopt;
+        }
+
+        if (lhs_record != rhs_record) {
+            return trace_divergence{index, std::move(lhs_record), std::move(rhs_record)};
+        }
+    }
+}
+
+}  // namespace rv
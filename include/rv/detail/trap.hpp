@@ -0,0 +1,217 @@
+#pragma once
+
+#include <rv/detail/csr.hpp>
+
+#include <stuff/core.hpp>
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <limits>
+#include <optional>
+
+namespace rv {
+
+/// The exception codes of `mcause`, interrupts have the top bit of the register set on top of theirs.
+namespace trap_cause {
+
+inline constexpr u64 instruction_address_misaligned = 0;
+inline constexpr u64 illegal_instruction = 2;
+inline constexpr u64 breakpoint = 3;
+inline constexpr u64 environment_call_from_m = 11;
+
+inline constexpr u64 machine_software_interrupt = 3;
+inline constexpr u64 machine_timer_interrupt = 7;
+inline constexpr u64 machine_external_interrupt = 11;
+
+}  // namespace trap_cause
+
+/// The bits of `mip` and `mie` for the interrupts, the bit of an interrupt is its exception code.
+namespace interrupt_bit {
+
+inline constexpr u64 machine_software = u64(1) << trap_cause::machine_software_interrupt;
+inline constexpr u64 machine_timer = u64(1) << trap_cause::machine_timer_interrupt;
+inline constexpr u64 machine_external = u64(1) << trap_cause::machine_external_interrupt;
+
+inline constexpr u64 machine = machine_software | machine_timer | machine_external;
+
+}  // namespace interrupt_bit
+
+/// What needs looking at once enough instructions retired, see `event_queue`.
+enum class event_source : usize {
+    /// the CLINT's timer, at the point where `mtime` reaches `mtimecmp` or where it has to look at the host's clock again
+    timer,
+    /// something changed what interrupts are pending or enabled (a write to `msip`, `mie` or `mstatus`, an `mret`)
+    interrupts,
+    /// where `risc_v::run` has to return
+    run_limit,
+};
+
+/// The deadlines of the event sources in retired instructions. There are only a handful of sources and each has at most one deadline, so
+/// the queue is a deadline per source along with the earliest of them, which is the only thing the interpreter compares against.
+struct event_queue {
+    static constexpr u64 never = std::numeric_limits<u64>::max();
+    static constexpr usize num_sources = 3;
+
+    /// Replaces the deadline of `source`.
+    constexpr void schedule(event_source source, u64 deadline) {
+        m_deadlines[static_cast<usize>(source)] = deadline;
+        m_next = std::ranges::min(m_deadlines);
+    }
+
+    constexpr void cancel(event_source source) {
+        m_deadlines[static_cast<usize>(source)] = never;
+        m_next = std::ranges::min(m_deadlines);
+    }
+
+    /// the earliest deadline, `never` without any
+    constexpr auto next() const -> u64 { return m_next; }
+
+    constexpr auto deadline(event_source source) const -> u64 { return m_deadlines[static_cast<usize>(source)]; }
+
+    /// Removes the sources due at `now` and calls `fn(source)` for each of them, they can get scheduled again from within `fn`.
+    template<typename Fn>
+    constexpr void pop_due(u64 now, Fn&& fn) {
+        std::array<bool, num_sources> due{};
+        for (usize i = 0; i < num_sources; i++) {
+            due[i] = m_deadlines[i] <= now;
+            if (due[i]) {
+                m_deadlines[i] = never;
+            }
+        }
+
+        m_next = std::ranges::min(m_deadlines);
+
+        for (usize i = 0; i < num_sources; i++) {
+            if (due[i]) {
+                std::invoke(fn, static_cast<event_source>(i));
+            }
+        }
+    }
+
+private:
+    std::array<u64, num_sources> m_deadlines{never, never, never};
+    u64 m_next = never;
+};
+
+/// The machine mode trap CSRs and what happens to them when a trap is taken or returned from.
+/// Only machine mode is implemented: `mstatus.MPP` is always M, and the CLINT's (or an interrupt controller's) lines are the only ones in
+/// `mip`, which makes it read-only.
+template<typename RegisterType>
+struct trap_state {
+    using register_type = RegisterType;
+
+    static constexpr register_type interrupt_flag = register_type(1) << (sizeof(register_type) * 8 - 1);
+
+    static constexpr u64 status_mie = u64(1) << 3;
+    static constexpr u64 status_mpie = u64(1) << 7;
+    static constexpr u64 status_mpp = u64(0b11) << 11;
+
+    static constexpr auto is_csr(u32 address) -> bool {
+        switch (address) {
+            case csr_address::mstatus: [[fallthrough]];
+            case csr_address::mie: [[fallthrough]];
+            case csr_address::mtvec: [[fallthrough]];
+            case csr_address::mscratch: [[fallthrough]];
+            case csr_address::mepc: [[fallthrough]];
+            case csr_address::mcause: [[fallthrough]];
+            case csr_address::mtval: [[fallthrough]];
+            case csr_address::mip: [[fallthrough]];
+            case csr_address::mhartid: return true;
+            default: return false;
+        }
+    }
+
+    constexpr auto read_csr(u32 address) const -> std::optional<register_type> {
+        switch (address) {
+            // the previous privilege is always M
+            case csr_address::mstatus: return static_cast<register_type>(m_status | status_mpp);
+            case csr_address::mie: return static_cast<register_type>(m_enabled);
+            case csr_address::mtvec: return m_vector;
+            case csr_address::mscratch: return m_scratch;
+            case csr_address::mepc: return m_exception_pc;
+            case csr_address::mcause: return m_cause;
+            case csr_address::mtval: return m_value;
+            case csr_address::mip: return static_cast<register_type>(m_pending);
+            case csr_address::mhartid: return 0;
+            default: return std::nullopt;
+        }
+    }
+
+    /// `mhartid` is read-only. The bits of `mip` are too, writes to it are legal but change nothing.
+    constexpr auto write_csr(u32 address, register_type value) -> bool {
+        switch (address) {
+            case csr_address::mstatus: m_status = static_cast<u64>(value) & (status_mie | status_mpie); return true;
+            case csr_address::mie: m_enabled = static_cast<u64>(value) & interrupt_bit::machine; return true;
+            // the reserved modes are taken to be direct mode
+            case csr_address::mtvec: m_vector = (value & 0b11) > 1 ? value & ~register_type(0b11) : value; return true;
+            case csr_address::mscratch: m_scratch = value; return true;
+            // instructions are two byte aligned with the C extension
+            case csr_address::mepc: m_exception_pc = value & ~register_type(1); return true;
+            case csr_address::mcause: m_cause = value; return true;
+            case csr_address::mtval: m_value = value; return true;
+            // MSIP and MTIP follow the CLINT and MEIP an interrupt controller, without S-mode nothing in `mip` is writable
+            case csr_address::mip: return true;
+            default: return false;
+        }
+    }
+
+    /// Sets the bits of `mip` that are in `lines` to what they are in `levels`.
+    constexpr void set_pending(u64 lines, u64 levels) { m_pending = (m_pending & ~lines) | (levels & lines); }
+
+    /// The cause of the interrupt to take, if any is pending, enabled and not masked by `mstatus.MIE`.
+    /// Simultaneous interrupts are taken external first, then software, then timer.
+    constexpr auto pending_interrupt() const -> std::optional<register_type> {
+        const auto pending = m_pending & m_enabled;
+        if ((m_status & status_mie) == 0 || pending == 0) [[likely]] {
+            return std::nullopt;
+        }
+
+        for (const auto cause : {trap_cause::machine_external_interrupt, trap_cause::machine_software_interrupt, trap_cause::machine_timer_interrupt}) {
+            if ((pending >> cause) & 1) {
+                return static_cast<register_type>(cause) | interrupt_flag;
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    /// Takes a trap from `program_counter`, returns where the handler is.
+    /// Interrupts go to `BASE + 4 * cause` in vectored mode, exceptions always go to `BASE`.
+    constexpr auto enter(register_type program_counter, register_type cause, register_type value) -> register_type {
+        ++m_taken;
+        m_exception_pc = program_counter;
+        m_cause = cause;
+        m_value = value;
+
+        m_status = (m_status & status_mie) != 0 ? status_mpie : 0;
+
+        const auto base = m_vector & ~register_type(0b11);
+        const auto vectored = (m_vector & 1) != 0 && (cause & interrupt_flag) != 0;
+
+        return vectored ? base + 4 * (cause & ~interrupt_flag) : base;
+    }
+
+    /// `mret`, returns where to return to.
+    constexpr auto leave() -> register_type {
+        m_status = status_mpie | ((m_status & status_mpie) != 0 ? status_mie : 0);
+        return m_exception_pc;
+    }
+
+    /// The amount of traps taken since the reset, for telling whether one got taken in between.
+    constexpr auto taken() const -> u64 { return m_taken; }
+
+private:
+    /// `MIE` and `MPIE`
+    u64 m_status = 0;
+    u64 m_enabled = 0;
+    u64 m_pending = 0;
+    register_type m_vector = 0;
+    register_type m_scratch = 0;
+    register_type m_exception_pc = 0;
+    register_type m_cause = 0;
+    register_type m_value = 0;
+    u64 m_taken = 0;
+};
+
+}  // namespace rv
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <rv/detail/memory.hpp>
+#include <rv/detail/ring_buffer.hpp>
+
+#include <stuff/core.hpp>
+
+#include <atomic>
+#include <optional>
+
+namespace rv {
+
+/// A 16550-style UART with its registers a byte apart.
+///
+/// What the guest transmits goes into a ring that another thread drains and what it receives comes out of a ring that the other thread
+/// fills, neither side ever waits for the other. A full transmit ring shows up as a busy transmitter, so guests that poll the line status
+/// before writing (like the usual newlib `_write` does) spin in the guest until there is room instead of losing output. There are no
+/// interrupts and the FIFO and the divisor latch are only there for drivers to write to.
+struct uart final : mmio_device {
+    static constexpr usize register_span = 8;
+
+    explicit uart(usize capacity = 4096)
+        : m_transmitted(capacity)
+        , m_received(capacity) {}
+
+    /*
+     * guest side, the thread running the processor
+     */
+
+    auto load(u64 offset, usize) -> u64 override {
+        switch (offset) {
+            case 0: {
+                if (divisor_latch_access()) {
+                    return m_divisor & 0xFF;
+                }
+
+                return m_received.try_pop().value_or(0);
+            }
+            case 1: return divisor_latch_access() ? m_divisor >> 8 : m_interrupt_enable;
+            // no interrupt pending, with the FIFO bits mirroring the FIFO control register
+            case 2: return (m_fifo_control & 1) != 0 ? 0xC1 : 0x01;
+            case 3: return m_line_control;
+            case 4: return m_modem_control;
+            case 5: {
+                u8 ret = 0;
+                if (m_received.size() != 0) {
+                    ret |= line_status_data_ready;
+                }
+                if (m_transmitted.size() < m_transmitted.capacity()) {
+                    ret |= line_status_transmitter_empty;
+                }
+                return ret;
+            }
+            // clear to send, data set ready and carrier detect
+            case 6: return 0xB0;
+            case 7: return m_scratch;
+            default: return 0;
+        }
+    }
+
+    void store(u64 offset, usize, u64 value) override {
+        const auto byte = static_cast<u8>(value);
+
+        switch (offset) {
+            case 0: {
+                if (divisor_latch_access()) {
+                    m_divisor = (m_divisor & 0xFF00) | byte;
+                } else if (!m_transmitted.try_push(byte)) {
+                    m_dropped.fetch_add(1, std::memory_order_relaxed);
+                }
+                break;
+            }
+            case 1: {
+                if (divisor_latch_access()) {
+                    m_divisor = (m_divisor & 0x00FF) | static_cast<u16>(byte << 8);
+                } else {
+                    m_interrupt_enable = byte & 0x0F;
+                }
+                break;
+            }
+            case 2: m_fifo_control = byte; break;
+            case 3: m_line_control = byte; break;
+            case 4: m_modem_control = byte & 0x1F; break;
+            case 7: m_scratch = byte; break;
+            default: break;
+        }
+    }
+
+    /*
+     * host side, e.g. a terminal on the GUI thread
+     */
+
+    /// the next byte the guest transmitted, if there is one
+    auto read_transmitted() -> std::optional<u8> { return m_transmitted.try_pop(); }
+
+    /// Hands a byte to the guest, returns false if the guest hasn't read enough of the previous ones for it to fit.
+    auto write_received(u8 byte) -> bool {
+        if (!m_received.try_push(byte)) {
+            return false;
+        }
+
+        m_had_input.store(true, std::memory_order_relaxed);
+        return true;
+    }
+
+    /// the bytes the guest wrote while the transmit ring was full, only guests that don't look at the line status lose any
+    auto dropped() const -> u64 { return m_dropped.load(std::memory_order_relaxed); }
+
+    /// What the guest receives isn't recorded, executing the same loads again after the host handed it anything might not see the same.
+    auto deterministic() const -> bool override { return !m_had_input.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr u8 line_status_data_ready = 0x01;
+    /// THRE and TEMT, the transmitter holding register and the shift register being empty
+    static constexpr u8 line_status_transmitter_empty = 0x60;
+
+    detail::spsc_ring<u8> m_transmitted;
+    detail::spsc_ring<u8> m_received;
+    std::atomic<u64> m_dropped{0};
+    std::atomic<bool> m_had_input{false};
+
+    u16 m_divisor = 1;
+    u8 m_interrupt_enable = 0;
+    u8 m_fifo_control = 0;
+    u8 m_line_control = 0x03;
+    u8 m_modem_control = 0;
+    u8 m_scratch = 0;
+
+    constexpr auto divisor_latch_access() const -> bool { return (m_line_control & 0x80) != 0; }
+};
+
+}  // namespace rv
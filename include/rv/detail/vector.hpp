@@ -0,0 +1,276 @@
+#pragma once
+
+#include <rv/detail/csr.hpp>
+
+#include <stuff/core.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+
+namespace rv {
+
+/// The largest VLEN a `vector_register_file` can be set up with, every processor carries storage for 32 registers of this many bits.
+inline constexpr usize max_vlen = 1024;
+
+/// ELEN, the widest element the vector instructions work on.
+inline constexpr usize max_element_bits = 64;
+
+/// A decoded `vtype`. SEW is `8 << sew_shift` bits and LMUL is `2^lmul_shift` registers.
+struct vector_type {
+    u32 sew_shift = 0;
+    i32 lmul_shift = 0;
+    bool tail_agnostic = false;
+    bool mask_agnostic = false;
+    /// `vill`, set for encodings that aren't supported (reserved SEWs and LMULs, fractional LMULs too small for SEW)
+    bool illegal = true;
+
+    static constexpr auto from_bits(u64 bits) -> vector_type {
+        const auto vlmul = static_cast<u32>(bits & 0b111);
+        const auto vsew = static_cast<u32>((bits >> 3) & 0b111);
+
+        auto ret = vector_type{
+          .sew_shift = vsew,
+          .lmul_shift = vlmul < 4 ? static_cast<i32>(vlmul) : static_cast<i32>(vlmul) - 8,
+          .tail_agnostic = ((bits >> 6) & 1) != 0,
+          .mask_agnostic = ((bits >> 7) & 1) != 0,
+          .illegal = false,
+        };
+
+        // SEW has to fit into LMUL * ELEN for fractional LMULs
+        const auto fits = static_cast<i32>(vsew) <= std::countr_zero(max_element_bits / 8) + std::min(ret.lmul_shift, 0);
+        if ((bits >> 8) != 0 || vsew > 3 || vlmul == 4 || !fits) {
+            return vector_type{};
+        }
+
+        return ret;
+    }
+
+    template<std::unsigned_integral T>
+    constexpr auto bits() const -> T {
+        if (illegal) {
+            return T(1) << (std::numeric_limits<T>::digits - 1);
+        }
+
+        const auto vlmul = static_cast<u32>(lmul_shift) & 0b111;
+        return static_cast<T>(vlmul | (sew_shift << 3) | (static_cast<u32>(tail_agnostic) << 6) | (static_cast<u32>(mask_agnostic) << 7));
+    }
+
+    constexpr auto sew() const -> usize { return 8uz << sew_shift; }
+};
+
+static_assert(vector_type::from_bits(0b1101'0000).bits<u64>() == 0b1101'0000);
+static_assert(vector_type::from_bits(0b0001'0101).illegal);  // e32, mf8
+static_assert(vector_type::from_bits(0b0000'0100).illegal);  // reserved LMUL
+
+/// The state of the vector unit: the 32 vector registers along with `vl`, `vtype` and the rest of the vector CSRs.
+///
+/// Registers are kept as bytes and the instructions work on the elements in place, the registers of a group come one after the other so
+/// that a group is a single array of elements. Element `i` of a group of `T`s is at `i * sizeof(T)` like it is on a little endian host.
+struct vector_register_file {
+    /// VLEN has to be a power of two between ELEN and `max_vlen`.
+    constexpr explicit vector_register_file(usize vlen = 128)
+        : m_vlen(vlen) {
+        if (!std::has_single_bit(vlen) || vlen < max_element_bits || vlen > max_vlen) {
+            throw std::runtime_error("VLEN has to be a power of two between ELEN and max_vlen");
+        }
+    }
+
+    /// what the vector state is after a reset, VLEN stays as it is
+    constexpr void reset() { *this = vector_register_file(m_vlen); }
+
+    constexpr auto vlen() const -> usize { return m_vlen; }
+    constexpr auto vlenb() const -> usize { return m_vlen / 8; }
+
+    constexpr auto vl() const -> usize { return m_vl; }
+    constexpr auto type() const -> vector_type { return m_type; }
+
+    constexpr auto vstart() const -> usize { return m_vstart; }
+    constexpr void set_vstart(usize vstart) { m_vstart = vstart; }
+
+    /// VLMAX for `type`, zero for illegal types
+    constexpr auto max_length(vector_type type) const -> usize {
+        if (type.illegal) {
+            return 0;
+        }
+
+        const auto per_register = m_vlen >> (type.sew_shift + 3);
+        return type.lmul_shift >= 0 ? per_register << type.lmul_shift : per_register >> -type.lmul_shift;
+    }
+
+    /// What `vsetvl` and friends do, returns the new `vl`. Requests for more than VLMAX elements get VLMAX.
+    constexpr auto configure(u64 avl, vector_type type) -> usize {
+        m_type = type;
+        m_vl = static_cast<usize>(std::min<u64>(avl, max_length(type)));
+        m_vstart = 0;
+        return m_vl;
+    }
+
+    /// Whether a group of `2^emul_shift` registers can start at `reg`: EMUL has to be between 1/8 and 8 and groups of more than one
+    /// register have to start at a multiple of their size.
+    static constexpr auto group_is_legal(u32 reg, i32 emul_shift) -> bool {
+        if (emul_shift < -3 || emul_shift > 3) {
+            return false;
+        }
+
+        return emul_shift <= 0 || reg % (1u << emul_shift) == 0;
+    }
+
+    /// The elements of the register group starting at `reg`, see `group_is_legal`.
+    template<std::unsigned_integral T>
+    auto group(u32 reg) -> T* {
+        return reinterpret_cast<T*>(m_registers.data() + reg * vlenb());
+    }
+
+    template<std::unsigned_integral T>
+    auto group(u32 reg) const -> T const* {
+        return reinterpret_cast<T const*>(m_registers.data() + reg * vlenb());
+    }
+
+    /// `v0`, which masks the masked instructions with one bit per element
+    auto mask() const -> u8 const* { return m_registers.data(); }
+
+    static constexpr auto is_csr(u32 address) -> bool {
+        switch (address) {
+            case csr_address::vstart: [[fallthrough]];
+            case csr_address::vxsat: [[fallthrough]];
+            case csr_address::vxrm: [[fallthrough]];
+            case csr_address::vcsr: [[fallthrough]];
+            case csr_address::vl: [[fallthrough]];
+            case csr_address::vtype: [[fallthrough]];
+            case csr_address::vlenb: return true;
+            default: return false;
+        }
+    }
+
+    template<std::unsigned_integral T>
+    constexpr auto read_csr(u32 address) const -> std::optional<T> {
+        switch (address) {
+            case csr_address::vstart: return static_cast<T>(m_vstart);
+            case csr_address::vxsat: return static_cast<T>(m_fixed_point & 1);
+            case csr_address::vxrm: return static_cast<T>(m_fixed_point >> 1);
+            case csr_address::vcsr: return static_cast<T>(m_fixed_point);
+            case csr_address::vl: return static_cast<T>(m_vl);
+            case csr_address::vtype: return m_type.bits<T>();
+            case csr_address::vlenb: return static_cast<T>(vlenb());
+            default: return std::nullopt;
+        }
+    }
+
+    /// `vl`, `vtype` and `vlenb` are read-only, they only change through `vsetvl` and friends.
+    template<std::unsigned_integral T>
+    constexpr auto write_csr(u32 address, T value) -> bool {
+        switch (address) {
+            // vstart only has to be able to hold the largest element index
+            case csr_address::vstart: m_vstart = static_cast<usize>(value) & (max_vlen - 1); return true;
+            case csr_address::vxsat: m_fixed_point = (m_fixed_point & ~u32(1)) | (static_cast<u32>(value) & 1); return true;
+            case csr_address::vxrm: m_fixed_point = (m_fixed_point & 1) | ((static_cast<u32>(value) & 0b11) << 1); return true;
+            case csr_address::vcsr: m_fixed_point = static_cast<u32>(value) & 0b111; return true;
+            default: return false;
+        }
+    }
+
+private:
+    usize m_vlen;
+    usize m_vl = 0;
+    usize m_vstart = 0;
+    vector_type m_type{};
+    /// `vcsr`, `vxrm` in bits 2:1 and `vxsat` in bit 0
+    u32 m_fixed_point = 0;
+
+    alignas(64) std::array<u8, 32 * max_vlen / 8> m_registers{};
+};
+
+namespace detail {
+
+/// Calls `fn.template operator()<T>()` with `T` being the unsigned integer that is SEW bits wide.
+template<typename Fn>
+constexpr void vector_dispatch(vector_type type, Fn&& fn) {
+    switch (type.sew_shift) {
+        case 0: return fn.template operator()<u8>();
+        case 1: return fn.template operator()<u16>();
+        case 2: return fn.template operator()<u32>();
+        default: return fn.template operator()<u64>();
+    }
+}
+
+constexpr auto vector_mask_bit(u8 const* mask, usize i) -> bool { return ((mask[i / 8] >> (i % 8)) & 1) != 0; }
+
+template<typename T, typename Rhs>
+constexpr auto vector_operand(Rhs rhs, usize i) -> T {
+    if constexpr (std::is_pointer_v<Rhs>) {
+        return rhs[i];
+    } else {
+        return rhs;
+    }
+}
+
+/*
+ * The loops below are what the vector instructions spend their time in. The unmasked ones are plain loops over arrays with nothing to
+ * keep the host compiler from vectorizing them, masked elements are blended in rather than branched around for the same reason.
+ * `Rhs` is either a pointer to a register group or a scalar that all elements get.
+ */
+
+/// `vd[i] = fn(vd[i], vs2[i], rhs[i])` for the active elements in [`start`, `end`), `mask` is null for unmasked instructions
+template<typename T, typename Rhs, typename Fn>
+void vector_map(T* vd, T const* vs2, Rhs rhs, usize start, usize end, u8 const* mask, Fn&& fn) {
+    if (mask == nullptr) {
+        for (auto i = start; i < end; i++) {
+            vd[i] = fn(vd[i], vs2[i], vector_operand<T>(rhs, i));
+        }
+        return;
+    }
+
+    for (auto i = start; i < end; i++) {
+        const auto result = fn(vd[i], vs2[i], vector_operand<T>(rhs, i));
+        vd[i] = vector_mask_bit(mask, i) ? result : vd[i];
+    }
+}
+
+/// Sets bit `i` of the mask `vd` to `pred(vs2[i], rhs[i])` for the active elements in [`start`, `end`). The bits are put together a byte
+/// at a time, which also makes `vd` overlapping the first register of `vs2` work out.
+template<typename T, typename Rhs, typename Pred>
+void vector_compare(u8* vd, T const* vs2, Rhs rhs, usize start, usize end, u8 const* mask, Pred&& pred) {
+    for (auto i = start; i < end;) {
+        const auto byte = i / 8;
+        const auto byte_end = std::min(end, (byte + 1) * 8);
+
+        auto touched = u8(0);
+        auto result = u8(0);
+        for (; i < byte_end; i++) {
+            const auto bit = static_cast<u8>(1u << (i % 8));
+            const auto active = mask == nullptr || (mask[byte] & bit) != 0;
+            touched |= active ? bit : 0;
+            result |= active && pred(vs2[i], vector_operand<T>(rhs, i)) ? bit : 0;
+        }
+
+        vd[byte] = static_cast<u8>((vd[byte] & ~touched) | result);
+    }
+}
+
+/// Folds the active elements of `vs2` in [0, `end`) into `init`.
+template<typename T, typename Fn>
+auto vector_reduce(T init, T const* vs2, usize end, u8 const* mask, Fn&& fn) -> T {
+    auto accumulator = init;
+
+    if (mask == nullptr) {
+        for (usize i = 0; i < end; i++) {
+            accumulator = fn(accumulator, vs2[i]);
+        }
+        return accumulator;
+    }
+
+    for (usize i = 0; i < end; i++) {
+        accumulator = vector_mask_bit(mask, i) ? fn(accumulator, vs2[i]) : accumulator;
+    }
+    return accumulator;
+}
+
+}  // namespace detail
+
+}  // namespace rv
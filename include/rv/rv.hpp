@@ -2,3 +2,16 @@
 
 #include <rv/detail/rv.hpp>
 #include <rv/detail/rv.ipp>
+#include <rv/detail/branch_prediction.hpp>
+#include <rv/detail/clint.hpp>
+#include <rv/detail/disassembler.hpp>
+#include <rv/detail/framebuffer.hpp>
+#include <rv/detail/gdb_stub.hpp>
+#include <rv/detail/instruction_listing.hpp>
+#include <rv/detail/memory_snapshot.hpp>
+#include <rv/detail/profiler.hpp>
+#include <rv/detail/statistics.hpp>
+#include <rv/detail/time_travel.hpp>
+#include <rv/detail/timing.hpp>
+#include <rv/detail/trace.hpp>
+#include <rv/detail/uart.hpp>
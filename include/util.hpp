@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stuff/core.hpp>
+
+#include <atomic>
+#include <cstring>
+
+namespace util {
+
+/// A single-writer sequence lock for small, trivially copyable values.
+/// The payload is kept in relaxed atomic words so that a reader racing with the writer never touches a non-atomic object, a torn read is
+/// detected through the sequence number and retried.
+template<typename T>
+    requires(std::is_trivially_copyable_v<T> && std::is_default_constructible_v<T>)
+struct seqlock {
+    seqlock() { store(T{}); }
+    explicit seqlock(T const& value) { store(value); }
+
+    void store(T const& value) {
+        const auto sequence = m_sequence.load(std::memory_order_relaxed);
+        m_sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        word_array words{};
+        std::memcpy(words.data(), &value, sizeof(T));
+        for (usize i = 0; i < num_words; i++) {
+            m_words[i].store(words[i], std::memory_order_relaxed);
+        }
+
+        m_sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    auto load() const -> T {
+        for (word_array words;;) {
+            const auto sequence_0 = m_sequence.load(std::memory_order_acquire);
+            if ((sequence_0 & 1) != 0) {
+                continue;
+            }
+
+            for (usize i = 0; i < num_words; i++) {
+                words[i] = m_words[i].load(std::memory_order_relaxed);
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (m_sequence.load(std::memory_order_relaxed) != sequence_0) {
+                continue;
+            }
+
+            auto ret = T{};
+            std::memcpy(&ret, words.data(), sizeof(T));
+            return ret;
+        }
+    }
+
+private:
+    static constexpr usize num_words = (sizeof(T) + sizeof(u64) - 1) / sizeof(u64);
+    using word_array = std::array<u64, num_words>;
+
+    std::atomic<u64> m_sequence{0};
+    std::array<std::atomic<u64>, num_words> m_words{};
+};
+
+}  // namespace util
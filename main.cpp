@@ -1,13 +1,13 @@
 #include <rv/detail/definitions.hpp>
 #include <rv/rv.hpp>
 
+#include <histogram.hpp>
 #include <imgui.hpp>
 #include <util.hpp>
 
 #include <stuff/bit.hpp>
 #include <stuff/core.hpp>
 #include <stuff/random.hpp>
-#include <stuff/thread/channel.hpp>
 
 #include <fmt/format.h>
 #include <imgui-SFML.h>
@@ -15,89 +15,65 @@
 #include <imgui_memory_editor/imgui_memory_editor.h>
 #include <SFML/Graphics.hpp>
 
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <cmath>
+#include <fstream>
 #include <functional>
+#include <optional>
 #include <random>
+#include <ranges>
+#include <span>
+#include <string>
 #include <string_view>
-
-template<std::floating_point T>
-struct averager {
-    constexpr averager(usize window_size)
-        : m_data(window_size) {}
-
-    constexpr auto average() const -> T {
-        if (!m_average_invalid) {
-            return m_average_cache;
-        }
-
-        m_average_invalid = false;
-        const auto avg = std::reduce(m_data.begin(), m_data.end(), T(0)) / static_cast<T>(m_data.size());
-        return m_average_cache = avg;
-    }
-
-    constexpr auto stdev() const -> T {
-        if (!m_stdev_invalid) {
-            return m_stdev_cache;
-        }
-
-        m_stdev_invalid = false;
-
-        const auto sum = std::accumulate(m_data.begin(), m_data.end(), T(0), [this](T accumulator, T val) {
-            const auto temp = val - average();
-            return accumulator + temp * temp;
-        });
-
-        return m_stdev_cache = std::sqrt(sum / static_cast<T>(m_data.size()));
-    }
-
-    constexpr auto below_z_score(T z) const -> T {
-        const auto at_most = average() + stdev() * z;
-
-        usize count = 0;
-        const auto sum = std::accumulate(m_data.begin(), m_data.end(), T(0), [at_most, &count](T accumulator, T val) {
-            if (val > at_most) {
-                return accumulator;
-            }
-
-            ++count;
-            return accumulator + val;
-        });
-
-        if (count == 0) {
-            return 0;
-        }
-
-        return sum / static_cast<T>(count);
-    }
-
-    constexpr auto percentile_95() const -> T { return below_z_score((T)-1.6449); }
-
-    constexpr auto percentile_99() const -> T { return below_z_score((T)-2.3263); }
-
-    constexpr auto add_sample(T v) {
-        m_average_invalid = true;
-        m_stdev_invalid = true;
-
-        m_data[m_data_ptr++ % m_data.size()] = v;
-    }
-
-private:
-    std::vector<T> m_data;
-
-    mutable bool m_average_invalid = true;
-    mutable T m_average_cache;
-
-    mutable bool m_stdev_invalid = true;
-    mutable T m_stdev_cache;
-
-    usize m_data_ptr = 0;
-};
+#include <vector>
+
+using processor_observer = rv::observer_list<
+#ifdef RV_TIMING
+  // ahead of the profiler so that the cycles it samples by include the current instruction
+  rv::timing_observer,
+#endif
+#ifdef RV_EXECUTION_STATISTICS
+  rv::statistics_observer,
+#endif
+#ifdef RV_PROFILER
+  rv::profiler_observer,
+#endif
+#ifdef RV_TRACE
+  rv::trace_observer,
+#endif
+  rv::null_observer>;
+
+using processor_type = rv::risc_v<u64, std::allocator<u8>, processor_observer>;
 
 struct program {
     program()
-        : m_window(sf::VideoMode({1280, 720}), "lorem ipsum")
-        , m_processor_worker_thread([this] { processor_worker(); }) {
+        : m_window(sf::VideoMode({1280, 720}), "lorem ipsum") {
         m_risc_v.load("a.hex", rv::infmt_ihex_tag{}, 0);
+        std::ignore = m_risc_v.m_memory.map_device({uart_address, rv::uart::register_span, &m_uart});
+        std::ignore = m_risc_v.m_memory.map_device({framebuffer_address, rv::framebuffer::register_span, &m_framebuffer});
+        std::ignore = m_risc_v.map_clint(m_clint, clint_address);
+
+#ifdef RV_EXECUTION_STATISTICS
+        m_risc_v.m_observer.get<rv::statistics_observer>() = rv::statistics_observer{m_risc_v.m_isa.num_instructions()};
+#endif
+#ifdef RV_TIMING
+        m_risc_v.m_observer.get<rv::timing_observer>() = rv::timing_observer{rv::timing_config{
+          .instruction_cache = rv::cache_config{},
+          .data_cache = rv::cache_config{},
+          .branch_prediction = rv::branch_prediction_config{},
+        }};
+#endif
+#ifdef RV_PROFILER
+        load_symbols();
+#endif
+#if defined(RV_PROFILER) && defined(RV_TIMING)
+        m_risc_v.m_observer.get<rv::profiler_observer>() = rv::profiler_observer{rv::profiler_config{.mode = rv::sampling_mode::cycle_count}};
+#endif
+#ifdef RV_TRACE
+        m_risc_v.m_observer.get<rv::trace_observer>() = rv::trace_observer{m_trace_stream};
+#endif
 
         m_window.setFramerateLimit(60);
         std::ignore = ImGui::SFML::Init(m_window);
@@ -106,11 +82,31 @@ struct program {
 
         m_memory_editor.Cols = 8;
         m_memory_editor.OptShowDataPreview = true;
+        // what the editor shows is a copy, writes into it would get lost
+        m_memory_editor.ReadOnly = true;
+
+        // the worker publishes the loaded image as soon as it starts, everything has to be set up by then
+        m_processor_worker_thread = std::thread([this] { processor_worker(); });
     }
 
     ~program() {
-        m_request_channel.close();
+        set_control_word(control_quit_bit);
+        // the worker might be waiting for the GUI to take its last publication, pairs with the fence in `publish_processor_state`
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        m_memory_snapshot.take();
         m_processor_worker_thread.join();
+
+#ifdef RV_EXECUTION_STATISTICS
+        dump_execution_statistics();
+#endif
+#ifdef RV_TIMING
+        dump_branch_prediction();
+#endif
+#ifdef RV_PROFILER
+        if (profiler().drain(); profiler().total_samples() != 0) {
+            write_profile();
+        }
+#endif
     }
 
     auto main() -> int {
@@ -123,6 +119,11 @@ struct program {
             }
 
             ImGui::SFML::Update(m_window, frame_delta_clock.restart());
+            update_processor_stats();
+            update_processor_state();
+#ifdef RV_PROFILER
+            profiler().drain();
+#endif
             ImGui::PushFont(m_font);
 
             ImGui::SetNextWindowSize(ImVec2(m_window.getSize().x, m_window.getSize().y));
@@ -137,21 +138,19 @@ struct program {
                 imgui::group([this] {
                     if (ImGui::BeginTabBar("LHSTabBar")) {
                         if (ImGui::BeginTabItem("Control and State")) {
-                            imgui::button("Run", ImVec2(0, 0), [this] { stf::send(m_request_channel, processor_request{.run = true}); });
+                            imgui::button("Run", ImVec2(0, 0), [this] { set_control_word(control_run_bit); });
                             ImGui::SameLine();
-                            imgui::button("Stop", ImVec2(0, 0), [this] { stf::send(m_request_channel, processor_request{.run = false}); });
+                            imgui::button("Stop", ImVec2(0, 0), [this] { set_control_word(0); });
                             ImGui::SameLine();
-                            imgui::button("Step", ImVec2(0, 0), [this] { stf::send(m_request_channel, processor_request{.run = false, .amt_steps = 1}); });
+                            imgui::button("Step", ImVec2(0, 0), [this] { set_control_word(1); });
                             ImGui::SameLine();
                             ImGui::Button("Reset");
 
                             imgui::input_scalar("Amt Steps", m_amt_steps);
                             ImGui::SameLine();
-                            imgui::button("Run For", ImVec2(0, 0), [this] { stf::send(m_request_channel, processor_request{.run = false, .amt_steps = m_amt_steps}); });
+                            imgui::button("Run For", ImVec2(0, 0), [this] { set_control_word(std::min<u64>(m_amt_steps, control_budget_mask)); });
 
-                            imgui::text("Instructions per Second: {:.2f}", m_ips_averager.average());
-                            imgui::text("Instructions per Second (95th): {:.2f}", m_ips_averager.percentile_95());
-                            imgui::text("Instructions per Second (99th): {:.2f}", m_ips_averager.percentile_99());
+                            gui_performance();
 
                             ImGui::BeginTable(
                               "##control_brief_info_table", 2, ImGuiTableFlags_SizingFixedFit | ImGuiTableFlags_BordersV | ImGuiTableFlags_BordersH | ImGuiTableFlags_RowBg
@@ -161,9 +160,9 @@ struct program {
                             ImGui::TableNextColumn();
                             imgui::text("PC");
                             ImGui::TableNextColumn();
-                            imgui::text("{:016X}", m_risc_v.program_counter());
+                            imgui::text("{:016X}", m_processor_state.program_counter);
 
-                            const auto next_instruction_word = m_risc_v.memory().read<u32>(m_risc_v.program_counter());
+                            const auto next_instruction_word = m_memory_snapshot.read<u32>(m_processor_state.program_counter);
 
                             ImGui::TableNextRow();
                             ImGui::TableNextColumn();
@@ -175,13 +174,13 @@ struct program {
                             ImGui::TableNextColumn();
                             imgui::text("next instruction (RV32)");
                             ImGui::TableNextColumn();
-                            imgui::text(rv::is_rv32<rv::risc_v<u32>>.format(next_instruction_word).c_str());
+                            imgui::text(m_disassembly_cache.format(rv::is_rv32<rv::risc_v<u32>>, next_instruction_word));
 
                             ImGui::TableNextRow();
                             ImGui::TableNextColumn();
                             imgui::text("next instruction (RV64)");
                             ImGui::TableNextColumn();
-                            imgui::text(rv::is_rv64<rv::risc_v<u64>>.format(next_instruction_word).c_str());
+                            imgui::text(m_disassembly_cache.format(rv::is_rv64<rv::risc_v<u64>>, next_instruction_word));
 
                             ImGui::EndTable();
 
@@ -195,14 +194,14 @@ struct program {
                                 ImGui::TableNextColumn();
                                 imgui::text("{}({})", rv::register_name<false>(reg_0), rv::register_name<true>(reg_0));
                                 ImGui::TableNextColumn();
-                                imgui::text("{:016X}", m_risc_v.read_register(reg_0));
+                                imgui::text("{:016X}", m_processor_state.registers[i]);
 
                                 const auto reg_1 = static_cast<rv::reg>(i + 16);
 
                                 ImGui::TableNextColumn();
                                 imgui::text("{}({})", rv::register_name<false>(reg_1), rv::register_name<true>(reg_1));
                                 ImGui::TableNextColumn();
-                                imgui::text("{:016X}", m_risc_v.read_register(reg_1));
+                                imgui::text("{:016X}", m_processor_state.registers[i + 16]);
                             }
 
                             ImGui::EndTable();
@@ -210,6 +209,27 @@ struct program {
                             ImGui::EndTabItem();
                         }
 
+#ifdef RV_EXECUTION_STATISTICS
+                        if (ImGui::BeginTabItem("Statistics")) {
+                            gui_statistics_tab();
+                            ImGui::EndTabItem();
+                        }
+#endif
+
+#ifdef RV_TIMING
+                        if (ImGui::BeginTabItem("Timing")) {
+                            gui_timing_tab();
+                            ImGui::EndTabItem();
+                        }
+#endif
+
+#ifdef RV_PROFILER
+                        if (ImGui::BeginTabItem("Profiler")) {
+                            gui_profiler_tab();
+                            ImGui::EndTabItem();
+                        }
+#endif
+
                         if (ImGui::BeginTabItem("Logs")) {
                             imgui::text("NYI");
                             ImGui::EndTabItem();
@@ -220,17 +240,23 @@ struct program {
                 });
 
                 ImGui::TableNextColumn();
-                imgui::text("the TTY will be here");
+                gui_tty();
 
                 ImGui::TableNextColumn();
                 imgui::group([this] {
                     if (ImGui::BeginTabBar("RHSTabBar")) {
                         if (ImGui::BeginTabItem("Memory Editor")) {
-                            m_memory_editor.DrawContents(m_risc_v.memory().data(), m_risc_v.memory().size());
+                            m_memory_editor.DrawContents(const_cast<u8*>(m_memory_snapshot.data()), m_memory_snapshot.size());
                             ImGui::EndTabItem();
                         }
 
                         if (ImGui::BeginTabItem("Instruction Viewer")) {
+                            gui_instruction_viewer();
+                            ImGui::EndTabItem();
+                        }
+
+                        if (ImGui::BeginTabItem("Framebuffer")) {
+                            gui_framebuffer();
                             ImGui::EndTabItem();
                         }
 
@@ -257,77 +283,560 @@ private:
     ImFont* m_font = nullptr;
     ImFontConfig m_font_config{};
 
-    averager<double> m_ips_averager{4096};
-    rv::risc_v<u64> m_risc_v{rv::is_rv64<rv::risc_v<u64>>, 0x4'0000, {}};
+    // instructions per second are recorded every frame by the GUI, the latencies of slices by the worker as it executes them
+    util::log_histogram<> m_ips_histogram{};
+    util::log_histogram<> m_slice_latency_histogram{};
+    std::atomic<bool> m_slice_latency_reset_requested{false};
+#ifdef RV_TRACE
+    // outlives the processor that writes into it
+    std::ofstream m_trace_stream{"execution.rvtrace", std::ios::binary};
+#endif
+    /// where the guest finds the UART, where QEMU's virt machine has it
+    static constexpr u64 uart_address = 0x1000'0000;
+    /// the TTY forgets the oldest output past this
+    static constexpr usize max_tty_size = 1uz << 20;
+
+    static constexpr u64 framebuffer_address = 0x1000'1000;
+
+    /// where QEMU's virt machine has it too
+    static constexpr u64 clint_address = 0x0200'0000;
+
+    // outlive the processor that they are mapped into
+    rv::uart m_uart{};
+    rv::framebuffer m_framebuffer{};
+    /// the guest's timer keeps up with the wall clock rather than with the (pausable) instruction count
+    rv::clint m_clint{rv::clint_config{.timebase = rv::clint_timebase::host_clock}};
+
+    std::string m_tty{};
+
+    sf::Texture m_framebuffer_texture{};
+    /// what the texture was created for, it is created anew when the guest changes it
+    rv::framebuffer_config m_framebuffer_texture_config{};
+    /// `memory_snapshot::generation` as of the last upload, the rows on pages stamped since get uploaded
+    u64 m_framebuffer_uploaded = 0;
+    std::vector<u8> m_framebuffer_rgba{};
+
+    processor_type m_risc_v{rv::is_rv64<processor_type>, 0x4'0000, {}};
+    // what the GUI looks at instead of the processor, which only the worker touches after it has started
+    rv::memory_snapshot<rv::memory<u64>> m_memory_snapshot{m_risc_v.memory().size()};
     usize m_amt_steps = 0;
     MemoryEditor m_memory_editor{};
+    rv::disassembly_cache m_disassembly_cache{};
+    rv::instruction_listing<processor_type> m_instruction_listing{};
+    bool m_follow_pc = true;
+    u64 m_listing_address = 0;
+    std::optional<u64> m_listing_scrolled_to = std::nullopt;
+
+#ifdef RV_PROFILER
+    std::array<char, 256> m_symbols_path{"a.elf"};
+    std::optional<rv::elf::symbol_table> m_symbols{};
+#endif
+
+    // The control word is the only thing the GUI and the worker share for run control.
+    // The top bit asks the worker to exit, the one below it asks for free-running execution and the rest is a budget of instructions to step.
+    static constexpr u64 control_quit_bit = 1ull << 63;
+    static constexpr u64 control_run_bit = 1ull << 62;
+    static constexpr u64 control_budget_mask = control_run_bit - 1;
+
+    struct processor_stats {
+        u64 retired_instructions = 0;
+        u64 busy_nanoseconds = 0;
+#ifdef RV_TIMING
+        u64 cycles = 0;
+        rv::timing_stalls stalls{};
+        u64 instruction_cache_misses = 0;
+        u64 instruction_cache_accesses = 0;
+        u64 data_cache_misses = 0;
+        u64 data_cache_accesses = 0;
+        u64 branches = 0;
+        u64 mispredictions = 0;
+#endif
+    };
 
-    struct processor_request {
-        bool run = false;
-        usize amt_steps = 0;
+    struct processor_state {
+        u64 program_counter = 0;
+        std::array<u64, 32> registers{};
     };
 
+    std::atomic<u64> m_control_word{0};
+    util::seqlock<processor_stats> m_processor_stats{};
+    processor_stats m_last_processor_stats{};
+    util::seqlock<processor_state> m_published_processor_state{};
+    processor_state m_processor_state{};
+
     std::thread m_processor_worker_thread{};
-    stf::channel<processor_request> m_request_channel{};
+
+    void set_control_word(u64 word) {
+        m_control_word.store(word, std::memory_order_release);
+        m_control_word.notify_one();
+    }
+
+    void update_processor_stats() {
+        const auto stats = m_processor_stats.load();
+        const auto delta_instructions = stats.retired_instructions - m_last_processor_stats.retired_instructions;
+        const auto delta_nanoseconds = stats.busy_nanoseconds - m_last_processor_stats.busy_nanoseconds;
+        m_last_processor_stats = stats;
+
+        if (delta_nanoseconds != 0) {
+            m_ips_histogram.record(delta_instructions * 1'000'000'000 / delta_nanoseconds);
+        }
+    }
+
+    void update_processor_state() {
+        m_memory_snapshot.take();
+        m_processor_state = m_published_processor_state.load();
+    }
+
+    void write_performance() {
+        if (auto ofs = std::ofstream("performance.json"); ofs) {
+            ofs << "{\n  \"instructions_per_second\": ";
+            m_ips_histogram.dump_json(ofs);
+            ofs << ",\n  \"slice_latency_nanoseconds\": ";
+            m_slice_latency_histogram.dump_json(ofs);
+            ofs << "\n}\n";
+        }
+    }
+
+    void gui_performance() {
+        constexpr auto table_flags = ImGuiTableFlags_SizingFixedFit | ImGuiTableFlags_BordersV | ImGuiTableFlags_BordersH | ImGuiTableFlags_RowBg;
+
+        if (!ImGui::BeginTable("##performance_table", 6, table_flags)) {
+            return;
+        }
+
+        ImGui::TableSetupColumn("");
+        ImGui::TableSetupColumn("mean");
+        ImGui::TableSetupColumn("p50");
+        ImGui::TableSetupColumn("p95");
+        ImGui::TableSetupColumn("p99");
+        ImGui::TableSetupColumn("p99.9");
+        ImGui::TableHeadersRow();
+
+        const auto row = [](std::string_view name, auto const& histogram) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            imgui::text("{}", name);
+            ImGui::TableNextColumn();
+            imgui::text("{:.0f}", histogram.mean());
+
+            for (const auto percentile : {50., 95., 99., 99.9}) {
+                ImGui::TableNextColumn();
+                imgui::text("{}", histogram.percentile(percentile));
+            }
+        };
+
+        row("Instructions per Second", m_ips_histogram);
+        row("Slice Latency (ns)", m_slice_latency_histogram);
+
+        ImGui::EndTable();
+
+        imgui::button("Reset##performance", ImVec2(0, 0), [this] {
+            m_ips_histogram.reset();
+            m_slice_latency_reset_requested.store(true, std::memory_order_relaxed);
+        });
+        ImGui::SameLine();
+        imgui::button("Write performance.json", ImVec2(0, 0), [this] { write_performance(); });
+    }
+
+    void gui_tty() {
+        const auto previous_size = m_tty.size();
+        for (auto byte = m_uart.read_transmitted(); byte; byte = m_uart.read_transmitted()) {
+            if (*byte != '\r') {
+                m_tty.push_back(static_cast<char>(*byte));
+            }
+        }
+
+        if (m_tty.size() > max_tty_size) {
+            m_tty.erase(0, m_tty.size() - max_tty_size);
+        }
+
+        if (!ImGui::BeginChild("##tty", ImVec2(0, 0), true)) {
+            ImGui::EndChild();
+            return;
+        }
+
+        // what is typed while the TTY is focused goes to the guest, what doesn't fit is lost like on a real line
+        if (ImGui::IsWindowFocused()) {
+            auto& io = ImGui::GetIO();
+            for (const auto c : io.InputQueueCharacters) {
+                if (c < 0x80) {
+                    std::ignore = m_uart.write_received(static_cast<u8>(c));
+                }
+            }
+
+            if (ImGui::IsKeyPressed(ImGuiKey_Enter) || ImGui::IsKeyPressed(ImGuiKey_KeypadEnter)) {
+                std::ignore = m_uart.write_received('\r');
+            }
+
+            if (ImGui::IsKeyPressed(ImGuiKey_Backspace)) {
+                std::ignore = m_uart.write_received(0x7F);
+            }
+        }
+
+        // stick to the bottom unless scrolled away from it
+        const auto at_bottom = ImGui::GetScrollY() >= ImGui::GetScrollMaxY();
+        ImGui::TextUnformatted(m_tty.data(), m_tty.data() + m_tty.size());
+        if (at_bottom && m_tty.size() != previous_size) {
+            ImGui::SetScrollHereY(1.f);
+        }
+
+        ImGui::EndChild();
+    }
+
+    void gui_framebuffer() {
+        const auto config = m_framebuffer.config();
+        if (!config.enabled()) {
+            imgui::text("the guest hasn't set the framebuffer up, its registers are at {:#x}", framebuffer_address);
+            return;
+        }
+
+        if (config.address >= m_memory_snapshot.size() || m_memory_snapshot.size() - config.address < config.size()) {
+            imgui::text("the framebuffer ({}x{} at {:#x}) isn't in RAM", config.width, config.height, config.address);
+            return;
+        }
+
+        auto since = m_framebuffer_uploaded;
+        if (config != m_framebuffer_texture_config) {
+            if (!m_framebuffer_texture.create(config.width, config.height)) {
+                imgui::text("could not create a {}x{} texture", config.width, config.height);
+                return;
+            }
+
+            m_framebuffer_texture_config = config;
+            since = 0;
+        }
+
+        // only the rows on pages that changed since the last upload
+        if (const auto rows = rv::dirty_rows(m_memory_snapshot, config, since); rows) {
+            const auto [first, last] = *rows;
+            const auto pixels = std::span(m_memory_snapshot.data() + config.address, config.size());
+
+            m_framebuffer_rgba.resize(usize(config.width) * 4 * (last - first));
+            for (auto y = first; y < last; y++) {
+                rv::convert_to_rgba(config.format, pixels.subspan(y * config.stride(), config.stride()), m_framebuffer_rgba.data() + usize(y - first) * config.width * 4, config.width);
+            }
+
+            m_framebuffer_texture.update(m_framebuffer_rgba.data(), config.width, last - first, 0, first);
+        }
+
+        m_framebuffer_uploaded = m_memory_snapshot.generation();
+
+        // scaled up by a whole factor while it fits, pixel art stays sharp that way
+        const auto available = ImGui::GetContentRegionAvail();
+        const auto fit = std::min(available.x / static_cast<float>(config.width), available.y / static_cast<float>(config.height));
+        const auto scale = fit >= 1.f ? std::floor(fit) : fit;
+        ImGui::Image(m_framebuffer_texture, sf::Vector2f(static_cast<float>(config.width) * scale, static_cast<float>(config.height) * scale));
+    }
+
+    void gui_instruction_viewer() {
+        ImGui::Checkbox("Follow PC", &m_follow_pc);
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(ImGui::CalcTextSize("0000000000000000").x + ImGui::GetStyle().FramePadding.x * 2);
+        if (ImGui::InputScalar("Address", ImGuiDataType_U64, &m_listing_address, nullptr, nullptr, "%016llX", ImGuiInputTextFlags_CharsHexadecimal)) {
+            m_follow_pc = false;
+        }
+
+        const auto pc = m_processor_state.program_counter;
+        if (m_follow_pc) {
+            m_listing_address = pc;
+        }
+
+        // only the pages around the address are laid out and only the rows on screen get disassembled
+        m_instruction_listing.update(m_memory_snapshot, m_listing_address);
+
+        if (!ImGui::BeginChild("##instruction_viewer")) {
+            ImGui::EndChild();
+            return;
+        }
+
+        const auto line_height = ImGui::GetTextLineHeightWithSpacing();
+
+        // scroll only when the address moves so that the view can be scrolled around while it stays put
+        if (m_listing_scrolled_to != m_listing_address) {
+            if (const auto row = m_instruction_listing.row_of(m_listing_address); row) {
+                ImGui::SetScrollY(static_cast<float>(*row) * line_height - ImGui::GetWindowHeight() / 2);
+            }
+            m_listing_scrolled_to = m_listing_address;
+        }
+
+        auto clipper = ImGuiListClipper{};
+        clipper.Begin(static_cast<int>(m_instruction_listing.num_rows()), line_height);
+        while (clipper.Step()) {
+            for (auto i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+                const auto row = m_instruction_listing.row(static_cast<usize>(i));
+                const auto text = m_instruction_listing.row_text(m_risc_v, static_cast<usize>(i), true);
+
+                // compressed instructions are padded to line up with the others
+                auto line = std::array<char, 160>{};
+                const auto [_, length] = fmt::format_to_n(
+                  line.data(), line.size(), "{} {:016X}  {:0{}X}{:{}}  {}",  //
+                  row.address == pc ? '>' : ' ', row.address, row.word, row.size * 2, "", 8 - row.size * 2, text
+                );
+
+                imgui::text(std::string_view(line.data(), std::min(length, line.size())));
+            }
+        }
+        clipper.End();
+
+        ImGui::EndChild();
+    }
+
+    /// Hands the registers and the memory over to the GUI, only while the snapshot can be published.
+    void publish_processor_state() {
+        auto state = processor_state{.program_counter = m_risc_v.program_counter()};
+        for (u32 i = 0; i < state.registers.size(); i++) {
+            state.registers[i] = m_risc_v.read_register(static_cast<rv::reg>(i));
+        }
+
+        m_published_processor_state.store(state);
+        m_memory_snapshot.publish(m_risc_v.m_memory);
+
+        // going to sleep after this must not miss the GUI asking to quit, see the destructor
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
 
     void processor_worker() {
+        using clock = std::chrono::steady_clock;
+
+        // the amount of instructions per slice is adjusted so that a slice takes about this long
+        constexpr auto target_slice_nanoseconds = 1'000'000.0;
+        constexpr auto min_slice_length = 64uz;
+        constexpr auto max_slice_length = 1uz << 26;
+
+        auto slice_length = 4096uz;
+        auto stats = processor_stats{};
+        // whether the GUI was handed the state the processor is in
+        auto published = false;
+
         for (;;) {
-            auto request = processor_request{};
-            if (auto recv_res = stf::receive(m_request_channel); recv_res) {
-                request = *recv_res;
-            } else {
+            auto control = m_control_word.load(std::memory_order_acquire);
+
+            if ((control & control_quit_bit) != 0) {
                 break;
             }
 
-            constexpr auto step_batch_amt = 32uz;
+            const auto running = (control & control_run_bit) != 0;
+            const auto budget = control & control_budget_mask;
 
-            const auto batch_count = request.amt_steps / step_batch_amt;
-            const auto batch_excess = request.amt_steps % step_batch_amt;
+            if (!running && budget == 0) {
+                // the GUI gets to see where the processor stopped, it takes a publication every frame so this isn't a long wait
+                if (!published) {
+                    m_memory_snapshot.wait_for_reader();
+                    publish_processor_state();
+                    published = true;
+                    continue;
+                }
 
-            auto step = [this](usize step_for) {
-                const auto tp_0 = std::chrono::system_clock::now();
-                stf::scope::scope_exit chrono_guard{[this, tp_0] {
-                    const auto tp_1 = std::chrono::system_clock::now();
+                m_control_word.wait(control, std::memory_order_acquire);
+                continue;
+            }
 
-                    const auto t_delta_secs = static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(tp_1 - tp_0).count()) / 1e6;
+            const auto to_execute = running ? slice_length : std::min<usize>(slice_length, budget);
 
-                    m_ips_averager.add_sample(static_cast<double>(step_batch_amt) / t_delta_secs);
-                }};
+            const auto tp_0 = clock::now();
+            const auto executed = m_risc_v.run(to_execute);
+            const auto tp_1 = clock::now();
 
-                for (usize step = 0; step < step_for; step++) {
-                    const auto pc_0 = m_risc_v.m_program_counter;
-                    m_risc_v.step();
-                    const auto pc_1 = m_risc_v.m_program_counter;
+            // at most one publication per frame, the GUI has to take the last one first
+            published = m_memory_snapshot.can_publish();
+            if (published) {
+                publish_processor_state();
+            }
 
-                    if (pc_0 == pc_1) [[unlikely]] {
-                        return false;
-                    }
-                }
+            const auto elapsed_nanoseconds = std::max<i64>(std::chrono::duration_cast<std::chrono::nanoseconds>(tp_1 - tp_0).count(), 1);
+
+            stats.retired_instructions += executed;
+            stats.busy_nanoseconds += elapsed_nanoseconds;
+#ifdef RV_TIMING
+            auto const& model = m_risc_v.m_observer.get<rv::timing_observer>().m_model;
+            stats.cycles = model.cycles();
+            stats.stalls = model.stalls();
+            stats.instruction_cache_misses = model.instruction_cache()->misses();
+            stats.instruction_cache_accesses = model.instruction_cache()->hits() + model.instruction_cache()->misses();
+            stats.data_cache_misses = model.data_cache()->misses();
+            stats.data_cache_accesses = model.data_cache()->hits() + model.data_cache()->misses();
+            stats.branches = model.branch_prediction()->branches() + model.branch_prediction()->indirect_jumps();
+            stats.mispredictions = model.branch_prediction()->mispredictions();
+#endif
+            m_processor_stats.store(stats);
+
+            // the worker is the only one recording into the histogram, so it is the one to reset it too
+            if (m_slice_latency_reset_requested.exchange(false, std::memory_order_relaxed)) {
+                m_slice_latency_histogram.reset();
+            }
 
-                return true;
-            };
+            m_slice_latency_histogram.record(static_cast<u64>(elapsed_nanoseconds));
 
-            if (request.run) {
-                for (bool stop = false; !stop;) {
-                    if (!step(step_batch_amt)) {
-                        spdlog::warn("PC didn't change (@ {:#018X}), halting", m_risc_v.m_program_counter);
-                        stop = true;
-                    }
+            if (to_execute == slice_length) {
+                const auto ideal_length = static_cast<double>(slice_length) * target_slice_nanoseconds / static_cast<double>(elapsed_nanoseconds);
+                slice_length = std::clamp((slice_length + static_cast<usize>(ideal_length)) / 2, min_slice_length, max_slice_length);
+            }
 
-                    stf::select(
-                      stf::channel_selector(m_request_channel, [&stop](auto req) { stop = !req || !req->run; }),  //
-                      stf::default_channel_selector([] {})
-                    );
-                }
-            } else {
-                for (usize batch_no = 0; batch_no < batch_count; batch_no++) {
-                    step(step_batch_amt);
-                }
+            // if the GUI changed the control word while we were running, its request wins and the CAS below fails
+            if (executed != to_execute) {
+                spdlog::warn("PC didn't change (@ {:#018X}), halting", m_risc_v.m_program_counter);
+                m_control_word.compare_exchange_strong(control, 0, std::memory_order_acq_rel);
+            } else if (!running) {
+                m_control_word.compare_exchange_strong(control, budget - executed, std::memory_order_acq_rel);
+            }
+        }
+    }
 
-                step(batch_excess);
+#ifdef RV_TIMING
+    void gui_timing_tab() {
+        auto const& stats = m_last_processor_stats;
+        const auto ratio = [](u64 lhs, u64 rhs) { return rhs == 0 ? 0. : static_cast<double>(lhs) / static_cast<double>(rhs); };
+
+        imgui::text("Cycles: {}", stats.cycles);
+        imgui::text("Cycles per instruction: {:.3f}", ratio(stats.cycles, stats.retired_instructions));
+
+        imgui::text("Data hazard stalls: {} ({:.2f}%)", stats.stalls.data, ratio(stats.stalls.data, stats.cycles) * 100.);
+        imgui::text("Control flow bubbles: {} ({:.2f}%)", stats.stalls.control, ratio(stats.stalls.control, stats.cycles) * 100.);
+        imgui::text("Divider stalls: {} ({:.2f}%)", stats.stalls.structural, ratio(stats.stalls.structural, stats.cycles) * 100.);
+        imgui::text("Cache miss stalls: {} ({:.2f}%)", stats.stalls.memory, ratio(stats.stalls.memory, stats.cycles) * 100.);
+
+        imgui::text("I$ misses: {} ({:.2f}%)", stats.instruction_cache_misses, ratio(stats.instruction_cache_misses, stats.instruction_cache_accesses) * 100.);
+        imgui::text("D$ misses: {} ({:.2f}%)", stats.data_cache_misses, ratio(stats.data_cache_misses, stats.data_cache_accesses) * 100.);
+        imgui::text("Branch mispredictions: {} ({:.2f}%)", stats.mispredictions, ratio(stats.mispredictions, stats.branches) * 100.);
+    }
+
+    void dump_branch_prediction() const {
+        if (auto ofs = std::ofstream("branch_prediction.csv"); ofs) {
+            m_risc_v.m_observer.get<rv::timing_observer>().m_model.branch_prediction()->dump_csv(ofs);
+        }
+    }
+#endif
+
+#ifdef RV_EXECUTION_STATISTICS
+    void dump_execution_statistics() const {
+        auto const& statistics = m_risc_v.m_observer.get<rv::statistics_observer>().m_statistics;
+
+        if (auto ofs = std::ofstream("execution_statistics.csv"); ofs) {
+            statistics.dump_csv(ofs, m_risc_v.m_isa);
+        }
+
+        if (auto ofs = std::ofstream("execution_statistics.json"); ofs) {
+            statistics.dump_json(ofs, m_risc_v.m_isa);
+        }
+    }
+
+    void gui_statistics_tab() {
+        auto& statistics = m_risc_v.m_observer.get<rv::statistics_observer>().m_statistics;
+        const auto total = statistics.total();
+
+        imgui::text("Executed instructions: {}", total);
+        ImGui::SameLine();
+        imgui::button("Reset##statistics", ImVec2(0, 0), [&statistics] { statistics.reset(); });
+
+        const auto percentage = [total](u64 count) { return total == 0 ? 0. : static_cast<double>(count) * 100. / static_cast<double>(total); };
+        constexpr auto table_flags = ImGuiTableFlags_SizingFixedFit | ImGuiTableFlags_BordersV | ImGuiTableFlags_BordersH | ImGuiTableFlags_RowBg;
+
+        const auto count_table = [&](const char* id, auto const& rows) {
+            if (!ImGui::BeginTable(id, 3, table_flags)) {
+                return;
+            }
+
+            for (auto const& [name, count] : rows) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                imgui::text("{}", name);
+                ImGui::TableNextColumn();
+                imgui::text("{}", count);
+                ImGui::TableNextColumn();
+                imgui::text("{:.2f}%", percentage(count));
+            }
+
+            ImGui::EndTable();
+        };
+
+        if (ImGui::CollapsingHeader("Per standard", ImGuiTreeNodeFlags_DefaultOpen)) {
+            auto rows = std::vector<std::pair<std::string_view, u64>>{};
+            for (auto const& [standard, count] : statistics.per_standard(m_risc_v.m_isa)) {
+                rows.emplace_back(rv::enum_name(standard), count);
             }
+            count_table("##statistics_standards", rows);
         }
+
+        if (ImGui::CollapsingHeader("Per format", ImGuiTreeNodeFlags_DefaultOpen)) {
+            auto rows = std::vector<std::pair<std::string_view, u64>>{};
+            for (auto const& [format, count] : statistics.per_format(m_risc_v.m_isa)) {
+                rows.emplace_back(rv::enum_name(format), count);
+            }
+            count_table("##statistics_formats", rows);
+        }
+
+        if (ImGui::CollapsingHeader("Per instruction", ImGuiTreeNodeFlags_DefaultOpen)) {
+            auto rows = std::vector<std::pair<std::string_view, u64>>{};
+            for (usize i = 0; i < statistics.num_slots(); i++) {
+                if (const auto count = statistics.slot_count(i); count != 0) {
+                    rows.emplace_back(m_risc_v.m_isa[i].mnemonic, count);
+                }
+            }
+            std::ranges::sort(rows, std::greater{}, [](auto const& row) { return row.second; });
+            count_table("##statistics_instructions", rows);
+        }
+    }
+#endif
+
+#ifdef RV_PROFILER
+    auto profiler() -> rv::profiler& { return m_risc_v.m_observer.get<rv::profiler_observer>().m_profiler; }
+
+    void load_symbols() {
+        auto symbols = rv::elf::symbol_table::from_file(m_symbols_path.data());
+
+        if (!symbols) {
+            spdlog::warn("could not load symbols from {}: {}", m_symbols_path.data(), symbols.error());
+            return;
+        }
+
+        m_symbols = std::move(*symbols);
+    }
+
+    void write_profile() {
+        if (auto ofs = std::ofstream("profile.folded"); ofs) {
+            profiler().write_collapsed(ofs, m_symbols ? &*m_symbols : nullptr);
+        }
+    }
+
+    void gui_profiler_tab() {
+        auto& profiler = this->profiler();
+
+        if (auto enabled = profiler.enabled(); ImGui::Checkbox("Sample", &enabled)) {
+            profiler.set_enabled(enabled);
+        }
+
+        ImGui::SameLine();
+        imgui::button("Clear##profiler", ImVec2(0, 0), [&profiler] { profiler.clear(); });
+        ImGui::SameLine();
+        imgui::button("Write profile.folded", ImVec2(0, 0), [this] { write_profile(); });
+
+        ImGui::InputText("##symbols_path", m_symbols_path.data(), m_symbols_path.size());
+        ImGui::SameLine();
+        imgui::button("Load Symbols", ImVec2(0, 0), [this] { load_symbols(); });
+
+        imgui::text("Symbols: {}", m_symbols ? m_symbols->symbols().size() : 0);
+        imgui::text("Samples: {} ({} dropped)", profiler.total_samples(), profiler.dropped_samples());
+
+        const auto total = profiler.total_samples();
+        const auto samples = profiler.self_samples(m_symbols ? &*m_symbols : nullptr);
+
+        if (!ImGui::BeginTable("##profiler_self_samples", 3, ImGuiTableFlags_SizingFixedFit | ImGuiTableFlags_BordersV | ImGuiTableFlags_BordersH | ImGuiTableFlags_RowBg)) {
+            return;
+        }
+
+        for (auto const& [name, count] : samples | std::views::take(64)) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            imgui::text("{}", name);
+            ImGui::TableNextColumn();
+            imgui::text("{}", count);
+            ImGui::TableNextColumn();
+            imgui::text("{:.2f}%", static_cast<double>(count) * 100. / static_cast<double>(total));
+        }
+
+        ImGui::EndTable();
     }
+#endif
 
     void load_fonts() {
         ImGuiIO& io = ImGui::GetIO();
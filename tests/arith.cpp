@@ -0,0 +1,47 @@
+#include <gtest/gtest.h>
+
+#include <rv/detail/arith.hpp>
+
+#include <random>
+
+namespace arith = rv::arith;
+
+namespace {
+
+/// goes through a function pointer so that the compiler can't constant evaluate the call and the `if !consteval` branches get taken
+template<std::unsigned_integral T>
+auto matches_at_runtime() -> bool {
+    auto volatile fn = &arith::detail::host_matches_portable<T>;
+    return fn();
+}
+
+}  // namespace
+
+TEST(rv_arith, host_matches_portable) {
+    ASSERT_TRUE(matches_at_runtime<u8>());
+    ASSERT_TRUE(matches_at_runtime<u16>());
+    ASSERT_TRUE(matches_at_runtime<u32>());
+    ASSERT_TRUE(matches_at_runtime<u64>());
+}
+
+TEST(rv_arith, random_multiplies) {
+    auto engine = std::mt19937_64(0x5eed);
+
+    for (usize i = 0; i < 100'000; i++) {
+        const auto lhs = static_cast<u64>(engine());
+        const auto rhs = static_cast<u64>(engine());
+
+        ASSERT_EQ((arith::host_multiply<u64, false, false>(lhs, rhs)), (arith::portable_multiply<u64, false, false>(lhs, rhs))) << lhs << " * " << rhs;
+        ASSERT_EQ((arith::host_multiply<u64, true, false>(lhs, rhs)), (arith::portable_multiply<u64, true, false>(lhs, rhs))) << lhs << " * " << rhs;
+        ASSERT_EQ((arith::host_multiply<u64, true, true>(lhs, rhs)), (arith::portable_multiply<u64, true, true>(lhs, rhs))) << lhs << " * " << rhs;
+
+        const auto narrow_lhs = static_cast<u32>(lhs);
+        const auto narrow_rhs = static_cast<u32>(rhs);
+        ASSERT_EQ((arith::host_multiply<u32, true, false>(narrow_lhs, narrow_rhs)), (arith::portable_multiply<u32, true, false>(narrow_lhs, narrow_rhs)));
+        ASSERT_EQ((arith::host_multiply<u32, true, true>(narrow_lhs, narrow_rhs)), (arith::portable_multiply<u32, true, true>(narrow_lhs, narrow_rhs)));
+
+        const auto amount = static_cast<u64>(engine() % 64);
+        ASSERT_EQ(arith::host_arithmetic_shr(lhs, amount), arith::portable_arithmetic_shr(lhs, amount));
+        ASSERT_EQ(arith::host_signed_compare(lhs, rhs), arith::portable_signed_compare(lhs, rhs));
+    }
+}
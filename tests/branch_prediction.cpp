@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+
+#include <rv/rv.hpp>
+
+namespace {
+
+using namespace rv::detail::assembler;
+using rv::alu_action;
+using rv::reg;
+
+/// mispredictions over `repetitions` repetitions of `pattern` as the outcomes of a single branch, after as many to warm up
+auto mispredictions(rv::branch_predictor predictor, std::span<const bool> pattern, usize repetitions) -> u64 {
+    auto model = rv::branch_prediction_model(rv::branch_prediction_config{.predictor = std::move(predictor)});
+
+    for (usize i = 0; i < repetitions; i++) {
+        for (const auto taken : pattern) {
+            model.on_branch(0x100, 0x80, taken);
+        }
+    }
+
+    const auto warm = model.mispredictions();
+
+    for (usize i = 0; i < repetitions; i++) {
+        for (const auto taken : pattern) {
+            model.on_branch(0x100, 0x80, taken);
+        }
+    }
+
+    return model.mispredictions() - warm;
+}
+
+}  // namespace
+
+TEST(branch_prediction, predictors) {
+    const bool loop[]{true, true, true, true, true, true, true, false};
+    const bool alternating[]{true, false};
+    const bool period_seven[]{true, true, false, true, false, false, true};
+
+    // everything but the exit of the loop is backwards and taken
+    ASSERT_EQ(mispredictions(rv::static_btfn_predictor{}, loop, 100), 100);
+    ASSERT_EQ(mispredictions(rv::bimodal_predictor{}, loop, 100), 100);
+
+    // bimodal counters can't follow an alternating branch, a history can
+    ASSERT_GE(mispredictions(rv::bimodal_predictor{}, alternating, 100), 100);
+    ASSERT_EQ(mispredictions(rv::gshare_predictor{}, alternating, 100), 0);
+    ASSERT_EQ(mispredictions(rv::tage_lite_predictor{}, alternating, 100), 0);
+
+    // the loop exit is learnt from a history that is longer than the loop
+    ASSERT_EQ(mispredictions(rv::gshare_predictor{}, loop, 100), 0);
+    ASSERT_EQ(mispredictions(rv::tage_lite_predictor{}, loop, 100), 0);
+    ASSERT_EQ(mispredictions(rv::tage_lite_predictor{}, period_seven, 100), 0);
+}
+
+TEST(branch_prediction, return_address_stack) {
+    auto model = rv::branch_prediction_model(rv::branch_prediction_config{.return_stack_depth = 2});
+
+    // call 0x100 from 0x00, which calls 0x200 from 0x104 (compressed), which returns twice
+    ASSERT_FALSE(model.on_jump(0x00, 0x100, 4, reg::ra, reg::zero));
+    ASSERT_FALSE(model.on_jump(0x104, 0x200, 2, reg::ra, reg::zero));
+    ASSERT_FALSE(model.on_jump(0x204, 0x106, 4, reg::zero, reg::ra));
+    ASSERT_FALSE(model.on_jump(0x108, 0x04, 4, reg::zero, reg::ra));
+
+    // three levels deep, the outermost return address fell off the stack
+    model.on_jump(0x00, 0x100, 4, reg::ra, reg::zero);
+    model.on_jump(0x100, 0x200, 4, reg::ra, reg::zero);
+    model.on_jump(0x200, 0x300, 4, reg::ra, reg::zero);
+    ASSERT_FALSE(model.on_jump(0x304, 0x204, 4, reg::zero, reg::ra));
+    ASSERT_FALSE(model.on_jump(0x204, 0x104, 4, reg::zero, reg::ra));
+    ASSERT_TRUE(model.on_jump(0x104, 0x04, 4, reg::zero, reg::ra));
+
+    ASSERT_EQ(model.jump_mispredictions(), 1);
+    ASSERT_EQ(model.worst_sites(1).front().first, 0x104);
+}
+
+TEST(branch_prediction, timing) {
+    using timed_risc_v = rv::risc_v<u64, std::allocator<u8>, rv::timing_observer>;
+
+    // clang-format off
+    const u32 program[] {
+        asm_immediate(rv::csr_address::mhpmevent3, static_cast<reg>(rv::hpm_event::branch_mispredicts), 0b101, reg::zero, 0b11100'11),  // 0x00
+        alu_i<alu_action::add, false>(reg::a0, reg::zero, 100),     // 0x04: li a0, 100
+        alu_i<alu_action::add, false>(reg::a0, reg::a0, -1),        // 0x08: addi a0, a0, -1
+        branch<branch_type::not_equal>(reg::a0, reg::zero, -4),     // 0x0C: bnez a0, 0x08
+        jal(reg::zero, 0),                                          // 0x10: j .
+    };
+    // clang-format on
+
+    const auto config = rv::timing_config{.branch_prediction = rv::branch_prediction_config{.predictor = rv::bimodal_predictor{}}};
+    auto risc_v = timed_risc_v(rv::is_rv64<timed_risc_v>, 0x1000, {}, rv::timing_observer{config});
+
+    for (usize i = 0; i < std::size(program); i++) {
+        risc_v.m_memory.write<u32>(i * 4, program[i]);
+    }
+
+    risc_v.run(1000);
+    auto const& model = risc_v.m_observer.m_model;
+
+    // the counter starts out weakly not taken, it mispredicts the first iteration and the exit
+    ASSERT_EQ(model.branch_prediction()->branch_mispredictions(), 2);
+    ASSERT_EQ(model.stalls().control, 2 * 2);
+    ASSERT_EQ(model.cycles(), risc_v.retired_instructions() + 2 * 2);
+
+    const auto source = [&](usize index) { return risc_v.event_count(risc_v.m_csr.event(index), risc_v.retired_instructions()); };
+    ASSERT_EQ(risc_v.m_csr.read(rv::csr_address::hpmcounter3, source), 2);
+}
@@ -1,25 +1,26 @@
 #include <gtest/gtest.h>
 
-#include <stuff/core.hpp>
+#include <rv/detail/cache.hpp>
 
-template<typename AddrType = u64, usize AddrBitsPerLine = 6>
-struct cache {
-    static constexpr usize address_bits_per_line = AddrBitsPerLine;
-    static constexpr usize bytes_per_line = 1uz << AddrBitsPerLine;
-    static constexpr usize line_count = 64;
+TEST(cache, lru_replacement) {
+    // 2 sets of 2 ways of 16 byte lines
+    auto cache = rv::cache_model(rv::cache_config{.size_bytes = 64, .line_bytes = 16, .ways = 2});
 
-    using address_type = AddrType;
+    ASSERT_FALSE(cache.access(0x00));
+    ASSERT_TRUE(cache.access(0x0F));
+    ASSERT_FALSE(cache.access(0x10));  // the other set
+    ASSERT_FALSE(cache.access(0x20));
+    ASSERT_TRUE(cache.access(0x00));
 
-    struct line_type {
-        bool valid;
-        address_type address;
-        std::array<u8, bytes_per_line> data;
-    };
+    // 0x20 is the least recently used line in the set now
+    ASSERT_FALSE(cache.access(0x40));
+    ASSERT_TRUE(cache.access(0x00));
+    ASSERT_FALSE(cache.access(0x20));
+    ASSERT_TRUE(cache.access(0x10));
 
-private:
-    std::array<line_type, line_count> m_lines {};
-};
-
-TEST(cache, cache) {
+    ASSERT_EQ(cache.hits(), 4);
+    ASSERT_EQ(cache.misses(), 5);
 
+    cache.invalidate();
+    ASSERT_FALSE(cache.access(0x00));
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <rv/rv.hpp>
+
 #include <stuff/core.hpp>
 
 #include <gtest/gtest.h>
@@ -16,3 +18,53 @@ auto run_tests(std::span<const std::pair<u32, std::string_view>, N> test_cases,
         ASSERT_EQ(got_str, expected_str) << fmt::format("case {}, word: {:#08X}", i++, instruction_word);
     }
 };
+
+/*
+ * encoders for what `rv::detail::assembler` doesn't have
+ */
+
+constexpr auto x(rv::reg reg) -> u32 { return static_cast<u32>(reg); }
+
+/// The R-type layout, which the float and vector formats share with `funct_7` holding their own fields.
+constexpr auto r_type(u32 opcode, u32 funct_7, u32 funct_3, u32 rd, u32 rs_1, u32 rs_2) -> u32 {
+    return (funct_7 << 25) | (rs_2 << 20) | (rs_1 << 15) | (funct_3 << 12) | (rd << 7) | opcode;
+}
+
+constexpr auto li(rv::reg rd, i32 value) -> u32 { return rv::detail::assembler::alu_i<rv::alu_action::add, false>(rd, rv::reg::zero, value); }
+
+constexpr auto csrrw(rv::reg rd, u32 address, rv::reg rs_1) -> u32 { return rv::detail::assembler::asm_immediate(address, rs_1, 0b001, rd, 0b11100'11); }
+constexpr auto csrrs(rv::reg rd, u32 address, rv::reg rs_1) -> u32 { return rv::detail::assembler::asm_immediate(address, rs_1, 0b010, rd, 0b11100'11); }
+constexpr auto csrrwi(rv::reg rd, u32 address, u32 uimm) -> u32 { return rv::detail::assembler::asm_immediate(address, static_cast<rv::reg>(uimm), 0b101, rd, 0b11100'11); }
+constexpr auto csrrsi(rv::reg rd, u32 address, u32 uimm) -> u32 { return rv::detail::assembler::asm_immediate(address, static_cast<rv::reg>(uimm), 0b110, rd, 0b11100'11); }
+
+constexpr u32 mret = 0x3020'0073;
+
+/// Writes `program` to the memory of `risc_v`, starting at `address`.
+template<typename RiscV>
+void load_program(RiscV& risc_v, std::span<const u32> program, u64 address = 0) {
+    for (usize i = 0; i < program.size(); i++) {
+        risc_v.m_memory.template write<u32>(address + i * 4, program[i]);
+    }
+}
+
+/// Points `mtvec` at a handler placed at `address` that puts `mcause` into `s10` and `mtval` into `s11` and returns past the trapping
+/// instruction, which is to be a 4 byte one. The handler takes 6 instructions and clobbers `t6`.
+template<typename RiscV>
+void load_skipping_trap_handler(RiscV& risc_v, u64 address) {
+    using namespace rv::detail::assembler;
+    namespace csr = rv::csr_address;
+
+    // clang-format off
+    const u32 handler[] {
+        csrrs(rv::reg::s10, csr::mcause, rv::reg::zero),
+        csrrs(rv::reg::s11, csr::mtval, rv::reg::zero),
+        csrrs(rv::reg::t6, csr::mepc, rv::reg::zero),
+        alu_i<rv::alu_action::add, false>(rv::reg::t6, rv::reg::t6, 4),
+        csrrw(rv::reg::zero, csr::mepc, rv::reg::t6),
+        mret,
+    };
+    // clang-format on
+
+    load_program(risc_v, handler, address);
+    risc_v.m_trap.write_csr(csr::mtvec, static_cast<typename RiscV::register_type>(address));
+}
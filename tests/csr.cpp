@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+
+#include "./common.hpp"
+
+#include <rv/rv.hpp>
+
+namespace {
+
+using namespace rv::detail::assembler;
+using rv::alu_action;
+using rv::reg;
+namespace csr = rv::csr_address;
+
+}  // namespace
+
+TEST(rv_csr, counters) {
+    using risc_v_type = rv::risc_v<u64>;
+
+    // clang-format off
+    const u32 program[] {
+        csrrs(reg::a0, csr::instret, reg::zero),                  // 0x00
+        alu_i<alu_action::add, false>(reg::a2, reg::zero, 100),   // 0x04: li a2, 100
+        csrrs(reg::a1, csr::cycle, reg::zero),                    // 0x08
+        csrrw(reg::zero, csr::minstret, reg::a2),                 // 0x0C
+        csrrs(reg::a3, csr::minstret, reg::zero),                 // 0x10
+        csrrsi(reg::zero, csr::mcountinhibit, 0b100),             // 0x14: stop instret
+        alu_i<alu_action::add, false>(reg::zero, reg::zero, 0),   // 0x18: nop
+        csrrs(reg::a4, csr::instret, reg::zero),                  // 0x1C
+        alu_i<alu_action::add, false>(reg::a5, reg::zero, 7),     // 0x20: li a5, 7
+        csrrw(reg::a5, csr::cycle, reg::a2),                      // 0x24: illegal, cycle is read-only
+        jal(reg::zero, 0),                                        // 0x28: j .
+    };
+    // clang-format on
+
+    auto risc_v = risc_v_type(rv::is_rv64<risc_v_type>, 0x1000);
+    load_program(risc_v, program);
+    load_skipping_trap_handler(risc_v, 0x100);
+
+    // the illegal instruction retires and so does the handler
+    const auto executed = std::size(program) + 6;
+    ASSERT_EQ(risc_v.run(100), executed);
+    ASSERT_EQ(risc_v.retired_instructions(), executed);
+
+    ASSERT_EQ(risc_v.read_register(reg::a0), 0);
+    ASSERT_EQ(risc_v.read_register(reg::a1), 2);
+    // the write takes effect once the writing instruction has retired
+    ASSERT_EQ(risc_v.read_register(reg::a3), 100);
+    ASSERT_EQ(risc_v.read_register(reg::a4), 102);
+    ASSERT_EQ(risc_v.read_register(reg::a5), 7);
+    ASSERT_EQ(risc_v.read_register(reg::s10), rv::trap_cause::illegal_instruction);
+    ASSERT_EQ(risc_v.read_register(reg::s11), program[9]);
+
+    const auto source = [&](usize index) { return risc_v.event_count(risc_v.m_csr.event(index), risc_v.retired_instructions()); };
+    ASSERT_EQ(risc_v.m_csr.read(csr::instret, source), 102);
+    ASSERT_EQ(risc_v.m_csr.read(csr::cycle, source), executed);
+    ASSERT_EQ(risc_v.m_csr.read(csr::cycleh, source), std::nullopt);
+}
+
+TEST(rv_csr, upper_halves) {
+    using risc_v_type = rv::risc_v<u32>;
+
+    // clang-format off
+    const u32 program[] {
+        alu_i<alu_action::add, false>(reg::a0, reg::zero, 1),     // 0x00: li a0, 1
+        csrrw(reg::zero, csr::mcycleh, reg::a0),                  // 0x04
+        csrrs(reg::a1, csr::cycle, reg::zero),                    // 0x08
+        csrrs(reg::a2, csr::cycleh, reg::zero),                   // 0x0C
+        jal(reg::zero, 0),                                        // 0x10: j .
+    };
+    // clang-format on
+
+    auto risc_v = risc_v_type(rv::is_rv32<risc_v_type>, 0x1000);
+    load_program(risc_v, program);
+    risc_v.run(100);
+
+    ASSERT_EQ(risc_v.read_register(reg::a1), 2);
+    ASSERT_EQ(risc_v.read_register(reg::a2), 1);
+}
+
+TEST(rv_csr, hpm_events) {
+    using risc_v_type = rv::risc_v<u64, std::allocator<u8>, rv::statistics_observer>;
+
+    // clang-format off
+    const u32 program[] {
+        csrrwi(reg::zero, csr::mhpmevent3, static_cast<u32>(rv::hpm_event::loads)),             // 0x00
+        csrrwi(reg::zero, csr::mhpmevent3 + 1, static_cast<u32>(rv::hpm_event::csr_accesses)),  // 0x04
+        csrrwi(reg::zero, csr::mhpmevent3 + 2, static_cast<u32>(rv::hpm_event::branch_mispredicts)),  // 0x08
+        load<ld_st_type::dword>(reg::a0, 0x100, reg::zero),                                      // 0x0C
+        load<ld_st_type::word>(reg::a0, 0x100, reg::zero),                                       // 0x10
+        0x0001'4108,                                                                             // 0x14: c.lw a0, 0(a0); c.nop
+        csrrs(reg::a1, csr::hpmcounter3, reg::zero),                                             // 0x18
+        csrrs(reg::a2, csr::hpmcounter3 + 1, reg::zero),                                         // 0x1C
+        csrrs(reg::a3, csr::hpmcounter3 + 2, reg::zero),                                         // 0x20
+        jal(reg::zero, 0),                                                                       // 0x24: j .
+    };
+    // clang-format on
+
+    auto risc_v = risc_v_type(rv::is_rv64<risc_v_type>, 0x1000, {}, rv::statistics_observer(rv::is_rv64<risc_v_type>.num_instructions()));
+    load_program(risc_v, program);
+    // c.lw loads through the address that gets loaded
+    risc_v.m_memory.write<u64>(0x100, 0);
+    risc_v.run(100);
+
+    ASSERT_EQ(risc_v.read_register(reg::a1), 3);
+    // counting starts after the selecting instruction, the reading one has counted itself already
+    ASSERT_EQ(risc_v.read_register(reg::a2), 3);
+    // there is no observer keeping track of mispredicts
+    ASSERT_EQ(risc_v.read_register(reg::a3), 0);
+}
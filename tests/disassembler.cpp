@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+
+#include <rv/rv.hpp>
+
+#include <algorithm>
+#include <sstream>
+
+namespace {
+
+using namespace rv::detail::assembler;
+using rv::alu_action;
+using rv::reg;
+
+using rv64_type = rv::risc_v<u64>;
+using rv32_type = rv::risc_v<u32>;
+
+}  // namespace
+
+TEST(disassembler, format_to) {
+    auto const& isa = rv::is_rv64<rv64_type>;
+
+    // appends
+    auto buffer = rv::format_buffer{};
+    isa.format_to(buffer, alu<alu_action::add>(reg::a0, reg::a1, reg::a2), true);
+    isa.format_to(buffer, 0xFFFF'FFFF, true);
+    ASSERT_EQ(fmt::to_string(buffer), "add a0, a1, a2" "unknown");
+
+    // compressed instructions are followed by what they expand into, like `format` does it
+    ASSERT_EQ(isa.format(0x4505, true), "c.li -> addi a0, Zero, 1");
+
+    char small[8];
+    ASSERT_EQ(isa.format_to(std::span(small), alu<alu_action::add>(reg::a0, reg::a1, reg::a2), true), "add a0, ");
+}
+
+TEST(disassembler, cache) {
+    auto cache = rv::disassembly_cache(1, 2);
+    const auto add = alu<alu_action::add>(reg::a0, reg::a1, reg::a2);
+    const auto sub = alu<alu_action::sub>(reg::a0, reg::a1, reg::a2);
+
+    ASSERT_EQ(cache.format(rv::is_rv64<rv64_type>, add, true), "add a0, a1, a2");
+    ASSERT_EQ(cache.format(rv::is_rv64<rv64_type>, add, false), "add x10, x11, x12");
+    ASSERT_EQ(cache.format(rv::is_rv64<rv64_type>, add, true), "add a0, a1, a2");
+    ASSERT_EQ(cache.hits(), 1);
+    ASSERT_EQ(cache.misses(), 2);
+
+    // the instruction set is part of the key, `ld` is only in RV64
+    const auto ld = load<ld_st_type::dword>(reg::a0, 8, reg::sp);
+    ASSERT_EQ(cache.format(rv::is_rv64<rv64_type>, ld, false), "ld x10, 8(x2)");
+    ASSERT_EQ(cache.format(rv::is_rv32<rv32_type>, ld, false), "unknown");
+
+    // the least recently used entries got replaced
+    ASSERT_EQ(cache.format(rv::is_rv64<rv64_type>, sub, true), "sub a0, a1, a2");
+    ASSERT_EQ(cache.misses(), 5);
+    ASSERT_EQ(cache.format(rv::is_rv64<rv64_type>, add, true), "add a0, a1, a2");
+    ASSERT_EQ(cache.misses(), 6);
+}
+
+TEST(disassembler, disassemble) {
+    const u8 code[]{
+      0x05, 0x45,              // c.li a0, 1
+      0x33, 0x05, 0xB5, 0x00,  // add a0, a0, a1
+      0x6F, 0x00,              // the first half of a `jal`
+    };
+
+    auto lines = std::vector<std::string>{};
+    rv::disassemble(rv::is_rv64<rv64_type>, code, 0x100, true, [&](u64 address, u32, std::string_view text) {  //
+        lines.push_back(fmt::format("{:x}: {}", address, text));
+    });
+
+    ASSERT_EQ(lines.size(), 2);
+    ASSERT_EQ(lines[0], "100: c.li -> addi a0, Zero, 1");
+    ASSERT_EQ(lines[1], "102: add a0, a0, a1");
+}
+
+TEST(disassembler, listing) {
+    const u8 code[]{
+      0x05, 0x45,              // c.li a0, 1
+      0x33, 0x05, 0xB5, 0x00,  // add a0, a0, a1
+      0x6F, 0x00,              // the first half of a `jal`
+    };
+
+    auto oss = std::ostringstream{};
+    rv::write_listing(oss, rv::is_rv64<rv64_type>, code, 0x100, {.num_threads = 1});
+    ASSERT_EQ(
+      oss.str(),
+      "     100:\t4505    \tc.li -> addi a0, Zero, 1\n"
+      "     102:\t00b50533\tadd a0, a0, a1\n"
+      "     106:\t006f    \t.2byte 0x006f\n"
+    );
+}
+
+TEST(disassembler, parallel_listing) {
+    // compressed and uncompressed instructions in a pattern that puts chunk boundaries in the middle of instructions
+    auto code = std::vector<u8>{};
+    for (usize i = 0; i < 0x1000; i++) {
+        const auto word = i % 3 == 0 ? u32(0x4505) : alu<alu_action::add>(reg::a0, reg::a0, reg::a1);
+        const auto size = i % 3 == 0 ? 2uz : 4uz;
+        for (usize j = 0; j < size; j++) {
+            code.push_back(static_cast<u8>(word >> (j * 8)));
+        }
+    }
+
+    const auto listing = [&](rv::listing_options const& options) {
+        auto oss = std::ostringstream{};
+        rv::write_listing(oss, rv::is_rv64<rv64_type>, code, 0x8000, options);
+        return oss.str();
+    };
+
+    const auto expected = listing({.num_threads = 1, .chunk_size = code.size()});
+    ASSERT_EQ(std::ranges::count(expected, '\n'), 0x1000);
+    ASSERT_EQ(listing({.num_threads = 4, .chunk_size = 6}), expected);
+    ASSERT_EQ(listing({.num_threads = 3, .chunk_size = 256}), expected);
+
+    // `lb t1, 48(t1)` has the low bits of a 32-bit instruction in both halves, decoding from anywhere but the start never falls back into
+    // step with it. After the `c.nop` in front, all of them start in the middle of a word.
+    code = {0x01, 0x00};
+    for (usize i = 0; i < 0x400; i++) {
+        code.insert(code.end(), {0x03, 0x03, 0x03, 0x03});
+    }
+
+    const auto misaligned = listing({.num_threads = 1, .chunk_size = code.size()});
+    ASSERT_EQ(std::ranges::count(misaligned, '\n'), 0x401);
+    ASSERT_EQ(misaligned.find(".2byte"), std::string::npos);
+    ASSERT_EQ(listing({.num_threads = 4, .chunk_size = 256}), misaligned);
+    ASSERT_EQ(listing({.num_threads = 2, .chunk_size = 7}), misaligned);
+}
@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+
+#include <rv/rv.hpp>
+
+#include <cstring>
+
+namespace {
+
+template<typename T>
+void put(std::vector<u8>& image, usize offset, T value) {
+    if (image.size() < offset + sizeof(T)) {
+        image.resize(offset + sizeof(T));
+    }
+
+    std::memcpy(image.data() + offset, &value, sizeof(T));
+}
+
+/// an executable with the program headers right after the ELF header and a single loadable segment with `contents` after those
+auto make_executable(bool is_64_bit, u64 entry, u64 address, std::span<const u8> contents, u64 memory_size) -> std::vector<u8> {
+    const auto header_size = is_64_bit ? 0x40uz : 0x34uz;
+    const auto program_header_size = is_64_bit ? 0x38uz : 0x20uz;
+    // a PT_NOTE that is to be skipped and the PT_LOAD
+    const auto contents_offset = header_size + 2 * program_header_size;
+
+    auto image = std::vector<u8>(contents_offset);
+    std::memcpy(image.data(), "\x7F" "ELF", 4);
+    image[4] = is_64_bit ? 2 : 1;
+    image[5] = 1;
+
+    const auto put_word = [&](usize offset, u64 value) {
+        if (is_64_bit) {
+            put<u64>(image, offset, value);
+        } else {
+            put<u32>(image, offset, static_cast<u32>(value));
+        }
+    };
+
+    put_word(0x18, entry);
+    put_word(is_64_bit ? 0x20 : 0x1C, header_size);
+    put<u16>(image, is_64_bit ? 0x36 : 0x2A, static_cast<u16>(program_header_size));
+    put<u16>(image, is_64_bit ? 0x38 : 0x2C, 2);
+
+    put<u32>(image, header_size, 4);
+
+    const auto load = header_size + program_header_size;
+    put<u32>(image, load, 1);
+    put_word(load + (is_64_bit ? 0x08 : 0x04), contents_offset);
+    // the virtual address is garbage, the physical one is what gets loaded
+    put_word(load + (is_64_bit ? 0x10 : 0x08), 0xDEAD'0000);
+    put_word(load + (is_64_bit ? 0x18 : 0x0C), address);
+    put_word(load + (is_64_bit ? 0x20 : 0x10), contents.size());
+    put_word(load + (is_64_bit ? 0x28 : 0x14), memory_size);
+
+    image.insert(image.end(), contents.begin(), contents.end());
+    return image;
+}
+
+}  // namespace
+
+TEST(elf, load_segments) {
+    const u8 contents[]{0x01, 0x02, 0x03, 0x04, 0x05};
+
+    for (const auto is_64_bit : {false, true}) {
+        const auto image = make_executable(is_64_bit, 0x104, 0x100, contents, 16);
+
+        const auto executable = rv::elf::executable::from_image(image);
+        ASSERT_TRUE(executable);
+        ASSERT_EQ(executable->is_64_bit, is_64_bit);
+        ASSERT_EQ(executable->entry, 0x104);
+        ASSERT_EQ(executable->segments.size(), 1);
+
+        auto memory = rv::memory<u64>(0x200);
+        ASSERT_TRUE(memory.load_from(image, rv::infmt_elf_tag{}));
+
+        ASSERT_EQ(memory.read<u32>(0x100), 0x0403'0201);
+        ASSERT_EQ(memory.read<u8>(0x104), 0x05);
+        // what isn't in the image is zeroed
+        for (usize i = 5; i < 16; i++) {
+            ASSERT_EQ(memory.read<u8>(0x100 + i), 0) << i;
+        }
+    }
+}
+
+TEST(elf, bad_images) {
+    const u8 contents[]{0x01, 0x02, 0x03, 0x04};
+
+    auto memory = rv::memory<u64>(0x200);
+
+    // doesn't fit
+    ASSERT_FALSE(memory.load_from(make_executable(true, 0, 0x1F0, contents, 32), rv::infmt_elf_tag{}));
+
+    // more in the image than in memory
+    ASSERT_FALSE(rv::elf::executable::from_image(make_executable(true, 0, 0, contents, 2)));
+
+    // truncated
+    auto truncated = make_executable(false, 0, 0, contents, 4);
+    truncated.resize(truncated.size() - 1);
+    ASSERT_FALSE(rv::elf::executable::from_image(truncated));
+
+    const u8 not_elf[]{0x7F, 'E', 'L', 'G', 2, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+    ASSERT_FALSE(rv::elf::executable::from_image(not_elf));
+}
@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+
+#include <rv/rv.hpp>
+
+namespace {
+
+constexpr u64 framebuffer_address = 0x1000'1000;
+
+}  // namespace
+
+TEST(framebuffer, registers) {
+    auto memory = rv::memory<u64>(0x1000);
+    auto framebuffer = rv::framebuffer{};
+    ASSERT_TRUE(memory.map_device({framebuffer_address, rv::framebuffer::register_span, &framebuffer}));
+    ASSERT_FALSE(framebuffer.config().enabled());
+
+    memory.store<u64>(framebuffer_address, 0x800);
+    memory.store<u32>(framebuffer_address + 0x08, 16);
+    memory.store<u16>(framebuffer_address + 0x0C, 8);
+    memory.store<u8>(framebuffer_address + 0x10, static_cast<u8>(rv::pixel_format::rgb565));
+
+    const auto config = framebuffer.config();
+    ASSERT_EQ(config, (rv::framebuffer_config{.address = 0x800, .width = 16, .height = 8, .format = rv::pixel_format::rgb565}));
+    ASSERT_EQ(config.stride(), 32);
+    ASSERT_EQ(memory.load<u64>(framebuffer_address + 0x08), 0x0000'0008'0000'0010ull);
+
+    // formats that don't exist fall back to gray8
+    memory.store<u32>(framebuffer_address + 0x10, 42);
+    ASSERT_EQ(framebuffer.config().format, rv::pixel_format::gray8);
+}
+
+TEST(framebuffer, dirty_rows) {
+    auto memory = rv::memory<u64>(0x4000);
+    // 48 rows of 256 bytes from the middle of the first page to the middle of the last
+    const auto config = rv::framebuffer_config{.address = 0x800, .width = 64, .height = 48, .format = rv::pixel_format::rgba8888};
+
+    memory.advance_generation();
+    const auto since = memory.generation();
+    ASSERT_EQ(rv::dirty_rows(memory, config, since), std::nullopt);
+
+    // the whole page gets uploaded, not just the row that was written
+    memory.write<u32>(0x800 + 256 * 10, 0xFFFF'FFFF);
+    ASSERT_EQ(rv::dirty_rows(memory, config, since), (std::pair<u32, u32>{8, 24}));
+
+    memory.write<u8>(0x3000, 1);
+    ASSERT_EQ(rv::dirty_rows(memory, config, since), (std::pair<u32, u32>{8, 48}));
+
+    // not in RAM
+    ASSERT_EQ(rv::dirty_rows(memory, rv::framebuffer_config{.address = 0x3000, .width = 64, .height = 48}, 0), std::nullopt);
+}
+
+TEST(framebuffer, convert_to_rgba) {
+    const u8 rgb565[]{0x00, 0xF8, 0xE0, 0x07, 0x1F, 0x00};
+    u8 out[12];
+    rv::convert_to_rgba(rv::pixel_format::rgb565, rgb565, out, 3);
+
+    const u8 expected[]{0xFF, 0, 0, 0xFF, 0, 0xFF, 0, 0xFF, 0, 0, 0xFF, 0xFF};
+    ASSERT_TRUE(std::ranges::equal(out, expected));
+
+    const u8 gray[]{0x80};
+    rv::convert_to_rgba(rv::pixel_format::gray8, gray, out, 1);
+    ASSERT_EQ(out[0], 0x80);
+    ASSERT_EQ(out[2], 0x80);
+    ASSERT_EQ(out[3], 0xFF);
+}
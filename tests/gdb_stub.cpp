@@ -0,0 +1,207 @@
+#include <gtest/gtest.h>
+
+#include "./common.hpp"
+
+#include <rv/rv.hpp>
+
+#include <fmt/format.h>
+
+namespace {
+
+using namespace rv::detail::assembler;
+using rv::alu_action;
+using rv::reg;
+
+using stub_type = rv::gdb_stub<rv::risc_v<u64>>;
+
+auto packet(std::string_view body) -> std::string {
+    u8 checksum = 0;
+    for (const auto c : body) {
+        checksum += static_cast<u8>(c);
+    }
+    return fmt::format("${}#{:02x}", body, checksum);
+}
+
+/// the body of the packet in `reply`, without the ack in front of it
+auto body_of(std::string_view reply) -> std::string {
+    const auto begin = reply.find('$');
+    if (begin == std::string_view::npos) {
+        return {};
+    }
+
+    return std::string(reply.substr(begin + 1, reply.find('#') - begin - 1));
+}
+
+auto request(stub_type& stub, std::string_view body) -> std::string { return body_of(stub.receive(packet(body))); }
+
+auto resume(stub_type& stub) -> std::string { return body_of(stub.resume(1000)); }
+
+auto le_hex(u64 value) -> std::string {
+    auto ret = std::string{};
+    for (usize i = 0; i < 8; i++) {
+        ret += fmt::format("{:02x}", static_cast<u8>(value >> (i * 8)));
+    }
+    return ret;
+}
+
+}  // namespace
+
+TEST(gdb_stub, breakpoints_and_continue) {
+    // clang-format off
+    const u32 program[] {
+        alu_i<alu_action::add, false>(reg::t0, reg::zero, 10),  // 0x00: li t0, 10
+        alu_i<alu_action::add, false>(reg::a0, reg::zero, 0),   // 0x04: li a0, 0
+        alu_i<alu_action::add, false>(reg::a0, reg::a0, 1),     // 0x08: addi a0, a0, 1
+        alu_i<alu_action::add, false>(reg::a1, reg::a0, 0),     // 0x0C: mv a1, a0
+        branch<branch_type::not_equal>(reg::a0, reg::t0, -8),   // 0x10: bne a0, t0, 0x08
+        jal(reg::zero, 0),                                      // 0x14: j .
+    };
+    // clang-format on
+
+    auto risc_v = rv::risc_v<u64>(rv::is_rv64<rv::risc_v<u64>>, 0x1000);
+    for (usize i = 0; i < std::size(program); i++) {
+        risc_v.m_memory.write<u32>(i * 4, program[i]);
+    }
+
+    auto stub = stub_type(risc_v);
+    ASSERT_EQ(stub.receive(packet("QStartNoAckMode")), "+" + packet("OK"));
+
+    // a breakpoint in the middle of the loop body
+    ASSERT_EQ(request(stub, "Z0,c,4"), "OK");
+    for (u64 i = 1; i <= 3; i++) {
+        ASSERT_EQ(request(stub, "c"), "");
+        ASSERT_EQ(stub.state(), rv::gdb_stub_state::running);
+        ASSERT_EQ(resume(stub), "S05");
+        ASSERT_EQ(request(stub, "p20"), le_hex(0x0C));
+        ASSERT_EQ(request(stub, "pa"), le_hex(i));
+    }
+
+    ASSERT_EQ(request(stub, "s"), "S05");
+    ASSERT_EQ(request(stub, "pb"), le_hex(3));
+
+    // the halt at the end stops the target too
+    ASSERT_EQ(request(stub, "z0,c,4"), "OK");
+    request(stub, "c");
+    ASSERT_EQ(resume(stub), "S05");
+    ASSERT_EQ(request(stub, "p20"), le_hex(0x14));
+    ASSERT_EQ(request(stub, "pa"), le_hex(10));
+
+    // patching the loop through memory writes invalidates the cached blocks: `li t0, 10` becomes `li t0, 12`
+    ASSERT_EQ(request(stub, fmt::format("M0,4:{}", le_hex(alu_i<alu_action::add, false>(reg::t0, reg::zero, 12)).substr(0, 8))), "OK");
+    ASSERT_EQ(request(stub, "m0,2"), le_hex(alu_i<alu_action::add, false>(reg::t0, reg::zero, 12)).substr(0, 4));
+    ASSERT_EQ(request(stub, fmt::format("P20={}", le_hex(0))), "OK");
+    request(stub, "c");
+    ASSERT_EQ(resume(stub), "S05");
+    ASSERT_EQ(request(stub, "pa"), le_hex(12));
+
+    ASSERT_EQ(request(stub, "m10000,4"), "E01");
+    ASSERT_EQ(request(stub, "D"), "OK");
+    ASSERT_EQ(stub.state(), rv::gdb_stub_state::detached);
+}
+
+TEST(gdb_stub, interrupt) {
+    auto risc_v = rv::risc_v<u64>(rv::is_rv64<rv::risc_v<u64>>, 0x1000);
+    risc_v.m_memory.write<u32>(0, alu_i<alu_action::add, false>(reg::a0, reg::a0, 1));
+    risc_v.m_memory.write<u32>(4, jal(reg::zero, -4));
+
+    auto stub = stub_type(risc_v);
+    request(stub, "c");
+    ASSERT_EQ(resume(stub), "");
+    ASSERT_EQ(stub.state(), rv::gdb_stub_state::running);
+
+    ASSERT_EQ(stub.receive("\x03"), packet("S02"));
+    ASSERT_EQ(stub.state(), rv::gdb_stub_state::stopped);
+    ASSERT_EQ(request(stub, "?"), "S02");
+}
+
+TEST(gdb_stub, breakpoints_in_trap_handlers) {
+    namespace csr = rv::csr_address;
+
+    // clang-format off
+    const u32 program[] {
+        li(reg::a0, 1),                                         // 0x00
+        li(reg::a1, 2),                                         // 0x04
+        li(reg::a2, 3),                                         // 0x08
+        li(reg::a3, 4),                                         // 0x0C
+        jal(reg::zero, 0),                                      // 0x10: j .
+    };
+
+    const u32 handler[] {
+        li(reg::s0, 1),                                         // 0x100
+        mret,                                                   // 0x104
+    };
+    // clang-format on
+
+    auto risc_v = rv::risc_v<u64>(rv::is_rv64<rv::risc_v<u64>>, 0x1000);
+    load_program(risc_v, program);
+    load_program(risc_v, handler, 0x100);
+    risc_v.m_trap.write_csr(csr::mtvec, 0x100);
+
+    // a software interrupt that comes due in the middle of the first block, which would run on into the handler otherwise
+    risc_v.m_trap.write_csr(csr::mie, rv::interrupt_bit::machine_software);
+    risc_v.m_trap.write_csr(csr::mstatus, rv::trap_state<u64>::status_mie);
+    risc_v.m_trap.set_pending(rv::interrupt_bit::machine_software, rv::interrupt_bit::machine_software);
+    risc_v.m_events.schedule(rv::event_source::interrupts, 2);
+
+    auto stub = stub_type(risc_v);
+    request(stub, "QStartNoAckMode");
+
+    // one on where the trap goes and one within the handler
+    ASSERT_EQ(request(stub, "Z0,100,4"), "OK");
+    ASSERT_EQ(request(stub, "Z0,104,4"), "OK");
+
+    request(stub, "c");
+    ASSERT_EQ(resume(stub), "S05");
+    ASSERT_EQ(request(stub, "p20"), le_hex(0x100));
+    ASSERT_EQ(request(stub, "pb"), le_hex(2));
+
+    request(stub, "c");
+    ASSERT_EQ(resume(stub), "S05");
+    ASSERT_EQ(request(stub, "p20"), le_hex(0x104));
+    ASSERT_EQ(request(stub, "p8"), le_hex(1));
+
+    // `mret` goes back to the instruction that the interrupt came before
+    risc_v.m_trap.set_pending(rv::interrupt_bit::machine_software, 0);
+    request(stub, "c");
+    ASSERT_EQ(resume(stub), "S05");
+    ASSERT_EQ(request(stub, "p20"), le_hex(0x10));
+    ASSERT_EQ(request(stub, "pc"), le_hex(3));
+    ASSERT_EQ(request(stub, "pd"), le_hex(4));
+}
+
+TEST(gdb_stub, watchpoints) {
+    // clang-format off
+    const u32 program[] {
+        alu_i<alu_action::add, false>(reg::a0, reg::zero, 0x100),   // 0x00: li a0, 0x100
+        store<ld_st_type::dword>(reg::zero, 0, reg::a0),            // 0x04: sd zero, 0(a0)
+        load<ld_st_type::dword>(reg::a1, 8, reg::a0),               // 0x08: ld a1, 8(a0)
+        jal(reg::zero, 0),                                          // 0x0C: j .
+    };
+    // clang-format on
+
+    auto risc_v = rv::risc_v<u64>(rv::is_rv64<rv::risc_v<u64>>, 0x1000);
+    for (usize i = 0; i < std::size(program); i++) {
+        risc_v.m_memory.write<u32>(i * 4, program[i]);
+    }
+
+    auto stub = stub_type(risc_v);
+    request(stub, "QStartNoAckMode");
+
+    // the read doesn't hit a write watch, the store does and the target stops right after it
+    ASSERT_EQ(request(stub, "Z2,104,4"), "OK");
+    ASSERT_EQ(request(stub, "Z3,100,8"), "OK");
+    ASSERT_EQ(request(stub, "Z4,10c,1"), "OK");
+    request(stub, "c");
+    ASSERT_EQ(resume(stub), "T05watch:104;");
+    ASSERT_EQ(request(stub, "p20"), le_hex(0x08));
+
+    request(stub, "c");
+    ASSERT_EQ(resume(stub), "T05awatch:10c;");
+    ASSERT_EQ(request(stub, "p20"), le_hex(0x0C));
+
+    ASSERT_EQ(request(stub, "z2,104,4"), "OK");
+    ASSERT_EQ(request(stub, "z2,104,4"), "E01");
+    ASSERT_EQ(request(stub, "z3,100,8"), "OK");
+    ASSERT_EQ(request(stub, "z4,10c,1"), "OK");
+    ASSERT_TRUE(risc_v.m_memory.watches().empty());
+}
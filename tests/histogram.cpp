@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+
+#include <histogram.hpp>
+
+#include <sstream>
+
+TEST(log_histogram, exact_below_sub_buckets) {
+    auto histogram = util::log_histogram<>{};
+
+    for (u64 i = 1; i <= 100; i++) {
+        histogram.record(i);
+    }
+
+    ASSERT_EQ(histogram.count(), 100);
+    ASSERT_EQ(histogram.min(), 1);
+    ASSERT_EQ(histogram.max(), 100);
+    ASSERT_DOUBLE_EQ(histogram.mean(), 50.5);
+
+    ASSERT_EQ(histogram.percentile(50.), 50);
+    ASSERT_EQ(histogram.percentile(95.), 95);
+    ASSERT_EQ(histogram.percentile(99.), 99);
+    ASSERT_EQ(histogram.percentile(100.), 100);
+    ASSERT_EQ(histogram.percentile(0.), 1);
+}
+
+TEST(log_histogram, relative_precision) {
+    using histogram_type = util::log_histogram<7>;
+
+    for (u64 value = 1; value < (1ull << 40); value = value * 3 + 1) {
+        const auto bucket = histogram_type::bucket_of(value);
+        const auto lower = histogram_type::bucket_lower_bound(bucket);
+        const auto upper = histogram_type::bucket_upper_bound(bucket);
+
+        ASSERT_LE(lower, value);
+        ASSERT_GE(upper, value);
+        ASSERT_LE(static_cast<double>(upper - lower), static_cast<double>(value) / 64.);
+    }
+}
+
+TEST(log_histogram, skewed_and_merged) {
+    auto fast = util::log_histogram<>{};
+    auto slow = util::log_histogram<>{};
+
+    // a distribution that z-scores get wrong: mostly fast with a long tail
+    fast.record(1'000, 990);
+    slow.record(1'000'000, 10);
+
+    ASSERT_EQ(fast.percentile(99.9), 1'000);
+
+    fast.merge(slow);
+
+    ASSERT_EQ(fast.count(), 1'000);
+    ASSERT_EQ(fast.max(), 1'000'000);
+    // percentiles are the largest value of their bucket unless that is past the largest recorded value
+    ASSERT_EQ(util::log_histogram<>::bucket_of(fast.percentile(99.)), util::log_histogram<>::bucket_of(1'000));
+    ASSERT_EQ(fast.percentile(99.9), 1'000'000);
+
+    auto ss = std::stringstream{};
+    fast.dump_json(ss);
+    ASSERT_TRUE(ss.str().starts_with(R"({"count": 1000, "min": 1000, "max": 1000000,)"));
+
+    fast.reset();
+    ASSERT_EQ(fast.count(), 0);
+    ASSERT_EQ(fast.percentile(50.), 0);
+}
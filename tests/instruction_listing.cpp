@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+
+#include <rv/rv.hpp>
+
+#include <algorithm>
+
+namespace {
+
+using namespace rv::detail::assembler;
+using rv::alu_action;
+using rv::reg;
+
+using rv64_type = rv::risc_v<u64>;
+
+}  // namespace
+
+TEST(instruction_listing, mixed_lengths) {
+    auto risc_v = rv64_type(rv::is_rv64<rv64_type>, 0x4000);
+    auto& memory = risc_v.m_memory;
+    std::fill_n(memory.data(), memory.size(), 0);
+    memory.mark_written(0, memory.size());
+
+    // the first page is full of `c.nop`s save for the last instruction, which continues in the next page
+    for (u64 address = 0; address < 0xFFE; address += 2) {
+        memory.write<u16>(address, 0x0001);
+    }
+    const auto addi = alu_i<alu_action::add, false>(reg::a0, reg::a0, 1);
+    memory.write<u32>(0xFFE, addi);
+    memory.advance_generation();
+
+    auto listing = rv::instruction_listing<rv64_type>{};
+    listing.update(risc_v, 0);
+    ASSERT_EQ(listing.layouts(), 4);
+    ASSERT_EQ(listing.num_rows(), 0x800 + 0x7FF + 0x800 + 0x800);
+
+    ASSERT_EQ(listing.row(0x7FE).address, 0xFFC);
+    ASSERT_EQ(listing.row(0x7FE).size, 2);
+    ASSERT_EQ(listing.row(0x7FF).address, 0xFFE);
+    ASSERT_EQ(listing.row(0x7FF).word, addi);
+    ASSERT_EQ(listing.row(0x7FF).size, 4);
+    ASSERT_EQ(listing.row_text(risc_v, 0x7FF), "addi x10, x10, 1");
+    ASSERT_EQ(listing.row(0x800).address, 0x1002);
+
+    ASSERT_EQ(listing.row_of(0xFFE), 0x7FF);
+    ASSERT_EQ(listing.row_of(0x1000), 0x7FF);
+    ASSERT_EQ(listing.row_of(0x1002), 0x800);
+    ASSERT_EQ(listing.row_of(0x1003), 0x800);
+}
+
+TEST(instruction_listing, invalidation) {
+    auto risc_v = rv64_type(rv::is_rv64<rv64_type>, 0x4000);
+    auto& memory = risc_v.m_memory;
+    std::fill_n(memory.data(), memory.size(), 0);
+    memory.mark_written(0, memory.size());
+    memory.advance_generation();
+
+    auto listing = rv::instruction_listing<rv64_type>{};
+    listing.update(risc_v, 0);
+    listing.update(risc_v, 0);
+    ASSERT_EQ(listing.layouts(), 4);
+
+    const auto row = *listing.row_of(0x2000);
+    ASSERT_EQ(listing.row_text(risc_v, row), "c.invalid");
+
+    // the written page and the ones next to it are laid out again
+    memory.write<u32>(0x2000, alu<alu_action::add>(reg::a0, reg::a1, reg::a2));
+    memory.advance_generation();
+    listing.update(risc_v, 0);
+    ASSERT_EQ(listing.layouts(), 7);
+    ASSERT_EQ(listing.row_text(risc_v, *listing.row_of(0x2000), true), "add a0, a1, a2");
+
+    listing.update(risc_v, 0);
+    ASSERT_EQ(listing.layouts(), 7);
+
+    // only the pages around the address are laid out
+    auto window = rv::instruction_listing<rv64_type>(2);
+    window.update(risc_v, 0x3000);
+    ASSERT_EQ(window.layouts(), 2);
+    ASSERT_EQ(window.row(0).address, 0x2000);
+    ASSERT_EQ(window.row_of(0), std::nullopt);
+    ASSERT_EQ(window.num_rows(), 0x7FF + 0x800);
+}
@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+
+#include <rv/rv.hpp>
+
+#include <array>
+
+namespace {
+
+using memory_type = rv::memory<u64>;
+using watch_type = rv::memory_watch<u64>;
+
+}  // namespace
+
+TEST(memory_watch, loads_and_stores) {
+    auto memory = memory_type(0x4000);
+
+    const auto read_watch = watch_type{0x100, 4, rv::watch_type::read};
+    const auto write_watch = watch_type{0x200, 8, rv::watch_type::write};
+    const auto access_watch = watch_type{0x2FFC, 8, rv::watch_type::access};
+    memory.add_watch(read_watch);
+    memory.add_watch(write_watch);
+    memory.add_watch(access_watch);
+
+    // instruction fetches and accesses from the outside don't hit watches
+    memory.write<u32>(0x100, 1);
+    memory.write<u32>(0x200, 1);
+    ASSERT_EQ(memory.read<u32>(0x100), 1);
+    ASSERT_TRUE(memory.consume_watch_hits().empty());
+
+    // only accesses of a watch's kind hit it
+    memory.store<u32>(0x100, 2);
+    memory.load<u32>(0x200);
+    ASSERT_TRUE(memory.consume_watch_hits().empty());
+
+    // overlapping the watch is enough, the hit has the address of the access
+    memory.load<u16>(0x102);
+    memory.store<u64>(0x1FC, 3);
+    memory.load<u8>(0x104);
+    auto hits = memory.consume_watch_hits();
+    ASSERT_EQ(hits.size(), 2);
+    ASSERT_EQ(hits[0].watch, read_watch);
+    ASSERT_EQ(hits[0].address, 0x102);
+    ASSERT_EQ(hits[0].access, rv::memory_access_type::read);
+    ASSERT_EQ(hits[1].watch, write_watch);
+    ASSERT_EQ(hits[1].address, 0x1FC);
+    ASSERT_EQ(hits[1].access, rv::memory_access_type::write);
+
+    // a watch across a page boundary, hit from either page and by consecutive elements as a single access, the first load ends right below it
+    memory.load<u32>(0x2FF8);
+    memory.store<u32>(0x3000, 4);
+    auto elements = std::array<u32, 4>{};
+    memory.load(0x2FF0, std::span<u32>(elements));
+    hits = memory.consume_watch_hits();
+    ASSERT_EQ(hits.size(), 2);
+    ASSERT_EQ(hits[0].access, rv::memory_access_type::write);
+    ASSERT_EQ(hits[0].address, 0x3000);
+    ASSERT_EQ(hits[1].access, rv::memory_access_type::read);
+    ASSERT_EQ(hits[1].address, 0x2FF0);
+
+    ASSERT_TRUE(memory.remove_watch(access_watch));
+    ASSERT_FALSE(memory.remove_watch(access_watch));
+    memory.store<u32>(0x3000, 5);
+    ASSERT_TRUE(memory.consume_watch_hits().empty());
+}
+
+TEST(memory_watch, bounded_hits) {
+    auto memory = memory_type(0x1000);
+    memory.add_watch({0x100, 4, rv::watch_type::access});
+
+    for (usize i = 0; i < memory_type::max_watch_hits * 4; i++) {
+        memory.load<u32>(0x100);
+    }
+
+    // the first ones are kept
+    ASSERT_EQ(memory.consume_watch_hits().size(), memory_type::max_watch_hits);
+    ASSERT_TRUE(memory.consume_watch_hits().empty());
+
+    memory.store<u32>(0x100, 0);
+    ASSERT_EQ(memory.consume_watch_hits().size(), 1);
+}
+
+TEST(memory_generations, tracking_starts_with_the_first_advance) {
+    auto memory = memory_type(0x3000);
+    const auto initial = memory.page_generation(0);
+
+    // nobody asked for the pages written since any point yet
+    memory.write<u32>(0x0, 1);
+    ASSERT_EQ(memory.page_generation(0), initial);
+
+    const auto since = memory.advance_generation();
+    memory.write<u32>(0x1000, 2);
+    memory.store(0x1FFC, std::span<const u32>(std::array<u32, 2>{3, 4}));
+    ASSERT_LE(memory.page_generation(0), since);
+    ASSERT_GT(memory.page_generation(1), since);
+    ASSERT_GT(memory.page_generation(2), since);
+
+    // writes from outside that are marked by hand count either way
+    memory.mark_written(0x0, 4);
+    ASSERT_GT(memory.page_generation(0), since);
+}
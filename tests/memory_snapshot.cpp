@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include <rv/rv.hpp>
+
+
+namespace {
+
+using namespace rv::detail::assembler;
+using rv::alu_action;
+using rv::reg;
+
+using rv64_type = rv::risc_v<u64>;
+using memory_type = rv::memory<u64>;
+
+}  // namespace
+
+TEST(memory_snapshot, dirty_pages) {
+    auto memory = memory_type(0x4000);
+    auto snapshot = rv::memory_snapshot<memory_type>(memory.size());
+
+    // nothing to take before the first publication
+    ASSERT_FALSE(snapshot.take());
+    ASSERT_TRUE(snapshot.can_publish());
+
+    // every page of both buffers gets copied once
+    memory.write<u32>(0x1000, 0xDEAD'BEEF);
+    snapshot.publish(memory);
+    ASSERT_FALSE(snapshot.can_publish());
+    ASSERT_TRUE(snapshot.take());
+    ASSERT_EQ(snapshot.pages_copied(), 4);
+    ASSERT_EQ(snapshot.read<u32>(0x1000), 0xDEAD'BEEF);
+    ASSERT_EQ(snapshot.read<u32>(0x4000), 0);
+
+    snapshot.publish(memory);
+    ASSERT_TRUE(snapshot.take());
+    ASSERT_EQ(snapshot.pages_copied(), 8);
+    ASSERT_EQ(snapshot.read<u32>(0x1000), 0xDEAD'BEEF);
+
+    // from here on only what was written since a buffer was last published
+    const auto before = snapshot.read<u32>(0x2FFE);
+    memory.write<u32>(0x2FFE, 0x0102'0304);
+    snapshot.publish(memory);
+
+    // the reader keeps looking at what it had until it takes the publication
+    ASSERT_EQ(snapshot.read<u32>(0x2FFE), before);
+    ASSERT_TRUE(snapshot.take());
+    ASSERT_EQ(snapshot.pages_copied(), 10);
+    ASSERT_EQ(snapshot.read<u32>(0x2FFE), 0x0102'0304);
+
+    // the other buffer catches up on the same pages
+    snapshot.publish(memory);
+    ASSERT_TRUE(snapshot.take());
+    ASSERT_EQ(snapshot.pages_copied(), 12);
+    ASSERT_EQ(snapshot.read<u32>(0x2FFE), 0x0102'0304);
+
+    snapshot.publish(memory);
+    ASSERT_TRUE(snapshot.take());
+    ASSERT_EQ(snapshot.pages_copied(), 12);
+}
+
+TEST(memory_snapshot, instruction_listing) {
+    auto risc_v = rv64_type(rv::is_rv64<rv64_type>, 0x4000);
+    auto& memory = risc_v.m_memory;
+    std::fill_n(memory.data(), memory.size(), 0);
+    memory.mark_written(0, memory.size());
+
+    // both buffers get everything once
+    auto snapshot = rv::memory_snapshot<memory_type>(memory.size());
+    for (auto i = 0; i < 2; i++) {
+        snapshot.publish(memory);
+        ASSERT_TRUE(snapshot.take());
+    }
+
+    auto listing = rv::instruction_listing<rv64_type>{};
+    listing.update(snapshot, 0);
+    ASSERT_EQ(listing.layouts(), 4);
+    ASSERT_EQ(listing.row_text(risc_v, *listing.row_of(0x2000)), "c.invalid");
+
+    // the listing only sees the write once the publication with it is taken
+    memory.write<u32>(0x2000, alu<alu_action::add>(reg::a0, reg::a1, reg::a2));
+    snapshot.publish(memory);
+    listing.update(snapshot, 0);
+    ASSERT_EQ(listing.layouts(), 4);
+
+    ASSERT_TRUE(snapshot.take());
+    listing.update(snapshot, 0);
+    ASSERT_EQ(listing.layouts(), 7);
+    ASSERT_EQ(listing.row_text(risc_v, *listing.row_of(0x2000), true), "add a0, a1, a2");
+}
@@ -0,0 +1,53 @@
+#include <gtest/gtest.h>
+
+#include "./common.hpp"
+
+#include <rv/rv.hpp>
+
+#include <sstream>
+
+namespace {
+
+using namespace rv::detail::assembler;
+using rv::alu_action;
+using rv::reg;
+
+using profiled_risc_v = rv::risc_v<u64, std::allocator<u8>, rv::profiler_observer>;
+
+}  // namespace
+
+TEST(profiler, collapsed_stacks) {
+    // clang-format off
+    const u32 program[] {
+        jal(reg::ra, 8),                                                // 0x00: call 0x08
+        jal(reg::zero, 0),                                              // 0x04: j .
+        alu_i<alu_action::add, false>(reg::sp, reg::ra, 0),             // 0x08: mv sp, ra
+        jal(reg::ra, 12),                                               // 0x0C: call 0x18
+        jalr(reg::zero, reg::sp, 0),                                    // 0x10: jr sp
+        jal(reg::zero, 0),                                              // 0x14
+        alu_i<alu_action::add, false>(reg::a0, reg::zero, 64),          // 0x18: li a0, 64
+        alu_i<alu_action::add, false>(reg::a0, reg::a0, -1),            // 0x1C: addi a0, a0, -1
+        branch<branch_type::not_equal>(reg::a0, reg::zero, -4),         // 0x20: bnez a0, 0x1C
+        jalr(reg::zero, reg::ra, 0),                                    // 0x24: ret
+    };
+    // clang-format on
+
+    auto risc_v = profiled_risc_v(rv::is_rv64<profiled_risc_v>, 0x1000, {}, rv::profiler_observer{rv::profiler_config{.interval_instructions = 1}});
+    load_program(risc_v, program);
+
+    auto& profiler = risc_v.m_observer.m_profiler;
+    profiler.set_enabled(true);
+
+    // `jr sp` is not a return as far as the link register hints go, `main` is never popped
+    const auto executed = risc_v.run(1000);
+    ASSERT_EQ(risc_v.m_program_counter, 0x04);
+
+    profiler.drain();
+    ASSERT_EQ(profiler.total_samples(), executed);
+    ASSERT_EQ(profiler.dropped_samples(), 0);
+
+    auto ss = std::stringstream{};
+    profiler.write_collapsed(ss);
+
+    ASSERT_EQ(ss.str(), "0x0 1\n0x8 4\n0x8;0x18 130\n");
+}
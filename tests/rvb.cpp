@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+
+#include "./common.hpp"
+
+#include <rv/rv.hpp>
+
+namespace {
+
+using namespace rv::detail::assembler;
+using rv::reg;
+
+constexpr auto op(u32 opcode, u32 funct_7, u32 funct_3, reg rd, reg rs_1, reg rs_2) -> u32 {
+    return r_type(opcode, funct_7, funct_3, x(rd), x(rs_1), x(rs_2));
+}
+
+constexpr auto op_imm(u32 opcode, u32 funct_12, u32 funct_3, reg rd, reg rs_1) -> u32 { return asm_immediate(funct_12, rs_1, funct_3, rd, opcode); }
+
+constexpr u32 reg_reg = 0b01100'11;
+constexpr u32 reg_reg_word = 0b01110'11;
+constexpr u32 reg_imm = 0b00100'11;
+constexpr u32 reg_imm_word = 0b00110'11;
+
+}  // namespace
+
+TEST(rv_decode, rv64zba_rv64zbb_rv64zbs) {
+    // clang-format off
+    static constexpr std::pair<u32, std::string_view> test_cases[]{
+      {0x20c5a533u, "sh1add x10, x11, x12"},   {0x20c5e533u, "sh3add x10, x11, x12"},  {0x0805853bu, "zext.w x10, x11"},
+      {0x08c5853bu, "add.uw x10, x11, x12"},   {0x20c5c53bu, "sh2add.uw x10, x11, x12"}, {0x0a35951bu, "slli.uw x10, x11, 35"},
+      {0x40c5f533u, "andn x10, x11, x12"},     {0x60059513u, "clz x10, x11"},           {0x60159513u, "ctz x10, x11"},
+      {0x6025951bu, "cpopw x10, x11"},         {0x60559513u, "sext.h x10, x11"},        {0x0805c53bu, "zext.h x10, x11"},
+      {0x2875d513u, "orc.b x10, x11"},         {0x6b85d513u, "rev8 x10, x11"},          {0x0ac5e533u, "max x10, x11, x12"},
+      {0x0ac5d533u, "minu x10, x11, x12"},     {0x6285d513u, "rori x10, x11, 40"},      {0x60c5953bu, "rolw x10, x11, x12"},
+      {0x6075d51bu, "roriw x10, x11, 7"},      {0x48c59533u, "bclr x10, x11, x12"},     {0x4bf5d513u, "bexti x10, x11, 63"},
+      {0x28359513u, "bseti x10, x11, 3"},      {0x68c59533u, "binv x10, x11, x12"},
+      // not a shift with the funct6 of slli.uw
+      {0x0a359513u, "unknown"},
+    };
+    // clang-format on
+
+    run_tests({test_cases}, rv::is_rv64<rv::risc_v<u64>>, false);
+}
+
+TEST(rv_decode, rv32zbb_rv32zbs) {
+    // clang-format off
+    static constexpr std::pair<u32, std::string_view> test_cases[]{
+      {0x6985d513u, "rev8 x10, x11"},  {0x0805c533u, "zext.h x10, x11"},  {0x6b85d513u, "unknown"},
+      {0x6075d513u, "rori x10, x11, 7"},  {0x69f59513u, "binvi x10, x11, 31"},  {0x28359513u, "bseti x10, x11, 3"},
+      // shift amounts and bit indices past 31 are reserved
+      {0x6285d513u, "unknown"},  {0x4bf5d513u, "unknown"},  {0x4a059513u, "unknown"},
+    };
+    // clang-format on
+
+    run_tests({test_cases}, rv::is_rv32<rv::risc_v<u32>>, false);
+}
+
+TEST(rv_bitmanip, execution) {
+    using risc_v_type = rv::risc_v<u64>;
+
+    // clang-format off
+    const u32 program[] {
+        op(reg_reg, 0b00100'00, 0b110, reg::a0, reg::s0, reg::s1),         // 0x00: sh3add
+        op(reg_reg_word, 0b00001'00, 0b000, reg::a1, reg::s2, reg::zero),  // 0x04: zext.w
+        op_imm(reg_imm, 0x600, 0b001, reg::a2, reg::s2),                   // 0x08: clz
+        op_imm(reg_imm_word, 0x601, 0b001, reg::a3, reg::s0),              // 0x0C: ctzw
+        op_imm(reg_imm, 0x602, 0b001, reg::a4, reg::s2),                   // 0x10: cpop
+        op_imm(reg_imm, 0x6B8, 0b101, reg::a5, reg::s3),                   // 0x14: rev8
+        op_imm(reg_imm, 0x287, 0b101, reg::a6, reg::s3),                   // 0x18: orc.b
+        op(reg_reg, 0b00001'01, 0b100, reg::a7, reg::s2, reg::s1),         // 0x1C: min
+        op(reg_reg_word, 0b01100'00, 0b101, reg::t0, reg::s4, reg::s0),    // 0x20: rorw
+        op_imm(reg_imm, (0b001010 << 6) | 63, 0b001, reg::t1, reg::zero),  // 0x24: bseti
+        op(reg_reg, 0b01001'00, 0b101, reg::t2, reg::s2, reg::s5),         // 0x28: bext
+        op_imm(reg_imm, 0x604, 0b001, reg::t3, reg::s3),                   // 0x2C: sext.b
+        jal(reg::zero, 0),                                                 // 0x30: j .
+    };
+    // clang-format on
+
+    auto risc_v = risc_v_type(rv::is_rv64<risc_v_type>, 0x1000);
+    load_program(risc_v, program);
+    risc_v.write_register(reg::s0, u64(8));
+    risc_v.write_register(reg::s1, u64(0x1000));
+    risc_v.write_register(reg::s2, u64(0xFFFF'FFFF'8000'0001));
+    risc_v.write_register(reg::s3, u64(0x0102'0304'0500'0780));
+    risc_v.write_register(reg::s4, u64(0x0000'0000'0000'01FF));
+    risc_v.write_register(reg::s5, u64(31));
+    risc_v.run(std::size(program));
+
+    ASSERT_EQ(risc_v.read_register(reg::a0), 0x1040);
+    ASSERT_EQ(risc_v.read_register(reg::a1), 0x8000'0001);
+    ASSERT_EQ(risc_v.read_register(reg::a2), 0);
+    ASSERT_EQ(risc_v.read_register(reg::a3), 3);
+    ASSERT_EQ(risc_v.read_register(reg::a4), 34);
+    ASSERT_EQ(risc_v.read_register(reg::a5), 0x8007'0005'0403'0201);
+    ASSERT_EQ(risc_v.read_register(reg::a6), 0xFFFF'FFFF'FF00'FFFF);
+    ASSERT_EQ(risc_v.read_register(reg::a7), 0xFFFF'FFFF'8000'0001);
+    ASSERT_EQ(risc_v.read_register(reg::t0), 0xFFFF'FFFF'FF00'0001);
+    ASSERT_EQ(risc_v.read_register(reg::t1), u64(1) << 63);
+    ASSERT_EQ(risc_v.read_register(reg::t2), 1);
+    ASSERT_EQ(risc_v.read_register(reg::t3), 0xFFFF'FFFF'FFFF'FF80);
+}
@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+
+#include "./common.hpp"
+
+#include <rv/rv.hpp>
+
+#include <bit>
+
+namespace {
+
+using namespace rv::detail::assembler;
+using rv::alu_action;
+using rv::float_reg;
+using rv::reg;
+namespace csr = rv::csr_address;
+namespace flags = rv::float_flags;
+
+constexpr u32 rne = 0b000;
+constexpr u32 rtz = 0b001;
+constexpr u32 rdn = 0b010;
+constexpr u32 rup = 0b011;
+constexpr u32 rmm = 0b100;
+constexpr u32 dyn = 0b111;
+
+constexpr auto float_op(u32 funct_5, bool is_double, u32 rm, u32 rd, u32 rs_1, u32 rs_2) -> u32 {
+    return r_type(0b10100'11u, (funct_5 << 2) | static_cast<u32>(is_double), rm, rd, rs_1, rs_2);
+}
+
+constexpr auto f(float_reg reg) -> u32 { return static_cast<u32>(reg); }
+
+constexpr auto fadd(bool is_double, float_reg rd, float_reg rs_1, float_reg rs_2, u32 rm = dyn) -> u32 { return float_op(0b00000, is_double, rm, f(rd), f(rs_1), f(rs_2)); }
+constexpr auto fdiv(bool is_double, float_reg rd, float_reg rs_1, float_reg rs_2, u32 rm = dyn) -> u32 { return float_op(0b00011, is_double, rm, f(rd), f(rs_1), f(rs_2)); }
+constexpr auto fmin(bool is_double, float_reg rd, float_reg rs_1, float_reg rs_2) -> u32 { return float_op(0b00101, is_double, 0b000, f(rd), f(rs_1), f(rs_2)); }
+constexpr auto fcvt_w(bool is_double, reg rd, float_reg rs_1, u32 rm, bool is_unsigned = false) -> u32 { return float_op(0b11000, is_double, rm, x(rd), f(rs_1), is_unsigned); }
+constexpr auto fcvt_s_d(float_reg rd, float_reg rs_1, u32 rm = dyn) -> u32 { return float_op(0b01000, false, rm, f(rd), f(rs_1), 1); }
+constexpr auto fclass(bool is_double, reg rd, float_reg rs_1) -> u32 { return float_op(0b11100, is_double, 0b001, x(rd), f(rs_1), 0); }
+constexpr auto fmv_x(bool is_double, reg rd, float_reg rs_1) -> u32 { return float_op(0b11100, is_double, 0b000, x(rd), f(rs_1), 0); }
+constexpr auto fmv_f(bool is_double, float_reg rd, reg rs_1) -> u32 { return float_op(0b11110, is_double, 0b000, f(rd), x(rs_1), 0); }
+
+}  // namespace
+
+TEST(rv_decode, rv64f_rv64d) {
+    // clang-format off
+    static constexpr std::pair<u32, std::string_view> test_cases[]{
+      {0x00812087u, "flw f1, 8(x2)"},             {0x00112427u, "fsw f1, 8(x2)"},
+      {0x0020f053u, "fadd.s f0, f1, f2"},         {0x00208053u, "fadd.s f0, f1, f2, rne"},   {0x0220f053u, "fadd.d f0, f1, f2"},
+      {0x1820f043u, "fmadd.s f0, f1, f2, f3"},    {0x5800f053u, "fsqrt.s f0, f1"},
+      {0xc0009553u, "fcvt.w.s x10, f1, rtz"},     {0xe0008553u, "fmv.x.w x10, f1"},          {0xa020a553u, "feq.s x10, f1, f2"},
+      {0xe2009553u, "fclass.d x10, f1"},          {0x4200f053u, "fcvt.d.s f0, f1"},          {0x4010f053u, "fcvt.s.d f0, f1"},
+      {0x22209053u, "fsgnjn.d f0, f1, f2"},       {0xd035f053u, "fcvt.s.lu f0, x10"},        {0xf2050053u, "fmv.d.x f0, x10"},
+    };
+    // clang-format on
+
+    run_tests({test_cases}, rv::is_rv64<rv::risc_v<u64>>, false);
+}
+
+TEST(rv_float, rounding_modes) {
+    using risc_v_type = rv::risc_v<u64>;
+
+    // clang-format off
+    const u32 program[] {
+        fdiv(false, float_reg::f3, float_reg::f1, float_reg::f2, rdn),  // 0x00: 1/3
+        fdiv(false, float_reg::f4, float_reg::f1, float_reg::f2, rup),  // 0x04
+        fadd(false, float_reg::f5, float_reg::f1, float_reg::f6, rmm),  // 0x08: 1 + 2^-24, a tie
+        fadd(false, float_reg::f7, float_reg::f1, float_reg::f6, rne),  // 0x0C
+        csrrwi(reg::zero, csr::frm, rup),                               // 0x10
+        fadd(false, float_reg::f8, float_reg::f1, float_reg::f6),       // 0x14: dynamic, so rup
+        fcvt_w(false, reg::a0, float_reg::f9, rne),                     // 0x18: 2.5
+        fcvt_w(false, reg::a1, float_reg::f9, rmm),                     // 0x1C
+        fcvt_w(false, reg::a2, float_reg::f9, 0b101),                   // 0x20: illegal, skipped by the handler
+        csrrs(reg::a3, csr::fcsr, reg::zero),                           // 0x24
+        jal(reg::zero, 0),                                              // 0x28: j .
+    };
+    // clang-format on
+
+    auto risc_v = risc_v_type(rv::is_rv64<risc_v_type>, 0x1000);
+    load_program(risc_v, program);
+    risc_v.write_float(float_reg::f1, 1.f);
+    risc_v.write_float(float_reg::f2, 3.f);
+    risc_v.write_float(float_reg::f6, 0x1p-24f);
+    risc_v.write_float(float_reg::f9, 2.5f);
+    risc_v.write_register(reg::a2, u64(0x1234));
+    load_skipping_trap_handler(risc_v, 0x200);
+    risc_v.run(100);
+
+    const auto down = risc_v.read_float<float>(float_reg::f3);
+    const auto up = risc_v.read_float<float>(float_reg::f4);
+    ASSERT_LT(static_cast<double>(down), 1. / 3.);
+    ASSERT_GT(static_cast<double>(up), 1. / 3.);
+    ASSERT_EQ(std::bit_cast<u32>(up) - std::bit_cast<u32>(down), 1);
+
+    ASSERT_EQ(risc_v.read_float<float>(float_reg::f5), 0x1.000002p+0f);
+    ASSERT_EQ(risc_v.read_float<float>(float_reg::f7), 1.f);
+    ASSERT_EQ(risc_v.read_float<float>(float_reg::f8), 0x1.000002p+0f);
+
+    ASSERT_EQ(risc_v.read_register(reg::a0), 2);
+    ASSERT_EQ(risc_v.read_register(reg::a1), 3);
+    ASSERT_EQ(risc_v.read_register(reg::a2), 0x1234);
+    ASSERT_EQ(risc_v.read_register(reg::s10), rv::trap_cause::illegal_instruction);
+    ASSERT_EQ(risc_v.read_register(reg::s11), program[8]);
+    ASSERT_EQ(risc_v.read_register(reg::a3), (rup << 5) | flags::inexact);
+}
+
+TEST(rv_float, exceptions) {
+    using risc_v_type = rv::risc_v<u64>;
+
+    // clang-format off
+    const u32 program[] {
+        fdiv(false, float_reg::f3, float_reg::f1, float_reg::f0),  // 0x00: 1/0
+        csrrs(reg::a0, csr::fflags, reg::zero),                    // 0x04
+        csrrwi(reg::zero, csr::fflags, 0),                         // 0x08
+        fdiv(false, float_reg::f4, float_reg::f0, float_reg::f0),  // 0x0C: 0/0
+        csrrs(reg::a1, csr::fflags, reg::zero),                    // 0x10
+        csrrwi(reg::zero, csr::fflags, 0),                         // 0x14
+        fcvt_w(false, reg::a2, float_reg::f4, rtz),                // 0x18: NaN
+        fcvt_w(false, reg::a3, float_reg::f5, rtz, true),          // 0x1C: -1 to unsigned
+        csrrs(reg::a4, csr::fflags, reg::zero),                    // 0x20
+        jal(reg::zero, 0),                                         // 0x24: j .
+    };
+    // clang-format on
+
+    auto risc_v = risc_v_type(rv::is_rv64<risc_v_type>, 0x1000);
+    load_program(risc_v, program);
+    risc_v.write_float(float_reg::f0, 0.f);
+    risc_v.write_float(float_reg::f1, 1.f);
+    risc_v.write_float(float_reg::f5, -1.f);
+    risc_v.run(std::size(program));
+
+    ASSERT_EQ(risc_v.read_float<float>(float_reg::f3), std::numeric_limits<float>::infinity());
+    ASSERT_EQ(risc_v.read_register(reg::a0), flags::divide_by_zero);
+
+    ASSERT_EQ(std::bit_cast<u32>(risc_v.read_float<float>(float_reg::f4)), 0x7FC0'0000);
+    ASSERT_EQ(risc_v.read_register(reg::a1), flags::invalid);
+
+    ASSERT_EQ(risc_v.read_register(reg::a2), 0x7FFF'FFFF);
+    ASSERT_EQ(risc_v.read_register(reg::a3), 0);
+    ASSERT_EQ(risc_v.read_register(reg::a4), flags::invalid);
+}
+
+TEST(rv_float, nan_boxing_and_moves) {
+    using risc_v_type = rv::risc_v<u64>;
+
+    // clang-format off
+    const u32 program[] {
+        fadd(false, float_reg::f2, float_reg::f1, float_reg::f1),    // 0x00: f1 is not properly boxed
+        fmv_f(false, float_reg::f3, reg::a0),                        // 0x04
+        fmv_x(false, reg::a1, float_reg::f3),                        // 0x08: sign extended
+        fmv_x(true, reg::a2, float_reg::f4),                         // 0x0C
+        fcvt_s_d(float_reg::f5, float_reg::f4),                      // 0x10
+        fmin(false, float_reg::f6, float_reg::f7, float_reg::f8),    // 0x14: fmin(+0, -0)
+        fclass(false, reg::a3, float_reg::f6),                       // 0x18
+        fclass(true, reg::a4, float_reg::f3),                        // 0x1C: a boxed single is a quiet NaN as a double
+        jal(reg::zero, 0),                                           // 0x20: j .
+    };
+    // clang-format on
+
+    auto risc_v = risc_v_type(rv::is_rv64<risc_v_type>, 0x1000);
+    load_program(risc_v, program);
+    risc_v.m_register_bank.write_register(float_reg::f1, u64(0x3F80'0000));
+    risc_v.write_register(reg::a0, u64(0xBF80'0000));
+    risc_v.write_float(float_reg::f4, -2.5);
+    risc_v.write_float(float_reg::f7, 0.f);
+    risc_v.write_float(float_reg::f8, -0.f);
+    risc_v.run(std::size(program));
+
+    ASSERT_EQ(risc_v.m_register_bank.read_register(float_reg::f2), 0xFFFF'FFFF'7FC0'0000);
+    ASSERT_EQ(risc_v.m_register_bank.read_register(float_reg::f3), 0xFFFF'FFFF'BF80'0000);
+    ASSERT_EQ(risc_v.read_register(reg::a1), 0xFFFF'FFFF'BF80'0000);
+    ASSERT_EQ(risc_v.read_register(reg::a2), std::bit_cast<u64>(-2.5));
+    ASSERT_EQ(risc_v.read_float<float>(float_reg::f5), -2.5f);
+    ASSERT_TRUE(std::signbit(risc_v.read_float<float>(float_reg::f6)));
+    ASSERT_EQ(risc_v.read_register(reg::a3), 1u << 3);
+    ASSERT_EQ(risc_v.read_register(reg::a4), 1u << 9);
+}
+
+TEST(rv_float, compressed_loads_and_stores) {
+    using risc_v_type = rv::risc_v<u64>;
+
+    // clang-format off
+    const u32 program[] {
+        0x24A2'A422u,    // 0x00: c.fsdsp f8, 8(sp); c.fldsp f9, 8(sp)
+        jal(reg::zero, 0),  // 0x04: j .
+    };
+    // clang-format on
+
+    auto risc_v = risc_v_type(rv::is_rv64<risc_v_type>, 0x1000);
+    load_program(risc_v, program);
+    risc_v.write_register(reg::sp, u64(0x800));
+    risc_v.write_float(float_reg::f8, 0.1);
+    risc_v.run(2);
+
+    ASSERT_EQ(risc_v.m_memory.template read<u64>(0x808), std::bit_cast<u64>(0.1));
+    ASSERT_EQ(risc_v.read_float<double>(float_reg::f9), 0.1);
+}
@@ -73,9 +73,45 @@ TEST(rv_decode, rv32zifencei) {
 }
 
 TEST(rv_decode, rv32zicsr) {
-    /*static constexpr std::pair<u32, std::string_view> test_cases[]{
+    static constexpr std::pair<u32, std::string_view> test_cases[]{
+      {0xc00020f3u, "csrrs x1, cycle, x0"},          {0xc0202573u, "csrrs x10, instret, x0"},     {0xc80022f3u, "csrrs x5, cycleh, x0"},
+      {0xb0059073u, "csrrw x0, mcycle, x11"},        {0xb8309173u, "csrrw x2, mhpmcounter3h, x1"}, {0xb03fbff3u, "csrrc x31, mhpmcounter3, x31"},
+      {0x3202d073u, "csrrwi x0, mcountinhibit, 5"},  {0x3231e673u, "csrrsi x12, mhpmevent3, 3"},  {0x7c0171f3u, "csrrci x3, 0x7c0, 2"},
+    };
+
+    run_tests({test_cases}, rv::detail::is_rv32zicsr<rv::risc_v<u32>>, false);
+    run_tests({test_cases}, rv::detail::is_rv32zicsr<rv::risc_v<u64>>, false);
+}
+
+TEST(rv_execute, rv64i_bit_31) {
+    using namespace rv::detail::assembler;
+    using rv::alu_action;
+    using rv::reg;
+    using risc_v_type = rv::risc_v<u64>;
 
+    // clang-format off
+    const u32 program[] {
+        li(reg::a0, 1),                                              // 0x00
+        alu_i<alu_action::sll>(reg::a0, reg::a0, 31),                // 0x04: 0x8000'0000
+        alu<alu_action::add>(reg::a1, reg::a0, reg::a0),             // 0x08
+        alu<alu_action::add, true>(reg::a2, reg::a0, reg::zero),     // 0x0C: addw sign extends
+        alu_i<alu_action::srl>(reg::a3, reg::a2, 32),                // 0x10
+        jal(reg::zero, 0),                                           // 0x14: j .
     };
+    // clang-format on
+
+    auto risc_v = risc_v_type(rv::is_rv64<risc_v_type>, 0x1000);
+    load_program(risc_v, program);
+    risc_v.run(100);
+
+    // 64-bit results keep bit 31 as it is, only 32-bit values get sign extended on their way into a register
+    ASSERT_EQ(risc_v.read_register(reg::a0), 0x8000'0000);
+    ASSERT_EQ(risc_v.read_register(reg::a1), 0x1'0000'0000);
+    ASSERT_EQ(risc_v.read_register(reg::a2), 0xFFFF'FFFF'8000'0000);
+    ASSERT_EQ(risc_v.read_register(reg::a3), 0xFFFF'FFFF);
 
-    run_tests<rv::detail::is_rv32zicsr>({test_cases}, false);*/
+    risc_v.write_register(reg::a4, u32(0x8000'0000));
+    risc_v.write_register(reg::a5, u64(0x8000'0000));
+    ASSERT_EQ(risc_v.read_register(reg::a4), 0xFFFF'FFFF'8000'0000);
+    ASSERT_EQ(risc_v.read_register(reg::a5), 0x8000'0000);
 }
@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+
+#include "./common.hpp"
+
+#include <rv/rv.hpp>
+
+namespace {
+
+using namespace rv::detail::assembler;
+using rv::reg;
+namespace csr = rv::csr_address;
+
+/// e32, m2, ta, mu
+constexpr u32 e32_m2 = 0b0101'0001;
+
+constexpr auto vsetvli(reg rd, reg rs_1, u32 vtype) -> u32 { return (vtype << 20) | (x(rs_1) << 15) | (0b111u << 12) | (x(rd) << 7) | 0b10101'11u; }
+
+constexpr auto vector_op(u32 funct_6, u32 category, u32 vd, u32 vs_2, u32 vs_1, bool masked = false) -> u32 {
+    return r_type(0b10101'11u, (funct_6 << 1) | static_cast<u32>(!masked), category, vd, vs_2, vs_1);
+}
+
+constexpr auto vle32(u32 vd, reg rs_1) -> u32 { return (1u << 25) | (x(rs_1) << 15) | (0b110u << 12) | (vd << 7) | 0b00001'11u; }
+constexpr auto vse32(u32 vs_3, reg rs_1, bool masked = false) -> u32 { return (static_cast<u32>(!masked) << 25) | (x(rs_1) << 15) | (0b110u << 12) | (vs_3 << 7) | 0b01001'11u; }
+constexpr auto vlse32(u32 vd, reg rs_1, reg rs_2) -> u32 { return (0b10u << 26) | (1u << 25) | (x(rs_2) << 20) | (x(rs_1) << 15) | (0b110u << 12) | (vd << 7) | 0b00001'11u; }
+
+constexpr auto vadd_vv(u32 vd, u32 vs_2, u32 vs_1) -> u32 { return vector_op(0b000000, 0b000, vd, vs_2, vs_1); }
+constexpr auto vmul_vx(u32 vd, u32 vs_2, reg rs_1, bool masked) -> u32 { return vector_op(0b100101, 0b110, vd, vs_2, x(rs_1), masked); }
+constexpr auto vmslt_vx(u32 vd, u32 vs_2, reg rs_1) -> u32 { return vector_op(0b011011, 0b100, vd, vs_2, x(rs_1)); }
+constexpr auto vredsum_vs(u32 vd, u32 vs_2, u32 vs_1) -> u32 { return vector_op(0b000000, 0b010, vd, vs_2, vs_1); }
+constexpr auto vmv_s_x(u32 vd, reg rs_1) -> u32 { return vector_op(0b010000, 0b110, vd, 0, x(rs_1)); }
+constexpr auto vmv_x_s(reg rd, u32 vs_2) -> u32 { return vector_op(0b010000, 0b010, x(rd), vs_2, 0); }
+constexpr auto vcpop_m(reg rd, u32 vs_2) -> u32 { return vector_op(0b010000, 0b010, x(rd), vs_2, 0b10000); }
+
+}  // namespace
+
+TEST(rv_decode, rvv) {
+    // clang-format off
+    static constexpr std::pair<u32, std::string_view> test_cases[]{
+      {0x0d0572d7u, "vsetvli x5, x10, e32, m1, ta, ma"},  {0xc11272d7u, "vsetivli x5, 4, e32, m2, tu, mu"},
+      {0x0205e107u, "vle32.v v2, (x11)"},                 {0x08c5f227u, "vsse64.v v4, (x11), x12, v0.t"},  {0x02b58007u, "vlm.v v0, (x11)"},
+      {0x02220357u, "vadd.vv v6, v2, v4"},                {0x002fb357u, "vadd.vi v6, v2, -1, v0.t"},       {0x6e27c057u, "vmslt.vx v0, v2, x15"},
+      {0xb6222357u, "vmacc.vv v6, v4, v2"},               {0x5e01b457u, "vmv.v.i v8, 3"},                  {0x02642557u, "vredsum.vs v10, v6, v8"},
+      {0x42082857u, "vcpop.m x16, v0"},                   {0x661121d7u, "vmand.mm v3, v1, v2"},
+    };
+    // clang-format on
+
+    run_tests({test_cases}, rv::is_rv64<rv::risc_v<u64>>, false);
+}
+
+TEST(rv_vector, integer_kernel) {
+    using risc_v_type = rv::risc_v<u64>;
+
+    // clang-format off
+    const u32 program[] {
+        vsetvli(reg::t0, reg::a0, e32_m2),       // 0x00: asks for 10, VLMAX is 8
+        vle32(2, reg::a1),                       // 0x04
+        vle32(4, reg::a2),                       // 0x08
+        vadd_vv(6, 2, 4),                        // 0x0C
+        vse32(6, reg::a3),                       // 0x10
+        vmv_s_x(8, reg::zero),                   // 0x14
+        vredsum_vs(10, 6, 8),                    // 0x18
+        vmv_x_s(reg::a4, 10),                    // 0x1C
+        vmslt_vx(0, 2, reg::a5),                 // 0x20: the first 4 elements
+        vcpop_m(reg::a6, 0),                     // 0x24
+        vmul_vx(6, 2, reg::a5, true),            // 0x28: the rest stay undisturbed
+        vse32(6, reg::a7),                       // 0x2C
+        jal(reg::zero, 0),                       // 0x30: j .
+    };
+    // clang-format on
+
+    auto risc_v = risc_v_type(rv::is_rv64<risc_v_type>, 0x1000);
+    load_program(risc_v, program);
+
+    for (u32 i = 0; i < 8; i++) {
+        risc_v.m_memory.template write<u32>(0x400 + i * 4, i);
+        risc_v.m_memory.template write<u32>(0x500 + i * 4, 100 * i);
+    }
+
+    // right past where the sum gets stored
+    risc_v.m_memory.template write<u32>(0x620, 0xDEAD'BEEF);
+
+    risc_v.write_register(reg::a0, u64(10));
+    risc_v.write_register(reg::a1, u64(0x400));
+    risc_v.write_register(reg::a2, u64(0x500));
+    risc_v.write_register(reg::a3, u64(0x600));
+    risc_v.write_register(reg::a5, u64(4));
+    risc_v.write_register(reg::a7, u64(0x700));
+    risc_v.run(std::size(program));
+
+    ASSERT_EQ(risc_v.read_register(reg::t0), 8);
+
+    for (u32 i = 0; i < 8; i++) {
+        ASSERT_EQ(risc_v.m_memory.template read<u32>(0x600 + i * 4), 101 * i);
+        ASSERT_EQ(risc_v.m_memory.template read<u32>(0x700 + i * 4), i < 4 ? 4 * i : 101 * i);
+    }
+
+    // past vl
+    ASSERT_EQ(risc_v.m_memory.template read<u32>(0x620), 0xDEAD'BEEF);
+
+    ASSERT_EQ(risc_v.read_register(reg::a4), 101 * 28);
+    ASSERT_EQ(risc_v.read_register(reg::a6), 4);
+}
+
+TEST(rv_vector, configuration) {
+    using risc_v_type = rv::risc_v<u64>;
+
+    // clang-format off
+    const u32 program[] {
+        vsetvli(reg::t0, reg::zero, e32_m2),     // 0x00: VLMAX
+        csrrs(reg::t1, csr::vlenb, reg::zero),   // 0x04
+        vlse32(2, reg::a1, reg::a2),             // 0x08: every other word
+        vsetvli(reg::t2, reg::a0, 0b0001'0101),  // 0x0C: e32, mf8 is reserved
+        csrrs(reg::t3, csr::vtype, reg::zero),   // 0x10
+        vmv_x_s(reg::t4, 2),                     // 0x14: illegal with vill set, t4 stays as it is and the handler skips it
+        jal(reg::zero, 0),                       // 0x18: j .
+    };
+    // clang-format on
+
+    auto risc_v = risc_v_type(rv::is_rv64<risc_v_type>, 0x1000);
+    risc_v.m_vector = rv::vector_register_file(256);
+    load_program(risc_v, program);
+
+    for (u32 i = 0; i < 32; i++) {
+        risc_v.m_memory.template write<u32>(0x400 + i * 4, i);
+    }
+
+    risc_v.write_register(reg::a0, u64(4));
+    risc_v.write_register(reg::a1, u64(0x400));
+    risc_v.write_register(reg::a2, u64(8));
+    risc_v.write_register(reg::t4, u64(0x1234));
+    load_skipping_trap_handler(risc_v, 0x800);
+    risc_v.run(100);
+
+    ASSERT_EQ(risc_v.read_register(reg::t0), 16);
+    ASSERT_EQ(risc_v.read_register(reg::t1), 32);
+    ASSERT_EQ(risc_v.read_register(reg::t2), 0);
+    ASSERT_EQ(risc_v.read_register(reg::t3), u64(1) << 63);
+    ASSERT_EQ(risc_v.read_register(reg::t4), 0x1234);
+    ASSERT_EQ(risc_v.read_register(reg::s10), rv::trap_cause::illegal_instruction);
+    ASSERT_EQ(risc_v.read_register(reg::s11), program[5]);
+
+    auto const* const elements = risc_v.m_vector.group<u32>(2);
+    for (u32 i = 0; i < 16; i++) {
+        ASSERT_EQ(elements[i], 2 * i);
+    }
+}
@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+
+#include "./common.hpp"
+
+#include <rv/rv.hpp>
+
+#include <atomic>
+#include <thread>
+
+namespace {
+
+using namespace rv::detail::assembler;
+using rv::alu_action;
+using rv::reg;
+
+using counted_risc_v = rv::risc_v<u64, std::allocator<u8>, rv::statistics_observer>;
+
+}  // namespace
+
+TEST(rv_statistics, counting) {
+    // clang-format off
+    const u32 program[] {
+        li(reg::a0, 3),                                              // 0x00
+        alu_i<alu_action::add, false>(reg::a0, reg::a0, -1),         // 0x04
+        branch<branch_type::not_equal>(reg::a0, reg::zero, -4),      // 0x08
+        0x0001'0001,                                                 // 0x0C: c.nop; c.nop
+        jal(reg::zero, 0),                                           // 0x10: j .
+    };
+    // clang-format on
+
+    auto const& isa = rv::is_rv64<counted_risc_v>;
+    auto risc_v = counted_risc_v(isa, 0x1000, {}, rv::statistics_observer(isa.num_instructions()));
+    load_program(risc_v, program);
+    risc_v.run(100);
+
+    auto const& statistics = risc_v.m_observer.m_statistics;
+    ASSERT_EQ(statistics.total(), 1 + 3 + 3 + 2 + 1);
+    ASSERT_EQ(statistics.slot_count(isa.match_slot(program[1])), 4);
+    ASSERT_EQ(statistics.slot_count(isa.match_slot(program[2])), 3);
+    ASSERT_EQ(statistics.slot_count(isa.match_slot(0x0001)), 2);
+
+    const auto per_standard = statistics.per_standard(isa);
+    ASSERT_EQ(per_standard.at(rv::instruction_standard::RV32I), 1 + 3 + 3 + 1);
+    ASSERT_EQ(per_standard.at(rv::instruction_standard::RV32C), 2);
+    ASSERT_EQ(statistics.event_count(isa, rv::hpm_event::branches), 3);
+    ASSERT_EQ(statistics.event_count(isa, rv::hpm_event::compressed), 2);
+}
+
+TEST(rv_statistics, reset) {
+    // clang-format off
+    const u32 program[] {
+        li(reg::a0, 1),                                              // 0x00
+        li(reg::a1, 2),                                              // 0x04
+        li(reg::a2, 3),                                              // 0x08
+        jal(reg::zero, 0),                                           // 0x0C: j .
+    };
+    // clang-format on
+
+    auto const& isa = rv::is_rv64<counted_risc_v>;
+    auto risc_v = counted_risc_v(isa, 0x1000, {}, rv::statistics_observer(isa.num_instructions()));
+    load_program(risc_v, program);
+
+    auto& statistics = risc_v.m_observer.m_statistics;
+    risc_v.run(2);
+    ASSERT_EQ(statistics.total(), 2);
+
+    statistics.reset();
+    ASSERT_EQ(statistics.total(), 0);
+    ASSERT_EQ(statistics.slot_count(isa.match_slot(program[0])), 0);
+
+    // only what ran after the reset
+    risc_v.run(100);
+    ASSERT_EQ(statistics.total(), 2);
+    ASSERT_EQ(statistics.slot_count(isa.match_slot(program[0])), 1);
+    ASSERT_EQ(statistics.slot_count(isa.match_slot(program[3])), 1);
+}
+
+TEST(rv_statistics, reset_while_counting) {
+    constexpr u64 num_counts = 1'000'000;
+
+    auto statistics = rv::execution_statistics(4);
+    auto started = std::atomic<bool>{false};
+
+    auto worker = std::thread([&] {
+        for (u64 i = 0; i < num_counts; i++) {
+            statistics.count(1);
+            if (i == num_counts / 4) {
+                started.store(true, std::memory_order_release);
+            }
+        }
+    });
+
+    while (!started.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+
+    statistics.reset();
+    worker.join();
+
+    // a quarter of the counts were in before the reset, none of them are to come back
+    ASSERT_LT(statistics.slot_count(1), num_counts - num_counts / 4);
+    ASSERT_EQ(statistics.total(), statistics.slot_count(1));
+
+    statistics.reset();
+    ASSERT_EQ(statistics.total(), 0);
+}
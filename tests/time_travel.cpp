@@ -0,0 +1,179 @@
+#include <gtest/gtest.h>
+
+#include <rv/rv.hpp>
+
+namespace {
+
+using namespace rv::detail::assembler;
+using rv::alu_action;
+using rv::reg;
+
+using risc_v_type = rv::risc_v<u64>;
+
+// clang-format off
+const u32 program[] {
+    alu_i<alu_action::add, false>(reg::a0, reg::zero, 0),       // 0x00: li a0, 0
+    lui(reg::a1, 1),                                            // 0x04: lui a1, 1
+    alu_i<alu_action::add, false>(reg::a2, reg::zero, 200),     // 0x08: li a2, 200
+    alu_i<alu_action::add, false>(reg::a0, reg::a0, 1),         // 0x0C: addi a0, a0, 1
+    store<ld_st_type::dword>(reg::a0, 0, reg::a1),              // 0x10: sd a0, 0(a1)
+    store<ld_st_type::dword>(reg::a0, 0x7F8, reg::zero),        // 0x14: sd a0, 0x7F8(zero)
+    alu_i<alu_action::add, false>(reg::a1, reg::a1, 0x100),     // 0x18: addi a1, a1, 0x100
+    branch<branch_type::not_equal>(reg::a0, reg::a2, -16),      // 0x1C: bne a0, a2, 0x0C
+    jal(reg::zero, 0),                                          // 0x20: j .
+};
+// clang-format on
+
+constexpr u64 program_length = 3 + 200 * 5 + 1;
+
+struct state {
+    u64 program_counter;
+    u64 a0;
+    u64 a1;
+    u64 stored;
+
+    constexpr auto operator==(state const&) const -> bool = default;
+};
+
+auto capture(risc_v_type& risc_v) -> state {
+    return {risc_v.m_program_counter, risc_v.read_register(reg::a0), risc_v.read_register(reg::a1), risc_v.m_memory.read<u64>(0x7F8)};
+}
+
+struct time_travel_test : testing::Test {
+    risc_v_type m_risc_v{rv::is_rv64<risc_v_type>, 0x10000};
+    std::vector<state> m_states{};
+
+    /// runs the program to completion one instruction at a time, recording the state before each instruction
+    void run(rv::time_travel<risc_v_type>& time_travel) {
+        while (time_travel.position() < program_length) {
+            m_states.emplace_back(capture(m_risc_v));
+            time_travel.run(1);
+        }
+
+        m_states.emplace_back(capture(m_risc_v));
+    }
+
+    void SetUp() override {
+        for (usize i = 0; i < std::size(program); i++) {
+            m_risc_v.m_memory.write<u32>(i * 4, program[i]);
+        }
+    }
+};
+
+}  // namespace
+
+TEST_F(time_travel_test, seek) {
+    auto time_travel = rv::time_travel<risc_v_type>(m_risc_v, {.checkpoint_interval = 64});
+    run(time_travel);
+
+    ASSERT_EQ(time_travel.num_checkpoints(), program_length / 64 + 1);
+
+    for (const auto position : std::to_array<u64>({0, 1, 500, 63, 64, 65, program_length, 17, 640})) {
+        time_travel.seek(position);
+        ASSERT_EQ(time_travel.position(), position);
+        ASSERT_EQ(capture(m_risc_v), m_states[position]) << position;
+    }
+
+    ASSERT_TRUE(time_travel.reverse_step(3));
+    ASSERT_EQ(capture(m_risc_v), m_states[637]);
+    ASSERT_FALSE(time_travel.reverse_step(1000));
+    ASSERT_EQ(time_travel.position(), 637);
+}
+
+TEST_F(time_travel_test, queries) {
+    auto time_travel = rv::time_travel<risc_v_type>(m_risc_v, {.checkpoint_interval = 100});
+    run(time_travel);
+    time_travel.seek(500);
+
+    const auto last_position_at = [this](u64 program_counter, u64 before) -> u64 {
+        for (auto position = before; position-- != 0;) {
+            if (m_states[position].program_counter == program_counter) {
+                return position;
+            }
+        }
+        return std::numeric_limits<u64>::max();
+    };
+
+    const auto write = time_travel.last_write(0x7FC, 2);
+    ASSERT_TRUE(write);
+    ASSERT_EQ(write->program_counter, 0x14);
+    ASSERT_EQ(write->position, last_position_at(0x14, 500));
+    ASSERT_EQ(time_travel.position(), 500);
+    ASSERT_EQ(capture(m_risc_v), m_states[500]);
+
+    // written once, right at the start
+    const auto first_store = time_travel.last_write(0x1000, 8);
+    ASSERT_TRUE(first_store);
+    ASSERT_EQ(first_store->position, 4);
+    ASSERT_FALSE(time_travel.last_write(0x8000, 8));
+
+    const u64 breakpoints[] {0x20, 0x1C};
+    ASSERT_TRUE(time_travel.reverse_continue(breakpoints));
+    ASSERT_EQ(time_travel.position(), last_position_at(0x1C, 500));
+    ASSERT_EQ(capture(m_risc_v), m_states[time_travel.position()]);
+
+    const u64 unreachable[] {0x24};
+    ASSERT_FALSE(time_travel.reverse_continue(unreachable));
+}
+
+TEST_F(time_travel_test, memory_budget) {
+    constexpr auto budget = 4 * rv::memory<u64>::page_size;
+
+    auto time_travel = rv::time_travel<risc_v_type>(m_risc_v, {.checkpoint_interval = 16, .memory_budget = budget});
+    run(time_travel);
+
+    ASSERT_LE(time_travel.checkpoint_bytes(), budget);
+    ASSERT_GT(time_travel.earliest_position(), 0);
+    ASSERT_FALSE(time_travel.reverse_step(time_travel.position() - time_travel.earliest_position() + 1));
+
+    for (auto position = time_travel.earliest_position(); position <= program_length; position += 37) {
+        time_travel.seek(position);
+        ASSERT_EQ(capture(m_risc_v), m_states[position]) << position;
+    }
+}
+
+TEST(time_travel, devices) {
+    constexpr u64 clint_address = 0x0200'0000;
+    constexpr u64 uart_address = 0x1000'0000;
+
+    // clang-format off
+    const u32 clint_program[] {
+        lui(reg::t0, static_cast<i32>((clint_address + rv::clint::mtimecmp_offset) >> 12)),  // 0x00
+        alu_i<alu_action::add, false>(reg::a0, reg::zero, 100),                                // 0x04: li a0, 100
+        store<ld_st_type::dword>(reg::a0, 0, reg::t0),                                         // 0x08: sd a0, 0(t0)
+        alu_i<alu_action::add, false>(reg::a0, reg::zero, 200),                                // 0x0C: li a0, 200
+        store<ld_st_type::dword>(reg::a0, 0, reg::t0),                                         // 0x10: sd a0, 0(t0)
+        jal(reg::zero, 0),                                                                     // 0x14: j .
+    };
+    // clang-format on
+
+    auto clint = rv::clint{};
+    auto uart = rv::uart{};
+    auto risc_v = risc_v_type(rv::is_rv64<risc_v_type>, 0x1000);
+    ASSERT_TRUE(risc_v.map_clint(clint, clint_address));
+    ASSERT_TRUE(risc_v.m_memory.map_device({uart_address, rv::uart::register_span, &uart}));
+    for (usize i = 0; i < std::size(clint_program); i++) {
+        risc_v.m_memory.write<u32>(i * 4, clint_program[i]);
+    }
+
+    auto time_travel = rv::time_travel<risc_v_type>(risc_v, {.checkpoint_interval = 2});
+    time_travel.run(100);
+    const auto end = time_travel.position();
+    ASSERT_EQ(clint.mtimecmp(), 200);
+
+    // the CLINT goes back along with the processor
+    ASSERT_TRUE(time_travel.seek(3));
+    ASSERT_EQ(clint.mtimecmp(), 100);
+    ASSERT_TRUE(time_travel.seek(0));
+    ASSERT_EQ(clint.mtimecmp(), std::numeric_limits<u64>::max());
+    ASSERT_TRUE(time_travel.seek(end));
+    ASSERT_EQ(clint.mtimecmp(), 200);
+
+    // what the UART got from the host isn't recorded
+    ASSERT_TRUE(uart.write_received('x'));
+    ASSERT_FALSE(time_travel.can_go_back());
+    ASSERT_FALSE(time_travel.reverse_step(1));
+    ASSERT_FALSE(time_travel.seek(0));
+    ASSERT_EQ(time_travel.position(), end);
+    ASSERT_EQ(clint.mtimecmp(), 200);
+}
@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+
+#include "./common.hpp"
+
+#include <rv/rv.hpp>
+
+namespace {
+
+using namespace rv::detail::assembler;
+using rv::alu_action;
+using rv::reg;
+
+using timed_risc_v = rv::risc_v<u64, std::allocator<u8>, rv::timing_observer>;
+
+constexpr auto add(reg rd, reg rs_1, reg rs_2) -> u32 { return alu<alu_action::add>(rd, rs_1, rs_2); }
+
+auto run_program(std::span<const u32> program, rv::timing_config config = {}) -> timed_risc_v {
+    auto risc_v = timed_risc_v(rv::is_rv64<timed_risc_v>, 0x1000, {}, rv::timing_observer{config});
+    load_program(risc_v, program);
+
+    risc_v.run(1000);
+    return risc_v;
+}
+
+}  // namespace
+
+TEST(timing, hazards) {
+    // clang-format off
+    const u32 program[] {
+        li(reg::a0, 1),                                     // 0x00
+        li(reg::a1, 2),                                     // 0x04
+        load<ld_st_type::dword>(reg::a2, 0x100, reg::zero), // 0x08
+        add(reg::a3, reg::a2, reg::a0),                     // 0x0C: load-use, 1 stall
+        alu<alu_action::mul>(reg::a4, reg::a0, reg::a1),    // 0x10
+        add(reg::a5, reg::a4, reg::a0),                     // 0x14: 2 stalls
+        alu<alu_action::div>(reg::a6, reg::a1, reg::a0),    // 0x18
+        alu<alu_action::div>(reg::a7, reg::a1, reg::a0),    // 0x1C: 33 stalls for the divider
+        jal(reg::zero, 0),                                  // 0x20: j .
+    };
+    // clang-format on
+
+    const auto risc_v = run_program(program);
+    auto const& model = risc_v.m_observer.m_model;
+
+    ASSERT_EQ(model.stalls().data, 3);
+    ASSERT_EQ(model.stalls().structural, 33);
+    ASSERT_EQ(model.stalls().control, 0);
+    ASSERT_EQ(model.cycles(), std::size(program) + 36);
+}
+
+TEST(timing, control_flow) {
+    // clang-format off
+    const u32 program[] {
+        li(reg::a0, 3),                                             // 0x00
+        branch<branch_type::equal>(reg::a0, reg::zero, 8),          // 0x04: not taken
+        alu_i<alu_action::add, false>(reg::a0, reg::a0, -1),        // 0x08
+        branch<branch_type::not_equal>(reg::a0, reg::zero, -4),     // 0x0C: taken twice
+        jal(reg::ra, 8),                                            // 0x10
+        jal(reg::zero, 0),                                          // 0x14: j .
+        jalr(reg::zero, reg::ra, 0),                                // 0x18: ret
+    };
+    // clang-format on
+
+    const auto risc_v = run_program(program);
+    auto const& model = risc_v.m_observer.m_model;
+
+    // two taken branches, a jal and a jalr
+    ASSERT_EQ(model.stalls().control, 2 * 2 + 1 + 2);
+    ASSERT_EQ(model.cycles(), risc_v.retired_instructions() + model.stalls().control);
+}
+
+TEST(timing, caches_and_counters) {
+    // clang-format off
+    const u32 program[] {
+        asm_immediate(rv::csr_address::mhpmevent3, static_cast<reg>(rv::hpm_event::data_cache_misses), 0b101, reg::zero, 0b11100'11),  // 0x00
+        load<ld_st_type::dword>(reg::a0, 0x100, reg::zero),             // 0x04: miss
+        load<ld_st_type::dword>(reg::a1, 0x108, reg::zero),             // 0x08: same line
+        store<ld_st_type::dword>(reg::zero, 0x200, reg::zero),          // 0x0C: miss
+        asm_immediate(rv::csr_address::cycle, reg::zero, 0b010, reg::a2, 0b11100'11),        // 0x10: rdcycle a2
+        asm_immediate(rv::csr_address::hpmcounter3, reg::zero, 0b010, reg::a3, 0b11100'11),  // 0x14
+        jal(reg::zero, 0),                                              // 0x18: j .
+    };
+    // clang-format on
+
+    const auto config = rv::timing_config{
+      .instruction_cache = rv::cache_config{.size_bytes = 256, .line_bytes = 16, .ways = 1, .miss_penalty = 5},
+      .data_cache = rv::cache_config{.size_bytes = 256, .line_bytes = 16, .ways = 1, .miss_penalty = 10},
+    };
+
+    auto risc_v = run_program(program, config);
+    auto const& model = risc_v.m_observer.m_model;
+
+    ASSERT_EQ(model.instruction_cache()->misses(), 2);
+    ASSERT_EQ(model.data_cache()->misses(), 2);
+    ASSERT_EQ(model.stalls().memory, 2 * 5 + 2 * 10);
+
+    // the reading instruction has been issued and missed itself, there are 4 instructions with 3 misses in front of it
+    ASSERT_EQ(risc_v.read_register(reg::a2), 5 + 2 * 5 + 2 * 10);
+    ASSERT_EQ(risc_v.read_register(reg::a3), 2);
+    ASSERT_EQ(model.cycles(), std::size(program) + model.stalls().memory);
+}
+
+TEST(timing, cycle_attribution) {
+    using profiled_risc_v = rv::risc_v<u64, std::allocator<u8>, rv::observer_list<rv::timing_observer, rv::profiler_observer>>;
+
+    // clang-format off
+    const u32 program[] {
+        jal(reg::ra, 12),                                       // 0x00: call 0x0C
+        jal(reg::ra, 28),                                       // 0x04: call 0x20
+        jal(reg::zero, 0),                                      // 0x08: j .
+        li(reg::a0, 16),                                        // 0x0C: 16 dependent divides
+        alu<alu_action::div>(reg::a1, reg::a0, reg::a0),        // 0x10
+        alu<alu_action::sub>(reg::a0, reg::a0, reg::a1),        // 0x14
+        branch<branch_type::not_equal>(reg::a0, reg::zero, -8), // 0x18
+        jalr(reg::zero, reg::ra, 0),                            // 0x1C: ret
+        li(reg::a0, 16),                                        // 0x20: as many adds
+        alu_i<alu_action::add, false>(reg::a1, reg::a0, 1),     // 0x24
+        alu_i<alu_action::add, false>(reg::a0, reg::a0, -1),    // 0x28
+        branch<branch_type::not_equal>(reg::a0, reg::zero, -8), // 0x2C
+        jalr(reg::zero, reg::ra, 0),                            // 0x30: ret
+    };
+    // clang-format on
+
+    auto observers = rv::observer_list(rv::timing_observer{}, rv::profiler_observer{rv::profiler_config{.mode = rv::sampling_mode::cycle_count, .interval_cycles = 1}});
+    auto risc_v = profiled_risc_v(rv::is_rv64<profiled_risc_v>, 0x1000, {}, std::move(observers));
+    load_program(risc_v, program);
+
+    auto& profiler = risc_v.m_observer.get<rv::profiler_observer>().m_profiler;
+    profiler.set_enabled(true);
+    risc_v.run(1000);
+    profiler.drain();
+
+    // a sample per cycle
+    ASSERT_EQ(profiler.total_samples(), risc_v.m_observer.get<rv::timing_observer>().m_model.cycles());
+
+    const auto samples = profiler.self_samples();
+    ASSERT_EQ(samples[0].first, "0xc");
+    ASSERT_GT(samples[0].second, 16 * 34);
+    ASSERT_EQ(samples[1].first, "0x20");
+    ASSERT_LT(samples[1].second, 16 * 6);
+}
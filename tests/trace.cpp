@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+
+#include "./common.hpp"
+
+#include <rv/rv.hpp>
+
+#include <sstream>
+
+namespace {
+
+using namespace rv::detail::assembler;
+using rv::alu_action;
+using rv::reg;
+
+using traced_risc_v = rv::risc_v<u64, std::allocator<u8>, rv::trace_observer>;
+
+/// runs `words` loaded at address 0 until it halts, returns the trace
+auto trace_program(std::span<const u32> words) -> std::string {
+    auto ss = std::stringstream{};
+
+    {
+        auto risc_v = traced_risc_v(rv::is_rv64<traced_risc_v>, 0x1000, {}, rv::trace_observer{ss});
+        load_program(risc_v, words);
+        risc_v.m_register_bank.write_register(reg::a0, 0x100u);
+        risc_v.run(1000);
+    }
+
+    return ss.str();
+}
+
+// clang-format off
+const u32 program[] {
+    alu_i<alu_action::add, false>(reg::a1, reg::zero, -5),      // 0x00: li a1, -5
+    store<ld_st_type::dword>(reg::a1, 8, reg::a0),              // 0x04: sd a1, 8(a0)
+    load<ld_st_type::word>(reg::a2, 8, reg::a0),                // 0x08: lw a2, 8(a0)
+    jal(reg::zero, 8),                                          // 0x0C: j 0x14
+    jal(reg::zero, 0),                                          // 0x10
+    jal(reg::zero, 0),                                          // 0x14: j .
+};
+// clang-format on
+
+}  // namespace
+
+TEST(trace, round_trip) {
+    auto ss = std::stringstream{trace_program(program)};
+    auto reader = rv::trace_reader::open(ss);
+    ASSERT_TRUE(reader);
+
+    using rv::memory_access_type;
+    using rv::trace_record;
+
+    const trace_record expected[] {
+        {0x00, program[0], {{reg::a1, static_cast<u64>(-5)}}, {}},
+        {0x04, program[1], {}, {{0x108, 8, memory_access_type::write}}},
+        {0x08, program[2], {{reg::a2, static_cast<u64>(-5)}}, {{0x108, 4, memory_access_type::read}}},
+        {0x0C, program[3], {}, {}},
+        {0x14, program[5], {}, {}},
+    };
+
+    for (auto const& record : expected) {
+        ASSERT_EQ(reader->next(), record) << fmt::format("record at {:#x}", record.program_counter);
+    }
+
+    ASSERT_EQ(reader->next(), std::nullopt);
+    ASSERT_EQ(reader->error(), std::nullopt);
+}
+
+TEST(trace, first_divergence) {
+    auto modified_program = std::to_array(program);
+    modified_program[2] = load<ld_st_type::byte>(reg::a2, 8, reg::a0);
+
+    auto lhs_stream = std::stringstream{trace_program(program)};
+    auto rhs_stream = std::stringstream{trace_program(modified_program)};
+    auto lhs = rv::trace_reader::open(lhs_stream);
+    auto rhs = rv::trace_reader::open(rhs_stream);
+    ASSERT_TRUE(lhs && rhs);
+
+    const auto divergence = rv::trace_first_divergence(*lhs, *rhs);
+    ASSERT_TRUE(divergence);
+    ASSERT_EQ(divergence->index, 2);
+    ASSERT_EQ(divergence->lhs->program_counter, 0x08);
+    ASSERT_EQ(divergence->rhs->memory_accesses.front().size, 1);
+
+    auto again = std::stringstream{trace_program(program)};
+    auto reader = rv::trace_reader::open(again);
+    const auto found = rv::trace_find(*reader, [](auto const& record) { return !record.memory_accesses.empty(); });
+    ASSERT_TRUE(found);
+    ASSERT_EQ(found->first, 1);
+}
+
+TEST(trace, truncated) {
+    auto trace = trace_program(program);
+    trace.pop_back();
+
+    auto ss = std::stringstream{trace};
+    auto reader = rv::trace_reader::open(ss);
+    ASSERT_TRUE(reader);
+
+    while (reader->next()) {}
+    ASSERT_TRUE(reader->error());
+}
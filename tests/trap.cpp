@@ -0,0 +1,242 @@
+#include <gtest/gtest.h>
+
+#include "./common.hpp"
+
+#include <rv/rv.hpp>
+
+namespace {
+
+using namespace rv::detail::assembler;
+using rv::alu_action;
+using rv::reg;
+namespace csr = rv::csr_address;
+
+constexpr u32 ecall = 0x0000'0073;
+constexpr u32 ebreak = 0x0010'0073;
+
+constexpr u64 clint_address = 0x0200'0000;
+constexpr u64 handler_address = 0x100;
+
+}  // namespace
+
+TEST(rv_decode, privileged) {
+    // clang-format off
+    static constexpr std::pair<u32, std::string_view> test_cases[]{
+      {0x30200073u, "mret"}, {0x10500073u, "wfi"}, {0x00000073u, "ecall"}, {0x00100073u, "ebreak"},
+      // sret isn't there without S-mode
+      {0x10200073u, "unknown"},
+    };
+    // clang-format on
+
+    run_tests({test_cases}, rv::is_rv64<rv::risc_v<u64>>, false);
+}
+
+TEST(rv_trap, event_queue) {
+    auto queue = rv::event_queue{};
+    ASSERT_EQ(queue.next(), rv::event_queue::never);
+
+    queue.schedule(rv::event_source::timer, 100);
+    queue.schedule(rv::event_source::interrupts, 10);
+    ASSERT_EQ(queue.next(), 10);
+
+    // later deadlines replace earlier ones
+    queue.schedule(rv::event_source::interrupts, 200);
+    ASSERT_EQ(queue.next(), 100);
+
+    auto fired = std::vector<rv::event_source>{};
+    queue.pop_due(150, [&](rv::event_source source) {
+        fired.push_back(source);
+        queue.schedule(rv::event_source::timer, 300);
+    });
+
+    ASSERT_EQ(fired, std::vector{rv::event_source::timer});
+    ASSERT_EQ(queue.next(), 200);
+
+    queue.cancel(rv::event_source::interrupts);
+    ASSERT_EQ(queue.next(), 300);
+}
+
+TEST(rv_trap, exceptions) {
+    using risc_v_type = rv::risc_v<u64>;
+
+    // clang-format off
+    const u32 program[] {
+        li(reg::t0, handler_address),                                // 0x00
+        csrrw(reg::zero, csr::mtvec, reg::t0),                       // 0x04
+        li(reg::a0, 1),                                              // 0x08
+        ecall,                                                       // 0x0C
+        li(reg::a1, 2),                                              // 0x10
+        ebreak,                                                      // 0x14
+        li(reg::a2, 3),                                              // 0x18
+        jal(reg::zero, 0),                                           // 0x1C: j .
+    };
+
+    const u32 handler[] {
+        csrrs(reg::t1, csr::mcause, reg::zero),                      // 0x100
+        alu<alu_action::add>(reg::s0, reg::s0, reg::t1),             // 0x104
+        csrrs(reg::t2, csr::mepc, reg::zero),                        // 0x108
+        alu_i<alu_action::add, false>(reg::t2, reg::t2, 4),          // 0x10C
+        csrrw(reg::zero, csr::mepc, reg::t2),                        // 0x110
+        csrrs(reg::s1, csr::mtval, reg::zero),                       // 0x114
+        mret,                                                        // 0x118
+    };
+    // clang-format on
+
+    auto risc_v = risc_v_type(rv::is_rv64<risc_v_type>, 0x1000);
+    load_program(risc_v, program);
+    load_program(risc_v, handler, handler_address);
+    risc_v.write_register(reg::s0, u64(0));
+
+    ASSERT_EQ(risc_v.run(100), 22);
+
+    ASSERT_EQ(risc_v.read_register(reg::a0), 1);
+    ASSERT_EQ(risc_v.read_register(reg::a1), 2);
+    ASSERT_EQ(risc_v.read_register(reg::a2), 3);
+    // environment call from M-mode and breakpoint
+    ASSERT_EQ(risc_v.read_register(reg::s0), 11 + 3);
+    // the address of the ebreak
+    ASSERT_EQ(risc_v.read_register(reg::s1), 0x14);
+    // MPIE set by mret, MPP is always M
+    ASSERT_EQ(*risc_v.m_trap.read_csr(csr::mstatus), 0x1880);
+}
+
+TEST(rv_trap, unknown_instructions) {
+    using risc_v_type = rv::risc_v<u64>;
+
+    constexpr u32 sret = 0x1020'0073;
+
+    // clang-format off
+    const u32 program[] {
+        li(reg::a0, 1),                                              // 0x00
+        sret,                                                        // 0x04: unknown without S-mode, skipped by the handler
+        li(reg::a1, 2),                                              // 0x08
+        jal(reg::zero, 0),                                           // 0x0C: j .
+    };
+    // clang-format on
+
+    auto risc_v = risc_v_type(rv::is_rv64<risc_v_type>, 0x1000);
+    load_program(risc_v, program);
+    load_skipping_trap_handler(risc_v, handler_address);
+
+    ASSERT_EQ(risc_v.run(100), 4 + 6);
+
+    ASSERT_EQ(risc_v.read_register(reg::a0), 1);
+    ASSERT_EQ(risc_v.read_register(reg::a1), 2);
+    ASSERT_EQ(risc_v.read_register(reg::s10), rv::trap_cause::illegal_instruction);
+    ASSERT_EQ(risc_v.read_register(reg::s11), sret);
+    ASSERT_EQ(*risc_v.m_trap.read_csr(csr::mepc), 0x04);
+}
+
+TEST(rv_trap, mip_writes) {
+    using risc_v_type = rv::risc_v<u64>;
+
+    // clang-format off
+    const u32 program[] {
+        li(reg::t0, -1),                                             // 0x00
+        csrrw(reg::zero, csr::mip, reg::t0),                         // 0x04: csrw mip, t0
+        csrrwi(reg::zero, csr::mip, 0),                              // 0x08: csrwi mip, 0
+        csrrs(reg::a0, csr::mip, reg::zero),                         // 0x0C: csrr a0, mip
+        jal(reg::zero, 0),                                           // 0x10: j .
+    };
+    // clang-format on
+
+    auto risc_v = risc_v_type(rv::is_rv64<risc_v_type>, 0x1000);
+    load_program(risc_v, program);
+    load_skipping_trap_handler(risc_v, handler_address);
+    risc_v.write_register(reg::s10, u64(0));
+    risc_v.m_trap.set_pending(rv::interrupt_bit::machine_software, rv::interrupt_bit::machine_software);
+
+    // neither write traps nor changes what is pending
+    ASSERT_EQ(risc_v.run(100), 5);
+    ASSERT_EQ(risc_v.read_register(reg::s10), 0);
+    ASSERT_EQ(risc_v.read_register(reg::a0), rv::interrupt_bit::machine_software);
+}
+
+TEST(rv_trap, timer_interrupt) {
+    using risc_v_type = rv::risc_v<u64>;
+
+    // clang-format off
+    const u32 program[] {
+        li(reg::t0, handler_address),                                // 0x00
+        csrrw(reg::zero, csr::mtvec, reg::t0),                       // 0x04
+        lui(reg::t1, static_cast<i32>((clint_address + rv::clint::mtimecmp_offset) >> 12)),  // 0x08
+        li(reg::t2, 40),                                             // 0x0C
+        store<ld_st_type::dword>(reg::t2, 0, reg::t1),               // 0x10: mtimecmp = 40
+        li(reg::t3, 0x80),                                           // 0x14
+        csrrs(reg::zero, csr::mie, reg::t3),                         // 0x18: MTIE
+        csrrsi(reg::zero, csr::mstatus, 0b1000),                     // 0x1C: MIE
+        alu_i<alu_action::add, false>(reg::a0, reg::a0, 1),          // 0x20
+        branch<branch_type::equal>(reg::s1, reg::zero, -4),          // 0x24: until the handler ran
+        jal(reg::zero, 0),                                           // 0x28: j .
+    };
+
+    const u32 handler[] {
+        csrrs(reg::s0, csr::mepc, reg::zero),                        // 0x100
+        csrrs(reg::s2, csr::mcause, reg::zero),                      // 0x104
+        li(reg::s1, 1),                                              // 0x108
+        li(reg::t4, -1),                                             // 0x10C
+        store<ld_st_type::dword>(reg::t4, 0, reg::t1),               // 0x110: disarm
+        csrrs(reg::s3, csr::mip, reg::zero),                         // 0x114
+        mret,                                                        // 0x118
+    };
+    // clang-format on
+
+    auto clint = rv::clint{};
+    auto risc_v = risc_v_type(rv::is_rv64<risc_v_type>, 0x1000);
+    ASSERT_TRUE(risc_v.map_clint(clint, clint_address));
+    load_program(risc_v, program);
+    load_program(risc_v, handler, handler_address);
+    risc_v.write_register(reg::a0, u64(0));
+    risc_v.write_register(reg::s1, u64(0));
+
+    // `mtime` counts retired instructions, the interrupt comes once 40 have retired, which is 8 of setup and 16 iterations of the loop
+    ASSERT_EQ(risc_v.run(100), 40 + 7 + 3);
+
+    ASSERT_EQ(risc_v.read_register(reg::a0), 17);
+    ASSERT_EQ(risc_v.read_register(reg::s0), 0x20);
+    ASSERT_EQ(risc_v.read_register(reg::s2), (u64(1) << 63) | 7);
+    ASSERT_EQ(risc_v.read_register(reg::s3), 0);
+    ASSERT_EQ(clint.mtimecmp(), ~u64(0));
+    // MIE is back on
+    ASSERT_EQ(*risc_v.m_trap.read_csr(csr::mstatus) & 0b1000, 0b1000);
+}
+
+TEST(rv_trap, software_interrupt) {
+    using risc_v_type = rv::risc_v<u32>;
+
+    // clang-format off
+    const u32 program[] {
+        li(reg::t0, handler_address | 1),                            // 0x00: vectored
+        csrrw(reg::zero, csr::mtvec, reg::t0),                       // 0x04
+        lui(reg::t1, static_cast<i32>(clint_address >> 12)),         // 0x08
+        li(reg::t3, 0x8),                                            // 0x0C
+        csrrs(reg::zero, csr::mie, reg::t3),                         // 0x10: MSIE
+        csrrsi(reg::zero, csr::mstatus, 0b1000),                     // 0x14: MIE
+        li(reg::t2, 1),                                              // 0x18
+        store<ld_st_type::word>(reg::t2, 0, reg::t1),                // 0x1C: msip = 1, taken before the next instruction
+        li(reg::a0, 5),                                              // 0x20
+        jal(reg::zero, 0),                                           // 0x24: j .
+    };
+
+    const u32 handler[] {
+        store<ld_st_type::word>(reg::zero, 0, reg::t1),              // 0x10C: msip = 0
+        csrrs(reg::s0, csr::mepc, reg::zero),                        // 0x110
+        csrrs(reg::s1, csr::mcause, reg::zero),                      // 0x114
+        mret,                                                        // 0x118
+    };
+    // clang-format on
+
+    auto clint = rv::clint{};
+    auto risc_v = risc_v_type(rv::is_rv32<risc_v_type>, 0x1000);
+    ASSERT_TRUE(risc_v.map_clint(clint, clint_address));
+    load_program(risc_v, program);
+    // machine software interrupts are number 3
+    load_program(risc_v, handler, handler_address + 4 * 3);
+
+    risc_v.run(100);
+
+    ASSERT_EQ(risc_v.read_register(reg::s0), 0x20);
+    ASSERT_EQ(risc_v.read_register(reg::s1), (u32(1) << 31) | 3);
+    ASSERT_EQ(risc_v.read_register(reg::a0), 5);
+    ASSERT_EQ(clint.pending(), 0);
+}
@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include <rv/rv.hpp>
+
+namespace {
+
+using namespace rv::detail::assembler;
+using rv::alu_action;
+using rv::reg;
+
+using rv64_type = rv::risc_v<u64>;
+
+constexpr u64 uart_address = 0x1000'0000;
+
+}  // namespace
+
+TEST(uart, registers) {
+    auto memory = rv::memory<u64>(0x1000);
+    auto uart = rv::uart(2);
+
+    ASSERT_TRUE(memory.map_device({uart_address, rv::uart::register_span, &uart}));
+    ASSERT_FALSE(memory.map_device({0x800, rv::uart::register_span, &uart}));
+    ASSERT_FALSE(memory.map_device({uart_address + 4, rv::uart::register_span, &uart}));
+
+    // nothing received, room to transmit
+    ASSERT_EQ(memory.load<u8>(uart_address + 5), 0x60);
+
+    memory.store<u8>(uart_address, 'h');
+    memory.store<u8>(uart_address, 'i');
+    ASSERT_EQ(memory.load<u8>(uart_address + 5), 0x00);
+    memory.store<u8>(uart_address, '!');
+    ASSERT_EQ(uart.dropped(), 1);
+
+    ASSERT_EQ(uart.read_transmitted(), 'h');
+    ASSERT_EQ(memory.load<u8>(uart_address + 5), 0x60);
+    ASSERT_EQ(uart.read_transmitted(), 'i');
+    ASSERT_EQ(uart.read_transmitted(), std::nullopt);
+
+    ASSERT_TRUE(uart.write_received('x'));
+    ASSERT_EQ(memory.load<u8>(uart_address + 5), 0x61);
+    ASSERT_EQ(memory.load<u8>(uart_address), 'x');
+    ASSERT_EQ(memory.load<u8>(uart_address + 5), 0x60);
+
+    // the divisor latch takes the place of the data and interrupt enable registers
+    memory.store<u8>(uart_address + 3, 0x83);
+    memory.store<u8>(uart_address, 0x01);
+    memory.store<u8>(uart_address + 1, 0x02);
+    ASSERT_EQ(memory.load<u8>(uart_address + 1), 0x02);
+    memory.store<u8>(uart_address + 3, 0x03);
+    ASSERT_EQ(memory.load<u8>(uart_address + 1), 0x00);
+    ASSERT_EQ(uart.read_transmitted(), std::nullopt);
+
+    // past the end of RAM without a device there
+    ASSERT_EQ(memory.load<u32>(0x2000), 0);
+    memory.store<u32>(0x2000, 0xFFFF'FFFF);
+}
+
+TEST(uart, guest) {
+    // clang-format off
+    const u32 program[] {
+        lui(reg::t0, static_cast<i32>(uart_address >> 12)),            // 0x00: lui t0, 0x10000
+        alu_i<alu_action::add, false>(reg::a0, reg::zero, 'h'),        // 0x04: li a0, 'h'
+        load<ld_st_type::ubyte>(reg::t1, 5, reg::t0),                  // 0x08: lbu t1, 5(t0)
+        alu_i<alu_action::band, false>(reg::t1, reg::t1, 0x20),        // 0x0C: andi t1, t1, 0x20
+        branch<branch_type::equal>(reg::t1, reg::zero, -8),            // 0x10: beqz t1, 0x08
+        store<ld_st_type::byte>(reg::a0, 0, reg::t0),                  // 0x14: sb a0, 0(t0)
+        load<ld_st_type::ubyte>(reg::a1, 0, reg::t0),                  // 0x18: lbu a1, 0(t0)
+        jal(reg::zero, 0),                                             // 0x1C: j .
+    };
+    // clang-format on
+
+    auto risc_v = rv64_type(rv::is_rv64<rv64_type>, 0x1000);
+    for (usize i = 0; i < std::size(program); i++) {
+        risc_v.m_memory.write<u32>(i * 4, program[i]);
+    }
+
+    auto uart = rv::uart{};
+    ASSERT_TRUE(risc_v.m_memory.map_device({uart_address, rv::uart::register_span, &uart}));
+    ASSERT_TRUE(uart.write_received('x'));
+
+    risc_v.run(100);
+    ASSERT_EQ(risc_v.program_counter(), 0x1C);
+    ASSERT_EQ(uart.read_transmitted(), 'h');
+    ASSERT_EQ(risc_v.read_register(reg::a1), 'x');
+}
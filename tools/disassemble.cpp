@@ -0,0 +1,228 @@
+#include <rv/rv.hpp>
+
+#include <fmt/format.h>
+
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+struct options {
+    std::string_view image_path;
+    std::string_view output_path;
+    std::string_view symbols_path;
+    /// for raw images, ELF images have their segments at their addresses
+    u64 base = 0;
+    std::optional<bool> is_64_bit = std::nullopt;
+    rv::listing_options listing{};
+    bool print_stats = false;
+};
+
+auto parse_number(std::string_view str) -> std::optional<u64> {
+    auto base = 10;
+    if (str.starts_with("0x") || str.starts_with("0X")) {
+        str.remove_prefix(2);
+        base = 16;
+    }
+
+    u64 ret = 0;
+    const auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), ret, base);
+    if (ec != std::errc{} || ptr != str.data() + str.size()) {
+        return std::nullopt;
+    }
+
+    return ret;
+}
+
+auto usage(const char* program_name) -> int {
+    fmt::print(stderr, "usage: {} [options] <image>\n", program_name);
+    fmt::print(stderr, "  -o <file>                 where to write the listing, stdout by default\n");
+    fmt::print(stderr, "  --base <address>          where a raw image is, 0 by default\n");
+    fmt::print(stderr, "  --isa rv32|rv64           rv64 by default, or the class of the ELF image\n");
+    fmt::print(stderr, "  --symbols <file.elf>      where to take function labels from, the image itself if it is an ELF one\n");
+    fmt::print(stderr, "  --threads <n>             one per hardware thread by default\n");
+    fmt::print(stderr, "  --chunk <bytes>           how much code a thread lists at a time\n");
+    fmt::print(stderr, "  --numeric                 x0-x31 instead of the ABI register names\n");
+    fmt::print(stderr, "  --stats                   print how long the listing took to stderr\n");
+    fmt::print(stderr, "the executable segments of ELF images are listed, raw images are listed whole\n");
+    return 1;
+}
+
+auto parse_options(int argc, char** argv) -> std::optional<options> {
+    auto ret = options{};
+
+    for (auto i = 1; i < argc; i++) {
+        const auto arg = std::string_view(argv[i]);
+        const auto next = [&]() -> std::optional<std::string_view> {
+            if (i + 1 >= argc) {
+                return std::nullopt;
+            }
+
+            return std::string_view(argv[++i]);
+        };
+
+        if (arg == "-o") {
+            const auto value = next();
+            if (!value) {
+                return std::nullopt;
+            }
+            ret.output_path = *value;
+        } else if (arg == "--base") {
+            const auto value = next().and_then(parse_number);
+            if (!value) {
+                return std::nullopt;
+            }
+            ret.base = *value;
+        } else if (arg == "--isa") {
+            const auto value = next();
+            if (value != "rv32" && value != "rv64") {
+                return std::nullopt;
+            }
+            ret.is_64_bit = value == "rv64";
+        } else if (arg == "--symbols") {
+            const auto value = next();
+            if (!value) {
+                return std::nullopt;
+            }
+            ret.symbols_path = *value;
+        } else if (arg == "--threads") {
+            const auto value = next().and_then(parse_number);
+            if (!value) {
+                return std::nullopt;
+            }
+            ret.listing.num_threads = *value;
+        } else if (arg == "--chunk") {
+            const auto value = next().and_then(parse_number);
+            if (!value || *value == 0) {
+                return std::nullopt;
+            }
+            ret.listing.chunk_size = *value;
+        } else if (arg == "--numeric") {
+            ret.listing.abi_register_names = false;
+        } else if (arg == "--stats") {
+            ret.print_stats = true;
+        } else if (arg.starts_with("-") || !ret.image_path.empty()) {
+            return std::nullopt;
+        } else {
+            ret.image_path = arg;
+        }
+    }
+
+    if (ret.image_path.empty()) {
+        return std::nullopt;
+    }
+
+    return ret;
+}
+
+auto read_file(std::string_view path) -> std::optional<std::vector<u8>> {
+    auto ifs = std::ifstream(std::filesystem::path(path), std::ios::binary);
+    if (!ifs) {
+        return std::nullopt;
+    }
+
+    return std::vector<u8>(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+}
+
+auto is_elf(std::span<const u8> image) -> bool { return image.size() >= 4 && std::memcmp(image.data(), "\x7F" "ELF", 4) == 0; }
+
+template<typename RegisterType>
+void write_listing(std::ostream& os, std::span<const rv::elf::segment> segments, options const& options) {
+    using processor_type = rv::risc_v<RegisterType>;
+
+    auto const& isa = []() -> rv::generic_instruction_set<processor_type> const& {
+        if constexpr (sizeof(RegisterType) == sizeof(u64)) {
+            return rv::is_rv64<processor_type>;
+        } else {
+            return rv::is_rv32<processor_type>;
+        }
+    }();
+
+    for (auto const& segment : segments) {
+        rv::write_listing(os, isa, segment.contents, segment.address, options.listing);
+    }
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) -> int {
+    auto options = parse_options(argc, argv);
+    if (!options) {
+        return usage(argv[0]);
+    }
+
+    const auto image = read_file(options->image_path);
+    if (!image) {
+        fmt::print(stderr, "could not open {}\n", options->image_path);
+        return 1;
+    }
+
+    auto is_64_bit = options->is_64_bit;
+    auto segments = std::vector<rv::elf::segment>{};
+
+    if (is_elf(*image)) {
+        auto executable = rv::elf::executable::from_image(*image);
+        if (!executable) {
+            fmt::print(stderr, "could not load {}: {}\n", options->image_path, executable.error());
+            return 1;
+        }
+
+        is_64_bit = is_64_bit.value_or(executable->is_64_bit);
+        std::ranges::copy_if(executable->segments, std::back_inserter(segments), &rv::elf::segment::is_executable);
+    } else {
+        segments.push_back({.address = options->base, .contents = *image, .memory_size = image->size(), .is_executable = true});
+    }
+
+    auto symbols = std::optional<rv::elf::symbol_table>{};
+    if (!options->symbols_path.empty() || is_elf(*image)) {
+        auto table = options->symbols_path.empty() ? rv::elf::symbol_table::from_image(*image) : rv::elf::symbol_table::from_file(options->symbols_path);
+        if (!table) {
+            fmt::print(stderr, "could not load symbols: {}\n", table.error());
+            return 1;
+        }
+        symbols = std::move(*table);
+        options->listing.symbols = &*symbols;
+    }
+
+    auto ofs = std::ofstream{};
+    if (!options->output_path.empty()) {
+        ofs.open(std::filesystem::path(options->output_path), std::ios::binary);
+        if (!ofs) {
+            fmt::print(stderr, "could not open {}\n", options->output_path);
+            return 1;
+        }
+    }
+
+    auto& os = options->output_path.empty() ? std::cout : ofs;
+
+    const auto tp_0 = std::chrono::steady_clock::now();
+
+    if (is_64_bit.value_or(true)) {
+        write_listing<u64>(os, segments, *options);
+    } else {
+        write_listing<u32>(os, segments, *options);
+    }
+
+    os.flush();
+
+    const auto tp_1 = std::chrono::steady_clock::now();
+
+    if (options->print_stats) {
+        auto bytes = 0uz;
+        for (auto const& segment : segments) {
+            bytes += segment.contents.size();
+        }
+
+        const auto elapsed = std::chrono::duration<double>(tp_1 - tp_0).count();
+        fmt::print(stderr, "listed {} bytes of code in {:.3f} ms, {:.2f} MB/s\n", bytes, elapsed * 1e3, static_cast<double>(bytes) / elapsed / 1e6);
+    }
+
+    return 0;
+}
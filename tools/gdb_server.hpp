@@ -0,0 +1,160 @@
+#pragma once
+
+#include <rv/rv.hpp>
+
+#include <fmt/format.h>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace gdb {
+
+/// instructions between checks for an interrupt from the debugger while continuing
+inline constexpr u64 poll_interval = 1uz << 16;
+
+/// closes the descriptor when it goes out of scope
+struct file_descriptor {
+    explicit file_descriptor(int fd)
+        : m_fd(fd) {}
+
+    file_descriptor(file_descriptor&& other) noexcept
+        : m_fd(std::exchange(other.m_fd, -1)) {}
+
+    file_descriptor(file_descriptor const&) = delete;
+    file_descriptor& operator=(file_descriptor const&) = delete;
+
+    ~file_descriptor() {
+        if (m_fd >= 0) {
+            ::close(m_fd);
+        }
+    }
+
+    auto get() const -> int { return m_fd; }
+
+private:
+    int m_fd;
+};
+
+/// Listens on `endpoint`, which is a TCP port on localhost if it is a number and the path of a Unix socket otherwise, and waits for a
+/// single connection.
+inline auto accept_connection(std::string_view endpoint) -> std::optional<file_descriptor> {
+    auto port = u16(0);
+    const auto [ptr, ec] = std::from_chars(endpoint.data(), endpoint.data() + endpoint.size(), port);
+    const auto is_tcp = ec == std::errc{} && ptr == endpoint.data() + endpoint.size();
+
+    auto listener = file_descriptor(::socket(is_tcp ? AF_INET : AF_UNIX, SOCK_STREAM, 0));
+    if (listener.get() < 0) {
+        fmt::print(stderr, "could not create a socket: {}\n", std::strerror(errno));
+        return std::nullopt;
+    }
+
+    auto bound = -1;
+    if (is_tcp) {
+        const auto reuse = 1;
+        ::setsockopt(listener.get(), SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        auto address = sockaddr_in{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bound = ::bind(listener.get(), reinterpret_cast<sockaddr const*>(&address), sizeof(address));
+    } else {
+        auto address = sockaddr_un{};
+        address.sun_family = AF_UNIX;
+        if (endpoint.size() >= sizeof(address.sun_path)) {
+            fmt::print(stderr, "the socket path is too long\n");
+            return std::nullopt;
+        }
+
+        std::ranges::copy(endpoint, address.sun_path);
+        ::unlink(address.sun_path);
+        bound = ::bind(listener.get(), reinterpret_cast<sockaddr const*>(&address), sizeof(address));
+    }
+
+    if (bound < 0 || ::listen(listener.get(), 1) < 0) {
+        fmt::print(stderr, "could not listen on {}: {}\n", endpoint, std::strerror(errno));
+        return std::nullopt;
+    }
+
+    fmt::print(stderr, "waiting for gdb on {}\n", endpoint);
+
+    auto connection = file_descriptor(::accept(listener.get(), nullptr, nullptr));
+    if (connection.get() < 0) {
+        fmt::print(stderr, "could not accept a connection: {}\n", std::strerror(errno));
+        return std::nullopt;
+    }
+
+    if (is_tcp) {
+        // packets are small and every one of them waits for a reply
+        const auto no_delay = 1;
+        ::setsockopt(connection.get(), IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+    }
+
+    return connection;
+}
+
+inline auto send_all(int fd, std::string_view data) -> bool {
+    while (!data.empty()) {
+        const auto sent = ::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+        if (sent <= 0) {
+            return false;
+        }
+        data.remove_prefix(static_cast<usize>(sent));
+    }
+
+    return true;
+}
+
+/// Debugs `risc_v` over a connection on `endpoint` until the debugger detaches, kills or goes away. Returns the state the stub ended up in,
+/// nothing if there never was a connection.
+template<typename RiscV>
+auto serve(RiscV& risc_v, std::string_view endpoint) -> std::optional<rv::gdb_stub_state> {
+    const auto connection = accept_connection(endpoint);
+    if (!connection) {
+        return std::nullopt;
+    }
+
+    auto stub = rv::gdb_stub<RiscV>(risc_v);
+    auto buffer = std::array<char, 4096>{};
+
+    while (stub.state() == rv::gdb_stub_state::stopped || stub.state() == rv::gdb_stub_state::running) {
+        const auto running = stub.state() == rv::gdb_stub_state::running;
+
+        // while running, only peek for an interrupt between batches
+        auto poll_fd = pollfd{.fd = connection->get(), .events = POLLIN, .revents = 0};
+        if (const auto ready = ::poll(&poll_fd, 1, running ? 0 : -1); ready < 0 && errno != EINTR) {
+            break;
+        }
+
+        if ((poll_fd.revents & (POLLIN | POLLHUP | POLLERR)) != 0) {
+            const auto received = ::recv(connection->get(), buffer.data(), buffer.size(), 0);
+            if (received <= 0) {
+                break;
+            }
+
+            if (!send_all(connection->get(), stub.receive(std::string_view(buffer.data(), static_cast<usize>(received))))) {
+                break;
+            }
+        }
+
+        if (stub.state() == rv::gdb_stub_state::running && !send_all(connection->get(), stub.resume(poll_interval))) {
+            break;
+        }
+    }
+
+    return stub.state();
+}
+
+}  // namespace gdb
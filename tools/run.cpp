@@ -0,0 +1,436 @@
+#include <rv/rv.hpp>
+
+#include "gdb_server.hpp"
+
+#include <fmt/format.h>
+
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <optional>
+#include <sstream>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+/// exit codes of the runner itself, otherwise it exits with the guest's a0
+enum exit_code : int {
+    exit_test_failure = 1,
+    exit_out_of_budget = 124,
+    exit_usage = 125,
+    /// the guest took a trap without having a handler for it, or stopped somewhere other than on a `j .` (e.g. on a reserved instruction)
+    exit_stuck = 126,
+    /// like a process that got SIGKILLed, for when the debugger kills the guest
+    exit_killed = 137,
+};
+
+/// `jal x0, 0` and `c.j 0`, the ways guests halt
+constexpr u32 halt_instruction = 0x0000'006F;
+constexpr u16 compressed_halt_instruction = 0xA001;
+
+/// Whether the guest exit code can't be told apart from one of the runner's own.
+constexpr auto collides_with_runner(int code) -> bool {
+    return code == exit_out_of_budget || code == exit_usage || code == exit_stuck || code == exit_killed;
+}
+
+/// `test_outputs` of the test programs starts with the head guard and the tail guard follows the results, the array got clobbered if either
+/// is missing
+constexpr u64 test_outputs_head_guard = 0x0F0E'0E0B'0D0A'0E0D;
+constexpr u64 test_outputs_tail_guard = 0x0E0B'0A0B'0E0F'0A0C;
+
+/// where the CLINT is mapped if RAM doesn't reach it, the same place as on QEMU's virt machine
+constexpr u64 clint_address = 0x0200'0000;
+
+/// what `mtvec` starts out as, a trap that goes there is one the guest has no handler for. It is the top of the address space so that no
+/// guest has its handler there, execution never gets to fetch from it.
+template<typename RegisterType>
+constexpr auto unhandled_trap_vector = ~RegisterType(0b11);
+
+enum class image_format {
+    automatic,
+    ihex,
+    bin,
+    elf,
+};
+
+struct options {
+    std::string_view image_path;
+    image_format format = image_format::automatic;
+    usize ram_size = 0x4'0000;
+    usize vlen = 128;
+    std::optional<bool> is_64_bit = std::nullopt;
+    u64 max_instructions = std::numeric_limits<u64>::max();
+    std::string_view symbols_path;
+    bool test_outputs = false;
+    std::vector<std::pair<usize, u64>> expected_outputs{};
+    bool print_stats = false;
+    std::string_view gdb_endpoint;
+};
+
+auto parse_number(std::string_view str) -> std::optional<u64> {
+    auto base = 10;
+    if (str.starts_with("0x") || str.starts_with("0X")) {
+        str.remove_prefix(2);
+        base = 16;
+    }
+
+    u64 ret = 0;
+    const auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), ret, base);
+    if (ec != std::errc{} || ptr != str.data() + str.size()) {
+        return std::nullopt;
+    }
+
+    return ret;
+}
+
+auto usage(const char* program_name) -> int {
+    fmt::print(stderr, "usage: {} [options] <image>\n", program_name);
+    fmt::print(stderr, "  --format ihex|bin|elf     the format of the image, ELF images and .hex files are recognised otherwise\n");
+    fmt::print(stderr, "  --ram <bytes>             the amount of RAM, 0x40000 by default\n");
+    fmt::print(stderr, "  --isa rv32|rv64           rv64 by default, or the class of the ELF image\n");
+    fmt::print(stderr, "  --vlen <bits>             the width of the vector registers, a power of two from 64 to {}, 128 by default\n", rv::max_vlen);
+    fmt::print(stderr, "  --max-instructions <n>    give up after this many instructions\n");
+    fmt::print(stderr, "  --symbols <file.elf>      where to look up `test_outputs` for non-ELF images\n");
+    fmt::print(stderr, "  --test-outputs            print and check `test_outputs` instead of exiting with the guest's a0\n");
+    fmt::print(stderr, "  --expect <index>=<value>  an entry of `test_outputs` to check, implies --test-outputs\n");
+    fmt::print(stderr, "  --stats                   print the instruction count and speed to stderr\n");
+    fmt::print(stderr, "  --gdb <port|path>         wait for gdb on a localhost TCP port or a Unix socket, run on when it detaches\n");
+    fmt::print(stderr, "exits with the guest's a0 when it halts on a `j .`, {} if it ran out of instructions and {} if it took a trap without a handler or got stuck anywhere else\n", static_cast<int>(exit_out_of_budget), static_cast<int>(exit_stuck));
+    fmt::print(stderr, "guest exit codes {}, {}, {} and {} are the same as the runner's own, a note goes to stderr when the guest uses them\n", static_cast<int>(exit_out_of_budget),
+               static_cast<int>(exit_usage), static_cast<int>(exit_stuck), static_cast<int>(exit_killed));
+    return exit_usage;
+}
+
+auto parse_options(int argc, char** argv) -> std::optional<options> {
+    auto ret = options{};
+
+    for (auto i = 1; i < argc; i++) {
+        const auto arg = std::string_view(argv[i]);
+        const auto next = [&]() -> std::optional<std::string_view> {
+            if (i + 1 >= argc) {
+                return std::nullopt;
+            }
+
+            return std::string_view(argv[++i]);
+        };
+
+        if (arg == "--format") {
+            const auto value = next();
+            if (value == "ihex") {
+                ret.format = image_format::ihex;
+            } else if (value == "bin") {
+                ret.format = image_format::bin;
+            } else if (value == "elf") {
+                ret.format = image_format::elf;
+            } else {
+                return std::nullopt;
+            }
+        } else if (arg == "--ram") {
+            const auto value = next().and_then(parse_number);
+            if (!value) {
+                return std::nullopt;
+            }
+            ret.ram_size = *value;
+        } else if (arg == "--isa") {
+            const auto value = next();
+            if (value != "rv32" && value != "rv64") {
+                return std::nullopt;
+            }
+            ret.is_64_bit = value == "rv64";
+        } else if (arg == "--vlen") {
+            const auto value = next().and_then(parse_number);
+            if (!value || !std::has_single_bit(*value) || *value < rv::max_element_bits || *value > rv::max_vlen) {
+                return std::nullopt;
+            }
+            ret.vlen = *value;
+        } else if (arg == "--max-instructions") {
+            const auto value = next().and_then(parse_number);
+            if (!value) {
+                return std::nullopt;
+            }
+            ret.max_instructions = *value;
+        } else if (arg == "--symbols") {
+            const auto value = next();
+            if (!value) {
+                return std::nullopt;
+            }
+            ret.symbols_path = *value;
+        } else if (arg == "--test-outputs") {
+            ret.test_outputs = true;
+        } else if (arg == "--expect") {
+            const auto value = next();
+            const auto separator = value ? value->find('=') : std::string_view::npos;
+            if (separator == std::string_view::npos) {
+                return std::nullopt;
+            }
+
+            const auto index = parse_number(value->substr(0, separator));
+            const auto expected = parse_number(value->substr(separator + 1));
+            if (!index || !expected) {
+                return std::nullopt;
+            }
+
+            ret.test_outputs = true;
+            ret.expected_outputs.emplace_back(*index, *expected);
+        } else if (arg == "--gdb") {
+            const auto value = next();
+            if (!value) {
+                return std::nullopt;
+            }
+            ret.gdb_endpoint = *value;
+        } else if (arg == "--stats") {
+            ret.print_stats = true;
+        } else if (arg.starts_with("--") || !ret.image_path.empty()) {
+            return std::nullopt;
+        } else {
+            ret.image_path = arg;
+        }
+    }
+
+    if (ret.image_path.empty()) {
+        return std::nullopt;
+    }
+
+    return ret;
+}
+
+auto read_file(std::string_view path) -> std::optional<std::vector<u8>> {
+    auto ifs = std::ifstream(std::filesystem::path(path), std::ios::binary);
+    if (!ifs) {
+        return std::nullopt;
+    }
+
+    return std::vector<u8>(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+}
+
+auto is_elf(std::span<const u8> image) -> bool { return image.size() >= 4 && std::memcmp(image.data(), "\x7F" "ELF", 4) == 0; }
+
+/// Prints and checks the guards and the expected entries of `test_outputs`, which has `count` int64 entries at `address`.
+template<typename RiscV>
+auto check_test_outputs(RiscV const& risc_v, options const& options, u64 address, usize count) -> int {
+    const auto entry = [&](usize index) { return risc_v.memory().template read<u64>(address + index * sizeof(u64)); };
+
+    auto tail = count;
+    for (usize i = 0; i < count; i++) {
+        fmt::print("test_outputs[{}] = {:#018x}\n", i, entry(i));
+
+        if (i != 0 && entry(i) == test_outputs_tail_guard) {
+            tail = i;
+            break;
+        }
+    }
+
+    auto failed = false;
+
+    if (count == 0 || entry(0) != test_outputs_head_guard || tail == count) {
+        fmt::print(stderr, "the guards of test_outputs are clobbered\n");
+        failed = true;
+    }
+
+    for (auto const& [index, expected] : options.expected_outputs) {
+        if (index >= count) {
+            fmt::print(stderr, "test_outputs has no entry {}\n", index);
+            failed = true;
+        } else if (const auto actual = entry(index); actual != expected) {
+            fmt::print(stderr, "test_outputs[{}]: expected {:#x}, got {:#x}\n", index, expected, actual);
+            failed = true;
+        }
+    }
+
+    return failed ? exit_test_failure : 0;
+}
+
+template<typename RegisterType>
+auto run(options const& options, std::span<const u8> image, image_format format, std::optional<rv::elf::symbol_table> const& symbols) -> int {
+    using processor_type = rv::risc_v<RegisterType>;
+    constexpr auto is_64_bit = sizeof(RegisterType) == sizeof(u64);
+
+    const auto start_time = std::chrono::steady_clock::now();
+
+    auto const& isa = []() -> rv::generic_instruction_set<processor_type> const& {
+        if constexpr (is_64_bit) {
+            return rv::is_rv64<processor_type>;
+        } else {
+            return rv::is_rv32<processor_type>;
+        }
+    }();
+
+    // `mtime` counts instructions so that runs stay reproducible, the CLINT is left out if RAM reaches where it would be
+    auto clint = rv::clint{};
+
+    auto risc_v = processor_type(isa, options.ram_size);
+    risc_v.m_vector = rv::vector_register_file(options.vlen);
+    std::ignore = risc_v.map_clint(clint, static_cast<RegisterType>(clint_address));
+
+    auto loaded = stf::expected<void, std::string_view>{};
+    auto entry = u64(0);
+
+    switch (format) {
+        case image_format::elf: {
+            loaded = risc_v.memory().load_from(image, rv::infmt_elf_tag{});
+            if (const auto executable = rv::elf::executable::from_image(image); executable) {
+                entry = executable->entry;
+            }
+            break;
+        }
+        case image_format::bin:
+        case image_format::ihex: {
+            // the stream loaders want a stream, this is the only copy of the image that is made
+            auto stream = std::istringstream(std::string(reinterpret_cast<const char*>(image.data()), image.size()));
+            loaded = format == image_format::bin ? risc_v.memory().load_from(stream, rv::infmt_bin_tag{}) : risc_v.memory().load_from(stream, rv::infmt_ihex_tag{});
+            break;
+        }
+        default: break;
+    }
+
+    if (!loaded) {
+        fmt::print(stderr, "could not load {}: {}\n", options.image_path, loaded.error());
+        return exit_usage;
+    }
+
+    risc_v.m_trap.write_csr(rv::csr_address::mtvec, unhandled_trap_vector<RegisterType>);
+    risc_v.jump_to(static_cast<RegisterType>(entry));
+
+    const auto loaded_time = std::chrono::steady_clock::now();
+
+    if (!options.gdb_endpoint.empty()) {
+        const auto state = gdb::serve(risc_v, options.gdb_endpoint);
+        if (!state) {
+            return exit_usage;
+        }
+
+        if (*state != rv::gdb_stub_state::detached) {
+            return exit_killed;
+        }
+    }
+
+    const auto run_time = std::chrono::steady_clock::now();
+
+    constexpr auto chunk = 1uz << 20;
+    auto executed = u64(0);
+    auto halted = false;
+    auto unhandled_trap = false;
+
+    while (executed < options.max_instructions) {
+        const auto to_execute = std::min<u64>(chunk, options.max_instructions - executed);
+        const auto taken = risc_v.m_trap.taken();
+        // traps end the chunk so that one going to `unhandled_trap_vector` is caught before anything gets fetched from there
+        const auto chunk_executed = risc_v.template run<true>(to_execute);
+        executed += chunk_executed;
+
+        if (taken != risc_v.m_trap.taken()) {
+            if (risc_v.program_counter() == unhandled_trap_vector<RegisterType>) {
+                unhandled_trap = true;
+                break;
+            }
+
+            continue;
+        }
+
+        if (chunk_executed != to_execute) {
+            halted = true;
+            break;
+        }
+    }
+
+    const auto end_time = std::chrono::steady_clock::now();
+
+    if (options.print_stats) {
+        const auto startup = std::chrono::duration<double, std::milli>(loaded_time - start_time).count();
+        const auto elapsed = std::chrono::duration<double>(end_time - run_time).count();
+        fmt::print(stderr, "startup: {:.3f} ms, {} instructions in {:.3f} s, {:.2f} MIPS\n", startup, executed, elapsed, executed / elapsed / 1e6);
+    }
+
+    if (unhandled_trap) {
+        fmt::print(
+          stderr, "unhandled trap after {} instructions, mcause = {:#x}, mepc = {:#x}, mtval = {:#x}\n", executed, static_cast<u64>(*risc_v.m_trap.read_csr(rv::csr_address::mcause)),
+          static_cast<u64>(*risc_v.m_trap.read_csr(rv::csr_address::mepc)), static_cast<u64>(*risc_v.m_trap.read_csr(rv::csr_address::mtval))
+        );
+        return exit_stuck;
+    }
+
+    if (!halted) {
+        fmt::print(stderr, "ran out of instructions after {}, pc = {:#x}\n", executed, static_cast<u64>(risc_v.program_counter()));
+        return exit_out_of_budget;
+    }
+
+    // reserved instructions that aren't implemented leave the program counter where it is too, only a `j .` is the guest halting
+    const auto word = risc_v.memory().template read<u32>(risc_v.program_counter());
+    if (word != halt_instruction && static_cast<u16>(word) != compressed_halt_instruction) {
+        fmt::print(stderr, "stuck on {:#010x} after {} instructions, pc = {:#x}\n", word, executed, static_cast<u64>(risc_v.program_counter()));
+        return exit_stuck;
+    }
+
+    if (options.test_outputs) {
+        const auto* const symbol = symbols ? symbols->find("test_outputs") : nullptr;
+        if (symbol == nullptr) {
+            fmt::print(stderr, "no test_outputs symbol, pass an ELF image or --symbols\n");
+            return exit_usage;
+        }
+
+        return check_test_outputs(risc_v, options, symbol->address, symbol->size / sizeof(u64));
+    }
+
+    const auto guest_exit_code = static_cast<int>(risc_v.read_register(rv::reg::a0) & 0xFF);
+    if (collides_with_runner(guest_exit_code)) {
+        fmt::print(stderr, "the guest exited with {}, which the runner uses for its own errors too\n", guest_exit_code);
+    }
+
+    return guest_exit_code;
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) -> int {
+    const auto options = parse_options(argc, argv);
+    if (!options) {
+        return usage(argv[0]);
+    }
+
+    const auto image = read_file(options->image_path);
+    if (!image) {
+        fmt::print(stderr, "could not open {}\n", options->image_path);
+        return exit_usage;
+    }
+
+    auto format = options->format;
+    if (format == image_format::automatic) {
+        if (is_elf(*image)) {
+            format = image_format::elf;
+        } else if (options->image_path.ends_with(".hex")) {
+            format = image_format::ihex;
+        } else {
+            format = image_format::bin;
+        }
+    }
+
+    auto is_64_bit = options->is_64_bit;
+    if (!is_64_bit && format == image_format::elf) {
+        if (const auto executable = rv::elf::executable::from_image(*image); executable) {
+            is_64_bit = executable->is_64_bit;
+        }
+    }
+
+    // symbols are only needed for `test_outputs`, parsing them isn't paid for otherwise
+    auto symbols = std::optional<rv::elf::symbol_table>{};
+    if (options->test_outputs) {
+        auto table = options->symbols_path.empty() ? rv::elf::symbol_table::from_image(*image) : rv::elf::symbol_table::from_file(options->symbols_path);
+        if (!table) {
+            fmt::print(stderr, "could not load symbols: {}\n", table.error());
+            return exit_usage;
+        }
+        symbols = std::move(*table);
+    }
+
+    if (is_64_bit.value_or(true)) {
+        return run<u64>(*options, *image, format, symbols);
+    }
+
+    return run<u32>(*options, *image, format, symbols);
+}
@@ -0,0 +1,181 @@
+#include <rv/rv.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string_view>
+
+namespace {
+
+using formatting_risc_v = rv::risc_v<u64>;
+
+void print_record(u64 index, rv::trace_record const& record) {
+    // dumps go through every record, the disassembly buffer is reused across them
+    static auto disassembly = rv::format_buffer{};
+    disassembly.clear();
+    rv::is_rv64<formatting_risc_v>.format_to(disassembly, record.instruction_word, true);
+
+    fmt::print("{:>10} {:016X}: {:<32}", index, record.program_counter, std::string_view(disassembly.data(), disassembly.size()));
+
+    for (auto const& write : record.register_writes) {
+        fmt::print(" {} <- {:#x}", rv::register_name<true>(write.destination), write.value);
+    }
+
+    for (auto const& access : record.memory_accesses) {
+        fmt::print(" {}{}[{:#x}]", access.type == rv::memory_access_type::write ? "st" : "ld", access.size * 8, access.address);
+    }
+
+    fmt::print("\n");
+}
+
+auto parse_address(std::string_view str) -> std::optional<u64> {
+    auto base = 10;
+    if (str.starts_with("0x") || str.starts_with("0X")) {
+        str.remove_prefix(2);
+        base = 16;
+    }
+
+    u64 ret = 0;
+    const auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), ret, base);
+    if (ec != std::errc{} || ptr != str.data() + str.size()) {
+        return std::nullopt;
+    }
+
+    return ret;
+}
+
+auto usage(const char* program_name) -> int {
+    fmt::print(stderr, "usage: {} dump <trace> [first] [count]\n", program_name);
+    fmt::print(stderr, "       {} find-pc <trace> <address>\n", program_name);
+    fmt::print(stderr, "       {} find-access <trace> <address>\n", program_name);
+    fmt::print(stderr, "       {} diff <trace> <trace>\n", program_name);
+    return 1;
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) -> int {
+    if (argc < 3) {
+        return usage(argv[0]);
+    }
+
+    const auto command = std::string_view(argv[1]);
+
+    auto open = [](const char* filename) -> std::optional<std::pair<std::unique_ptr<std::ifstream>, rv::trace_reader>> {
+        auto ifs = std::make_unique<std::ifstream>(filename, std::ios::binary);
+        if (!*ifs) {
+            fmt::print(stderr, "could not open {}\n", filename);
+            return std::nullopt;
+        }
+
+        auto reader = rv::trace_reader::open(*ifs);
+        if (!reader) {
+            fmt::print(stderr, "{}: {}\n", filename, reader.error());
+            return std::nullopt;
+        }
+
+        return std::pair{std::move(ifs), std::move(*reader)};
+    };
+
+    auto trace = open(argv[2]);
+    if (!trace) {
+        return 1;
+    }
+
+    auto& reader = trace->second;
+
+    const auto report_error = [](rv::trace_reader const& reader) {
+        if (const auto error = reader.error(); error) {
+            fmt::print(stderr, "record {}: {}\n", reader.index(), *error);
+            return 1;
+        }
+
+        return 0;
+    };
+
+    if (command == "dump") {
+        const auto first = argc > 3 ? parse_address(argv[3]) : 0;
+        const auto count = argc > 4 ? parse_address(argv[4]) : std::numeric_limits<u64>::max();
+        if (!first || !count) {
+            return usage(argv[0]);
+        }
+
+        for (auto index = reader.index(); auto record = reader.next(); index = reader.index()) {
+            if (index < *first) {
+                continue;
+            }
+
+            // `first + count` overflows with the default count
+            if (index - *first >= *count) {
+                break;
+            }
+
+            print_record(index, *record);
+        }
+
+        return report_error(reader);
+    }
+
+    if (command == "find-pc" || command == "find-access") {
+        const auto address = argc > 3 ? parse_address(argv[3]) : std::nullopt;
+        if (!address) {
+            return usage(argv[0]);
+        }
+
+        const auto found = command == "find-pc"  //
+                           ? rv::trace_find(reader, [&](auto const& record) { return record.program_counter == *address; })
+                           : rv::trace_find(reader, [&](auto const& record) {
+                                 return std::ranges::any_of(record.memory_accesses, [&](auto const& access) { return access.address == *address; });
+                             });
+
+        if (!found) {
+            fmt::print("not found\n");
+            return report_error(reader);
+        }
+
+        print_record(found->first, found->second);
+        return 0;
+    }
+
+    if (command == "diff") {
+        if (argc < 4) {
+            return usage(argv[0]);
+        }
+
+        auto other_trace = open(argv[3]);
+        if (!other_trace) {
+            return 1;
+        }
+
+        auto& other_reader = other_trace->second;
+        const auto divergence = rv::trace_first_divergence(reader, other_reader);
+
+        if (report_error(reader) != 0 || report_error(other_reader) != 0) {
+            return 1;
+        }
+
+        if (!divergence) {
+            fmt::print("traces are identical\n");
+            return 0;
+        }
+
+        fmt::print("traces diverge at record {}\n", divergence->index);
+        for (auto const& [name, record] : {std::pair{argv[2], &divergence->lhs}, std::pair{argv[3], &divergence->rhs}}) {
+            fmt::print("{}:\n", name);
+            if (*record) {
+                print_record(divergence->index, **record);
+            } else {
+                fmt::print("{:>10} (end of trace)\n", divergence->index);
+            }
+        }
+
+        return 2;
+    }
+
+    return usage(argv[0]);
+}